@@ -0,0 +1,141 @@
+#include "bench_allocator.h"
+#include "trek_tlsf.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace Trek
+{
+	namespace
+	{
+		struct OpTimings {
+			double allocateNs = 0.0;
+			double freeNs = 0.0;
+		};
+
+		double nanosecondsSince(const std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// Allocates every size, then frees them in a shuffled order, `rounds` times over.
+		template <typename Allocate, typename Free>
+		OpTimings timeRounds(const std::vector<VkDeviceSize>& sizes, const uint32_t rounds, Allocate allocate, Free free)
+		{
+			std::mt19937 rng{ 1234 };
+			std::vector<size_t> order(sizes.size());
+			double allocateNs = 0.0;
+			double freeNs = 0.0;
+			for (uint32_t round = 0; round < rounds; round++)
+			{
+				auto start = std::chrono::steady_clock::now();
+				for (size_t i = 0; i < sizes.size(); i++)
+				{
+					allocate(i, sizes[i]);
+				}
+				allocateNs += nanosecondsSince(start);
+
+				for (size_t i = 0; i < order.size(); i++)
+				{
+					order[i] = i;
+				}
+				std::shuffle(order.begin(), order.end(), rng);
+
+				start = std::chrono::steady_clock::now();
+				for (const size_t i : order)
+				{
+					free(i);
+				}
+				freeNs += nanosecondsSince(start);
+			}
+
+			const double operations = static_cast<double>(sizes.size()) * rounds;
+			return { allocateNs / operations, freeNs / operations };
+		}
+
+		void writeTimings(std::ostream& out, const char* name, const OpTimings& timings, const size_t count, const bool last)
+		{
+			out << "  \"" << name << "\": { \"allocations\": " << count
+				<< ", \"allocateNs\": " << timings.allocateNs
+				<< ", \"freeNs\": " << timings.freeNs << " }" << (last ? "\n" : ",\n");
+		}
+	}
+
+	void runAllocatorBenchmark(TrekCore& device, const uint32_t allocations, const uint32_t rounds, std::ostream& out)
+	{
+		// Sizes and memory type bits of a typical vertex buffer, so the pooled allocator picks the
+		// same memory type a TrekModel would.
+		VkBuffer probe;
+		TrekAllocation probeMemory;
+		device.createBuffer(
+			256,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			probe,
+			probeMemory);
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device.device(), probe, &requirements);
+		vkDestroyBuffer(device.device(), probe, nullptr);
+		device.getAllocator().free(probeMemory);
+
+		std::mt19937 rng{ 42 };
+		std::uniform_int_distribution<uint32_t> sizeDistribution{ 256, 256 * 1024 };
+		std::vector<VkDeviceSize> sizes(allocations);
+		for (auto& size : sizes)
+		{
+			size = (sizeDistribution(rng) + 255) & ~VkDeviceSize{ 255 };
+		}
+
+		TrekTlsfAllocator tlsf{ 1ull << 40 };
+		std::vector<uint32_t> nodes(sizes.size());
+		const OpTimings tlsfTimings = timeRounds(sizes, rounds,
+			[&](const size_t i, const VkDeviceSize size) { nodes[i] = tlsf.allocate(size, requirements.alignment).node; },
+			[&](const size_t i) { tlsf.free(nodes[i]); });
+
+		TrekMemoryAllocator& allocator = device.getAllocator();
+		const uint64_t deviceAllocationsBefore = allocator.getStats().deviceAllocations;
+		std::vector<TrekAllocation> pooled(sizes.size());
+		const OpTimings pooledTimings = timeRounds(sizes, rounds,
+			[&](const size_t i, const VkDeviceSize size)
+			{
+				VkMemoryRequirements sized = requirements;
+				sized.size = size;
+				pooled[i] = allocator.allocate(sized, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, TrekMemoryAllocator::ResourceKind::Linear);
+			},
+			[&](const size_t i) { allocator.free(pooled[i]); });
+		const uint64_t pooledDeviceAllocations = allocator.getStats().deviceAllocations - deviceAllocationsBefore;
+
+		// Raw allocations have to stay well under maxMemoryAllocationCount (4096 on many drivers).
+		const size_t rawCount = std::min<size_t>(sizes.size(), device.properties.limits.maxMemoryAllocationCount / 2);
+		const std::vector<VkDeviceSize> rawSizes(sizes.begin(), sizes.begin() + static_cast<std::ptrdiff_t>(rawCount));
+		const uint32_t memoryType = device.findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		std::vector<VkDeviceMemory> raw(rawSizes.size());
+		const OpTimings rawTimings = timeRounds(rawSizes, rounds,
+			[&](const size_t i, const VkDeviceSize size)
+			{
+				VkMemoryAllocateInfo allocInfo{};
+				allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				allocInfo.allocationSize = size;
+				allocInfo.memoryTypeIndex = memoryType;
+				if (vkAllocateMemory(device.device(), &allocInfo, nullptr, &raw[i]) != VK_SUCCESS) {
+					throw std::runtime_error("failed to allocate device memory!");
+				}
+			},
+			[&](const size_t i) { vkFreeMemory(device.device(), raw[i], nullptr); });
+
+		out << std::fixed << std::setprecision(1);
+		out << "{\n";
+		out << "  \"mode\": \"allocator\",\n";
+		out << "  \"rounds\": " << rounds << ",\n";
+		out << "  \"pooledDeviceAllocations\": " << pooledDeviceAllocations << ",\n";
+		writeTimings(out, "tlsf", tlsfTimings, sizes.size(), false);
+		writeTimings(out, "pooled", pooledTimings, sizes.size(), false);
+		writeTimings(out, "vkAllocateMemory", rawTimings, rawSizes.size(), true);
+		out << "}\n";
+	}
+}
@@ -0,0 +1,15 @@
+#ifndef TREK_BENCH_ALLOCATOR_H
+#define TREK_BENCH_ALLOCATOR_H
+#include "trek_core.h"
+
+// std
+#include <ostream>
+
+namespace Trek
+{
+	// Times allocate/free through the bare TLSF allocator, the pooled TrekMemoryAllocator and raw
+	// vkAllocateMemory for the same pseudo random buffer sizes, and writes the result as JSON.
+	void runAllocatorBenchmark(TrekCore& device, uint32_t allocations, uint32_t rounds, std::ostream& out);
+}
+
+#endif
@@ -0,0 +1,219 @@
+#include "bench_bvh.h"
+#include "bench_clock.h"
+#include "trek_bvh.h"
+#include "trek_camera.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+namespace Trek
+{
+	namespace
+	{
+		constexpr uint32_t QUERIES = 100;
+
+		struct Result {
+			uint32_t count;
+			uint32_t visible;
+			uint32_t nodes;
+			uint32_t partialRebuilds;
+			uint32_t fullBuilds;
+			double buildMs;
+			double refitMs;
+			double churnMs;
+			double frustumMs;
+			double linearFrustumMs;
+			double radiusMs;
+			double rayMs;
+			bool identical;
+		};
+
+		TrekBvh::Aabb box(const glm::vec3& center, const glm::vec3& halfSize)
+		{
+			return { center - halfSize, center + halfSize };
+		}
+
+		Result run(const uint32_t count, const uint32_t rounds, const TrekFrustum& frustum)
+		{
+			// The world grows with the count, so about as many boxes are in view in every scene.
+			const float halfWorld = 200.f * std::cbrt(count / 10000.f);
+			std::mt19937 rng{ 5 };
+			std::uniform_real_distribution<float> position{ -halfWorld, halfWorld };
+			std::uniform_real_distribution<float> size{ .1f, 5.f };
+			std::uniform_real_distribution<float> step{ -2.f, 2.f };
+			std::vector<TrekBvh::Aabb> bounds(count);
+			std::vector<glm::vec3> halfSizes(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				halfSizes[i] = glm::vec3{ size(rng), size(rng), size(rng) };
+				bounds[i] = box(glm::vec3{ position(rng), position(rng), position(rng) }, halfSizes[i]);
+			}
+
+			Result result{};
+			result.count = count;
+			TrekBvh bvh;
+			result.buildMs = fastestMs(rounds, [&]() { bvh.build(bounds); });
+
+			// The same 1% of the boxes walk a little further every round, so the tree degrades and
+			// parts of it get rebuilt.
+			std::vector<uint32_t> moving(count / 100);
+			std::uniform_int_distribution<uint32_t> pick{ 0, count - 1 };
+			for (uint32_t& item : moving)
+			{
+				item = pick(rng);
+			}
+			const uint32_t buildsBefore = bvh.getStats().fullBuilds;
+			result.refitMs = fastestMs(rounds * 4, [&]()
+			{
+				for (const uint32_t item : moving)
+				{
+					const glm::vec3 center = (bounds[item].min + bounds[item].max) * .5f + glm::vec3{ step(rng), step(rng), step(rng) };
+					bounds[item] = box(center, halfSizes[item]);
+					bvh.setBounds(item, bounds[item]);
+				}
+				bvh.refit();
+			});
+			// Another 1% leave the scene and come back somewhere else, like destroyed and created
+			// entities, without building the tree again.
+			result.churnMs = fastestMs(rounds * 4, [&]()
+			{
+				for (uint32_t item = 50; item < count; item += 100)
+				{
+					bvh.remove(item);
+				}
+				for (uint32_t item = 50; item < count; item += 100)
+				{
+					bounds[item] = box(glm::vec3{ position(rng), position(rng), position(rng) }, halfSizes[item]);
+					bvh.insert(item, bounds[item]);
+				}
+				bvh.refit();
+			});
+			result.nodes = bvh.getStats().nodes;
+			result.partialRebuilds = bvh.getStats().partialRebuilds;
+			result.fullBuilds = bvh.getStats().fullBuilds - buildsBefore;
+
+			std::vector<uint32_t> bvhVisible;
+			std::vector<uint32_t> linearVisible;
+			bvhVisible.reserve(count);
+			linearVisible.reserve(count);
+			result.frustumMs = fastestMs(rounds, [&]()
+			{
+				bvhVisible.clear();
+				bvh.queryFrustum(frustum, bvhVisible);
+			});
+			result.linearFrustumMs = fastestMs(rounds, [&]()
+			{
+				linearVisible.clear();
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (frustum.intersectsBox(bounds[i].min, bounds[i].max))
+					{
+						linearVisible.push_back(i);
+					}
+				}
+			});
+			std::sort(bvhVisible.begin(), bvhVisible.end());
+			result.visible = static_cast<uint32_t>(linearVisible.size());
+			result.identical = bvhVisible == linearVisible;
+
+			std::vector<glm::vec3> origins(QUERIES);
+			std::vector<glm::vec3> directions(QUERIES);
+			std::normal_distribution<float> normal{};
+			for (uint32_t i = 0; i < QUERIES; i++)
+			{
+				origins[i] = glm::vec3{ position(rng), position(rng), position(rng) };
+				directions[i] = glm::normalize(glm::vec3{ normal(rng), normal(rng), normal(rng) });
+			}
+			const float radius = 10.f;
+			const float rayLength = halfWorld;
+
+			std::vector<uint32_t> nearby;
+			result.radiusMs = fastestMs(rounds, [&]()
+			{
+				for (const glm::vec3& center : origins)
+				{
+					nearby.clear();
+					bvh.queryRadius(center, radius, nearby);
+				}
+			});
+			std::vector<uint32_t> hits(QUERIES);
+			std::vector<float> hitDistances(QUERIES);
+			result.rayMs = fastestMs(rounds, [&]()
+			{
+				for (uint32_t i = 0; i < QUERIES; i++)
+				{
+					hits[i] = bvh.raycast(origins[i], directions[i], rayLength, &hitDistances[i]);
+				}
+			});
+
+			for (uint32_t query = 0; query < QUERIES && result.identical; query++)
+			{
+				nearby.clear();
+				bvh.queryRadius(origins[query], radius, nearby);
+				std::sort(nearby.begin(), nearby.end());
+				std::vector<uint32_t> linearNearby;
+				float nearest = rayLength;
+				uint32_t nearestItem = TrekBvh::INVALID_INDEX;
+				const glm::vec3 inverseDirection = 1.f / directions[query];
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (TrekBvh::overlapsSphere(bounds[i], origins[query], radius))
+					{
+						linearNearby.push_back(i);
+					}
+					const float distance = TrekBvh::intersectRay(bounds[i], origins[query], inverseDirection, nearest);
+					if (distance >= 0.f && (distance < nearest || nearestItem == TrekBvh::INVALID_INDEX))
+					{
+						nearest = distance;
+						nearestItem = i;
+					}
+				}
+				// Boxes hit at exactly the same distance may come back in either order.
+				const bool sameHit = (hits[query] == TrekBvh::INVALID_INDEX) == (nearestItem == TrekBvh::INVALID_INDEX) &&
+					(nearestItem == TrekBvh::INVALID_INDEX || hitDistances[query] == nearest);
+				result.identical = nearby == linearNearby && sameHit;
+			}
+			return result;
+		}
+	}
+
+	bool runBvhBenchmark(const uint32_t rounds, std::ostream& out)
+	{
+		TrekCamera camera{};
+		camera.setPerspectiveProjection(glm::radians(50.f), 16.f / 9.f, .1f, 150.f);
+		camera.setViewTarget(glm::vec3{ 0.f }, glm::vec3{ 0.f, 0.f, 1.f });
+		const TrekFrustum frustum = TrekFrustum::fromMatrix(camera.getProjection() * camera.getView());
+
+		std::vector<Result> results;
+		bool allIdentical = true;
+		for (const uint32_t count : { 10000u, 100000u, 1000000u })
+		{
+			results.push_back(run(count, rounds, frustum));
+			allIdentical = allIdentical && results.back().identical;
+		}
+
+		out << std::fixed << std::setprecision(3);
+		out << "{\n";
+		out << "  \"mode\": \"bvh\",\n";
+		out << "  \"rounds\": " << rounds << ",\n";
+		out << "  \"queries\": " << QUERIES << ",\n";
+		out << "  \"scenes\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			out << "    { \"boxes\": " << result.count << ", \"visible\": " << result.visible << ", \"nodes\": " << result.nodes
+				<< ", \"buildMs\": " << result.buildMs << ", \"refitMs\": " << result.refitMs << ", \"churnMs\": " << result.churnMs
+				<< ", \"partialRebuilds\": " << result.partialRebuilds << ", \"fullBuilds\": " << result.fullBuilds
+				<< ", \"frustumMs\": " << result.frustumMs << ", \"linearFrustumMs\": " << result.linearFrustumMs
+				<< ", \"radiusMs\": " << result.radiusMs << ", \"rayMs\": " << result.rayMs
+				<< ", \"identical\": " << (result.identical ? "true" : "false") << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n";
+		out << "}\n";
+		return allIdentical;
+	}
+}
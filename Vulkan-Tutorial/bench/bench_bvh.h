@@ -0,0 +1,18 @@
+#ifndef TREK_BENCH_BVH_H
+#define TREK_BENCH_BVH_H
+
+// std
+#include <cstdint>
+#include <ostream>
+
+namespace Trek
+{
+	// Scatters 10k, 100k and 1M boxes at a constant density around a perspective camera and times
+	// building a TrekBvh over them, refitting it after 1% of them moved, and frustum, radius and ray
+	// queries, the frustum one next to testing every box. Keeps the fastest of `rounds` runs each.
+	// Writes the timings as JSON and returns false if a query after the refits returns other items
+	// than a linear scan.
+	bool runBvhBenchmark(uint32_t rounds, std::ostream& out);
+}
+
+#endif
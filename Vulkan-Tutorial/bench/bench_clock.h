@@ -0,0 +1,56 @@
+#ifndef TREK_BENCH_CLOCK_H
+#define TREK_BENCH_CLOCK_H
+#include "trek_utils.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace Trek
+{
+	// CPU time consumed by the calling thread in milliseconds. Unlike wall time this does not
+	// advance while the thread is blocked on a fence or in vkQueuePresentKHR.
+	inline double threadCpuTimeMs()
+	{
+#ifdef _WIN32
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime);
+		const auto toTicks = [](const FILETIME& time)
+		{
+			return (static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+		};
+		// FILETIME counts 100ns ticks.
+		return static_cast<double>(toTicks(kernelTime) + toTicks(userTime)) / 10000.0;
+#else
+		timespec time{};
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+		return static_cast<double>(time.tv_sec) * 1000.0 + static_cast<double>(time.tv_nsec) / 1000000.0;
+#endif
+	}
+
+	// Wall time of the fastest of `rounds` calls to run.
+	template <typename Run>
+	double fastestMs(const uint32_t rounds, Run run)
+	{
+		double fastest = std::numeric_limits<double>::max();
+		for (uint32_t round = 0; round < rounds; round++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			run();
+			fastest = std::min(fastest, millisecondsSince(start));
+		}
+		return fastest;
+	}
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include "bench_culling.h"
+#include "bench_clock.h"
+#include "trek_camera.h"
+#include "trek_frustum_culler.h"
+
+// std
+#include <iomanip>
+#include <random>
+#include <vector>
+
+namespace Trek
+{
+	namespace
+	{
+		struct Result {
+			uint32_t count;
+			uint32_t visible;
+			double scalarMs;
+			double vectorMs;
+			bool identical;
+		};
+
+		Result run(const uint32_t count, const uint32_t rounds, const TrekFrustum& frustum)
+		{
+			// A cube around the camera reaching past the far plane, a few percent of the spheres are in view.
+			std::mt19937 rng{ 3 };
+			std::uniform_real_distribution<float> position{ -200.f, 200.f };
+			std::uniform_real_distribution<float> size{ .1f, 5.f };
+			std::vector<float> x(count);
+			std::vector<float> y(count);
+			std::vector<float> z(count);
+			std::vector<float> radius(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				x[i] = position(rng);
+				y[i] = position(rng);
+				z[i] = position(rng);
+				radius[i] = size(rng);
+			}
+
+			Result result{ count, 0, 0.0, 0.0, true };
+			std::vector<uint32_t> scalarVisible;
+			std::vector<uint32_t> vectorVisible;
+			scalarVisible.reserve(count);
+			vectorVisible.reserve(count);
+			result.scalarMs = fastestMs(rounds, [&]()
+			{
+				scalarVisible.clear();
+				TrekFrustumCuller::cullSpheres(frustum, x.data(), y.data(), z.data(), radius.data(), count, scalarVisible, false);
+			});
+			result.vectorMs = fastestMs(rounds, [&]()
+			{
+				vectorVisible.clear();
+				TrekFrustumCuller::cullSpheres(frustum, x.data(), y.data(), z.data(), radius.data(), count, vectorVisible, true);
+			});
+			result.visible = static_cast<uint32_t>(vectorVisible.size());
+			result.identical = scalarVisible == vectorVisible;
+			return result;
+		}
+	}
+
+	bool runCullingBenchmark(const uint32_t rounds, std::ostream& out)
+	{
+		TrekCamera camera{};
+		camera.setPerspectiveProjection(glm::radians(50.f), 16.f / 9.f, .1f, 150.f);
+		camera.setViewTarget(glm::vec3{ 0.f }, glm::vec3{ 0.f, 0.f, 1.f });
+		const TrekFrustum frustum = TrekFrustum::fromMatrix(camera.getProjection() * camera.getView());
+
+		std::vector<Result> results;
+		bool allIdentical = true;
+		for (const uint32_t count : { 10000u, 100000u, 1000000u })
+		{
+			results.push_back(run(count, rounds, frustum));
+			allIdentical = allIdentical && results.back().identical;
+		}
+
+		const auto nsPerSphere = [](const double ms, const uint32_t count) { return ms * 1e6 / count; };
+		out << std::fixed << std::setprecision(3);
+		out << "{\n";
+		out << "  \"mode\": \"culling\",\n";
+		out << "  \"rounds\": " << rounds << ",\n";
+		out << "  \"scenes\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			out << "    { \"spheres\": " << result.count << ", \"visible\": " << result.visible
+				<< ", \"scalarMs\": " << result.scalarMs << ", \"vectorMs\": " << result.vectorMs
+				<< ", \"scalarNsPerSphere\": " << nsPerSphere(result.scalarMs, result.count)
+				<< ", \"vectorNsPerSphere\": " << nsPerSphere(result.vectorMs, result.count)
+				<< ", \"identical\": " << (result.identical ? "true" : "false") << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n";
+		out << "}\n";
+		return allIdentical;
+	}
+}
@@ -0,0 +1,17 @@
+#ifndef TREK_BENCH_CULLING_H
+#define TREK_BENCH_CULLING_H
+
+// std
+#include <cstdint>
+#include <ostream>
+
+namespace Trek
+{
+	// Scatters 10k, 100k and 1M bounding spheres around a perspective camera and culls them
+	// against its frustum one sphere at a time and vectorized through TrekFrustumCuller, keeping
+	// the fastest of `rounds` runs each. Writes timings and visible counts as JSON and returns false
+	// if the two visible lists differ.
+	bool runCullingBenchmark(uint32_t rounds, std::ostream& out);
+}
+
+#endif
@@ -0,0 +1,221 @@
+#include "bench_dedup.h"
+#include "trek_utils.h"
+#include "trek_vertex_welder.h"
+
+//libs
+#include "tiny_obj_loader.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace Trek
+{
+	namespace
+	{
+		constexpr uint32_t GRID_QUADS = 512;
+
+		// Attribute arrays plus one index triple per corner, like tinyobj's output.
+		struct CornerStream {
+			std::string name;
+			std::vector<float> positions;
+			std::vector<float> normals;
+			std::vector<float> texcoords;
+			std::vector<TrekIndexTriple> corners;
+		};
+
+		struct Result {
+			double ms = 0.0;
+			size_t vertexCount = 0;
+		};
+
+		TrekModel::Vertex makeVertex(const CornerStream& stream, const TrekIndexTriple& triple)
+		{
+			TrekModel::Vertex vertex{};
+			vertex.pos = { stream.positions[3 * triple.position + 0], stream.positions[3 * triple.position + 1], stream.positions[3 * triple.position + 2] };
+			vertex.color = { 1.f, 1.f, 1.f };
+			if (triple.normal >= 0)
+			{
+				vertex.normal = { stream.normals[3 * triple.normal + 0], stream.normals[3 * triple.normal + 1], stream.normals[3 * triple.normal + 2] };
+			}
+			if (triple.texcoord >= 0)
+			{
+				vertex.uv = { stream.texcoords[2 * triple.texcoord + 0], stream.texcoords[2 * triple.texcoord + 1] };
+			}
+			return vertex;
+		}
+
+		// Wavy heightfield where every grid point is shared by up to six triangles. With `soup` every
+		// corner gets its own copy of the attributes, as exporters that don't index do.
+		CornerStream makeGrid(const bool soup)
+		{
+			CornerStream stream{};
+			stream.name = soup ? "grid_soup" : "grid_indexed";
+			const uint32_t side = GRID_QUADS + 1;
+			const auto addPoint = [&stream](const uint32_t x, const uint32_t y)
+			{
+				const float u = static_cast<float>(x) / GRID_QUADS;
+				const float v = static_cast<float>(y) / GRID_QUADS;
+				const float height = .05f * std::sin(u * 20.f) * std::cos(v * 20.f);
+				stream.positions.insert(stream.positions.end(), { u - .5f, height, v - .5f });
+				stream.normals.insert(stream.normals.end(), { -height, 1.f, height });
+				stream.texcoords.insert(stream.texcoords.end(), { u, v });
+				return static_cast<int32_t>(stream.positions.size() / 3 - 1);
+			};
+
+			if (!soup)
+			{
+				for (uint32_t y = 0; y < side; y++)
+				{
+					for (uint32_t x = 0; x < side; x++)
+					{
+						addPoint(x, y);
+					}
+				}
+			}
+			for (uint32_t y = 0; y < GRID_QUADS; y++)
+			{
+				for (uint32_t x = 0; x < GRID_QUADS; x++)
+				{
+					const uint32_t quad[6][2] = { { x, y }, { x, y + 1 }, { x + 1, y }, { x + 1, y }, { x, y + 1 }, { x + 1, y + 1 } };
+					for (const auto& point : quad)
+					{
+						const int32_t index = soup ? addPoint(point[0], point[1]) : static_cast<int32_t>(point[1] * side + point[0]);
+						stream.corners.push_back({ index, index, index });
+					}
+				}
+			}
+			return stream;
+		}
+
+		CornerStream loadModel(const std::string& modelPath)
+		{
+			tinyobj::attrib_t attrib;
+			std::vector<tinyobj::shape_t> shapes;
+			std::vector<tinyobj::material_t> materials;
+			std::string err;
+			if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, modelPath.c_str()))
+			{
+				throw std::runtime_error(err);
+			}
+
+			CornerStream stream{};
+			stream.name = modelPath;
+			stream.positions = std::move(attrib.vertices);
+			stream.normals = std::move(attrib.normals);
+			stream.texcoords = std::move(attrib.texcoords);
+			for (const auto& shape : shapes)
+			{
+				for (const auto& index : shape.mesh.indices)
+				{
+					stream.corners.push_back({ index.vertex_index, index.texcoord_index, index.normal_index });
+				}
+			}
+			return stream;
+		}
+
+		template <typename Weld>
+		Result fastest(const uint32_t rounds, TrekModel::Data& data, Weld weld)
+		{
+			Result result{ std::numeric_limits<double>::max(), 0 };
+			for (uint32_t round = 0; round < rounds; round++)
+			{
+				data.vertices.clear();
+				data.indices.clear();
+				const auto start = std::chrono::steady_clock::now();
+				weld(data);
+				result.ms = std::min(result.ms, millisecondsSince(start));
+			}
+			result.vertexCount = data.vertices.size();
+			return result;
+		}
+
+		// The welding loop TrekObjLoader used before TrekVertexWelder.
+		void weldUnorderedMap(const CornerStream& stream, TrekModel::Data& data)
+		{
+			std::unordered_map<TrekModel::Vertex, uint32_t> uniqueVertices{};
+			for (const auto& corner : stream.corners)
+			{
+				const TrekModel::Vertex vertex = makeVertex(stream, corner);
+				if (uniqueVertices.count(vertex) == 0)
+				{
+					uniqueVertices[vertex] = static_cast<uint32_t>(data.vertices.size());
+					data.vertices.push_back(vertex);
+				}
+				data.indices.push_back(uniqueVertices[vertex]);
+			}
+		}
+
+		void weldFlat(const CornerStream& stream, const TrekWeldMode mode, TrekModel::Data& data)
+		{
+			TrekVertexWelder welder{ mode, TrekVertexWelder::estimateVertices(stream.corners.size()) };
+			data.indices.reserve(stream.corners.size());
+			for (const auto& corner : stream.corners)
+			{
+				data.indices.push_back(welder.weld(corner, [&]() { return makeVertex(stream, corner); }));
+			}
+			data.vertices = std::move(welder.getVertices());
+		}
+
+		bool identical(const TrekModel::Data& a, const TrekModel::Data& b)
+		{
+			return a.vertices.size() == b.vertices.size() &&
+				a.indices.size() == b.indices.size() &&
+				memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(TrekModel::Vertex)) == 0 &&
+				memcmp(a.indices.data(), b.indices.data(), a.indices.size() * sizeof(uint32_t)) == 0;
+		}
+
+		void writeResult(std::ostream& out, const char* name, const Result& result, const size_t cornerCount, const Result& baseline, const bool last)
+		{
+			out << "      \"" << name << "\": { \"ms\": " << result.ms
+				<< ", \"nsPerCorner\": " << result.ms * 1e6 / static_cast<double>(cornerCount)
+				<< ", \"speedup\": " << baseline.ms / result.ms
+				<< ", \"vertices\": " << result.vertexCount << " }" << (last ? "\n" : ",\n");
+		}
+	}
+
+	bool runDedupBenchmark(const std::string& modelPath, const uint32_t rounds, std::ostream& out)
+	{
+		std::vector<CornerStream> streams;
+		streams.push_back(makeGrid(false));
+		streams.push_back(makeGrid(true));
+		streams.push_back(loadModel(modelPath));
+
+		bool allIdentical = true;
+		out << std::fixed << std::setprecision(3);
+		out << "{\n";
+		out << "  \"mode\": \"dedup\",\n";
+		out << "  \"streams\": [\n";
+		for (size_t i = 0; i < streams.size(); i++)
+		{
+			const CornerStream& stream = streams[i];
+			TrekModel::Data reference{};
+			TrekModel::Data attributes{};
+			TrekModel::Data triples{};
+			const Result unorderedMap = fastest(rounds, reference, [&](TrekModel::Data& data) { weldUnorderedMap(stream, data); });
+			const Result flatAttributes = fastest(rounds, attributes, [&](TrekModel::Data& data) { weldFlat(stream, TrekWeldMode::Attributes, data); });
+			const Result flatTriples = fastest(rounds, triples, [&](TrekModel::Data& data) { weldFlat(stream, TrekWeldMode::IndexTriple, data); });
+			const bool same = identical(reference, attributes);
+			allIdentical = allIdentical && same;
+
+			out << "    {\n";
+			out << "      \"name\": \"" << stream.name << "\",\n";
+			out << "      \"corners\": " << stream.corners.size() << ",\n";
+			out << "      \"attributesIdentical\": " << (same ? "true" : "false") << ",\n";
+			writeResult(out, "unorderedMap", unorderedMap, stream.corners.size(), unorderedMap, false);
+			writeResult(out, "flatAttributes", flatAttributes, stream.corners.size(), unorderedMap, false);
+			writeResult(out, "flatIndexTriple", flatTriples, stream.corners.size(), unorderedMap, true);
+			out << "    }" << (i + 1 < streams.size() ? ",\n" : "\n");
+		}
+		out << "  ]\n";
+		out << "}\n";
+		return allIdentical;
+	}
+}
@@ -0,0 +1,19 @@
+#ifndef TREK_BENCH_DEDUP_H
+#define TREK_BENCH_DEDUP_H
+
+// std
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace Trek
+{
+	// Times vertex deduplication alone, without any parsing, on a generated indexed grid, the same
+	// grid as a triangle soup with every attribute duplicated per corner, and the corners of
+	// modelPath. Compares the original std::unordered_map<Vertex> welding with TrekVertexWelder in
+	// both modes, keeping the fastest of `rounds` runs each. Returns false if the flat table's
+	// attribute welding differs from the original output.
+	bool runDedupBenchmark(const std::string& modelPath, uint32_t rounds, std::ostream& out);
+}
+
+#endif
@@ -0,0 +1,328 @@
+#include "bench_entities.h"
+#include "bench_clock.h"
+#include "trek_entity_store.h"
+
+//libs
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace Trek
+{
+	namespace
+	{
+		// An object as scenes kept them before TrekEntityStore, everything in one node of the map.
+		struct MapObject {
+			TrekTransformComponent transform2d{};
+			TrekModelHandle model{};
+			glm::vec3 color{};
+		};
+		using Map = std::unordered_map<TrekEntityStore::id_t, MapObject>;
+
+		// Shared by many objects each, as scenes instance a few models.
+		constexpr uint32_t MODEL_COUNT = 16;
+		constexpr float SPIN = 0.01f;
+		// Entities per tree in the hierarchy scenes, up to 7 levels deep.
+		constexpr uint32_t TREE_SIZE = 8;
+		// Incremental world matrices against a full recompute: the kernel's vector and scalar paths
+		// differ by a few ulp, and an entity may take either.
+		constexpr float TOLERANCE = 1e-5f;
+
+		// SimpleRenderSystem's push constants.
+		struct Push {
+			glm::mat4 modelMatrix{};
+			glm::mat4 normalMatrix{};
+		};
+
+		TrekTransformComponent randomTransform(std::mt19937& rng)
+		{
+			std::uniform_real_distribution<float> position{ -100.f, 100.f };
+			std::uniform_real_distribution<float> angle{ 0.f, 6.28f };
+			std::uniform_real_distribution<float> scale{ .5f, 2.f };
+			TrekTransformComponent transform{};
+			transform.translation = { position(rng), position(rng), position(rng) };
+			transform.rotation = { angle(rng), angle(rng), angle(rng) };
+			transform.scale = glm::vec3{ scale(rng) };
+			return transform;
+		}
+
+		glm::mat4 dequantizeOf(const TrekModelHandle& model)
+		{
+			return model ? model->getDequantizeMatrix() : glm::mat4{ 1.f };
+		}
+
+		// The record pass of one object, without the Vulkan calls.
+		Push pushFor(const TrekTransformComponent& transform, const TrekModelHandle& model)
+		{
+			Push push{};
+			push.modelMatrix = transform.mat4() * dequantizeOf(model);
+			push.normalMatrix = transform.normalMatrix();
+			return push;
+		}
+
+		// Object i is scene id i in both containers, ids being handed out in the same order.
+		struct Scenes {
+			Map map;
+			std::vector<TrekEntityStore::id_t> mapIds;
+			TrekEntityStore store;
+		};
+
+		void build(const uint32_t count, const std::vector<TrekModelHandle>& models, Scenes& scenes)
+		{
+			std::mt19937 rng{ 7 };
+			scenes.map.reserve(count);
+			scenes.store.reserve(count);
+			// Map ids are never reused, like TrekGameObject ids.
+			TrekEntityStore::id_t nextMapId = 0;
+			const auto add = [&](const uint32_t index)
+			{
+				const TrekTransformComponent transform = randomTransform(rng);
+				const TrekModelHandle& model = models[index % models.size()];
+				const glm::vec3 color{ static_cast<float>(index % 255) / 255.f };
+
+				scenes.mapIds[index] = nextMapId;
+				scenes.map.emplace(nextMapId++, MapObject{ transform, model, color });
+
+				const TrekEntityStore::id_t id = scenes.store.create(transform, model, color);
+				(void)id;
+				assert(id == index && "Store ids are handed out in order");
+			};
+
+			scenes.mapIds.resize(count);
+			for (uint32_t index = 0; index < count; index++)
+			{
+				add(index);
+			}
+
+			// Churn: the map's nodes scatter over the heap, the store's arrays get reordered.
+			std::vector<uint32_t> victims(count);
+			for (uint32_t index = 0; index < count; index++)
+			{
+				victims[index] = index;
+			}
+			std::shuffle(victims.begin(), victims.end(), rng);
+			victims.resize(count / 10);
+			for (const uint32_t index : victims)
+			{
+				scenes.map.erase(scenes.mapIds[index]);
+				scenes.store.destroy(index);
+			}
+			for (auto it = victims.rbegin(); it != victims.rend(); ++it)
+			{
+				// The store reuses freed ids last in, first out.
+				add(*it);
+			}
+		}
+
+		struct Result {
+			uint32_t count;
+			double mapUpdateMs;
+			double storeUpdateMs;
+			double mapRecordMs;
+			double storeRecordMs;
+			bool identical;
+		};
+
+		Result run(const uint32_t count, const uint32_t rounds, const std::vector<TrekModelHandle>& models)
+		{
+			auto scenes = std::make_unique<Scenes>();
+			build(count, models, *scenes);
+			Result result{ count, 0.0, 0.0, 0.0, 0.0, true };
+
+			result.mapUpdateMs = fastestMs(rounds, [&]()
+			{
+				for (auto& kv : scenes->map)
+				{
+					kv.second.transform2d.rotation.y += SPIN;
+				}
+			});
+			result.storeUpdateMs = fastestMs(rounds, [&]()
+			{
+				TrekTransformComponent* transforms = scenes->store.getTransforms();
+				for (uint32_t i = 0; i < scenes->store.size(); i++)
+				{
+					transforms[i].rotation.y += SPIN;
+				}
+			});
+
+			// Written in iteration order, as a command buffer receives them, with the object they belong to.
+			std::vector<Push> mapPushes(count);
+			std::vector<uint32_t> mapOrder(count);
+			std::vector<Push> storePushes(count);
+			result.mapRecordMs = fastestMs(rounds, [&]()
+			{
+				uint32_t written = 0;
+				for (auto& kv : scenes->map)
+				{
+					mapPushes[written] = pushFor(kv.second.transform2d, kv.second.model);
+					mapOrder[written++] = kv.first;
+				}
+			});
+			result.storeRecordMs = fastestMs(rounds, [&]()
+			{
+				const TrekEntityStore& store = scenes->store;
+				const TrekTransformComponent* transforms = store.getTransforms();
+				const TrekModelHandle* storeModels = store.getModels();
+				for (uint32_t i = 0; i < scenes->store.size(); i++)
+				{
+					storePushes[i] = pushFor(transforms[i], storeModels[i]);
+				}
+			});
+
+			// Same object, same transform and push constants, whatever order the containers keep.
+			std::unordered_map<TrekEntityStore::id_t, uint32_t> indexOfMapId;
+			indexOfMapId.reserve(count);
+			for (uint32_t index = 0; index < count; index++)
+			{
+				indexOfMapId.emplace(scenes->mapIds[index], index);
+			}
+			for (uint32_t written = 0; written < count && result.identical; written++)
+			{
+				const uint32_t index = indexOfMapId.at(mapOrder[written]);
+				const TrekTransformComponent& mapTransform = scenes->map.at(mapOrder[written]).transform2d;
+				const TrekTransformComponent& storeTransform = scenes->store.transform(index);
+				const Push& storePush = storePushes[scenes->store.indexOf(index)];
+				result.identical = memcmp(&mapTransform, &storeTransform, sizeof(TrekTransformComponent)) == 0 &&
+					memcmp(&mapPushes[written], &storePush, sizeof(Push)) == 0;
+			}
+			result.identical = result.identical && scenes->map.size() == scenes->store.size();
+			return result;
+		}
+
+		struct HierarchyResult {
+			uint32_t count;
+			uint32_t moved;
+			uint32_t updated;
+			double fullMs;
+			double staticMs;
+			double movedMs;
+			float maxError;
+		};
+
+		// Trees of TREE_SIZE entities, each child under a random earlier entity of its tree.
+		HierarchyResult runHierarchy(const uint32_t count, const uint32_t rounds)
+		{
+			std::mt19937 rng{ 5 };
+			TrekEntityStore store;
+			store.reserve(count);
+			std::vector<TrekEntityStore::id_t> ids(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				ids[i] = store.create(randomTransform(rng));
+				if (i % TREE_SIZE != 0)
+				{
+					store.setParent(ids[i], ids[i - 1 - rng() % (i % TREE_SIZE)]);
+				}
+			}
+
+			HierarchyResult result{ count, count / 1000, 0, 0.0, 0.0, 0.0, 0.f };
+			result.fullMs = fastestMs(rounds, [&]()
+			{
+				store.getTransforms();
+				store.updateWorldMatrices();
+			});
+			result.staticMs = fastestMs(rounds, [&]() { store.updateWorldMatrices(); });
+
+			// A few animated objects, subtrees included.
+			std::vector<TrekEntityStore::id_t> movers(result.moved);
+			for (TrekEntityStore::id_t& mover : movers)
+			{
+				mover = ids[rng() % count];
+			}
+			result.movedMs = fastestMs(rounds, [&]()
+			{
+				for (const TrekEntityStore::id_t mover : movers)
+				{
+					store.transform(mover).rotation.y += SPIN;
+				}
+				store.updateWorldMatrices();
+			});
+			result.updated = store.getUpdatedCount();
+
+			const std::vector<glm::mat4> incremental(store.getWorldMatrices(), store.getWorldMatrices() + count);
+			store.getTransforms();
+			store.updateWorldMatrices();
+			const glm::mat4* full = store.getWorldMatrices();
+			for (uint32_t i = 0; i < count; i++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					for (int row = 0; row < 4; row++)
+					{
+						const float reference = full[i][column][row];
+						const float difference = std::abs(incremental[i][column][row] - reference);
+						result.maxError = std::max(result.maxError, difference / std::max(1.f, std::abs(reference)));
+					}
+				}
+			}
+			return result;
+		}
+	}
+
+	bool runEntityBenchmark(const uint32_t rounds, std::ostream& out)
+	{
+		// Handles to models that never finish loading: the record pass follows them like resident
+		// ones without a device.
+		std::vector<TrekModelHandle> models;
+		for (uint32_t i = 0; i < MODEL_COUNT; i++)
+		{
+			models.emplace_back(std::shared_ptr<TrekModel>{});
+		}
+
+		std::vector<Result> results;
+		bool allIdentical = true;
+		for (const uint32_t count : { 10000u, 100000u, 1000000u })
+		{
+			results.push_back(run(count, rounds, models));
+			allIdentical = allIdentical && results.back().identical;
+		}
+		std::vector<HierarchyResult> hierarchies;
+		for (const uint32_t count : { 100000u, 1000000u })
+		{
+			hierarchies.push_back(runHierarchy(count, rounds));
+			allIdentical = allIdentical && hierarchies.back().maxError <= TOLERANCE;
+		}
+
+		const auto nsPerObject = [](const double ms, const uint32_t count) { return ms * 1e6 / count; };
+		out << std::fixed << std::setprecision(3);
+		out << "{\n";
+		out << "  \"mode\": \"entities\",\n";
+		out << "  \"rounds\": " << rounds << ",\n";
+		out << "  \"scenes\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			out << "    { \"objects\": " << result.count
+				<< ", \"mapUpdateMs\": " << result.mapUpdateMs << ", \"storeUpdateMs\": " << result.storeUpdateMs
+				<< ", \"mapUpdateNsPerObject\": " << nsPerObject(result.mapUpdateMs, result.count)
+				<< ", \"storeUpdateNsPerObject\": " << nsPerObject(result.storeUpdateMs, result.count)
+				<< ", \"mapRecordMs\": " << result.mapRecordMs << ", \"storeRecordMs\": " << result.storeRecordMs
+				<< ", \"mapRecordNsPerObject\": " << nsPerObject(result.mapRecordMs, result.count)
+				<< ", \"storeRecordNsPerObject\": " << nsPerObject(result.storeRecordMs, result.count)
+				<< ", \"identical\": " << (result.identical ? "true" : "false") << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ],\n";
+		out << "  \"hierarchies\": [\n";
+		for (size_t i = 0; i < hierarchies.size(); i++)
+		{
+			const HierarchyResult& result = hierarchies[i];
+			out << "    { \"objects\": " << result.count << ", \"treeSize\": " << TREE_SIZE
+				<< ", \"fullUpdateMs\": " << result.fullMs << ", \"staticUpdateMs\": " << result.staticMs
+				<< ", \"moved\": " << result.moved << ", \"updated\": " << result.updated << ", \"movedUpdateMs\": " << result.movedMs
+				<< std::scientific << std::setprecision(2) << ", \"maxError\": " << result.maxError << std::fixed << std::setprecision(3)
+				<< " }" << (i + 1 < hierarchies.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n";
+		out << "}\n";
+		return allIdentical;
+	}
+}
@@ -0,0 +1,143 @@
+#include "bench_glb.h"
+#include "bench_clock.h"
+#include "trek_core.h"
+#include "trek_glb_file.h"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <vector>
+
+namespace Trek
+{
+	namespace
+	{
+		// What TrekUploadQueue hands a writer at most.
+		constexpr VkDeviceSize PIECE_BYTES = TrekCore::UPLOAD_STAGING_BYTES / 2;
+
+		const char* formatName(const TrekVertexFormat format)
+		{
+			switch (format)
+			{
+			case TrekVertexFormat::Packed: return "packed";
+			case TrekVertexFormat::PackedColor: return "packed-color";
+			default: return "float";
+			}
+		}
+	}
+
+	bool runGlbBenchmark(const std::string& modelPath, const uint32_t rounds, std::ostream& out)
+	{
+		std::unique_ptr<TrekGlbFile> glb{};
+		const double openMs = fastestMs(rounds, [&]() { glb = TrekGlbFile::open(modelPath); });
+
+		uint64_t vertexCount = 0;
+		uint64_t indexCount = 0;
+		for (uint32_t mesh = 0; mesh < glb->getMeshCount(); mesh++)
+		{
+			vertexCount += glb->getVertexCount(mesh);
+			indexCount += glb->getIndexCount(mesh);
+		}
+
+		struct Run {
+			TrekVertexFormat format;
+			VkDeviceSize gpuBytes;
+			double wholeMs;
+			VkDeviceSize wholePeakBytes;
+			double streamedMs;
+			VkDeviceSize streamedPeakBytes;
+			bool identical;
+		};
+		std::vector<Run> runs;
+		bool allIdentical = true;
+		for (const TrekVertexFormat format : { TrekVertexFormat::Float, TrekVertexFormat::Packed, TrekVertexFormat::PackedColor })
+		{
+			const uint32_t stride = TrekVertexLayout::stride(format);
+			Run run{ format, 0, 0.0, 0, 0.0, 0, true };
+			for (uint32_t mesh = 0; mesh < glb->getMeshCount(); mesh++)
+			{
+				const VkDeviceSize indexSize = glb->getIndexType(mesh) == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+				const VkDeviceSize bytes = static_cast<VkDeviceSize>(glb->getVertexCount(mesh)) * stride + glb->getIndexCount(mesh) * indexSize;
+				run.gpuBytes += bytes;
+				run.wholePeakBytes = std::max(run.wholePeakBytes, bytes);
+			}
+
+			// Whole arrays per mesh, as a loader building TrekModel::Data would hold them.
+			std::vector<std::vector<unsigned char>> whole(glb->getMeshCount());
+			run.wholeMs = fastestMs(rounds, [&]()
+			{
+				for (uint32_t mesh = 0; mesh < glb->getMeshCount(); mesh++)
+				{
+					const VkIndexType indexType = glb->getIndexType(mesh);
+					const size_t vertexBytes = static_cast<size_t>(glb->getVertexCount(mesh)) * stride;
+					const size_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+					whole[mesh].assign(vertexBytes + glb->getIndexCount(mesh) * indexSize, 0);
+					glb->writeVertices(mesh, format, whole[mesh].data(), 0, glb->getVertexCount(mesh));
+					glb->writeIndices(mesh, indexType, whole[mesh].data() + vertexBytes, 0, glb->getIndexCount(mesh));
+				}
+			});
+
+			// One reused window, every piece compared against the whole conversion outside the timing.
+			std::vector<unsigned char> window(static_cast<size_t>(PIECE_BYTES));
+			const auto streamAll = [&](const bool compare)
+			{
+				for (uint32_t mesh = 0; mesh < glb->getMeshCount(); mesh++)
+				{
+					const VkIndexType indexType = glb->getIndexType(mesh);
+					const uint32_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+					const uint32_t verticesPerPiece = static_cast<uint32_t>(PIECE_BYTES / stride);
+					for (uint32_t first = 0; first < glb->getVertexCount(mesh); first += verticesPerPiece)
+					{
+						const uint32_t count = std::min(verticesPerPiece, glb->getVertexCount(mesh) - first);
+						glb->writeVertices(mesh, format, window.data(), first, count);
+						run.streamedPeakBytes = std::max<VkDeviceSize>(run.streamedPeakBytes, static_cast<VkDeviceSize>(count) * stride);
+						if (compare && memcmp(window.data(), whole[mesh].data() + static_cast<size_t>(first) * stride, static_cast<size_t>(count) * stride) != 0)
+						{
+							run.identical = false;
+						}
+					}
+					const size_t vertexBytes = static_cast<size_t>(glb->getVertexCount(mesh)) * stride;
+					const uint32_t indicesPerPiece = static_cast<uint32_t>(PIECE_BYTES / indexSize);
+					for (uint32_t first = 0; first < glb->getIndexCount(mesh); first += indicesPerPiece)
+					{
+						const uint32_t count = std::min(indicesPerPiece, glb->getIndexCount(mesh) - first);
+						glb->writeIndices(mesh, indexType, window.data(), first, count);
+						run.streamedPeakBytes = std::max<VkDeviceSize>(run.streamedPeakBytes, static_cast<VkDeviceSize>(count) * indexSize);
+						if (compare && memcmp(window.data(), whole[mesh].data() + vertexBytes + static_cast<size_t>(first) * indexSize, static_cast<size_t>(count) * indexSize) != 0)
+						{
+							run.identical = false;
+						}
+					}
+				}
+			};
+			run.streamedMs = fastestMs(rounds, [&]() { streamAll(false); });
+			streamAll(true);
+			allIdentical = allIdentical && run.identical;
+			runs.push_back(run);
+		}
+
+		out << std::fixed << std::setprecision(3);
+		out << "{\n";
+		out << "  \"mode\": \"glb\",\n";
+		out << "  \"model\": \"" << modelPath << "\",\n";
+		out << "  \"fileBytes\": " << glb->getFileSize() << ",\n";
+		out << "  \"meshes\": " << glb->getMeshCount() << ",\n";
+		out << "  \"instances\": " << glb->getInstances().size() << ",\n";
+		out << "  \"vertices\": " << vertexCount << ",\n";
+		out << "  \"indices\": " << indexCount << ",\n";
+		out << "  \"openMs\": " << openMs << ",\n";
+		out << "  \"formats\": [\n";
+		for (size_t i = 0; i < runs.size(); i++)
+		{
+			const Run& run = runs[i];
+			out << "    { \"format\": \"" << formatName(run.format) << "\", \"gpuBytes\": " << run.gpuBytes
+				<< ", \"wholeMs\": " << run.wholeMs << ", \"wholePeakBytes\": " << run.wholePeakBytes
+				<< ", \"streamedMs\": " << run.streamedMs << ", \"streamedPeakBytes\": " << run.streamedPeakBytes
+				<< ", \"identical\": " << (run.identical ? "true" : "false") << " }" << (i + 1 < runs.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n";
+		out << "}\n";
+		return allIdentical;
+	}
+}
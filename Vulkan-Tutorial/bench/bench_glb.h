@@ -0,0 +1,18 @@
+#ifndef TREK_BENCH_GLB_H
+#define TREK_BENCH_GLB_H
+
+// std
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace Trek
+{
+	// Opens modelPath with TrekGlbFile and converts every mesh into each TrekVertexFormat twice:
+	// into whole arrays and a piece at a time through a window the size of an upload queue piece,
+	// the way TrekGeometryArena streams it into staging. Keeps the fastest of `rounds` runs and
+	// writes timings and peak host bytes of both as JSON. Returns false if the outputs differ.
+	bool runGlbBenchmark(const std::string& modelPath, uint32_t rounds, std::ostream& out);
+}
+
+#endif
@@ -0,0 +1,371 @@
+// trek_bench: renders a scene for a fixed number of frames with a scripted camera and a fixed
+// frame time, then reports frame time percentiles as JSON and optionally compares them against
+// a stored baseline.
+//
+//   trek_bench [--frames N] [--warmup N] [--frame-time S] [--width W] [--height H] [--windowed]
+//              [--vertex-format float|packed|packed-color]
+//              [--out report.json] [--compare baseline.json] [--threshold PCT] [--min-delta-ms MS]
+//   trek_bench --mode allocator [--allocations N] [--rounds N] [--out report.json]
+//   trek_bench --mode obj [--model file.obj] [--threads N] [--weld attributes|indices] [--rounds N] [--out report.json]
+//   trek_bench --mode dedup [--model file.obj] [--rounds N] [--out report.json]
+//   trek_bench --mode vertex-format [--model file.obj] [--out report.json]
+//   trek_bench --mode mesh-opt [--model file.obj] [--rounds N] [--out report.json]
+//   trek_bench --mode glb --model file.glb [--rounds N] [--out report.json]
+//   trek_bench --mode entities [--rounds N] [--out report.json]
+//   trek_bench --mode transforms [--rounds N] [--out report.json]
+//   trek_bench --mode culling [--rounds N] [--out report.json]
+//   trek_bench --mode bvh [--rounds N] [--out report.json]
+//
+// Exits with 2 when --compare finds a regression, the parallel OBJ loader's or flat welder's output
+// differs, the mesh optimizer is not deterministic or changes LOD 0's triangles, streamed GLB
+// conversion differs from converting whole meshes, the entity store and the game object map
+// disagree or the store's incremental world matrices drift, a vector transform kernel differs from
+// the scalar one, vectorized frustum culling keeps other spheres than the scalar test, or a BVH
+// query returns other items than a linear scan. A baseline recorded with other settings is not
+// compared, the run fails instead. Run from the Vulkan-Tutorial directory so the shaders and
+// models resolve.
+#include "bench_allocator.h"
+#include "bench_bvh.h"
+#include "bench_clock.h"
+#include "bench_culling.h"
+#include "bench_dedup.h"
+#include "bench_entities.h"
+#include "bench_glb.h"
+#include "bench_mesh_optimizer.h"
+#include "bench_obj.h"
+#include "bench_report.h"
+#include "bench_transforms.h"
+#include "bench_vertex_format.h"
+#include "scene.h"
+#include "trek_utils.h"
+
+// std
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct BenchOptions {
+		std::string mode = "frames";
+		uint32_t frames = 1000;
+		uint32_t warmupFrames = 100;
+		float frameTime = 1.f / 60.f;
+		uint32_t width = 800;
+		uint32_t height = 600;
+		bool windowed = false;
+		std::string outPath;
+		std::string baselinePath;
+		double thresholdPercent = 5.0;
+		double minDeltaMs = 0.05;
+		uint32_t allocations = 2000;
+		uint32_t rounds = 20;
+		std::string modelPath = "models/smooth_vase.obj";
+		unsigned threads = std::thread::hardware_concurrency();
+		Trek::TrekWeldMode weldMode = Trek::TrekWeldMode::Attributes;
+		Trek::TrekVertexFormat vertexFormat = Trek::TrekVertexFormat::Float;
+		std::string vertexFormatName = "float";
+	};
+
+	BenchOptions parseOptions(const int argc, char* argv[])
+	{
+		BenchOptions options{};
+		for (int i = 1; i < argc; i++)
+		{
+			const auto hasValue = [&](const char* flag)
+			{
+				return std::strcmp(argv[i], flag) == 0 && i + 1 < argc;
+			};
+
+			if (hasValue("--mode")) options.mode = argv[++i];
+			else if (hasValue("--frames")) options.frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+			else if (hasValue("--warmup")) options.warmupFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+			else if (hasValue("--frame-time")) options.frameTime = std::stof(argv[++i]);
+			else if (hasValue("--width")) options.width = static_cast<uint32_t>(std::stoul(argv[++i]));
+			else if (hasValue("--height")) options.height = static_cast<uint32_t>(std::stoul(argv[++i]));
+			else if (hasValue("--out")) options.outPath = argv[++i];
+			else if (hasValue("--compare")) options.baselinePath = argv[++i];
+			else if (hasValue("--threshold")) options.thresholdPercent = std::stod(argv[++i]);
+			else if (hasValue("--min-delta-ms")) options.minDeltaMs = std::stod(argv[++i]);
+			else if (hasValue("--allocations")) options.allocations = static_cast<uint32_t>(std::stoul(argv[++i]));
+			else if (hasValue("--rounds")) options.rounds = static_cast<uint32_t>(std::stoul(argv[++i]));
+			else if (hasValue("--model")) options.modelPath = argv[++i];
+			else if (hasValue("--threads")) options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+			else if (hasValue("--weld"))
+			{
+				const std::string weld = argv[++i];
+				if (weld == "attributes") options.weldMode = Trek::TrekWeldMode::Attributes;
+				else if (weld == "indices") options.weldMode = Trek::TrekWeldMode::IndexTriple;
+				else throw std::runtime_error("--weld must be attributes or indices");
+			}
+			else if (hasValue("--vertex-format"))
+			{
+				options.vertexFormatName = argv[++i];
+				if (!Trek::TrekVertexLayout::parse(options.vertexFormatName, options.vertexFormat))
+				{
+					throw std::runtime_error("--vertex-format must be float, packed or packed-color");
+				}
+			}
+			else if (std::strcmp(argv[i], "--windowed") == 0) options.windowed = true;
+			else throw std::runtime_error(std::string("unknown or incomplete argument ") + argv[i]);
+		}
+
+		if (options.frames == 0)
+		{
+			throw std::runtime_error("--frames must be at least 1");
+		}
+		if (options.threads == 0)
+		{
+			options.threads = 1;
+		}
+		return options;
+	}
+
+	// Writes to --out when given, stdout otherwise.
+	template <typename Write>
+	void writeOutput(const BenchOptions& options, Write write)
+	{
+		if (options.outPath.empty())
+		{
+			write(std::cout);
+			return;
+		}
+
+		std::ofstream out{ options.outPath };
+		if (!out.is_open())
+		{
+			throw std::runtime_error("failed to open " + options.outPath);
+		}
+		write(out);
+	}
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		const BenchOptions options = parseOptions(argc, argv);
+		if (options.mode == "allocator")
+		{
+			Trek::TrekCore device{};
+			writeOutput(options, [&](std::ostream& out)
+			{
+				Trek::runAllocatorBenchmark(device, options.allocations, options.rounds, out);
+			});
+			return EXIT_SUCCESS;
+		}
+		if (options.mode == "obj")
+		{
+			bool identical = true;
+			writeOutput(options, [&](std::ostream& out)
+			{
+				identical = Trek::runObjBenchmark(options.modelPath, options.threads, options.weldMode, options.rounds, out);
+			});
+			if (!identical)
+			{
+				std::cerr << "parallel OBJ loader output differs from the serial loader\n";
+				return 2;
+			}
+			return EXIT_SUCCESS;
+		}
+		if (options.mode == "dedup")
+		{
+			bool identical = true;
+			writeOutput(options, [&](std::ostream& out)
+			{
+				identical = Trek::runDedupBenchmark(options.modelPath, options.rounds, out);
+			});
+			if (!identical)
+			{
+				std::cerr << "flat attribute welding differs from the std::unordered_map welding\n";
+				return 2;
+			}
+			return EXIT_SUCCESS;
+		}
+		if (options.mode == "vertex-format")
+		{
+			writeOutput(options, [&](std::ostream& out) { Trek::runVertexFormatBenchmark(options.modelPath, out); });
+			return EXIT_SUCCESS;
+		}
+		if (options.mode == "mesh-opt")
+		{
+			bool valid = true;
+			writeOutput(options, [&](std::ostream& out)
+			{
+				valid = Trek::runMeshOptimizerBenchmark(options.modelPath, options.rounds, out);
+			});
+			if (!valid)
+			{
+				std::cerr << "mesh optimizer output is not deterministic or changed the triangles\n";
+				return 2;
+			}
+			return EXIT_SUCCESS;
+		}
+		if (options.mode == "glb")
+		{
+			bool identical = true;
+			writeOutput(options, [&](std::ostream& out)
+			{
+				identical = Trek::runGlbBenchmark(options.modelPath, options.rounds, out);
+			});
+			if (!identical)
+			{
+				std::cerr << "streamed GLB conversion differs from converting whole meshes\n";
+				return 2;
+			}
+			return EXIT_SUCCESS;
+		}
+		if (options.mode == "entities")
+		{
+			bool identical = true;
+			writeOutput(options, [&](std::ostream& out)
+			{
+				identical = Trek::runEntityBenchmark(options.rounds, out);
+			});
+			if (!identical)
+			{
+				std::cerr << "entity store results differ from the game object map\n";
+				return 2;
+			}
+			return EXIT_SUCCESS;
+		}
+		if (options.mode == "transforms")
+		{
+			bool withinTolerance = true;
+			writeOutput(options, [&](std::ostream& out)
+			{
+				withinTolerance = Trek::runTransformBenchmark(options.rounds, out);
+			});
+			if (!withinTolerance)
+			{
+				std::cerr << "vector transform kernel differs from the scalar path\n";
+				return 2;
+			}
+			return EXIT_SUCCESS;
+		}
+		if (options.mode == "culling")
+		{
+			bool identical = true;
+			writeOutput(options, [&](std::ostream& out)
+			{
+				identical = Trek::runCullingBenchmark(options.rounds, out);
+			});
+			if (!identical)
+			{
+				std::cerr << "vectorized frustum culling differs from the scalar test\n";
+				return 2;
+			}
+			return EXIT_SUCCESS;
+		}
+		if (options.mode == "bvh")
+		{
+			bool identical = true;
+			writeOutput(options, [&](std::ostream& out)
+			{
+				identical = Trek::runBvhBenchmark(options.rounds, out);
+			});
+			if (!identical)
+			{
+				std::cerr << "BVH queries differ from a linear scan\n";
+				return 2;
+			}
+			return EXIT_SUCCESS;
+		}
+		if (options.mode != "frames")
+		{
+			throw std::runtime_error("unknown --mode " + options.mode);
+		}
+
+		const std::string vertexShaderPath = Trek::DiffuseLightingScene::vertexShaderFor(options.vertexFormat);
+		const std::string fragmentShaderPath = "shaders/pointlight_diffuse_lighting_ubo_fragment.spv";
+
+		std::unique_ptr<Trek::TrekWindow> window{};
+		std::unique_ptr<Trek::TrekCore> device{};
+		std::unique_ptr<Trek::TrekAssetRegistry> assets{};
+		std::unique_ptr<Trek::Scene> scene{};
+		if (options.windowed)
+		{
+			window = std::make_unique<Trek::TrekWindow>(options.width, options.height, "trek_bench");
+			device = std::make_unique<Trek::TrekCore>(*window);
+			assets = std::make_unique<Trek::TrekAssetRegistry>(*device, options.vertexFormat);
+			scene = std::make_unique<Trek::DiffuseLightingScene>(
+				*window, *device, vertexShaderPath, fragmentShaderPath, *assets);
+		}
+		else
+		{
+			device = std::make_unique<Trek::TrekCore>();
+			assets = std::make_unique<Trek::TrekAssetRegistry>(*device, options.vertexFormat);
+			scene = std::make_unique<Trek::DiffuseLightingScene>(
+				*device, VkExtent2D{ options.width, options.height }, vertexShaderPath, fragmentShaderPath, *assets);
+		}
+
+		scene->setup();
+		// Measure the steady state, not the frames spent streaming the scene in.
+		assets->waitAll();
+		scene->setScriptedCamera(std::make_unique<Trek::ScriptedCameraController>(
+			Trek::ScriptedCameraController::orbit(glm::vec3{ 0.f, .5f, 0.f }, 2.5f, -1.f, 10.f)));
+
+		std::vector<Trek::BenchSample> samples;
+		samples.reserve(options.frames);
+		std::map<std::string, std::vector<double>> gpuScopes;
+		const Trek::TrekGpuProfiler* gpuProfiler = scene->getRenderer().getGpuProfiler();
+		for (uint32_t frame = 0; samples.size() < options.frames; frame++)
+		{
+			if (window)
+			{
+				glfwPollEvents();
+			}
+
+			const auto wallStart = std::chrono::steady_clock::now();
+			const double cpuStart = Trek::threadCpuTimeMs();
+			const bool rendered = scene->renderFrame(options.frameTime);
+			const double cpuMs = Trek::threadCpuTimeMs() - cpuStart;
+			const double wallMs = Trek::millisecondsSince(wallStart);
+
+			if (rendered && frame >= options.warmupFrames)
+			{
+				const Trek::FrameTimings& timings = scene->getFrameTimings();
+				samples.push_back({ wallMs, cpuMs, timings.updateMs, timings.recordMs, timings.submitMs, timings.presentMs });
+				// GPU results trail by MAX_FRAMES_IN_FLIGHT frames, which doesn't matter for a distribution.
+				for (const auto& scope : gpuProfiler->getResults())
+				{
+					gpuScopes[scope.name].push_back(scope.milliseconds);
+				}
+			}
+		}
+		vkDeviceWaitIdle(device->device());
+
+		const Trek::BenchReport report{
+			// compare() refuses baselines of another scene, so reports of different vertex formats are
+			// never compared with each other by accident.
+			{ options.vertexFormat == Trek::TrekVertexFormat::Float ? "diffuse_lighting" : "diffuse_lighting_" + options.vertexFormatName, options.frames, options.warmupFrames, options.frameTime,
+				options.width, options.height, !options.windowed },
+			samples,
+			gpuScopes };
+
+		writeOutput(options, [&report](std::ostream& out) { report.writeJson(out); });
+
+		if (!options.baselinePath.empty())
+		{
+			const int regressions = report.compare(options.baselinePath, options.thresholdPercent, options.minDeltaMs, std::cerr);
+			if (regressions > 0)
+			{
+				std::cerr << regressions << " metric(s) regressed against " << options.baselinePath << '\n';
+				return 2;
+			}
+		}
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
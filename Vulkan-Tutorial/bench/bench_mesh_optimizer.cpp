@@ -0,0 +1,160 @@
+#include "bench_mesh_optimizer.h"
+#include "trek_mesh_optimizer.h"
+#include "trek_utils.h"
+
+// std
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <vector>
+
+namespace Trek
+{
+	namespace
+	{
+		bool sameVertices(const std::vector<TrekModel::Vertex>& a, const std::vector<TrekModel::Vertex>& b)
+		{
+			return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(TrekModel::Vertex)) == 0);
+		}
+
+		// LOD 0's triangles as the bytes of their vertices, each rotated to start at the smallest
+		// one so the winding is kept but not the first corner. Independent of triangle and vertex order.
+		std::vector<std::array<TrekModel::Vertex, 3>> canonicalTriangles(const TrekModel::Data& data)
+		{
+			const size_t indexCount = data.lods.empty() ? data.indices.size() : data.lods[0].indexCount;
+			const auto less = [](const TrekModel::Vertex& a, const TrekModel::Vertex& b)
+			{
+				return std::memcmp(&a, &b, sizeof(TrekModel::Vertex)) < 0;
+			};
+
+			std::vector<std::array<TrekModel::Vertex, 3>> triangles(indexCount / 3);
+			for (size_t triangle = 0; triangle < triangles.size(); triangle++)
+			{
+				std::array<TrekModel::Vertex, 3>& corners = triangles[triangle];
+				for (int corner = 0; corner < 3; corner++)
+				{
+					corners[corner] = data.vertices[data.indices[3 * triangle + corner]];
+				}
+				std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end(), less), corners.end());
+			}
+			std::sort(triangles.begin(), triangles.end(), [&less](const auto& a, const auto& b)
+			{
+				return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), less);
+			});
+			return triangles;
+		}
+
+		// Fraction of the LOD's triangles whose meshlet the backface cone test rejects, averaged
+		// over the eight corner directions at twice the bounding radius.
+		float coneCulledFraction(const TrekModel::Data& data, const TrekModel::Lod& lod)
+		{
+			if (lod.meshletCount == 0 || lod.indexCount == 0)
+			{
+				return 0.f;
+			}
+			const TrekModel::Bounds bounds = data.computeBounds();
+			const glm::vec3 center = (bounds.min + bounds.max) * .5f;
+			const float distance = glm::length(bounds.max - bounds.min);
+
+			size_t culled = 0;
+			for (int corner = 0; corner < 8; corner++)
+			{
+				const glm::vec3 direction{ corner & 1 ? 1.f : -1.f, corner & 2 ? 1.f : -1.f, corner & 4 ? 1.f : -1.f };
+				const glm::vec3 camera = center + glm::normalize(direction) * distance;
+				for (uint32_t meshlet = lod.firstMeshlet; meshlet < lod.firstMeshlet + lod.meshletCount; meshlet++)
+				{
+					const TrekModel::Meshlet& cluster = data.meshlets[meshlet];
+					const glm::vec3 toCenter = cluster.center - camera;
+					if (cluster.coneCutoff < 1.f && glm::dot(toCenter, cluster.coneAxis) >= cluster.coneCutoff * glm::length(toCenter) + cluster.radius)
+					{
+						culled += cluster.indexCount;
+					}
+				}
+			}
+			return static_cast<float>(culled) / static_cast<float>(8 * lod.indexCount);
+		}
+	}
+
+	bool runMeshOptimizerBenchmark(const std::string& modelPath, const uint32_t rounds, std::ostream& out)
+	{
+		TrekModel::Data source{};
+		source.loadModel(modelPath);
+		const auto sourceTriangles = canonicalTriangles(source);
+
+		const struct {
+			const char* name;
+			uint32_t steps;
+		} configurations[] = {
+			{ "vertex-cache", TrekMeshOptimizer::VERTEX_CACHE },
+			{ "vertex-cache+overdraw", TrekMeshOptimizer::VERTEX_CACHE | TrekMeshOptimizer::OVERDRAW },
+			{ "vertex-cache+overdraw+vertex-fetch", TrekMeshOptimizer::VERTEX_CACHE | TrekMeshOptimizer::OVERDRAW | TrekMeshOptimizer::VERTEX_FETCH },
+			{ "all", TrekMeshOptimizer::ALL },
+		};
+		TrekModel::Data optimized{};
+
+		bool valid = true;
+		out << std::fixed << std::setprecision(4);
+		out << "{\n";
+		out << "  \"mode\": \"mesh-opt\",\n";
+		out << "  \"model\": \"" << modelPath << "\",\n";
+		out << "  \"vertices\": " << source.vertices.size() << ",\n";
+		out << "  \"triangles\": " << source.indices.size() / 3 << ",\n";
+		out << "  \"cacheSize\": " << TrekMeshOptimizer::CACHE_SIZE << ",\n";
+		out << "  \"steps\": [\n";
+		for (size_t i = 0; i < std::size(configurations); i++)
+		{
+			TrekModel::Data reference{};
+			TrekMeshOptimizer::Report report{};
+			double fastestMs = std::numeric_limits<double>::max();
+			bool deterministic = true;
+			for (uint32_t round = 0; round < std::max(rounds, 2u); round++)
+			{
+				TrekModel::Data data = source;
+				const auto start = std::chrono::steady_clock::now();
+				report = TrekMeshOptimizer::optimize(data, configurations[i].steps);
+				fastestMs = std::min(fastestMs, millisecondsSince(start));
+				if (round == 0)
+				{
+					reference = std::move(data);
+				}
+				else
+				{
+					deterministic = deterministic && data.indices == reference.indices && sameVertices(data.vertices, reference.vertices);
+				}
+			}
+			const bool sameTriangles = canonicalTriangles(reference) == sourceTriangles;
+			valid = valid && deterministic && sameTriangles;
+
+			out << "    { \"name\": \"" << configurations[i].name << "\""
+				<< ", \"ms\": " << fastestMs
+				<< ", \"acmrBefore\": " << report.before.acmr
+				<< ", \"acmrAfter\": " << report.after.acmr
+				<< ", \"atvrBefore\": " << report.before.atvr
+				<< ", \"atvrAfter\": " << report.after.atvr
+				<< ", \"deterministic\": " << (deterministic ? "true" : "false")
+				<< ", \"sameTriangles\": " << (sameTriangles ? "true" : "false") << " }"
+				<< (i + 1 < std::size(configurations) ? ",\n" : "\n");
+			optimized = std::move(reference);
+		}
+		out << "  ],\n";
+
+		// The chain and meshlets of the last configuration, which includes every step.
+		out << "  \"lods\": [\n";
+		for (size_t lod = 0; lod < optimized.lods.size(); lod++)
+		{
+			const TrekModel::Lod& range = optimized.lods[lod];
+			out << "    { \"triangles\": " << range.indexCount / 3
+				<< ", \"error\": " << range.error
+				<< ", \"meshlets\": " << range.meshletCount
+				<< ", \"coneCulled\": " << coneCulledFraction(optimized, range)
+				<< ", \"acmr\": " << TrekMeshOptimizer::analyzeVertexCache(optimized.indices.data() + range.firstIndex, range.indexCount, optimized.vertices.size()).acmr << " }"
+				<< (lod + 1 < optimized.lods.size() ? ",\n" : "\n");
+		}
+		out << "  ]\n";
+		out << "}\n";
+		return valid;
+	}
+}
@@ -0,0 +1,18 @@
+#ifndef TREK_BENCH_MESH_OPTIMIZER_H
+#define TREK_BENCH_MESH_OPTIMIZER_H
+
+// std
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace Trek
+{
+	// Runs TrekMeshOptimizer on modelPath with its steps added one at a time and writes the
+	// simulated ACMR and ATVR of LOD 0 before and after each, plus the fastest of `rounds` runs, and
+	// the LOD chain's triangle counts, errors, meshlet counts and backface cone culling rate as JSON. Returns false if two runs of the same
+	// steps differ or LOD 0's triangles changed.
+	bool runMeshOptimizerBenchmark(const std::string& modelPath, uint32_t rounds, std::ostream& out);
+}
+
+#endif
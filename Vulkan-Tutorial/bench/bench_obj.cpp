@@ -0,0 +1,78 @@
+#include "bench_obj.h"
+#include "bench_clock.h"
+#include "trek_obj_loader.h"
+
+// std
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+#include <vector>
+
+namespace Trek
+{
+	namespace
+	{
+		bool identical(const TrekModel::Data& a, const TrekModel::Data& b)
+		{
+			return a.vertices.size() == b.vertices.size() &&
+				a.indices.size() == b.indices.size() &&
+				memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(TrekModel::Vertex)) == 0 &&
+				memcmp(a.indices.data(), b.indices.data(), a.indices.size() * sizeof(uint32_t)) == 0;
+		}
+
+	}
+
+	bool runObjBenchmark(const std::string& modelPath, const unsigned maxThreads, const TrekWeldMode weldMode, const uint32_t rounds, std::ostream& out)
+	{
+		TrekModel::Data serial{};
+		const double serialMs = fastestMs(rounds, [&]() { TrekObjLoader::loadSerial(modelPath, serial, weldMode); });
+
+		struct Run {
+			unsigned threads;
+			double ms;
+			bool identical;
+		};
+		std::vector<unsigned> threadCounts;
+		for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+		{
+			threadCounts.push_back(threads);
+		}
+		threadCounts.push_back(maxThreads);
+
+		std::vector<Run> runs;
+		bool allIdentical = true;
+		for (const unsigned threads : threadCounts)
+		{
+			TrekModel::Data parallel{};
+			bool handled = true;
+			const double ms = fastestMs(rounds, [&]() { handled = TrekObjLoader::loadParallel(modelPath, parallel, threads, weldMode); });
+			if (!handled)
+			{
+				throw std::runtime_error(modelPath + " needs the serial loader (polygons or invalid indices)");
+			}
+			runs.push_back({ threads, ms, identical(serial, parallel) });
+			allIdentical = allIdentical && runs.back().identical;
+		}
+
+		out << std::fixed << std::setprecision(3);
+		out << "{\n";
+		out << "  \"mode\": \"obj\",\n";
+		out << "  \"model\": \"" << modelPath << "\",\n";
+		out << "  \"weld\": \"" << (weldMode == TrekWeldMode::IndexTriple ? "indices" : "attributes") << "\",\n";
+		out << "  \"vertices\": " << serial.vertices.size() << ",\n";
+		out << "  \"indices\": " << serial.indices.size() << ",\n";
+		out << "  \"serialMs\": " << serialMs << ",\n";
+		out << "  \"parallel\": [\n";
+		for (size_t i = 0; i < runs.size(); i++)
+		{
+			out << "    { \"threads\": " << runs[i].threads
+				<< ", \"ms\": " << runs[i].ms
+				<< ", \"speedup\": " << serialMs / runs[i].ms
+				<< ", \"identical\": " << (runs[i].identical ? "true" : "false") << " }"
+				<< (i + 1 < runs.size() ? ",\n" : "\n");
+		}
+		out << "  ]\n";
+		out << "}\n";
+		return allIdentical;
+	}
+}
@@ -0,0 +1,18 @@
+#ifndef TREK_BENCH_OBJ_H
+#define TREK_BENCH_OBJ_H
+
+#include "trek_vertex_welder.h"
+
+// std
+#include <ostream>
+#include <string>
+
+namespace Trek
+{
+	// Loads modelPath with the serial and the parallel OBJ loader at 1, 2, 4 ... maxThreads threads, all using weldMode,
+	// keeps the fastest of `rounds` runs each and writes the timings as JSON. Returns false if any
+	// parallel result differs from the serial one.
+	bool runObjBenchmark(const std::string& modelPath, unsigned maxThreads, TrekWeldMode weldMode, uint32_t rounds, std::ostream& out);
+}
+
+#endif
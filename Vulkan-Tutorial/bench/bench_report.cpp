@@ -0,0 +1,329 @@
+#include "bench_report.h"
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace Trek
+{
+	namespace
+	{
+		// Nearest-rank percentile on an already sorted, non-empty range.
+		double percentile(const std::vector<double>& sorted, const double p)
+		{
+			const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+			return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+		}
+
+		class JsonFlattener
+		{
+		public:
+			explicit JsonFlattener(std::string text) : text(std::move(text)) {}
+
+			FlatJson flatten()
+			{
+				parseValue("");
+				return std::move(json);
+			}
+
+		private:
+			void skipWhitespace()
+			{
+				while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+				{
+					pos++;
+				}
+			}
+
+			char peek()
+			{
+				skipWhitespace();
+				if (pos >= text.size())
+				{
+					throw std::runtime_error("unexpected end of benchmark JSON");
+				}
+				return text[pos];
+			}
+
+			void expect(const char c)
+			{
+				if (peek() != c)
+				{
+					throw std::runtime_error(std::string("malformed benchmark JSON, expected '") + c + "'");
+				}
+				pos++;
+			}
+
+			std::string parseString()
+			{
+				expect('"');
+				std::string result;
+				while (pos < text.size() && text[pos] != '"')
+				{
+					if (text[pos] == '\\' && pos + 1 < text.size())
+					{
+						pos++;
+					}
+					result += text[pos++];
+				}
+				expect('"');
+				return result;
+			}
+
+			void parseValue(const std::string& key)
+			{
+				const char c = peek();
+				if (c == '{')
+				{
+					pos++;
+					if (peek() == '}')
+					{
+						pos++;
+						return;
+					}
+					while (true)
+					{
+						const std::string member = parseString();
+						expect(':');
+						parseValue(key.empty() ? member : key + "." + member);
+						if (peek() == ',')
+						{
+							pos++;
+							continue;
+						}
+						expect('}');
+						return;
+					}
+				}
+				if (c == '[')
+				{
+					pos++;
+					if (peek() == ']')
+					{
+						pos++;
+						return;
+					}
+					for (int index = 0;; index++)
+					{
+						parseValue(key + "." + std::to_string(index));
+						if (peek() == ',')
+						{
+							pos++;
+							continue;
+						}
+						expect(']');
+						return;
+					}
+				}
+				if (c == '"')
+				{
+					json.strings[key] = parseString();
+					return;
+				}
+
+				const size_t start = pos;
+				while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && text[pos] != ']' &&
+					!std::isspace(static_cast<unsigned char>(text[pos])))
+				{
+					pos++;
+				}
+				const std::string token = text.substr(start, pos - start);
+				if (token == "true" || token == "false")
+				{
+					json.numbers[key] = token == "true" ? 1.0 : 0.0;
+					return;
+				}
+				if (token == "null")
+				{
+					return;
+				}
+				try
+				{
+					json.numbers[key] = std::stod(token);
+				}
+				catch (const std::exception&)
+				{
+					throw std::runtime_error("malformed number '" + token + "' in benchmark JSON");
+				}
+			}
+
+			std::string text;
+			size_t pos = 0;
+			FlatJson json;
+		};
+	}
+
+	BenchReport::BenchReport(
+		Settings settings,
+		const std::vector<BenchSample>& samples,
+		const std::map<std::string, std::vector<double>>& gpuScopes) :
+		settings(std::move(settings))
+	{
+		const auto collect = [&samples](double BenchSample::* member)
+		{
+			std::vector<double> values;
+			values.reserve(samples.size());
+			for (const auto& sample : samples)
+			{
+				values.push_back(sample.*member);
+			}
+			return summarize(std::move(values));
+		};
+
+		metrics.emplace_back("wall", collect(&BenchSample::wallMs));
+		metrics.emplace_back("cpu", collect(&BenchSample::cpuMs));
+		metrics.emplace_back("update", collect(&BenchSample::updateMs));
+		metrics.emplace_back("record", collect(&BenchSample::recordMs));
+		metrics.emplace_back("submit", collect(&BenchSample::submitMs));
+		metrics.emplace_back("present", collect(&BenchSample::presentMs));
+		for (const auto& [name, values] : gpuScopes)
+		{
+			metrics.emplace_back("gpu." + name, summarize(values));
+		}
+	}
+
+	MetricSummary BenchReport::summarize(std::vector<double> values)
+	{
+		MetricSummary summary{};
+		if (values.empty())
+		{
+			return summary;
+		}
+
+		std::sort(values.begin(), values.end());
+		double total = 0.0;
+		for (const double value : values)
+		{
+			total += value;
+		}
+
+		summary.mean = total / static_cast<double>(values.size());
+		summary.p50 = percentile(values, 50.0);
+		summary.p95 = percentile(values, 95.0);
+		summary.p99 = percentile(values, 99.0);
+		summary.max = values.back();
+		return summary;
+	}
+
+	void BenchReport::writeJson(std::ostream& out) const
+	{
+		out << std::fixed << std::setprecision(4);
+		out << "{\n";
+		out << "  \"scene\": \"" << settings.scene << "\",\n";
+		out << "  \"frames\": " << settings.frames << ",\n";
+		out << "  \"warmupFrames\": " << settings.warmupFrames << ",\n";
+		out << "  \"frameTime\": " << settings.frameTime << ",\n";
+		out << "  \"width\": " << settings.width << ",\n";
+		out << "  \"height\": " << settings.height << ",\n";
+		out << "  \"headless\": " << (settings.headless ? "true" : "false") << ",\n";
+		out << "  \"metrics\": {\n";
+		for (size_t i = 0; i < metrics.size(); i++)
+		{
+			const MetricSummary& summary = metrics[i].second;
+			out << "    \"" << metrics[i].first << "\": { "
+				<< "\"mean\": " << summary.mean << ", "
+				<< "\"p50\": " << summary.p50 << ", "
+				<< "\"p95\": " << summary.p95 << ", "
+				<< "\"p99\": " << summary.p99 << ", "
+				<< "\"max\": " << summary.max << " }"
+				<< (i + 1 < metrics.size() ? ",\n" : "\n");
+		}
+		out << "  }\n";
+		out << "}\n";
+	}
+
+	int BenchReport::compare(
+		const std::string& baselinePath,
+		const double thresholdPercent,
+		const double minDeltaMs,
+		std::ostream& out) const
+	{
+		const FlatJson baselineJson = readFlatJson(baselinePath);
+		const std::map<std::string, double>& baseline = baselineJson.numbers;
+
+		// Numbers of another configuration say nothing about this one. Baselines from before a
+		// setting was recorded are compared as they are.
+		std::ostringstream mismatches;
+		// The scene name also tells the vertex formats apart.
+		const auto scene = baselineJson.strings.find("scene");
+		if (scene != baselineJson.strings.end() && scene->second != settings.scene)
+		{
+			mismatches << "scene " << settings.scene << " (baseline " << scene->second << ")";
+		}
+		const auto checkSetting = [&](const char* name, const double current)
+		{
+			const auto found = baseline.find(name);
+			if (found != baseline.end() && std::fabs(found->second - current) > 1e-4)
+			{
+				mismatches << (mismatches.tellp() > 0 ? ", " : "") << name << " " << current << " (baseline " << found->second << ")";
+			}
+		};
+		checkSetting("frames", settings.frames);
+		checkSetting("warmupFrames", settings.warmupFrames);
+		checkSetting("frameTime", settings.frameTime);
+		checkSetting("width", settings.width);
+		checkSetting("height", settings.height);
+		checkSetting("headless", settings.headless ? 1.0 : 0.0);
+		if (mismatches.tellp() > 0)
+		{
+			throw std::runtime_error("not comparing against " + baselinePath + ", it was recorded with other settings: " + mismatches.str());
+		}
+
+		int regressions = 0;
+		out << std::fixed << std::setprecision(4);
+		for (const auto& [name, summary] : metrics)
+		{
+			const std::pair<const char*, double> values[] = {
+				{ "mean", summary.mean },
+				{ "p50", summary.p50 },
+				{ "p95", summary.p95 },
+				{ "p99", summary.p99 },
+				{ "max", summary.max },
+			};
+
+			for (const auto& [statistic, current] : values)
+			{
+				const auto found = baseline.find("metrics." + name + "." + statistic);
+				if (found == baseline.end())
+				{
+					continue;
+				}
+
+				const double previous = found->second;
+				const double delta = current - previous;
+				const double percent = previous > 0.0 ? delta / previous * 100.0 : 0.0;
+				// max is a single frame, too noisy to fail a run on.
+				const bool regressed = std::string(statistic) != "max" &&
+					delta >= minDeltaMs && percent > thresholdPercent;
+				regressions += regressed ? 1 : 0;
+
+				std::ostringstream label;
+				label << name << "." << statistic;
+				out << std::left << std::setw(16) << label.str()
+					<< std::right << std::setw(12) << previous << " -> " << std::setw(12) << current
+					<< " ms (" << std::showpos << std::setprecision(1) << percent << std::noshowpos
+					<< std::setprecision(4) << "%)" << (regressed ? "  REGRESSION" : "") << "\n";
+			}
+		}
+
+		return regressions;
+	}
+
+	FlatJson readFlatJson(const std::string& path)
+	{
+		std::ifstream file{ path };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open benchmark baseline " + path);
+		}
+
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		return JsonFlattener(buffer.str()).flatten();
+	}
+}
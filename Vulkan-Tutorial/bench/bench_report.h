@@ -0,0 +1,75 @@
+#ifndef TREK_BENCH_REPORT_H
+#define TREK_BENCH_REPORT_H
+
+// std
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Trek
+{
+	// One measured frame, all values in milliseconds.
+	struct BenchSample {
+		double wallMs;
+		double cpuMs;
+		double updateMs;
+		double recordMs;
+		double submitMs;
+		double presentMs;
+	};
+
+	struct MetricSummary {
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	class BenchReport
+	{
+	public:
+		struct Settings {
+			std::string scene;
+			uint32_t frames;
+			uint32_t warmupFrames;
+			float frameTime;
+			uint32_t width;
+			uint32_t height;
+			bool headless;
+		};
+
+		// gpuScopes maps a TrekGpuProfiler scope name to its per-frame GPU milliseconds.
+		BenchReport(
+			Settings settings,
+			const std::vector<BenchSample>& samples,
+			const std::map<std::string, std::vector<double>>& gpuScopes);
+
+		void writeJson(std::ostream& out) const;
+
+		// Compares against a report previously written by writeJson and prints one line per metric.
+		// A metric regresses when it is more than thresholdPercent slower and at least minDeltaMs
+		// slower, so sub-microsecond noise on tiny metrics never trips it. Returns the regression count.
+		// Throws, naming them, if the baseline was recorded with other settings.
+		int compare(const std::string& baselinePath, double thresholdPercent, double minDeltaMs, std::ostream& out) const;
+
+		static MetricSummary summarize(std::vector<double> values);
+
+	private:
+		Settings settings;
+		std::vector<std::pair<std::string, MetricSummary>> metrics;
+	};
+
+	// A JSON file's members flattened into "outer.inner.name" keys, booleans as numbers 1 or 0.
+	struct FlatJson {
+		std::map<std::string, double> numbers;
+		std::map<std::string, std::string> strings;
+	};
+
+	// Only covers what writeJson produces: objects, strings, numbers, booleans and flat arrays.
+	FlatJson readFlatJson(const std::string& path);
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "bench_transforms.h"
+#include "bench_clock.h"
+#include "trek_transform_kernel.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+namespace Trek
+{
+	namespace
+	{
+		// Not a multiple of any vector width.
+		constexpr uint32_t TRANSFORM_COUNT = (1u << 20) + 5;
+		// Relative to the element, or absolute below 1. A few ulp of sin and cos carried through two
+		// products and a scale.
+		constexpr float TOLERANCE = 1e-5f;
+
+		std::vector<TrekTransformComponent> randomTransforms()
+		{
+			std::mt19937 rng{ 11 };
+			std::uniform_real_distribution<float> position{ -100.f, 100.f };
+			// Several turns either way, as spinning objects accumulate.
+			std::uniform_real_distribution<float> angle{ -100.f, 100.f };
+			std::uniform_real_distribution<float> scale{ .1f, 10.f };
+			std::vector<TrekTransformComponent> transforms(TRANSFORM_COUNT);
+			for (uint32_t i = 0; i < TRANSFORM_COUNT; i++)
+			{
+				TrekTransformComponent& transform = transforms[i];
+				transform.translation = { position(rng), position(rng), position(rng) };
+				transform.rotation = { angle(rng), angle(rng), angle(rng) };
+				transform.scale = { scale(rng), scale(rng), scale(rng) };
+				if (i % 1000 == 0)
+				{
+					transform.rotation.y = TrekTransformKernel::MAX_VECTOR_ANGLE * 2.f;
+				}
+			}
+			return transforms;
+		}
+
+		float maxError(const std::vector<glm::mat4>& expected, const std::vector<glm::mat4>& actual)
+		{
+			float error = 0.f;
+			for (size_t i = 0; i < expected.size(); i++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					for (int row = 0; row < 4; row++)
+					{
+						const float reference = expected[i][column][row];
+						const float difference = std::abs(actual[i][column][row] - reference);
+						error = std::max(error, difference / std::max(1.f, std::abs(reference)));
+					}
+				}
+			}
+			return error;
+		}
+	}
+
+	bool runTransformBenchmark(const uint32_t rounds, std::ostream& out)
+	{
+		const std::vector<TrekTransformComponent> transforms = randomTransforms();
+
+		struct Run {
+			TrekTransformKernel::Path path;
+			double ms;
+			float modelError;
+			float normalError;
+		};
+		std::vector<Run> runs;
+		std::vector<glm::mat4> scalarModel(TRANSFORM_COUNT);
+		std::vector<glm::mat4> scalarNormal(TRANSFORM_COUNT);
+		bool withinTolerance = true;
+		for (const TrekTransformKernel::Path path : { TrekTransformKernel::Path::Scalar, TrekTransformKernel::Path::Sse2, TrekTransformKernel::Path::Avx2 })
+		{
+			if (!TrekTransformKernel::isSupported(path))
+			{
+				continue;
+			}
+			std::vector<glm::mat4> model(TRANSFORM_COUNT);
+			std::vector<glm::mat4> normal(TRANSFORM_COUNT);
+			Run run{ path, 0.0, 0.f, 0.f };
+			run.ms = fastestMs(rounds, [&]()
+			{
+				TrekTransformKernel::compute(transforms.data(), TRANSFORM_COUNT, model.data(), normal.data(), path);
+			});
+			if (path == TrekTransformKernel::Path::Scalar)
+			{
+				scalarModel = std::move(model);
+				scalarNormal = std::move(normal);
+			}
+			else
+			{
+				run.modelError = maxError(scalarModel, model);
+				run.normalError = maxError(scalarNormal, normal);
+				withinTolerance = withinTolerance && run.modelError <= TOLERANCE && run.normalError <= TOLERANCE;
+			}
+			runs.push_back(run);
+		}
+
+		out << std::fixed << std::setprecision(3);
+		out << "{\n";
+		out << "  \"mode\": \"transforms\",\n";
+		out << "  \"transforms\": " << TRANSFORM_COUNT << ",\n";
+		out << "  \"detected\": \"" << TrekTransformKernel::name(TrekTransformKernel::detect()) << "\",\n";
+		out << "  \"paths\": [\n";
+		for (size_t i = 0; i < runs.size(); i++)
+		{
+			const Run& run = runs[i];
+			out << "    { \"path\": \"" << TrekTransformKernel::name(run.path) << "\", \"ms\": " << run.ms
+				<< ", \"millionMatricesPerSecond\": " << TRANSFORM_COUNT / (run.ms * 1000.0)
+				<< ", \"speedup\": " << runs.front().ms / run.ms
+				<< std::scientific << std::setprecision(2)
+				<< ", \"maxModelError\": " << run.modelError << ", \"maxNormalError\": " << run.normalError
+				<< std::fixed << std::setprecision(3)
+				<< " }" << (i + 1 < runs.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n";
+		out << "}\n";
+		return withinTolerance;
+	}
+}
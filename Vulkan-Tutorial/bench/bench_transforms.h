@@ -0,0 +1,18 @@
+#ifndef TREK_BENCH_TRANSFORMS_H
+#define TREK_BENCH_TRANSFORMS_H
+
+// std
+#include <cstdint>
+#include <ostream>
+
+namespace Trek
+{
+	// Builds model and normal matrices of 1M pseudo random transforms on one thread with every
+	// TrekTransformKernel path this CPU supports, keeping the fastest of `rounds` runs each, and
+	// writes matrices per second and the largest difference from the scalar path as JSON. The
+	// transforms include a tail that fills no whole vector and rotations beyond MAX_VECTOR_ANGLE.
+	// Returns false if a vector path differs from the scalar one by more than float rounding.
+	bool runTransformBenchmark(uint32_t rounds, std::ostream& out);
+}
+
+#endif
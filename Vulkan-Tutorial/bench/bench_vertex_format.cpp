@@ -0,0 +1,100 @@
+#include "bench_vertex_format.h"
+#include "trek_model.h"
+#include "trek_vertex_format.h"
+
+//libs
+#include <glm/gtc/packing.hpp>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+namespace Trek
+{
+	namespace
+	{
+		struct FormatError {
+			// Relative to the largest bounds extent.
+			float maxPosition = 0.f;
+			float maxNormalDegrees = 0.f;
+			float maxUv = 0.f;
+		};
+
+		FormatError measurePacked(const TrekModel::Data& data, const TrekModel::Bounds& bounds)
+		{
+			FormatError error{};
+			const glm::mat4 dequantize = TrekVertexLayout::dequantizeMatrix(TrekVertexFormat::Packed, bounds.min, bounds.max);
+			const glm::vec3 extent = bounds.max - bounds.min;
+			const float scale = std::max({ extent.x, extent.y, extent.z, std::numeric_limits<float>::min() });
+			for (const auto& vertex : data.vertices)
+			{
+				TrekPackedVertex packed{};
+				TrekVertexLayout::quantizePosition(vertex.pos, bounds.min, bounds.max, packed.position);
+				TrekVertexLayout::encodeOctahedral(vertex.normal, packed.normal);
+				TrekVertexLayout::encodeHalf(vertex.uv, packed.uv);
+
+				// What the vertex fetch and the shader reconstruct.
+				const glm::vec3 unorm = glm::vec3{
+					static_cast<float>(packed.position[0]), static_cast<float>(packed.position[1]), static_cast<float>(packed.position[2]) } / 65535.f;
+				const glm::vec3 position = glm::vec3{ dequantize * glm::vec4{ unorm, 1.f } };
+				error.maxPosition = std::max(error.maxPosition, glm::length(position - vertex.pos) / scale);
+
+				if (glm::length(vertex.normal) > 0.f)
+				{
+					const float cosine = glm::clamp(glm::dot(glm::normalize(vertex.normal), TrekVertexLayout::decodeOctahedral(packed.normal)), -1.f, 1.f);
+					error.maxNormalDegrees = std::max(error.maxNormalDegrees, glm::degrees(std::acos(cosine)));
+				}
+
+				const glm::vec2 uv{ glm::unpackHalf1x16(packed.uv[0]), glm::unpackHalf1x16(packed.uv[1]) };
+				error.maxUv = std::max(error.maxUv, glm::length(uv - vertex.uv));
+			}
+			return error;
+		}
+	}
+
+	void runVertexFormatBenchmark(const std::string& modelPath, std::ostream& out)
+	{
+		TrekModel::Data data{};
+		data.loadModel(modelPath);
+		const TrekModel::Bounds bounds = data.computeBounds();
+		const FormatError error = measurePacked(data, bounds);
+		const bool shortIndices = data.vertices.size() < std::numeric_limits<uint16_t>::max() + 1u;
+		const size_t indexBytes = data.indices.size() * (shortIndices ? sizeof(uint16_t) : sizeof(uint32_t));
+		const size_t floatBytes = data.vertices.size() * TrekVertexLayout::stride(TrekVertexFormat::Float) + data.indices.size() * sizeof(uint32_t);
+
+		const struct {
+			const char* name;
+			TrekVertexFormat format;
+		} formats[] = {
+			{ "float", TrekVertexFormat::Float },
+			{ "packed", TrekVertexFormat::Packed },
+			{ "packed-color", TrekVertexFormat::PackedColor },
+		};
+
+		out << std::fixed << std::setprecision(6);
+		out << "{\n";
+		out << "  \"mode\": \"vertex-format\",\n";
+		out << "  \"model\": \"" << modelPath << "\",\n";
+		out << "  \"vertices\": " << data.vertices.size() << ",\n";
+		out << "  \"indices\": " << data.indices.size() << ",\n";
+		out << "  \"indexType\": \"" << (shortIndices ? "uint16" : "uint32") << "\",\n";
+		out << "  \"formats\": [\n";
+		for (size_t i = 0; i < std::size(formats); i++)
+		{
+			const size_t vertexBytes = data.vertices.size() * TrekVertexLayout::stride(formats[i].format);
+			out << "    { \"name\": \"" << formats[i].name << "\""
+				<< ", \"stride\": " << TrekVertexLayout::stride(formats[i].format)
+				<< ", \"vertexBytes\": " << vertexBytes
+				<< ", \"indexBytes\": " << indexBytes
+				<< ", \"reduction\": " << static_cast<double>(floatBytes) / static_cast<double>(vertexBytes + indexBytes) << " }"
+				<< (i + 1 < std::size(formats) ? ",\n" : "\n");
+		}
+		out << "  ],\n";
+		out << "  \"packedError\": { \"maxPositionRelative\": " << error.maxPosition
+			<< ", \"maxNormalDegrees\": " << error.maxNormalDegrees
+			<< ", \"maxUv\": " << error.maxUv << " }\n";
+		out << "}\n";
+	}
+}
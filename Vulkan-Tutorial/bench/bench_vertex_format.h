@@ -0,0 +1,15 @@
+#ifndef TREK_BENCH_VERTEX_FORMAT_H
+#define TREK_BENCH_VERTEX_FORMAT_H
+
+// std
+#include <ostream>
+#include <string>
+
+namespace Trek
+{
+	// Encodes modelPath in every TrekVertexFormat and writes vertex and index bytes next to the
+	// worst position and normal error the packing introduces, as JSON.
+	void runVertexFormatBenchmark(const std::string& modelPath, std::ostream& out);
+}
+
+#endif
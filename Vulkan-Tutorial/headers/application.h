@@ -7,9 +7,11 @@
 #include "trek_camera.h"
 #include "trek_descriptor_set.h"
 #include "scene.h"
+#include "trek_asset_registry.h"
 
 // std
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace Trek
@@ -17,7 +19,25 @@ namespace Trek
 	class Application
 	{
 	public:
+		struct Config
+		{
+			// Render without a window or swap chain, e.g. on lavapipe on a display-less box.
+			bool headless;
+			// Frames to render before run() returns. 0 renders until the window is closed.
+			uint32_t frameLimit;
+			// Chrome trace of the CPU profiler written when run() returns. Empty skips the export.
+			std::string tracePath{};
+			// Frames slower than this dump the last hitchFrames frames of CPU trace. 0 disables it.
+			double hitchBudgetMs = 0.0;
+			uint32_t hitchFrames = 120;
+			// Vertex layout of the scene's geometry, see TrekVertexFormat.
+			TrekVertexFormat vertexFormat = TrekVertexFormat::Float;
+			// Back face culling, which also enables meshlet cone culling. Open meshes lose their insides.
+			bool cullBackFaces = false;
+		};
+
 		Application();
+		explicit Application(const Config& config);
 		~Application() = default;
 		Application(const Application&) = delete;
 		Application& operator=(Application&) = delete;
@@ -27,9 +47,12 @@ namespace Trek
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
 	private:
-		TrekWindow trekWindow{WIDTH, HEIGHT, "Vulkan Tutorial!"};
-		TrekCore trekDevice{ trekWindow };
+		std::unique_ptr<TrekWindow> trekWindow{};
+		std::unique_ptr<TrekCore> trekDevice{};
+		// Outlives currentScene, so switching scenes keeps resident models.
+		std::unique_ptr<TrekAssetRegistry> assets{};
 		std::unique_ptr<Scene> currentScene{};
+		std::string tracePath;
 	};
 }
 
@@ -7,6 +7,10 @@
 #include "trek_descriptor_set.h"
 #include "simple_render_system.h"
 #include "keyboard_movement_controller.h"
+#include "scripted_camera_controller.h"
+#include "trek_frame_info.h"
+#include "trek_frustum_culler.h"
+#include "trek_asset_registry.h"
 
 // std
 #include <vector>
@@ -23,13 +27,22 @@ namespace Trek
 	class Scene
 	{
 	public:
-
 		Scene(
 			TrekWindow& trekWindow,
 			TrekCore& trekDevice,
 			std::string vertexShaderFilePath,
-			std::string fragmentShaderFilePath);
-		~Scene() = default;
+			std::string fragmentShaderFilePath,
+			TrekAssetRegistry& assets,
+			bool cullBackFaces = false);
+		// Headless scene rendering into an offscreen target of the given size.
+		Scene(
+			TrekCore& trekDevice,
+			VkExtent2D extent,
+			std::string vertexShaderFilePath,
+			std::string fragmentShaderFilePath,
+			TrekAssetRegistry& assets,
+			bool cullBackFaces = false);
+		virtual ~Scene() = default;
 
 		Scene(const Scene&) = delete;
 		Scene& operator=(Scene&) = delete;
@@ -39,25 +52,56 @@ namespace Trek
 		virtual void setup() = 0;
 		virtual void render() = 0;
 		virtual void cleanup() = 0;
+		// Updates and renders a single frame advanced by frameTime seconds. Returns false if no
+		// frame was produced, e.g. because the swap chain had to be recreated.
+		virtual bool renderFrame(float frameTime) = 0;
+
+		// Stops render() after this many frames. 0 keeps rendering until the window closes.
+		void setFrameLimit(const uint32_t frames) { frameLimit = frames; }
+		uint32_t getFramesRendered() const { return framesRendered; }
+		bool isHeadless() const { return trekWindow == nullptr; }
+		// Replaces keyboard input with a fixed camera path so runs are reproducible.
+		void setScriptedCamera(std::unique_ptr<ScriptedCameraController> controller) { scriptedCamera = std::move(controller); }
+		const FrameTimings& getFrameTimings() const { return frameTimings; }
+		// Objects drawn and culled in the last frame.
+		const TrekFrustumCuller::Stats& getCullStats() const { return culler.getStats(); }
+		TrekRenderer& getRenderer() { return trekRenderer; }
+		TrekAssetRegistry& getAssets() { return assets; }
 	protected:
-		TrekWindow& trekWindow;
+		bool shouldClose() const;
+		void updateCamera(float frameTime);
+
+		TrekWindow* trekWindow;
 		TrekCore& trekDevice;
-		TrekRenderer trekRenderer{ trekWindow, trekDevice };
-		std::vector<std::unique_ptr<TrekBuffer>> uboBuffers{ TrekSwapChain::MAX_FRAMES_IN_FLIGHT };
+		TrekRenderer trekRenderer;
+		// Outlives the scene, so the next scene reuses the models that are still resident.
+		TrekAssetRegistry& assets;
 		std::unique_ptr<TrekDescriptorSetLayout> globalDescriptorSetLayout{};
-		std::vector<VkDescriptorSet> globalDescriptorSets{ TrekSwapChain::MAX_FRAMES_IN_FLIGHT };
+		// Points at the renderer's frame allocator, GlobalUbo is selected by dynamic offset.
+		VkDescriptorSet globalDescriptorSet = VK_NULL_HANDLE;
 
 		std::unique_ptr<SimpleRenderSystem> renderSystem;
 
-		TrekGameObject::Map gameObjects;
+		TrekEntityStore gameObjects;
+		TrekFrustumCuller culler;
 		TrekCamera camera{};
 		TrekGameObject viewerObject = TrekGameObject::createGameObject();
 		KeyboardMovementController cameraController{};
+		std::unique_ptr<ScriptedCameraController> scriptedCamera{};
 		
 		std::unique_ptr<TrekDescriptorPool> globalPool{};
 
 		std::string vertexShaderPath;
 		std::string fragmentShaderPath;
+		// Vertex layout of the assets' geometry arena, vertexShaderPath has to decode it.
+		TrekVertexFormat vertexFormat;
+		bool cullBackFaces;
+
+		uint32_t frameLimit = 0;
+		uint32_t framesRendered = 0;
+		FrameTimings frameTimings{};
+	private:
+		void init();
 	};
 
 	class DiffuseLightingScene : public Scene
@@ -67,9 +111,13 @@ namespace Trek
 		using Scene::Scene;
 		~DiffuseLightingScene();
 
+		// Point light vertex shader decoding the given vertex format.
+		static std::string vertexShaderFor(TrekVertexFormat vertexFormat);
+
 		void setup() override;
 		void render() override;
 		void cleanup() override;
+		bool renderFrame(float frameTime) override;
 	};
 }
 
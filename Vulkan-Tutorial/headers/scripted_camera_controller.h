@@ -0,0 +1,36 @@
+#ifndef SCRIPTED_CAMERA_CONTROLLER_H
+#define SCRIPTED_CAMERA_CONTROLLER_H
+
+#include "trek_game_object.h"
+
+// std
+#include <vector>
+
+namespace Trek
+{
+	// Drives a game object along a looping keyframed path. Used in place of
+	// KeyboardMovementController when frames need to be reproducible, e.g. in trek_bench.
+	class ScriptedCameraController
+	{
+	public:
+		struct Keyframe {
+			float time;
+			glm::vec3 translation;
+			glm::vec3 rotation;
+		};
+
+		// Keyframes must be sorted by time. The path loops once the last keyframe is reached.
+		explicit ScriptedCameraController(std::vector<Keyframe> keyframes);
+
+		// Circles center at the given radius and height while looking at it, once per period seconds.
+		static ScriptedCameraController orbit(glm::vec3 center, float radius, float height, float period, int segments = 32);
+
+		void advance(float dt, TrekGameObject& gameObject);
+
+	private:
+		std::vector<Keyframe> keyframes;
+		float elapsed = 0.f;
+	};
+}
+
+#endif
@@ -20,7 +20,9 @@ namespace Trek
 			VkRenderPass renderPass,
 			VkDescriptorSetLayout globalSetLayout,
 			std::string vertexShader,
-			std::string fragmentShader);
+			std::string fragmentShader,
+			TrekVertexFormat vertexFormat = TrekVertexFormat::Float,
+			bool cullBackFaces = false);
 		~SimpleRenderSystem();
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(SimpleRenderSystem&) = delete;
@@ -39,6 +41,10 @@ namespace Trek
 
 		const std::string vertexShaderPath;
 		const std::string fragmentShaderPath;
+		const TrekVertexFormat vertexFormat;
+		// Drops back faces, and with them meshlets whose cone faces away from the camera. Off by
+		// default, open meshes and mirrored instances show their back faces.
+		const bool cullBackFaces;
 	};
 }
 
@@ -0,0 +1,90 @@
+#ifndef TREK_ASSET_LOADER_H
+#define TREK_ASSET_LOADER_H
+#include "trek_geometry_arena.h"
+#include "trek_glb_file.h"
+#include "trek_mesh_cache.h"
+#include "trek_model_handle.h"
+#include "trek_upload_queue.h"
+
+// std
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Trek
+{
+	// Loads models in the background. loadModel() returns a handle right away and queues the file
+	// for a worker, which runs TrekModel::importFile (cache lookup, or parse, optimize and cache
+	// write), or opens a .glb file with TrekGlbFile. update() then creates the finished models on
+	// the main thread and submits their geometry in one upload batch. Handles become drawable
+	// once that batch completes.
+	class TrekAssetLoader
+	{
+	public:
+		// New geometry update() creates per call, so a burst of finished imports is spread over
+		// several frames. A model larger than this still goes out on its own.
+		static constexpr VkDeviceSize DEFAULT_UPLOAD_BUDGET = 32 * 1024 * 1024;
+
+		// threadCount 0 uses one worker less than there are hardware threads, at least one.
+		TrekAssetLoader(TrekGeometryArena& arena, TrekUploadQueue& uploadQueue, unsigned threadCount = 0);
+		// Waits for the imports already running, drops the queued ones. Handles of models not
+		// created yet are left failed.
+		~TrekAssetLoader();
+
+		TrekAssetLoader(const TrekAssetLoader&) = delete;
+		TrekAssetLoader& operator=(const TrekAssetLoader&) = delete;
+
+		// Requesting a file that is still loading returns the pending handle. Files ending in .glb
+		// are binary glTF, mesh picks which of their meshes the model is and optimize is ignored.
+		// Other files are OBJ, with only mesh 0.
+		TrekModelHandle loadModel(const std::string& filePath, bool optimize = true, uint32_t mesh = 0);
+
+		// Main thread, once per frame. Import errors are rethrown here, for the first failed file.
+		void update(VkDeviceSize uploadBudget = DEFAULT_UPLOAD_BUDGET);
+		// Blocks until every requested model is created and its upload has completed.
+		void waitAll();
+
+		size_t getPendingCount() const { return jobs.size(); }
+
+	private:
+		struct Import {
+			std::unique_ptr<TrekMeshCache> cache{};
+			TrekModel::Data data{};
+			// Set instead of the other two for a .glb file.
+			std::unique_ptr<TrekGlbFile> glb{};
+			uint64_t contentHash = 0;
+		};
+
+		struct Job {
+			std::string filePath;
+			bool optimize;
+			uint32_t mesh;
+			TrekModelHandle handle;
+			std::future<Import> result;
+			// Taken from result once ready, until update() has the budget to create the model.
+			std::unique_ptr<Import> import;
+		};
+
+		void workerLoop();
+		VkDeviceSize geometryBytes(const Import& import, uint32_t mesh) const;
+
+		TrekGeometryArena& arena;
+		TrekUploadQueue& uploadQueue;
+
+		// Main thread only.
+		std::vector<Job> jobs;
+
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::deque<std::packaged_task<Import()>> tasks;
+		bool stopping = false;
+		std::vector<std::thread> workers;
+	};
+}
+
+#endif
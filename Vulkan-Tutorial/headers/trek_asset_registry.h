@@ -0,0 +1,120 @@
+#ifndef TREK_ASSET_REGISTRY_H
+#define TREK_ASSET_REGISTRY_H
+#include "trek_asset_loader.h"
+#include "trek_core.h"
+#include "trek_geometry_arena.h"
+#include "trek_model_handle.h"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Trek
+{
+	// Owns the geometry arena and the asset loader and shares the models loaded through them.
+	// Requests are keyed by canonical path, size and mtime, so the same file requested again,
+	// under another relative path or by the next scene, returns the model that is already
+	// resident instead of importing and uploading it twice. The loader hashes each file's bytes
+	// while importing it; an asset whose hash turns out to match one already loaded from another
+	// path, or from before a touch that left the bytes alone, is merged into that one.
+	// Assets no handle refers to stay resident until the GPU bytes of all assets exceed the
+	// budget, then the least recently used of them are evicted.
+	class TrekAssetRegistry
+	{
+	public:
+		// Geometry capacity shared by every scene: 1M vertices, 16 to 44 MiB depending on the vertex
+		// format, and 16 MiB of indices.
+		static constexpr uint32_t GEOMETRY_ARENA_VERTICES = 1u << 20;
+		static constexpr uint32_t GEOMETRY_ARENA_INDICES = 4u << 20;
+		static constexpr VkDeviceSize DEFAULT_BUDGET = 32 * 1024 * 1024;
+
+		struct AssetInfo {
+			std::string path;
+			// 0 until the import finished.
+			uint64_t contentHash;
+			// Handles outside the registry, 0 for an evictable asset.
+			long references;
+			// Vertex and index bytes in the arena, 0 while loading.
+			VkDeviceSize gpuBytes;
+			uint64_t lastUsedFrame;
+		};
+
+		struct Stats {
+			size_t assets = 0;
+			size_t loading = 0;
+			VkDeviceSize gpuBytes = 0;
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t evictions = 0;
+			// Assets found to duplicate another one's content once hashed.
+			uint64_t merges = 0;
+		};
+
+		TrekAssetRegistry(TrekCore& device, TrekVertexFormat vertexFormat, VkDeviceSize budget = DEFAULT_BUDGET);
+
+		TrekAssetRegistry(const TrekAssetRegistry&) = delete;
+		TrekAssetRegistry& operator=(const TrekAssetRegistry&) = delete;
+
+		// Only stats the file on the calling thread. A file that was edited on disk is a new asset.
+		// mesh as for TrekAssetLoader::loadModel.
+		TrekModelHandle loadModel(const std::string& filePath, bool optimize = true, uint32_t mesh = 0);
+
+		// Main thread, once per frame before recording. Creates finished models, refreshes the LRU
+		// order and evicts over budget. Evicted models are destroyed MAX_FRAMES_IN_FLIGHT updates
+		// later, once no command buffer can still draw them.
+		void update(VkDeviceSize uploadBudget = TrekAssetLoader::DEFAULT_UPLOAD_BUDGET);
+		// Blocks until every requested model is resident.
+		void waitAll();
+
+		// Takes effect on the next update().
+		void setBudget(const VkDeviceSize bytes) { budget = bytes; }
+		VkDeviceSize getBudget() const { return budget; }
+		Stats getStats() const;
+		std::vector<AssetInfo> getAssets() const;
+
+		TrekGeometryArena& getArena() { return arena; }
+		TrekAssetLoader& getLoader() { return loader; }
+
+	private:
+		struct Entry {
+			std::string path;
+			TrekModelHandle handle;
+			uint64_t contentHash = 0;
+			VkDeviceSize gpuBytes = 0;
+			uint64_t lastUsedFrame = 0;
+		};
+
+		// Canonical path, size, mtime, optimize and mesh.
+		using Key = std::tuple<std::string, uint64_t, int64_t, bool, uint32_t>;
+		// Content hash, optimize and mesh.
+		using ContentKey = std::tuple<uint64_t, bool, uint32_t>;
+
+		// Merges entries whose hash just arrived into an earlier one with the same content, sizes
+		// newly created models, marks referenced assets used this frame and evicts.
+		void refresh();
+		long referencesOf(const Entry& entry) const;
+		void evictOverBudget();
+
+		TrekGeometryArena arena;
+		// Declared after the arena and before the entries: workers are joined before models go
+		// away and models free their ranges before the arena does.
+		TrekAssetLoader loader;
+		std::map<Key, Entry> entries;
+		// Where merged entries went, and the entry holding each content. Either may name an entry
+		// evicted since, which lookups drop.
+		std::map<Key, Key> aliases;
+		std::map<ContentKey, Key> contents;
+		std::deque<std::pair<uint64_t, TrekModelHandle>> retired;
+
+		VkDeviceSize budget;
+		uint64_t frame = 0;
+		Stats stats{};
+	};
+}
+
+#endif
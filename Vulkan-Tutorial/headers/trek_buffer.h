@@ -20,7 +20,7 @@ namespace Trek
         TrekBuffer(const TrekBuffer&) = delete;
         TrekBuffer& operator=(const TrekBuffer&) = delete;
 
-        VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        VkResult map(VkDeviceSize offset = 0);
         void unmap();
 
         void writeToBuffer(const void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
@@ -41,6 +41,7 @@ namespace Trek
         VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
         VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
         VkDeviceSize getBufferSize() const { return bufferSize; }
+        const TrekAllocation& getAllocation() const { return memory; }
 
     private:
         static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
@@ -48,7 +49,7 @@ namespace Trek
         TrekCore& trekDevice;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        TrekAllocation memory{};
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
@@ -0,0 +1,135 @@
+#ifndef TREK_BVH_H
+#define TREK_BVH_H
+
+#include "trek_frustum.h"
+
+//libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Trek
+{
+	// Bounding volume hierarchy over axis aligned boxes, for queries that only touch the part of a
+	// large scene they return. Built top down with a binned surface area heuristic. Items that
+	// move are refit bottom up along their path to the root; a subtree whose box grew past
+	// rebuildRatio times its area at build time is rebuilt, so the tree's quality doesn't decay
+	// as objects drift apart. Items are indices the caller picks, such as entity ids, and come
+	// and go one at a time through insert() and remove() without rebuilding the tree.
+	class TrekBvh
+	{
+	public:
+		static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+		static constexpr uint32_t MAX_LEAF_ITEMS = 4;
+		static constexpr uint32_t SAH_BINS = 12;
+		// Below this depth splits go by count, which bounds the traversal stacks.
+		static constexpr uint32_t MAX_SAH_DEPTH = 32;
+		static constexpr uint32_t MAX_DEPTH = 64;
+
+		// An empty box, min above max, is skipped by every query until it gets bounds.
+		struct Aabb {
+			glm::vec3 min{ std::numeric_limits<float>::max() };
+			glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+			bool isEmpty() const { return min.x > max.x; }
+		};
+
+		struct Stats {
+			uint32_t items = 0;
+			uint32_t nodes = 0;
+			// Left behind by rebuilt subtrees until the next full build, with their leaves' slots.
+			uint32_t garbageNodes = 0;
+			uint32_t garbageSlots = 0;
+			uint32_t fullBuilds = 0;
+			uint32_t partialRebuilds = 0;
+		};
+
+		// Items are the indices into bounds, those with an empty box are left out.
+		void build(const std::vector<Aabb>& bounds);
+		// Into the leaf whose box grows least, splitting it when full. The boxes above it, and
+		// setBounds() of items already in the tree, take effect on the next refit().
+		void insert(uint32_t item, const Aabb& bounds);
+		void remove(uint32_t item);
+		void setBounds(uint32_t item, const Aabb& bounds);
+		// Refits the paths of the items moved since the last refit, then rebuilds the topmost
+		// degraded subtrees holding up to maxRebuildItems items in total, or the whole tree when
+		// the root degraded or half its nodes are garbage.
+		void refit(float rebuildRatio = 2.f, uint32_t maxRebuildItems = 4096);
+
+		// Append the items whose box passes TrekFrustum::intersectsBox, or overlapsSphere, in no
+		// particular order.
+		void queryFrustum(const TrekFrustum& frustum, std::vector<uint32_t>& items) const;
+		void queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& items) const;
+		// The item whose box the ray enters first within maxDistance, INVALID_INDEX if none.
+		// hitDistance is in units of direction, 0 when the origin is inside the box.
+		uint32_t raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* hitDistance = nullptr) const;
+
+		bool contains(const uint32_t item) const { return item < positions.size() && positions[item] != INVALID_INDEX; }
+		const Aabb& getBounds(const uint32_t item) const { return itemBounds[positions[item]]; }
+		const Stats& getStats() const { return stats; }
+
+		// The tests the queries apply to every item, for checking them against a linear scan.
+		static bool overlapsSphere(const Aabb& box, const glm::vec3& center, float radius);
+		// Entry distance of the ray, or a negative value if it misses within maxDistance.
+		static float intersectRay(const Aabb& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance);
+
+	private:
+		struct Node {
+			Aabb bounds{};
+			// Interior nodes have their children at left and left + 1, leaves INVALID_INDEX.
+			uint32_t left = INVALID_INDEX;
+			uint32_t parent = INVALID_INDEX;
+			// A leaf's items are items[first, first + count), and it owns MAX_LEAF_ITEMS slots
+			// from first on. Interior nodes count the items below them. While building, both are
+			// the node's range of the build arrays.
+			uint32_t first = 0;
+			uint32_t count = 0;
+			float buildArea = 0.f;
+		};
+
+		// Builds the whole tree again from the items it holds.
+		void buildAll();
+		// Builds the whole tree from the build arrays.
+		void buildTree();
+		// Below a node whose range of the build arrays is set.
+		void buildSubtree(uint32_t node, uint32_t depth);
+		// Splits a node whose bounds are already set, given the bounds of its items' centroids.
+		void buildNode(uint32_t node, uint32_t depth, const Aabb& centroids);
+		// Where to split its build range: the first item of the right half. Also returns the
+		// halves' bounds and centroid bounds.
+		uint32_t partition(uint32_t first, uint32_t count, const Aabb& centroids, uint32_t depth, Aabb childBounds[2], Aabb childCentroids[2]);
+		void swapBuildItems(uint32_t a, uint32_t b);
+		// Moves the build range into a fresh block of slots.
+		void makeLeaf(uint32_t node);
+		// Appends the items below node to the build arrays and clears the nodes below it, which
+		// become garbage.
+		void collectItems(uint32_t node);
+		Aabb computeBounds(const Node& node) const;
+		uint32_t depthOf(uint32_t node) const;
+		// Rebuilds below node, adding extraItem unless it is INVALID_INDEX.
+		void rebuildSubtree(uint32_t node, uint32_t extraItem, const Aabb& extraBounds);
+		void markChanged(uint32_t node);
+
+		std::vector<Node> nodes;
+		// Leaf slots and their boxes, and where each item sits in them, INVALID_INDEX if not in
+		// the tree.
+		std::vector<uint32_t> items;
+		std::vector<Aabb> itemBounds;
+		std::vector<uint32_t> positions;
+		std::vector<uint32_t> itemLeaves;
+		// Items of the build in progress, partitioned in place.
+		std::vector<uint32_t> buildItems;
+		std::vector<Aabb> buildBounds;
+		std::vector<glm::vec3> centers;
+		// Nodes whose box may be stale since the last refit, then the subtrees to rebuild.
+		std::vector<uint32_t> changedNodes;
+		std::vector<uint32_t> degradedNodes;
+		std::vector<uint8_t> marked;
+		Stats stats{};
+	};
+}
+
+#endif
@@ -1,13 +1,17 @@
 #ifndef TREK_CORE_H
 #define TREK_CORE_H
 #include "trek_window.h"
+#include "trek_memory_allocator.h"
 
 // std lib headers
+#include <memory>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace Trek {
 
+    class TrekUploadQueue;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
@@ -17,6 +21,9 @@ namespace Trek {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        // Family and queue used for uploads. Equal to graphicsFamily/0 on single queue devices.
+        uint32_t transferFamily;
+        uint32_t transferQueueIndex = 0;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
         bool isComplete() const { return graphicsFamilyHasValue && presentFamilyHasValue; }
@@ -24,6 +31,8 @@ namespace Trek {
 
     class TrekCore {
     public:
+        static constexpr VkDeviceSize UPLOAD_STAGING_BYTES = 32ull << 20;
+
 #ifdef NDEBUG
         const bool enableValidationLayers = false;
 #else
@@ -31,6 +40,8 @@ namespace Trek {
 #endif
 
         TrekCore(TrekWindow& window);
+        // Headless device: no window, no surface and no swap chain extension.
+        TrekCore();
         ~TrekCore();
 
         // Not copyable or movable
@@ -44,6 +55,13 @@ namespace Trek {
         VkSurfaceKHR surface() const { return surface_; }
         VkQueue graphicsQueue() const { return graphicsQueue_; }
         VkQueue presentQueue() const { return presentQueue_; }
+        // May be the graphics queue itself when the device exposes only one queue.
+        VkQueue transferQueue() const { return transferQueue_; }
+        VkPhysicalDevice getPhysicalDevice() const { return physicalDevice; }
+        TrekMemoryAllocator& getAllocator() const { return *allocator; }
+        // Batched staging uploads, see TrekUploadQueue.
+        TrekUploadQueue& getUploadQueue() const { return *uploadQueue; }
+        bool isHeadless() const { return window == nullptr; }
 
         SwapChainSupportDetails getSwapChainSupport() const { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
@@ -57,7 +75,7 @@ namespace Trek {
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory) const;
+            TrekAllocation& bufferMemory) const;
         VkCommandBuffer beginSingleTimeCommands() const;
         void endSingleTimeCommands(VkCommandBuffer commandBuffer) const;
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const;
@@ -68,11 +86,12 @@ namespace Trek {
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags memoryProperties,
             VkImage& image,
-            VkDeviceMemory& imageMemory) const;
+            TrekAllocation& imageMemory) const;
 
         VkPhysicalDeviceProperties properties;
 
     private:
+        void init();
         void createInstance();
         void setupDebugMessenger();
         void createSurface();
@@ -83,6 +102,7 @@ namespace Trek {
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device) const;
         std::vector<const char*> getRequiredExtensions() const;
+        std::vector<const char*> getRequiredDeviceExtensions() const;
         bool checkValidationLayerSupport() const;
         QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const;
         static void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
@@ -93,13 +113,16 @@ namespace Trek {
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        TrekWindow& window;
+        TrekWindow* window;
         VkCommandPool commandPool;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        std::unique_ptr<TrekMemoryAllocator> allocator;
+        std::unique_ptr<TrekUploadQueue> uploadQueue;
 
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
         const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
@@ -0,0 +1,97 @@
+#ifndef TREK_CPU_PROFILER_H
+#define TREK_CPU_PROFILER_H
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Trek
+{
+	// Always-on CPU zone profiler. Every thread writes begin/end events into its own fixed size
+	// ring buffer, so recording a zone is two clock reads and two uncontended stores, and old
+	// events are silently overwritten. Zone names must be string literals, only the pointer is kept.
+	class TrekCpuProfiler
+	{
+	public:
+		class Zone
+		{
+		public:
+			explicit Zone(const char* name) : name(name) { beginZone(name); }
+			~Zone() { endZone(name); }
+
+			Zone(const Zone&) = delete;
+			Zone& operator=(const Zone&) = delete;
+
+		private:
+			const char* name;
+		};
+
+		static constexpr uint32_t EVENTS_PER_THREAD = 1 << 16;
+
+		static void beginZone(const char* name);
+		static void endZone(const char* name);
+		// Called once per frame by the thread driving the renderer. Drives the flight recorder.
+		static void markFrame();
+		static void setThreadName(const std::string& name);
+		static void setEnabled(bool enabled);
+
+		// Dumps the last `frames` frames to flight_<frame>.json in directory whenever a frame takes
+		// longer than budgetMs. Dumps are at least `frames` frames apart so one hitch writes one file.
+		static void enableFlightRecorder(double budgetMs, uint32_t frames, const std::string& directory);
+
+		// Writes everything still in the ring buffers in Chrome trace event format, which both
+		// chrome://tracing and ui.perfetto.dev open.
+		static void exportChromeTrace(std::ostream& out);
+		static void exportChromeTrace(const std::string& path);
+
+	private:
+		enum class EventType : uint32_t { Begin, End, Frame };
+
+		struct Event {
+			std::atomic<const char*> name;
+			std::atomic<uint64_t> timestamp;
+			std::atomic<EventType> type;
+		};
+
+		struct EventCopy {
+			const char* name;
+			uint64_t timestamp;
+			EventType type;
+		};
+
+		// Single producer (the owning thread), any number of readers. Readers copy a range and
+		// then drop whatever the producer may have overwritten in the meantime.
+		struct ThreadBuffer {
+			uint32_t threadId;
+			std::string threadName;
+			std::atomic<uint64_t> head{ 0 };
+			std::unique_ptr<Event[]> events{ new Event[EVENTS_PER_THREAD] };
+
+			void push(const char* name, uint64_t timestamp, EventType type);
+			std::vector<EventCopy> snapshot(uint64_t since) const;
+		};
+
+		static ThreadBuffer& threadBuffer();
+		static uint64_t now();
+		static void writeTrace(std::ostream& out, uint64_t since);
+		static void dumpFlightRecorder(uint64_t since, uint64_t frame);
+
+		static std::atomic<bool> enabled;
+		static std::mutex registryMutex;
+		static std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+		// Flight recorder state, only touched by the thread calling markFrame.
+		static double frameBudgetMs;
+		static std::vector<uint64_t> frameStarts;
+		static uint64_t frameCount;
+		static uint64_t lastDumpFrame;
+		static std::string flightRecorderDirectory;
+	};
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef TREK_ENTITY_STORE_H
+#define TREK_ENTITY_STORE_H
+
+#include "trek_game_object.h"
+#include "trek_model_handle.h"
+
+//lib
+#include <glm/glm.hpp>
+
+// std
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Trek
+{
+	// The objects of a scene as parallel component arrays: the entity at dense index i has
+	// getIds()[i], getTransforms()[i], getColors()[i], getModels()[i] and getLods()[i]. Systems walk
+	// the arrays front to back instead of chasing hash map nodes, and a pass only pulls in the
+	// components it reads. Destroying an entity moves the last one into its slot, so dense indices
+	// are only stable until the next destroy. Ids stay valid until their entity is destroyed and
+	// are reused afterwards.
+	//
+	// Transforms are local to the entity's parent, if it has one. updateWorldMatrices() keeps the
+	// dense arrays sorted by depth, parents before their children, and recomputes the world
+	// matrices of entities whose transform changed and of everything below them, nothing else.
+	class TrekEntityStore
+	{
+	public:
+		using id_t = TrekGameObject::id_t;
+		static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+		static constexpr id_t INVALID_ID = std::numeric_limits<id_t>::max();
+
+		TrekEntityStore() = default;
+		TrekEntityStore(const TrekEntityStore&) = delete;
+		TrekEntityStore& operator=(const TrekEntityStore&) = delete;
+		TrekEntityStore(TrekEntityStore&&) = default;
+		TrekEntityStore& operator=(TrekEntityStore&&) = default;
+
+		id_t create(const TrekTransformComponent& transform = {}, TrekModelHandle model = {}, const glm::vec3& color = {});
+		// Children of the entity move up to its parent, keeping their local transforms.
+		void destroy(id_t id);
+		void clear();
+		void reserve(size_t count);
+
+		// INVALID_ID makes the entity a root. The parent must not be the entity or below it.
+		void setParent(id_t id, id_t parent);
+		id_t getParent(const id_t id) const { return parents[indexOf(id)]; }
+
+		bool contains(const id_t id) const { return id < sparse.size() && sparse[id] != INVALID_INDEX; }
+		uint32_t indexOf(const id_t id) const
+		{
+			assert(contains(id) && "Entity does not exist");
+			return sparse[id];
+		}
+		uint32_t size() const { return static_cast<uint32_t>(ids.size()); }
+		bool empty() const { return ids.empty(); }
+		// Every id is below this, for arrays indexed by id.
+		uint32_t getIdCapacity() const { return static_cast<uint32_t>(sparse.size()); }
+
+		// Dense component arrays, size() entries each.
+		const id_t* getIds() const { return ids.data(); }
+		const TrekTransformComponent* getTransforms() const { return transforms.data(); }
+		// For animating many entities at once, marks all of them dirty.
+		TrekTransformComponent* getTransforms();
+		glm::vec3* getColors() { return colors.data(); }
+		const glm::vec3* getColors() const { return colors.data(); }
+		const TrekModelHandle* getModels() const { return models.data(); }
+		// LOD each model was last drawn with, the starting point for TrekModel::selectLod's hysteresis.
+		uint32_t* getLods() { return lods.data(); }
+		const uint32_t* getLods() const { return lods.data(); }
+
+		// As of the last updateWorldMatrices(). Normal matrices widened to a mat4, the push constant layout.
+		const glm::mat4* getWorldMatrices() const { return worldMatrices.data(); }
+		const glm::mat4* getNormalMatrices() const { return normalMatrices.data(); }
+
+		// Components of a single entity by id. transform() marks the entity dirty.
+		TrekTransformComponent& transform(const id_t id) { return transforms[markDirty(indexOf(id))]; }
+		glm::vec3& color(const id_t id) { return colors[indexOf(id)]; }
+		const TrekModelHandle& model(const id_t id) const { return models[indexOf(id)]; }
+		// Models only change through here, so caches keyed by id can follow getChangedIds().
+		void setModel(id_t id, TrekModelHandle model);
+
+		// Once per frame before the world matrices are read. Free when nothing moved.
+		void updateWorldMatrices();
+		// Entities whose world matrix the last update recomputed, and their dense indices in
+		// ascending order.
+		uint32_t getUpdatedCount() const { return static_cast<uint32_t>(updateIndices.size()); }
+		const std::vector<uint32_t>& getUpdatedIndices() const { return updateIndices; }
+		// Ids created, destroyed or given another model before the last update, possibly more
+		// than once. Those destroyed may have been created again since.
+		const std::vector<id_t>& getChangedIds() const { return changedIds; }
+
+	private:
+		uint32_t markDirty(uint32_t index);
+		// Stable, so entities of equal depth keep their order.
+		void sortByDepth();
+		void refreshParentIndices();
+
+		// Dense index to id and id to dense index, INVALID_INDEX for ids that are free.
+		std::vector<id_t> ids;
+		std::vector<uint32_t> sparse;
+		std::vector<id_t> freeIds;
+
+		std::vector<TrekTransformComponent> transforms;
+		std::vector<glm::vec3> colors;
+		std::vector<TrekModelHandle> models;
+		std::vector<uint32_t> lods;
+		std::vector<id_t> parents;
+		// Dense index of the parent, INVALID_INDEX for roots. Rebuilt from parents when stale.
+		std::vector<uint32_t> parentIndices;
+		std::vector<uint32_t> childCounts;
+		std::vector<glm::mat4> worldMatrices;
+		std::vector<glm::mat4> normalMatrices;
+		std::vector<uint8_t> dirty;
+
+		// Dirty flags are all clear below firstDirty.
+		uint32_t firstDirty = INVALID_INDEX;
+		// A parent ended up after one of its children.
+		bool unsorted = false;
+		// An entity with children moved.
+		bool parentIndicesStale = false;
+
+		// Entities the last updateWorldMatrices() recomputed.
+		std::vector<uint32_t> updateIndices;
+		std::vector<id_t> changedIds;
+		// Ids changed since the last update.
+		std::vector<id_t> pendingChangedIds;
+		// Scratch of updateWorldMatrices(), kept to avoid allocating every frame.
+		std::vector<TrekTransformComponent> updateTransforms;
+		std::vector<glm::mat4> localMatrices;
+		std::vector<glm::mat4> localNormalMatrices;
+	};
+}
+
+#endif
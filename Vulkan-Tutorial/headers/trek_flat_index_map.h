@@ -0,0 +1,100 @@
+#ifndef TREK_FLAT_INDEX_MAP_H
+#define TREK_FLAT_INDEX_MAP_H
+
+// std
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Trek
+{
+	// Open addressing hash table from Key to a uint32_t index, for deduplication loops that do one
+	// find-or-insert per element. Slots live in one flat array probed linearly, so a lookup is a
+	// hash, a mask and usually a single cache line. No erase.
+	template <typename Key, typename Hash, typename Equal = std::equal_to<Key>>
+	class TrekFlatIndexMap
+	{
+	public:
+		explicit TrekFlatIndexMap(const size_t expectedSize = 0)
+		{
+			reserve(expectedSize);
+		}
+
+		// Sizes the table so expectedSize keys fit without growing.
+		void reserve(const size_t expectedSize)
+		{
+			size_t capacity = 16;
+			while (capacity * MAX_LOAD_NUMERATOR < expectedSize * MAX_LOAD_DENOMINATOR)
+			{
+				capacity *= 2;
+			}
+			if (capacity > slots.size())
+			{
+				rehash(capacity);
+			}
+		}
+
+		// Returns the index stored for key and false, or stores index and returns it with true.
+		std::pair<uint32_t, bool> tryEmplace(const Key& key, const uint32_t index)
+		{
+			if ((count + 1) * MAX_LOAD_DENOMINATOR > slots.size() * MAX_LOAD_NUMERATOR)
+			{
+				rehash(slots.size() * 2);
+			}
+
+			size_t slot = Hash{}(key) & mask;
+			while (slots[slot].index != EMPTY)
+			{
+				if (Equal{}(slots[slot].key, key))
+				{
+					return { slots[slot].index, false };
+				}
+				slot = (slot + 1) & mask;
+			}
+			slots[slot].key = key;
+			slots[slot].index = index;
+			count++;
+			return { index, true };
+		}
+
+		size_t size() const { return count; }
+
+	private:
+		static constexpr uint32_t EMPTY = ~0u;
+		// Grow past 70% occupancy.
+		static constexpr size_t MAX_LOAD_NUMERATOR = 7;
+		static constexpr size_t MAX_LOAD_DENOMINATOR = 10;
+
+		struct Slot {
+			Key key;
+			uint32_t index = EMPTY;
+		};
+
+		void rehash(const size_t capacity)
+		{
+			std::vector<Slot> previous(capacity);
+			previous.swap(slots);
+			mask = capacity - 1;
+			for (const Slot& old : previous)
+			{
+				if (old.index == EMPTY)
+				{
+					continue;
+				}
+				size_t slot = Hash{}(old.key) & mask;
+				while (slots[slot].index != EMPTY)
+				{
+					slot = (slot + 1) & mask;
+				}
+				slots[slot] = old;
+			}
+		}
+
+		std::vector<Slot> slots;
+		size_t mask = 0;
+		size_t count = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef TREK_FRAME_ALLOCATOR_H
+#define TREK_FRAME_ALLOCATOR_H
+#include "trek_core.h"
+#include "trek_buffer.h"
+
+// std
+#include <cstring>
+#include <memory>
+
+namespace Trek
+{
+	// Bump allocator for data that only lives for one frame: uniforms, per-draw constants, small
+	// storage buffers. One persistently mapped buffer is split into a region per frame in flight.
+	// A region is reset by beginFrame once that frame's fence has signalled, and everything written
+	// into it is flushed with a single vkFlushMappedMemoryRanges. Shaders see the data through
+	// UNIFORM_BUFFER_DYNAMIC / STORAGE_BUFFER_DYNAMIC descriptors that point at the whole buffer,
+	// so one descriptor set serves every frame and allocations are selected by dynamic offset.
+	class TrekFrameAllocator
+	{
+	public:
+		struct Slice {
+			void* data = nullptr;
+			// Offset from the start of the buffer, passed as the dynamic offset when binding.
+			uint32_t offset = 0;
+			VkDeviceSize size = 0;
+		};
+
+		TrekFrameAllocator(TrekCore& device, uint32_t framesInFlight, VkDeviceSize bytesPerFrame);
+
+		TrekFrameAllocator(const TrekFrameAllocator&) = delete;
+		TrekFrameAllocator& operator=(const TrekFrameAllocator&) = delete;
+
+		// Called by TrekRenderer after the frame's fence wait, discards everything allocated for frameIndex.
+		void beginFrame(int frameIndex);
+		// Makes this frame's allocations visible to the device. No-op on coherent memory.
+		void flush();
+
+		// Aligned to the larger of the uniform and storage buffer offset alignments.
+		Slice allocate(VkDeviceSize size);
+		template <typename T>
+		uint32_t push(const T& value)
+		{
+			const Slice slice = allocate(sizeof(T));
+			memcpy(slice.data, &value, sizeof(T));
+			return slice.offset;
+		}
+
+		// Descriptor for a dynamic binding that reads range bytes at each dynamic offset.
+		VkDescriptorBufferInfo descriptorInfo(VkDeviceSize range) const;
+		VkBuffer getBuffer() const { return buffer->getBuffer(); }
+		VkDeviceSize getBytesPerFrame() const { return bytesPerFrame; }
+		// Bytes allocated in the current frame so far.
+		VkDeviceSize getUsedBytes() const { return head - frameStart; }
+
+	private:
+		TrekCore& trekDevice;
+		std::unique_ptr<TrekBuffer> buffer;
+		VkDeviceSize bytesPerFrame;
+		VkDeviceSize alignment;
+		bool coherent;
+
+		VkDeviceSize frameStart = 0;
+		VkDeviceSize head = 0;
+	};
+}
+
+#endif
@@ -2,11 +2,17 @@
 #define TREK_FRAME_INFO
 
 #include "trek_camera.h"
-#include "trek_game_object.h"
+#include "trek_entity_store.h"
+#include "trek_gpu_profiler.h"
+#include "trek_frame_allocator.h"
 
 //lib
 #include <vulkan/vulkan.h>
 
+// std
+#include <cstdint>
+#include <vector>
+
 namespace Trek
 {
 	struct FrameInfo {
@@ -15,7 +21,24 @@ namespace Trek
 		VkCommandBuffer commandBuffer;
 		TrekCamera& camera;
 		VkDescriptorSet globalDescriptorSet;
-		TrekGameObject::Map& gameObjects;
+		// Dynamic offset of this frame's GlobalUbo inside the frame allocator's buffer.
+		uint32_t globalUboOffset;
+		TrekEntityStore& gameObjects;
+		TrekGpuProfiler* gpuProfiler = nullptr;
+		TrekFrameAllocator* frameAllocator = nullptr;
+		// Size of the render target, for screen space decisions such as LOD selection.
+		VkExtent2D extent{};
+		// Dense indices of the game objects to draw, every object when null.
+		const std::vector<uint32_t>* visibleObjects = nullptr;
+	};
+
+	// CPU-side breakdown of the last frame in milliseconds. The scene fills in update and record,
+	// the renderer fills in submit and present (which includes waiting for the next image).
+	struct FrameTimings {
+		double updateMs = 0.0;
+		double recordMs = 0.0;
+		double submitMs = 0.0;
+		double presentMs = 0.0;
 	};
 }
 
@@ -0,0 +1,31 @@
+#ifndef TREK_FRUSTUM_H
+#define TREK_FRUSTUM_H
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORECE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+namespace Trek
+{
+	// The six planes of a view frustum with normals pointing inside, for the engine's 0 to 1
+	// depth range.
+	struct TrekFrustum
+	{
+		enum Plane { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+		// Gribb and Hartmann: the planes of the space a projection * view matrix clips to, in the
+		// space it transforms from.
+		static TrekFrustum fromMatrix(const glm::mat4& projectionView);
+
+		// Conservative: spheres straddling two planes outside a corner still count as visible.
+		bool intersectsSphere(const glm::vec3& center, float radius) const;
+		// Tests the box corner furthest along each normal, conservative the same way.
+		bool intersectsBox(const glm::vec3& min, const glm::vec3& max) const;
+
+		// xyz is the unit normal, w the offset: dot(xyz, p) + w >= 0 inside.
+		glm::vec4 planes[PLANE_COUNT];
+	};
+}
+
+#endif
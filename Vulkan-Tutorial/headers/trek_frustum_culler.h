@@ -0,0 +1,85 @@
+#ifndef TREK_FRUSTUM_CULLER_H
+#define TREK_FRUSTUM_CULLER_H
+
+#include "trek_bvh.h"
+#include "trek_entity_store.h"
+#include "trek_frustum.h"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace Trek
+{
+	// Per frame list of the game objects inside the view frustum. Each resident model's bounding
+	// sphere is moved to world space, then the spheres are tested against the six planes as
+	// structure of arrays, four per SSE2 instruction where available.
+	//
+	// From BVH_MIN_OBJECTS objects on, a TrekBvh over the objects' world boxes is queried instead,
+	// so the cost follows what is visible rather than the size of the scene. Each frame only the
+	// objects the store updated get new boxes, and those it created, destroyed or gave another
+	// model are inserted into or removed from the tree, as are loading models once resident.
+	// Boxes are tighter than spheres, so the two paths can disagree about objects at the edges of
+	// the frustum.
+	class TrekFrustumCuller
+	{
+	public:
+		static constexpr uint32_t BVH_MIN_OBJECTS = 16384;
+
+		struct Stats {
+			// Objects with a resident model that passed or failed the test. Objects still loading
+			// count as neither.
+			uint32_t visible = 0;
+			uint32_t culled = 0;
+		};
+
+		// After objects.updateWorldMatrices(), fills getVisible() with the dense indices of the
+		// objects to draw, in dense order.
+		void cull(const TrekEntityStore& objects, const TrekFrustum& frustum);
+
+		const std::vector<uint32_t>& getVisible() const { return visible; }
+		const Stats& getStats() const { return stats; }
+		// Items are the ids of the objects with a resident model. Also for picking and proximity
+		// queries, as of the last cull() of a scene that large.
+		const TrekBvh& getBvh() const { return bvh; }
+		bool usesBvh() const { return bvhReady; }
+
+		// Appends the index of every sphere that intersects the frustum, with the same result as
+		// TrekFrustum::intersectsSphere. vectorized false tests one sphere at a time.
+		static void cullSpheres(
+			const TrekFrustum& frustum,
+			const float* centerX,
+			const float* centerY,
+			const float* centerZ,
+			const float* radius,
+			uint32_t count,
+			std::vector<uint32_t>& visible,
+			bool vectorized = true);
+
+	private:
+		void cullSpheres(const TrekEntityStore& objects, const TrekFrustum& frustum);
+		void cullBvh(const TrekEntityStore& objects, const TrekFrustum& frustum);
+		// Gives an existing object its box in the tree, or takes it out while its model loads.
+		void trackObject(const TrekEntityStore& objects, TrekEntityStore::id_t id, uint32_t index);
+
+		// World space spheres of the objects with a resident model, and their dense indices.
+		std::vector<float> centerX;
+		std::vector<float> centerY;
+		std::vector<float> centerZ;
+		std::vector<float> radius;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> visible;
+		Stats stats{};
+
+		TrekBvh bvh;
+		// The tree follows the store's changes since it was built, false while spheres are used.
+		bool bvhReady = false;
+		std::vector<TrekBvh::Aabb> bvhBounds;
+		// Ids whose model wasn't resident yet at the last cull, flagged by id too.
+		std::vector<TrekEntityStore::id_t> loadingIds;
+		std::vector<uint8_t> loading;
+		std::vector<uint32_t> bvhHits;
+	};
+}
+
+#endif
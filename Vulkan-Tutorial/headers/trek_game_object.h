@@ -1,32 +1,30 @@
 #ifndef TREK_GAME_OBJECT_H
 #define TREK_GAME_OBJECT_H
 
-#include "trek_model.h"
-
 //lib
 #include <glm/gtc/matrix_transform.hpp>
 
 // std
 #include <memory>
-#include <unordered_map>
 
 
 namespace Trek
 {
-	class TrekGameObject
+	struct TrekTransformComponent
 	{
-		struct TransformComponent
-		{
-			glm::vec3 translation{};
-			glm::vec3 scale{ 1.f, 1.f, 1.f };
-			glm::vec3 rotation{};
-			glm::mat4 mat4();
-			glm::mat3 normalMatrix();
-		};
+		glm::vec3 translation{};
+		glm::vec3 scale{ 1.f, 1.f, 1.f };
+		glm::vec3 rotation{};
+		glm::mat4 mat4() const;
+		glm::mat3 normalMatrix() const;
+	};
 
+	// A standalone object such as the viewer. Scenes keep the objects they draw in a TrekEntityStore.
+	class TrekGameObject
+	{
 	public:
 		using id_t = unsigned int;
-		using Map = std::unordered_map<id_t, TrekGameObject>;
+		using TransformComponent = TrekTransformComponent;
 
 		TrekGameObject(const TrekGameObject&) = delete;
 		TrekGameObject& operator=(TrekGameObject&) = delete;
@@ -41,9 +39,6 @@ namespace Trek
 
 		id_t getId() const { return id; }
 		TransformComponent transform2d{};
-
-		std::shared_ptr<TrekModel> model{};
-		glm::vec3 color{};
 	private:
 		explicit TrekGameObject(const id_t objId) : id{objId}{}
 		id_t id;
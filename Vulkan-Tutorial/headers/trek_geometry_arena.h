@@ -0,0 +1,91 @@
+#ifndef TREK_GEOMETRY_ARENA_H
+#define TREK_GEOMETRY_ARENA_H
+#include "trek_core.h"
+#include "trek_buffer.h"
+#include "trek_tlsf.h"
+#include "trek_upload_queue.h"
+#include "trek_vertex_format.h"
+
+// std
+#include <functional>
+#include <memory>
+
+namespace Trek
+{
+	// Where a model lives inside a TrekGeometryArena. Draws use firstIndex and firstVertex as
+	// vkCmdDrawIndexed's firstIndex and vertexOffset, so indices stay relative to the model.
+	struct TrekGeometryRange {
+		uint32_t firstVertex = 0;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		uint32_t vertexNode = TrekTlsfAllocator::INVALID_NODE;
+		uint32_t indexNode = TrekTlsfAllocator::INVALID_NODE;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+		// The range may only be drawn once this ticket has completed on the device's upload queue.
+		TrekUploadQueue::Ticket uploadTicket = TrekUploadQueue::COMPLETED_TICKET;
+	};
+
+	// One device local vertex buffer and one index buffer shared by every model, so a frame binds
+	// geometry once instead of once per object. Ranges are handed out by a TLSF free list in units
+	// of vertices and 16 bit index slots, and freed ranges are reused by later models. All vertices
+	// in an arena use one TrekVertexFormat, while 16 and 32 bit index ranges can be mixed.
+	class TrekGeometryArena
+	{
+	public:
+		// Fills count vertices or indices, starting at element first of the range, in the arena's
+		// vertex format or the range's index type.
+		using Writer = std::function<void(void* destination, uint32_t first, uint32_t count)>;
+
+		// indexCapacity counts 32 bit indices, twice as many 16 bit ones fit.
+		TrekGeometryArena(TrekCore& device, TrekVertexFormat vertexFormat, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+		TrekGeometryArena(const TrekGeometryArena&) = delete;
+		TrekGeometryArena& operator=(const TrekGeometryArena&) = delete;
+
+		// Reserves space and queues the upload of vertexCount vertices of vertexStride bytes and
+		// indexCount indices of indexType on the device's upload queue. Throws when no free range is
+		// large enough.
+		TrekGeometryRange allocate(
+			const void* vertices,
+			uint32_t vertexCount,
+			const void* indices,
+			uint32_t indexCount,
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+		// Same, but the vertices and indices are written straight into staging memory a piece at a
+		// time instead of being copied from arrays in the arena's layout.
+		TrekGeometryRange allocate(
+			uint32_t vertexCount,
+			const Writer& writeVertices,
+			uint32_t indexCount,
+			const Writer& writeIndices,
+			VkIndexType indexType);
+		// The range must no longer be referenced by command buffers in flight.
+		void free(TrekGeometryRange& range);
+
+		void bind(VkCommandBuffer commandBuffer, VkIndexType indexType) const;
+		bool isUploaded(const TrekGeometryRange& range) const;
+
+		TrekVertexFormat getVertexFormat() const { return vertexFormat; }
+		uint32_t getVertexStride() const { return vertexStride; }
+		uint32_t getVertexCapacity() const { return static_cast<uint32_t>(vertexRanges.getCapacity()); }
+		uint32_t getUsedVertices() const { return static_cast<uint32_t>(vertexRanges.getUsedBytes()); }
+		VkDeviceSize getIndexCapacityBytes() const { return indexRanges.getCapacity() * sizeof(uint16_t); }
+		VkDeviceSize getUsedIndexBytes() const { return indexRanges.getUsedBytes() * sizeof(uint16_t); }
+
+	private:
+		TrekGeometryRange reserve(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType);
+		TrekUploadQueue::Ticket upload(const TrekGeometryRange& range, const Writer& writeVertices, const Writer& writeIndices) const;
+
+		TrekCore& trekDevice;
+		TrekVertexFormat vertexFormat;
+		uint32_t vertexStride;
+
+		std::unique_ptr<TrekBuffer> vertexBuffer;
+		std::unique_ptr<TrekBuffer> indexBuffer;
+		TrekTlsfAllocator vertexRanges;
+		TrekTlsfAllocator indexRanges;
+	};
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef TREK_GLB_FILE_H
+#define TREK_GLB_FILE_H
+#include "trek_entity_store.h"
+#include "trek_geometry_arena.h"
+#include "trek_mapped_file.h"
+#include "trek_model.h"
+#include "trek_model_handle.h"
+#include "trek_vertex_format.h"
+
+// std
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Trek
+{
+	// Binary glTF 2.0 (.glb), mapped and validated up front. Geometry stays in the mapping until
+	// createModels converts it from the buffer views into the arena's vertex format and index type
+	// while writing it to staging, so a load holds no other copy of it. The primitives of a mesh
+	// become one TrekModel. Supports triangle lists with POSITION, NORMAL, TEXCOORD_0 and COLOR_0
+	// as the core spec allows them and 8, 16 or 32 bit indices. External buffers, sparse accessors
+	// and required extensions are rejected, skins, morph targets and materials ignored.
+	// TrekAssetLoader::loadModel() loads the meshes of .glb files in the background.
+	class TrekGlbFile
+	{
+	public:
+		// A node of the default scene with a mesh, placed by its world transform in
+		// TrekTransformComponent terms. Shear from non uniform scales in a hierarchy is lost.
+		struct Instance {
+			uint32_t mesh;
+			glm::vec3 translation;
+			glm::vec3 rotation;
+			glm::vec3 scale;
+		};
+
+		// Throws std::runtime_error naming the first problem if the file can't be read or is invalid.
+		// Safe on any thread.
+		static std::unique_ptr<TrekGlbFile> open(const std::string& filePath);
+
+		TrekGlbFile(const TrekGlbFile&) = delete;
+		TrekGlbFile& operator=(const TrekGlbFile&) = delete;
+
+		uint32_t getMeshCount() const { return static_cast<uint32_t>(meshes.size()); }
+		// The primitives of the mesh back to back. 0 for a mesh without triangles.
+		uint32_t getVertexCount(const uint32_t mesh) const { return meshes[mesh].vertexCount; }
+		uint32_t getIndexCount(const uint32_t mesh) const { return meshes[mesh].indexCount; }
+		const TrekModel::Bounds& getBounds(const uint32_t mesh) const { return meshes[mesh].bounds; }
+		// 16 bit when every vertex of the mesh is addressable with them.
+		VkIndexType getIndexType(uint32_t mesh) const;
+		const std::vector<Instance>& getInstances() const { return instances; }
+		size_t getFileSize() const { return file.size(); }
+		// TrekMeshCache::hashFile() of the file, from the mapping it is already open with.
+		uint64_t computeContentHash() const;
+
+		// Converts count vertices of the mesh, starting at first, into format. Packed positions are
+		// quantized against getBounds(mesh).
+		void writeVertices(uint32_t mesh, TrekVertexFormat format, void* destination, uint32_t first, uint32_t count) const;
+		// Indices of primitives without any count their vertices, all are relative to the mesh.
+		void writeIndices(uint32_t mesh, VkIndexType indexType, void* destination, uint32_t first, uint32_t count) const;
+
+		// Null for a mesh without triangles. On the thread that owns the arena.
+		std::shared_ptr<TrekModel> createModel(TrekGeometryArena& arena, uint32_t mesh) const;
+		// One handle per mesh, empty for meshes without triangles.
+		std::vector<TrekModelHandle> createModels(TrekGeometryArena& arena) const;
+		// A game object per instance, drawing models[mesh], from createModels or loaded in the
+		// background. Instances of meshes whose handle is empty or failed are skipped.
+		void createGameObjects(const std::vector<TrekModelHandle>& models, TrekEntityStore& gameObjects) const;
+
+	private:
+		// A validated view of accessor data inside the mapping. Null data for an absent attribute.
+		struct Accessor {
+			const unsigned char* data = nullptr;
+			uint32_t count = 0;
+			uint32_t stride = 0;
+			uint32_t componentType = 0;
+			uint32_t components = 0;
+			bool normalized = false;
+		};
+
+		struct Primitive {
+			Accessor position{};
+			Accessor normal{};
+			Accessor uv{};
+			Accessor color{};
+			Accessor indices{};
+			// Where the primitive starts within its mesh.
+			uint32_t firstVertex = 0;
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+		};
+
+		struct Mesh {
+			std::vector<Primitive> primitives;
+			uint32_t vertexCount = 0;
+			uint32_t indexCount = 0;
+			TrekModel::Bounds bounds{};
+		};
+
+		TrekGlbFile() = default;
+
+		TrekMappedFile file;
+		std::vector<Mesh> meshes;
+		std::vector<Instance> instances;
+	};
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef TREK_GPU_PROFILER_H
+#define TREK_GPU_PROFILER_H
+#include "trek_core.h"
+#include "trek_render_target.h"
+
+// std
+#include <array>
+#include <string>
+#include <vector>
+
+namespace Trek
+{
+	struct GpuScopeTiming {
+		std::string name;
+		uint32_t depth;
+		double milliseconds;
+	};
+
+	// Timestamp query profiler with one VkQueryPool per frame in flight. A frame's pool is read back
+	// when the same frame index comes around again, by which point its fence has already been waited
+	// on, so results arrive MAX_FRAMES_IN_FLIGHT frames late but never stall the CPU.
+	class TrekGpuProfiler
+	{
+	public:
+		// Writes a timestamp pair around everything recorded during its lifetime. A null profiler
+		// makes the scope a no-op so callers don't have to check.
+		class Scope
+		{
+		public:
+			Scope(TrekGpuProfiler* profiler, VkCommandBuffer commandBuffer, const char* name);
+			~Scope();
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			TrekGpuProfiler* profiler;
+			VkCommandBuffer commandBuffer;
+			uint32_t index;
+		};
+
+		explicit TrekGpuProfiler(TrekCore& device, uint32_t maxScopesPerFrame = 64);
+		~TrekGpuProfiler();
+
+		TrekGpuProfiler(const TrekGpuProfiler&) = delete;
+		TrekGpuProfiler& operator=(const TrekGpuProfiler&) = delete;
+
+		// Collects the results this frame index produced last time around and resets its pool.
+		// Must be recorded outside of a render pass, before any scope of the frame.
+		void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+
+		uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name);
+		void endScope(VkCommandBuffer commandBuffer, uint32_t scopeIndex);
+
+		bool isSupported() const { return supported; }
+		// Scope timings of the most recently resolved frame, in the order the scopes were opened.
+		// When the upload queue is timed, a last "uploads" entry at depth 0 holds the GPU time of
+		// the upload batches retired since the previous frame.
+		const std::vector<GpuScopeTiming>& getResults() const { return results; }
+
+		static constexpr uint32_t INVALID_SCOPE = ~0u;
+
+	private:
+		struct ScopeRecord {
+			const char* name;
+			uint32_t depth;
+			bool closed;
+		};
+
+		void resolve(int frameIndex);
+
+		TrekCore& trekDevice;
+		uint32_t maxScopes;
+		bool supported = false;
+		double nanosecondsPerTick = 1.0;
+		uint64_t timestampMask = ~0ull;
+
+		std::array<VkQueryPool, TrekRenderTarget::MAX_FRAMES_IN_FLIGHT> queryPools{};
+		std::array<std::vector<ScopeRecord>, TrekRenderTarget::MAX_FRAMES_IN_FLIGHT> frameScopes{};
+		std::vector<uint64_t> queryData;
+		std::vector<GpuScopeTiming> results;
+
+		int currentFrame = -1;
+		uint32_t openDepth = 0;
+	};
+}
+
+#endif
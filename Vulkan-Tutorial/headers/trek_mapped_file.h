@@ -0,0 +1,39 @@
+#ifndef TREK_MAPPED_FILE_H
+#define TREK_MAPPED_FILE_H
+
+// std
+#include <cstddef>
+#include <string>
+
+namespace Trek
+{
+	// Read-only memory mapping of a whole file. The pages are only read in as they are touched.
+	class TrekMappedFile
+	{
+	public:
+		TrekMappedFile() = default;
+		~TrekMappedFile();
+
+		TrekMappedFile(const TrekMappedFile&) = delete;
+		TrekMappedFile& operator=(const TrekMappedFile&) = delete;
+
+		// Returns false if the file doesn't exist or can't be mapped. Empty files open with no data.
+		bool open(const std::string& path);
+		void close();
+
+		bool isOpen() const { return opened; }
+		const unsigned char* data() const { return static_cast<const unsigned char*>(view); }
+		size_t size() const { return byteSize; }
+
+	private:
+		const void* view = nullptr;
+		size_t byteSize = 0;
+		bool opened = false;
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#endif
+	};
+}
+
+#endif
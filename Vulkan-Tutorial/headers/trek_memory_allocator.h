@@ -0,0 +1,105 @@
+#ifndef TREK_MEMORY_ALLOCATOR_H
+#define TREK_MEMORY_ALLOCATOR_H
+#include "trek_tlsf.h"
+
+#include <vulkan/vulkan_core.h>
+
+// std
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace Trek
+{
+	class TrekMemoryBlock;
+
+	// A range of device memory handed out by TrekMemoryAllocator. Bind resources at
+	// (memory, offset). mapped points at offset for host visible memory, null otherwise.
+	struct TrekAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mapped = nullptr;
+		uint32_t memoryType = 0;
+
+		TrekMemoryBlock* block = nullptr;
+		uint32_t node = TrekTlsfAllocator::INVALID_NODE;
+	};
+
+	// Sub-allocates resources out of large VkDeviceMemory blocks, one set of blocks per memory
+	// type and resource kind, using a TLSF allocator per block. Buffers and linear images never
+	// share a block with optimal images, which is how bufferImageGranularity is honoured without
+	// padding every allocation to it. Host visible blocks stay persistently mapped.
+	class TrekMemoryAllocator
+	{
+	public:
+		enum class ResourceKind { Linear, Optimal };
+
+		struct Stats {
+			uint32_t blockCount = 0;
+			uint32_t dedicatedCount = 0;
+			uint32_t allocationCount = 0;
+			VkDeviceSize blockBytes = 0;
+			VkDeviceSize usedBytes = 0;
+			VkDeviceSize dedicatedBytes = 0;
+			// vkAllocateMemory calls made over the allocator's lifetime.
+			uint64_t deviceAllocations = 0;
+		};
+
+		TrekMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize preferredBlockSize = 64ull << 20);
+		~TrekMemoryAllocator();
+
+		TrekMemoryAllocator(const TrekMemoryAllocator&) = delete;
+		TrekMemoryAllocator& operator=(const TrekMemoryAllocator&) = delete;
+
+		// Allocates memory for the resource, which the caller then binds at (memory, offset).
+		// Resources above half a block, or that the driver prefers to be dedicated, get their own
+		// VkDeviceMemory allocated for them with VkMemoryDedicatedAllocateInfo.
+		TrekAllocation allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+		TrekAllocation allocateImage(VkImage image, VkMemoryPropertyFlags properties, ResourceKind kind);
+		// Memory not made for one resource. Above half a block it still gets its own VkDeviceMemory.
+		TrekAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind);
+		void free(TrekAllocation& allocation);
+
+		// Translates a range relative to the allocation into one for vkFlush/InvalidateMappedMemoryRanges,
+		// rounded out to nonCoherentAtomSize. VK_WHOLE_SIZE covers the whole allocation.
+		VkMappedMemoryRange mappedRange(const TrekAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		VkMemoryPropertyFlags getMemoryTypeFlags(const uint32_t memoryType) const { return memoryProperties.memoryTypes[memoryType].propertyFlags; }
+		Stats getStats() const;
+		Stats getStats(uint32_t memoryType) const;
+		void printStats(std::ostream& out) const;
+
+	private:
+		struct Pool {
+			VkDeviceSize blockSize = 0;
+			std::vector<std::unique_ptr<TrekMemoryBlock>> blocks;
+		};
+
+		// resource names the buffer or image the memory is for, if any, and is chained into a
+		// dedicated allocation.
+		TrekAllocation allocate(
+			const VkMemoryRequirements& requirements,
+			VkMemoryPropertyFlags properties,
+			ResourceKind kind,
+			bool dedicated,
+			const VkMemoryDedicatedAllocateInfo* resource);
+		TrekAllocation allocateDedicated(VkDeviceSize size, uint32_t memoryType, const VkMemoryDedicatedAllocateInfo* resource);
+		// Chains dedicatedInfo into the allocation unless it is null.
+		VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void** mapped, const VkMemoryDedicatedAllocateInfo* dedicatedInfo);
+		void freeDeviceMemory(VkDeviceMemory memory, bool mapped);
+		bool isHostVisible(uint32_t memoryType) const;
+
+		VkDevice device;
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		VkPhysicalDeviceLimits limits{};
+
+		mutable std::mutex mutex;
+		std::vector<Pool> pools;
+		std::vector<Stats> typeStats;
+	};
+}
+
+#endif
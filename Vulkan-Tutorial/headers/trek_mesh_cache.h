@@ -0,0 +1,70 @@
+#ifndef TREK_MESH_CACHE_H
+#define TREK_MESH_CACHE_H
+#include "trek_model.h"
+#include "trek_mapped_file.h"
+
+// std
+#include <memory>
+#include <string>
+
+namespace Trek
+{
+	// Binary .tmesh cache of a parsed and deduplicated model: a versioned header with the source
+	// file's size, mtime and hash, the bounds, then the vertex and index arrays exactly as they are
+	// uploaded, the LOD table and the meshlets. Opening one maps the file, so vertices go from the page cache straight into staging.
+	class TrekMeshCache
+	{
+	public:
+		// Bump whenever the file layout, TrekModel::Vertex, Lod or Meshlet changes.
+		static constexpr uint32_t VERSION = 3;
+
+		static std::string cachePathFor(const std::string& sourcePath) { return sourcePath + ".tmesh"; }
+
+		// Null when the cache is missing, truncated, from another version, written with other
+		// processing steps (TrekMeshOptimizer::Steps) or out of date with sourcePath. A changed mtime
+		// alone doesn't invalidate it as long as the source hash matches, the cache then takes the
+		// new mtime. Without a source file the cache is used as is.
+		static std::unique_ptr<TrekMeshCache> open(const std::string& cachePath, const std::string& sourcePath, uint32_t processing = 0);
+		// Writes through a temporary file, so readers never see a partial cache. False on I/O errors.
+		// sourceHash is hashFile(sourcePath) if the caller already has it, 0 hashes the source here.
+		static bool write(
+			const std::string& cachePath,
+			const std::string& sourcePath,
+			const TrekModel::Data& data,
+			uint32_t processing = 0,
+			uint64_t sourceHash = 0);
+		// FNV-1a over the whole file, 0 if it can't be read.
+		static uint64_t hashFile(const std::string& path);
+		static uint64_t hashBytes(const unsigned char* data, size_t size);
+
+		const TrekModel::Vertex* vertices() const { return vertexData; }
+		uint32_t vertexCount() const { return vertexTotal; }
+		const uint32_t* indices() const { return indexData; }
+		uint32_t indexCount() const { return indexTotal; }
+		const TrekModel::Bounds& bounds() const { return meshBounds; }
+		// Empty for caches written without TrekMeshOptimizer::LODS.
+		const TrekModel::Lod* lods() const { return lodData; }
+		uint32_t lodCount() const { return lodTotal; }
+		const TrekModel::Meshlet* meshlets() const { return meshletData; }
+		uint32_t meshletCount() const { return meshletTotal; }
+		// hashFile() of the source the cache was written from, without reading the source again.
+		uint64_t sourceHash() const { return sourceContentHash; }
+
+	private:
+		TrekMeshCache() = default;
+
+		TrekMappedFile file;
+		const TrekModel::Vertex* vertexData = nullptr;
+		const uint32_t* indexData = nullptr;
+		uint32_t vertexTotal = 0;
+		uint32_t indexTotal = 0;
+		const TrekModel::Lod* lodData = nullptr;
+		uint32_t lodTotal = 0;
+		const TrekModel::Meshlet* meshletData = nullptr;
+		uint32_t meshletTotal = 0;
+		TrekModel::Bounds meshBounds{};
+		uint64_t sourceContentHash = 0;
+	};
+}
+
+#endif
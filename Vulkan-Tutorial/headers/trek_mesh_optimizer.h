@@ -0,0 +1,64 @@
+#ifndef TREK_MESH_OPTIMIZER_H
+#define TREK_MESH_OPTIMIZER_H
+#include "trek_model.h"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace Trek
+{
+	// Prepares imported model data for the GPU, in place and deterministically: builds the LOD
+	// chain, reorders each LOD's triangles and the shared vertices and cuts the LODs into meshlets. Reordering never changes
+	// the geometry, only the order in which it is stored.
+	class TrekMeshOptimizer
+	{
+	public:
+		// FIFO post-transform cache size the reordering targets and the statistics simulate.
+		static constexpr uint32_t CACHE_SIZE = 16;
+
+		enum Steps : uint32_t
+		{
+			NONE = 0,
+			// Tipsify triangle order for post-transform cache hits.
+			VERTEX_CACHE = 1u << 0,
+			// Sorts the cache friendly clusters so outward facing ones draw first. Implies VERTEX_CACHE.
+			OVERDRAW = 1u << 1,
+			// Renumbers vertices in first-use order so vertex fetch streams through memory.
+			VERTEX_FETCH = 1u << 2,
+			// Appends simplified LODs, see TrekMeshSimplifier::buildLods.
+			LODS = 1u << 3,
+			// Splits every LOD into meshlets for cluster culling, see TrekMeshletBuilder.
+			MESHLETS = 1u << 4,
+			ALL = VERTEX_CACHE | OVERDRAW | VERTEX_FETCH | LODS | MESHLETS,
+		};
+
+		struct CacheStats {
+			// Average cache miss ratio, transformed vertices per triangle. 0.5 is the ideal for
+			// large regular meshes, 3 means no reuse at all.
+			float acmr = 0.f;
+			// Average transform to vertex ratio, transformed vertices per vertex. 1 is ideal.
+			float atvr = 0.f;
+		};
+
+		// Cache statistics are of LOD 0.
+		struct Report {
+			CacheStats before{};
+			CacheStats after{};
+			uint32_t lodCount = 1;
+			// Over all LODs.
+			uint32_t meshletCount = 0;
+		};
+
+		static Report optimize(TrekModel::Data& data, uint32_t steps = ALL);
+
+		static CacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+		// The individual reordering steps, optimize() runs them in this order on every LOD.
+		static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+		static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<TrekModel::Vertex>& vertices, uint32_t cacheSize = CACHE_SIZE);
+		static void optimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<TrekModel::Vertex>& vertices);
+	};
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef TREK_MESH_SIMPLIFIER_H
+#define TREK_MESH_SIMPLIFIER_H
+#include "trek_model.h"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace Trek
+{
+	// Quadric error edge collapse (Garland and Heckbert 1997) over an indexed triangle list. Vertices
+	// only ever collapse onto existing ones, so every simplified index list draws against the
+	// original vertex buffer, and a LOD chain is nothing but extra index ranges.
+	//
+	// Open borders and non-manifold edges are locked. Vertices split along an attribute seam (equal
+	// positions, different normals or uvs) only collapse along the seam, with every copy moving to
+	// its counterpart on the same side, so seams stay watertight and keep their attributes.
+	class TrekMeshSimplifier
+	{
+	public:
+		// Each LOD aims for this fraction of the previous one's triangles.
+		static constexpr float LOD_REDUCTION = .5f;
+		// A LOD that removes less than this fraction of the previous one's triangles ends the chain.
+		static constexpr float LOD_MIN_GAIN = .15f;
+		// Upper bound on a single simplification's error, relative to the bounds diagonal.
+		static constexpr float LOD_MAX_ERROR = .05f;
+
+		// Collapses edges, cheapest first, until at most targetIndexCount indices are left or the
+		// next collapse would move the surface further than targetError (object space). The
+		// distance actually reached goes to resultError when given.
+		static std::vector<uint32_t> simplify(
+			const std::vector<TrekModel::Vertex>& vertices,
+			const std::vector<uint32_t>& indices,
+			size_t targetIndexCount,
+			float targetError,
+			float* resultError = nullptr);
+
+		// Appends up to maxLods - 1 successively simplified index lists to data.indices and fills
+		// data.lods, LOD 0 being the existing indices. Each LOD is simplified from the previous one
+		// and its error is the sum of the errors along the way.
+		static void buildLods(TrekModel::Data& data, uint32_t maxLods = 5);
+	};
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef TREK_MESHLET_BUILDER_H
+#define TREK_MESHLET_BUILDER_H
+#include "trek_model.h"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace Trek
+{
+	// Splits index ranges into TrekModel::Meshlets for per-cluster culling.
+	class TrekMeshletBuilder
+	{
+	public:
+		// The usual mesh shader limits, so the clusters stay usable if drawing moves to mesh shaders.
+		static constexpr uint32_t MAX_VERTICES = 64;
+		static constexpr uint32_t MAX_TRIANGLES = 124;
+		// Below this cosine between a triangle normal and the average, the cone is left open.
+		static constexpr float MIN_CONE_SPREAD = .1f;
+
+		// Cuts the triangles of indices[firstIndex, firstIndex + indexCount) into consecutive
+		// meshlets in their current order, starting a new one whenever the vertex or triangle
+		// limit would be exceeded. Run it after vertex cache optimization, which already groups
+		// triangles that share vertices.
+		static void buildRange(
+			const std::vector<TrekModel::Vertex>& vertices,
+			const std::vector<uint32_t>& indices,
+			uint32_t firstIndex,
+			uint32_t indexCount,
+			std::vector<TrekModel::Meshlet>& meshlets);
+
+		// Rebuilds data.meshlets for every LOD and points the LODs at them.
+		static void build(TrekModel::Data& data);
+	};
+}
+
+#endif
@@ -3,11 +3,20 @@
 #include "trek_core.h"
 #include "trek_swapchain.h"
 #include "trek_buffer.h"
+#include "trek_camera.h"
+#include "trek_frustum.h"
+#include "trek_geometry_arena.h"
+#include "trek_utils.h"
+#include "trek_vertex_input.h"
 //libs
 #define GLM_FORCE_RADIANS
 #define GLM_FORECE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/vec3.hpp>
+#ifndef GLM_ENABLE_EXPERIMENTAL
+#define GLM_ENABLE_EXPERIMENTAL
+#endif
+#include <glm/gtx/hash.hpp>
 
 //std
 #include <memory>
@@ -15,6 +24,8 @@
 
 namespace Trek
 {
+    class TrekMeshCache;
+
     class TrekModel
     {
     public:
@@ -24,8 +35,6 @@ namespace Trek
             glm::vec3 color;
             glm::vec3 normal{};
             glm::vec2 uv{};
-            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
-            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
 
             bool operator==(const Vertex& other) const
             {
@@ -37,17 +46,81 @@ namespace Trek
             }
         };
 
+        struct Bounds
+        {
+            glm::vec3 min{ 0.f };
+            glm::vec3 max{ 0.f };
+        };
+
+        // Centered on the bounding box, for culling whole objects.
+        struct Sphere
+        {
+            glm::vec3 center{ 0.f };
+            float radius = 0.f;
+        };
+
+        // One level of detail: a range of the model's index buffer drawn against the shared
+        // vertices. error is the object space distance the simplification moved the surface by.
+        // The LOD's meshlets, if any, tile its index range in order.
+        struct Lod
+        {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            float error = 0.f;
+            uint32_t firstMeshlet = 0;
+            uint32_t meshletCount = 0;
+        };
+
+        // A cluster of at most TrekMeshletBuilder::MAX_VERTICES vertices and MAX_TRIANGLES
+        // triangles, stored as a contiguous index range, with an object space bounding sphere and
+        // the cone of its triangles' normals. coneCutoff is the sine of the cone's half angle, 1
+        // when the normals spread too far for the cone to ever cull.
+        struct Meshlet
+        {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            glm::vec3 center{ 0.f };
+            float radius = 0.f;
+            glm::vec3 coneAxis{ 0.f };
+            float coneCutoff = 1.f;
+        };
+
         struct Data
         {
             std::vector<Vertex> vertices{};
             std::vector<uint32_t> indices{};
+            // Finest first. Empty means a single LOD spanning all indices.
+            std::vector<Lod> lods{};
+            std::vector<Meshlet> meshlets{};
 
-            void loadModel(const std::string& filePath);
+            // threadCount as for TrekObjLoader::loadParallel.
+            void loadModel(const std::string& filePath, unsigned threadCount = 0);
+            Bounds computeBounds() const;
         };
 
         TrekModel(
-            TrekCore& trekDevice,
+            TrekGeometryArena& arena,
             const TrekModel::Data& data);
+        // Uploads straight from caller owned arrays, e.g. a mapped TrekMeshCache. Vertices are
+        // converted to the arena's vertex format, and indices go up as 16 bit when every vertex
+        // is addressable with them.
+        TrekModel(
+            TrekGeometryArena& arena,
+            const Vertex* vertices,
+            uint32_t vertexCount,
+            const uint32_t* indices,
+            uint32_t indexCount,
+            const Bounds& bounds,
+            const Lod* lods = nullptr,
+            uint32_t lodCount = 0,
+            const Meshlet* meshlets = nullptr,
+            uint32_t meshletCount = 0);
+        // Takes over a range the caller already allocated from arena and filled, e.g. TrekGlbFile
+        // converting straight into staging. Packed positions must be quantized against bounds.
+        TrekModel(
+            TrekGeometryArena& arena,
+            const TrekGeometryRange& range,
+            const Bounds& bounds);
         ~TrekModel();
 
         TrekModel(const TrekModel&) = delete;
@@ -55,27 +128,119 @@ namespace Trek
         TrekModel(const TrekModel&&) = delete;
         TrekModel& operator=(const TrekModel&&) = delete;
 
+        // Loads from the file's .tmesh cache when it is up to date, otherwise parses the OBJ, runs
+        // every TrekMeshOptimizer step unless optimize is false and writes the cache for the next run.
         static std::unique_ptr<TrekModel> createModelFromFile(
-            TrekCore& device,
-            const std::string& filePath);
+            TrekGeometryArena& arena,
+            const std::string& filePath,
+            bool optimize = true);
+        // The CPU half of createModelFromFile, safe on any thread. Returns the mapped cache when it
+        // is up to date, otherwise fills data, writes the cache and returns null. Parsing uses up
+        // to threadCount threads, 0 for every hardware thread. sourceHash receives
+        // TrekMeshCache::hashFile(filePath), read from the cache when it is up to date.
+        static std::unique_ptr<TrekMeshCache> importFile(
+            const std::string& filePath,
+            Data& data,
+            bool optimize = true,
+            unsigned threadCount = 0,
+            uint64_t* sourceHash = nullptr);
+        // The GPU half, on the thread that owns the arena and the upload queue. Builds from cache
+        // when given, from data otherwise.
+        static std::unique_ptr<TrekModel> createFromImport(
+            TrekGeometryArena& arena,
+            const TrekMeshCache* cache,
+            const Data& data);
 
+        // Binds the whole arena with this model's index type. Models sharing an arena and index
+        // type only need this once per pipeline bind.
         void bind(VkCommandBuffer commandBuffer) const;
-        void draw(VkCommandBuffer commandBuffer) const;
+        void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0) const;
+        // Draws only the LOD's meshlets that intersect the frustum (world space) and, with
+        // coneCulling, aren't entirely back facing from cameraPosition. Runs of visible meshlets go
+        // out as one draw. LODs without meshlets are drawn whole. Cone culling assumes a uniform
+        // scale and outward normals of cross(b - a, c - a), and is only valid when the pipeline
+        // culls back faces.
+        void drawVisibleMeshlets(
+            VkCommandBuffer commandBuffer,
+            uint32_t lod,
+            const glm::mat4& modelMatrix,
+            const TrekFrustum& frustum,
+            const glm::vec3& cameraPosition,
+            bool coneCulling) const;
+
+        // Picks the coarsest LOD whose error, projected through the camera at the distance of the
+        // transformed bounds, stays within pixelError pixels of a viewport viewportHeight pixels
+        // tall. Moving to a coarser LOD than currentLod additionally needs the error to fit within
+        // (1 - hysteresis) of the budget, so objects near a threshold don't pop back and forth.
+        uint32_t selectLod(
+            const glm::mat4& modelMatrix,
+            const TrekCamera& camera,
+            float viewportHeight,
+            uint32_t currentLod,
+            float pixelError = 1.f,
+            float hysteresis = .25f) const;
+        uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); }
+        const Lod& getLod(const uint32_t lod) const { return lods[lod]; }
+        uint32_t getMeshletCount() const { return static_cast<uint32_t>(meshlets.size()); }
+
+        // False until the model's geometry upload has completed, such models are skipped when drawing.
+        bool isUploaded() const { return arena.isUploaded(range); }
+        const TrekGeometryArena& getArena() const { return arena; }
+        const TrekGeometryRange& getRange() const { return range; }
+        VkIndexType getIndexType() const { return range.indexType; }
+        // Applied before the object's transform, maps quantized positions back to object space.
+        const glm::mat4& getDequantizeMatrix() const { return dequantize; }
+        // Object space bounding box.
+        const Bounds& getBounds() const { return bounds; }
+        // Object space. Fit to the vertices when the model was built from them, around the
+        // bounding box otherwise.
+        const Sphere& getBoundingSphere() const { return sphere; }
 
     private:
-        void createVertexBuffers(const std::vector<Vertex>& vertices);
-        void createIndexBuffer(const std::vector<uint32_t>& indices);
-
-        TrekCore& trekDevice;
-        
-        std::unique_ptr<TrekBuffer> vertexBuffer;
-        uint32_t vertexCount;
-
-        bool hasIndexBuffer = false;
-        std::unique_ptr<TrekBuffer> indexBuffer;
-        uint32_t indexCount;
-        
+        TrekGeometryArena& arena;
+        TrekGeometryRange range{};
+        Bounds bounds{};
+        Sphere sphere{};
+        glm::mat4 dequantize{ 1.f };
+        // Never empty, LOD 0 is the full mesh.
+        std::vector<Lod> lods{};
+        std::vector<Meshlet> meshlets{};
+    };
+
+    // TrekVertexFormat::Float, see TrekVertexInput.
+    struct TrekModelVertexLayout
+    {
+        using Vertex = TrekModel::Vertex;
+        static constexpr TrekVertexField fields[] = {
+            { 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos), sizeof(Vertex::pos) },
+            { 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color), sizeof(Vertex::color) },
+            { 2, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal), sizeof(Vertex::normal) },
+            { 3, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv), sizeof(Vertex::uv) },
+        };
     };
+
+    // Only the position of a float arena's vertices, for depth-only passes.
+    struct TrekModelPositionLayout
+    {
+        using Vertex = TrekModel::Vertex;
+        static constexpr TrekVertexField fields[] = {
+            { 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos), sizeof(Vertex::pos) },
+        };
+    };
+}
+
+namespace std
+{
+	template<>
+	struct hash<Trek::TrekModel::Vertex>
+	{
+		size_t operator()(Trek::TrekModel::Vertex const& vertex) const
+		{
+			size_t seed = 0;
+			Trek::hashCombine(seed, vertex.pos, vertex.color, vertex.normal, vertex.uv);
+			return seed;
+		}
+	};
 }
 
 
@@ -0,0 +1,50 @@
+#ifndef TREK_MODEL_HANDLE_H
+#define TREK_MODEL_HANDLE_H
+#include "trek_model.h"
+
+// std
+#include <memory>
+
+namespace Trek
+{
+	// Shared reference to a model that may still be loading. Copies refer to the same model, which
+	// TrekAssetLoader fills in on the main thread once its import has finished. Built from a
+	// shared_ptr, the handle is ready right away.
+	class TrekModelHandle
+	{
+	public:
+		TrekModelHandle() = default;
+		TrekModelHandle(std::shared_ptr<TrekModel> model) : state{ std::make_shared<State>() }
+		{
+			state->model = std::move(model);
+		}
+
+		// Null while the model is loading.
+		TrekModel* get() const { return state ? state->model.get() : nullptr; }
+		TrekModel* operator->() const { return get(); }
+		explicit operator bool() const { return get() != nullptr; }
+		// Created and its geometry upload completed, so it can be drawn.
+		bool isResident() const { return get() && get()->isUploaded(); }
+		bool isLoading() const { return state && !state->model && !state->failed; }
+		// The import threw, the handle stays empty.
+		bool isFailed() const { return state && state->failed; }
+		// FNV-1a of the file's bytes, set by TrekAssetLoader once the import finished. 0 before
+		// and for models not loaded from a file.
+		uint64_t getContentHash() const { return state ? state->contentHash : 0; }
+		// Handles sharing this model, this one included. 0 for an empty handle.
+		long useCount() const { return state.use_count(); }
+
+	private:
+		friend class TrekAssetLoader;
+
+		struct State {
+			std::shared_ptr<TrekModel> model{};
+			uint64_t contentHash = 0;
+			bool failed = false;
+		};
+
+		std::shared_ptr<State> state{};
+	};
+}
+
+#endif
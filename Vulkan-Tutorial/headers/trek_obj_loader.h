@@ -0,0 +1,29 @@
+#ifndef TREK_OBJ_LOADER_H
+#define TREK_OBJ_LOADER_H
+#include "trek_model.h"
+#include "trek_vertex_welder.h"
+
+// std
+#include <string>
+
+namespace Trek
+{
+	// OBJ ingestion for TrekModel::Data. For a given weld mode both paths produce the same
+	// deduplicated vertices and indices byte for byte: the vertex order is the order of first use
+	// over all faces.
+	class TrekObjLoader
+	{
+	public:
+		// tinyobj parse followed by one serial welding loop.
+		static void loadSerial(const std::string& filePath, TrekModel::Data& data, TrekWeldMode weldMode = TrekWeldMode::Attributes);
+
+		// Splits the file into line aligned chunks that are parsed and welded concurrently, then
+		// merges the per-chunk vertex sets in file order. threadCount 0 uses every hardware thread.
+		// Returns false, leaving data untouched, for files only the serial path handles exactly:
+		// polygons that tinyobj would triangulate, and zero or out of range indices.
+		static bool loadParallel(const std::string& filePath, TrekModel::Data& data, unsigned threadCount = 0,
+			TrekWeldMode weldMode = TrekWeldMode::Attributes);
+	};
+}
+
+#endif
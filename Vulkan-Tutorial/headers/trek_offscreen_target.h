@@ -0,0 +1,63 @@
+#ifndef TREK_OFFSCREEN_TARGET_H
+#define TREK_OFFSCREEN_TARGET_H
+#include "trek_core.h"
+#include "trek_render_target.h"
+
+// std
+#include <vector>
+
+namespace Trek
+{
+	// Headless replacement for TrekSwapChain. Renders into a ring of plain VkImages, one per
+	// frame in flight, and never presents, so frames are only paced by the GPU itself.
+	class TrekOffscreenTarget : public TrekRenderTarget
+	{
+	public:
+		TrekOffscreenTarget(TrekCore& deviceRef, VkExtent2D extent);
+		~TrekOffscreenTarget() override;
+
+		TrekOffscreenTarget(const TrekOffscreenTarget&) = delete;
+		TrekOffscreenTarget& operator=(const TrekOffscreenTarget&) = delete;
+
+		VkRenderPass getRenderPass() const override { return renderPass; }
+		VkFramebuffer getFrameBuffer(const int index) const override { return framebuffers[index]; }
+		VkExtent2D getExtent() const override { return extent; }
+		VkImage getImage(const int index) const { return colorImages[index]; }
+		size_t imageCount() const { return colorImages.size(); }
+		VkFormat getImageFormat() const { return colorFormat; }
+
+		VkResult acquireNextImage(uint32_t* imageIndex) const override;
+		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, const uint32_t* imageIndex) override;
+		VkResult presentImage(const uint32_t* imageIndex) override;
+
+	private:
+		void createColorResources();
+		void createRenderPass();
+		void createDepthResources();
+		void createFramebuffers();
+		void createSyncObjects();
+
+		VkFormat findColorFormat() const;
+		VkFormat findDepthFormat() const;
+
+		TrekCore& device;
+		VkExtent2D extent;
+		VkFormat colorFormat;
+		VkFormat depthFormat;
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		std::vector<VkFramebuffer> framebuffers;
+
+		std::vector<VkImage> colorImages;
+		std::vector<TrekAllocation> colorImageMemorys;
+		std::vector<VkImageView> colorImageViews;
+		std::vector<VkImage> depthImages;
+		std::vector<TrekAllocation> depthImageMemorys;
+		std::vector<VkImageView> depthImageViews;
+
+		std::vector<VkFence> inFlightFences;
+		size_t currentFrame = 0;
+	};
+}
+
+#endif
@@ -25,6 +25,8 @@ namespace Trek
 		uint32_t subpass = 0;
 		std::vector<VkDynamicState> dynamicStateEnables;
 		VkPipelineDynamicStateCreateInfo dynamicStateInfo;
+		// TrekModelVertexLayout by default, assign TrekVertexInput<Layout>::state() for others.
+		TrekVertexInputState vertexInput{};
 	};
 
 	class TrekPipeline
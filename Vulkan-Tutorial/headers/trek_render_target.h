@@ -0,0 +1,39 @@
+#ifndef TREK_RENDER_TARGET_H
+#define TREK_RENDER_TARGET_H
+#include <vulkan/vulkan_core.h>
+
+// std
+#include <cstdint>
+
+namespace Trek
+{
+	// Common contract between the presentable swap chain and the headless offscreen target.
+	// TrekRenderer only talks to this interface, so scenes and render systems don't care
+	// whether frames end up on screen or in a plain VkImage.
+	class TrekRenderTarget
+	{
+	public:
+		static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+
+		virtual ~TrekRenderTarget() = default;
+
+		virtual VkRenderPass getRenderPass() const = 0;
+		virtual VkFramebuffer getFrameBuffer(int index) const = 0;
+		virtual VkExtent2D getExtent() const = 0;
+
+		// Waits until the next image is free to be rendered into and returns its index.
+		virtual VkResult acquireNextImage(uint32_t* imageIndex) const = 0;
+		virtual VkResult submitCommandBuffers(const VkCommandBuffer* buffers, const uint32_t* imageIndex) = 0;
+		// Hands the submitted image off (or not, for offscreen targets) and advances to the next frame.
+		// Kept separate from submitCommandBuffers so the two can be timed independently.
+		virtual VkResult presentImage(const uint32_t* imageIndex) = 0;
+
+		float extentAspectRatio() const
+		{
+			const VkExtent2D extent = getExtent();
+			return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+		}
+	};
+}
+
+#endif
@@ -3,6 +3,10 @@
 #include "trek_window.h"
 #include "trek_core.h"
 #include "trek_swapchain.h"
+#include "trek_offscreen_target.h"
+#include "trek_frame_info.h"
+#include "trek_gpu_profiler.h"
+#include "trek_frame_allocator.h"
 
 // std
 #include <cassert>
@@ -14,7 +18,11 @@ namespace Trek
 	class TrekRenderer
 	{
 	public:
+		static constexpr VkDeviceSize FRAME_ALLOCATOR_BYTES = 256 * 1024;
+
 		TrekRenderer(TrekWindow& window, TrekCore& device);
+		// Headless renderer drawing into a TrekOffscreenTarget of the given size.
+		TrekRenderer(TrekCore& device, VkExtent2D extent);
 		~TrekRenderer();
 		TrekRenderer(const TrekRenderer&) = delete;
 		TrekRenderer& operator=(TrekRenderer&) = delete;
@@ -22,9 +30,16 @@ namespace Trek
 		TrekRenderer& operator=(TrekRenderer&&) = delete;
 
 
-		VkRenderPass getSwapChainRenderPass() const { return trekSwapChain->getRenderPass(); }
-		float getAspectRatio() const { return trekSwapChain->extentAspectRatio(); }
+		VkRenderPass getSwapChainRenderPass() const { return renderTarget().getRenderPass(); }
+		float getAspectRatio() const { return renderTarget().extentAspectRatio(); }
+		VkExtent2D getExtent() const { return renderTarget().getExtent(); }
 		bool isFrameInProgress() const { return isFrameStarted; }
+		bool isHeadless() const { return trekWindow == nullptr; }
+		// Submit and present/wait timings of the most recently ended frame.
+		const FrameTimings& getFrameTimings() const { return frameTimings; }
+		TrekGpuProfiler* getGpuProfiler() const { return gpuProfiler.get(); }
+		// Transient per-frame data, reset in beginFrame and flushed in endFrame.
+		TrekFrameAllocator& getFrameAllocator() const { return *frameAllocator; }
 		VkCommandBuffer getCurrentCommandBuffer() const
 		{
 			assert(isFrameStarted && "Cannot get command buffer when frame is not in progress.");
@@ -38,17 +53,26 @@ namespace Trek
 
 		VkCommandBuffer beginFrame();
 		void endFrame();
-		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer) const;
-		void endSwapChainRenderPass(VkCommandBuffer commandBuffer) const;
+		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 	private:
 		void createCommandBuffers();
 		void freeCommandBuffers();
 		void recreateSwapChain();
+		TrekRenderTarget& renderTarget() const;
 
-		TrekWindow& trekWindow;
+		TrekWindow* trekWindow;
 		TrekCore& trekDevice;
 		std::unique_ptr<TrekSwapChain> trekSwapChain;
+		std::unique_ptr<TrekOffscreenTarget> offscreenTarget;
 		std::vector<VkCommandBuffer> commandBuffers;
+		std::unique_ptr<TrekGpuProfiler> gpuProfiler;
+		std::unique_ptr<TrekFrameAllocator> frameAllocator;
+		uint32_t frameScope = TrekGpuProfiler::INVALID_SCOPE;
+		uint32_t renderPassScope = TrekGpuProfiler::INVALID_SCOPE;
+
+		FrameTimings frameTimings{};
+		double acquireMs = 0.0;
 
 		uint32_t currentImageIndex{0};
 		int currentFrameIndex{ 0 };
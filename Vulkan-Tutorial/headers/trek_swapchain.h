@@ -5,37 +5,34 @@
 #include <vulkan/vulkan_core.h>
 
 #include "trek_core.h"
+#include "trek_render_target.h"
 
 namespace Trek
 {
-    class TrekSwapChain {
+    class TrekSwapChain : public TrekRenderTarget {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
         TrekSwapChain(TrekCore& deviceRef, VkExtent2D windowExtent);
         TrekSwapChain(TrekCore& deviceRef, VkExtent2D windowExtent, const std::shared_ptr<TrekSwapChain>& previous);
-        ~TrekSwapChain();
+        ~TrekSwapChain() override;
 
         TrekSwapChain(const TrekSwapChain&) = delete;
         TrekSwapChain operator=(const TrekSwapChain&) = delete;
 
-        VkFramebuffer getFrameBuffer(const int index) const { return swapChainFramebuffers[index]; }
-        VkRenderPass getRenderPass() const { return renderPass; }
+        VkFramebuffer getFrameBuffer(const int index) const override { return swapChainFramebuffers[index]; }
+        VkRenderPass getRenderPass() const override { return renderPass; }
         VkImageView getImageView(const int index) const { return swapChainImageViews[index]; }
         size_t imageCount() const { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() const { return swapChainImageFormat; }
         VkExtent2D getSwapChainExtent() const { return swapChainExtent; }
+        VkExtent2D getExtent() const override { return swapChainExtent; }
         uint32_t width() const { return swapChainExtent.width; }
         uint32_t height() const { return swapChainExtent.height; }
 
-        float extentAspectRatio() const
-        {
-            return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
-        }
         VkFormat findDepthFormat() const;
 
-        VkResult acquireNextImage(uint32_t* imageIndex) const;
-        VkResult submitCommandBuffers(const VkCommandBuffer* buffers, const uint32_t* imageIndex);
+        VkResult acquireNextImage(uint32_t* imageIndex) const override;
+        VkResult submitCommandBuffers(const VkCommandBuffer* buffers, const uint32_t* imageIndex) override;
+        VkResult presentImage(const uint32_t* imageIndex) override;
         bool compareSwapFormats(const TrekSwapChain& sc) const;
 
     private:
@@ -63,7 +60,7 @@ namespace Trek
         VkRenderPass renderPass;
 
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
+        std::vector<TrekAllocation> depthImageMemorys;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
@@ -0,0 +1,75 @@
+#ifndef TREK_TLSF_H
+#define TREK_TLSF_H
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Trek
+{
+	// Two-level segregated fit allocator over an abstract range [0, capacity). It only hands out
+	// offsets, TrekMemoryAllocator maps them onto VkDeviceMemory blocks. Allocation and free are
+	// O(1): a free block is found through two bitmap scans and neighbours are merged on free.
+	class TrekTlsfAllocator
+	{
+	public:
+		static constexpr uint32_t INVALID_NODE = ~0u;
+
+		struct Allocation {
+			uint64_t offset = 0;
+			uint32_t node = INVALID_NODE;
+			bool valid() const { return node != INVALID_NODE; }
+		};
+
+		explicit TrekTlsfAllocator(uint64_t capacity);
+
+		// Returns an invalid allocation when no free block is large enough. alignment must be a power of two.
+		Allocation allocate(uint64_t size, uint64_t alignment = 1);
+		void free(uint32_t node);
+
+		uint64_t getCapacity() const { return capacity; }
+		uint64_t getUsedBytes() const { return usedBytes; }
+		uint32_t getAllocationCount() const { return allocationCount; }
+		uint64_t getAllocationSize(uint32_t node) const { return nodes[node].size; }
+		bool isEmpty() const { return allocationCount == 0; }
+		// Size of the largest free block, an upper bound for the next allocation.
+		uint64_t largestFreeBlock() const;
+
+	private:
+		static constexpr uint32_t SL_BITS = 5;
+		static constexpr uint32_t SL_COUNT = 1u << SL_BITS;
+		static constexpr uint32_t FL_COUNT = 64 - SL_BITS + 1;
+
+		struct Node {
+			uint64_t offset;
+			uint64_t size;
+			uint32_t prevPhysical;
+			uint32_t nextPhysical;
+			uint32_t prevFree;
+			uint32_t nextFree;
+			bool free;
+		};
+
+		static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+		bool findFreeBlock(uint64_t size, uint32_t& fl, uint32_t& sl) const;
+
+		uint32_t createNode(uint64_t offset, uint64_t size);
+		void releaseNode(uint32_t node);
+		void insertFree(uint32_t node);
+		void removeFree(uint32_t node);
+
+		uint64_t capacity;
+		uint64_t usedBytes = 0;
+		uint32_t allocationCount = 0;
+
+		uint64_t flBitmap = 0;
+		std::array<uint32_t, FL_COUNT> slBitmaps{};
+		std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT> freeLists{};
+
+		std::vector<Node> nodes;
+		std::vector<uint32_t> unusedNodes;
+	};
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TREK_TRANSFORM_KERNEL_H
+#define TREK_TRANSFORM_KERNEL_H
+
+#include "trek_game_object.h"
+
+//libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+
+namespace Trek
+{
+	// Model and normal matrices of many transforms at once, 4 or 8 per iteration with a vectorized
+	// sincos, instead of six std::sin/cos calls and two matrix builds per object.
+	class TrekTransformKernel
+	{
+	public:
+		enum class Path
+		{
+			// TrekTransformComponent::mat4() and normalMatrix() one at a time.
+			Scalar,
+			Sse2,
+			// AVX2 and FMA, chosen at runtime.
+			Avx2,
+		};
+
+		// Fastest path this CPU supports, detected once.
+		static Path detect();
+		static bool isSupported(Path path);
+		static const char* name(Path path);
+
+		// Writes the model matrix of every transform and its normal matrix widened to a mat4, the
+		// push constant layout. The vector paths agree with Scalar to a few ulp, rotations beyond
+		// +-MAX_VECTOR_ANGLE radians take the scalar path.
+		static void compute(const TrekTransformComponent* transforms, uint32_t count, glm::mat4* modelMatrices, glm::mat4* normalMatrices);
+		static void compute(const TrekTransformComponent* transforms, uint32_t count, glm::mat4* modelMatrices, glm::mat4* normalMatrices, Path path);
+
+		// Where the vector sincos' range reduction stops being accurate.
+		static constexpr float MAX_VECTOR_ANGLE = 8192.f;
+	};
+}
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef TREK_TRANSFORM_KERNEL_SIMD_H
+#define TREK_TRANSFORM_KERNEL_SIMD_H
+
+// std
+#include <cstdint>
+
+// SSE2 is part of x64 and of MSVC's default Win32 target, AVX2 is detected at runtime.
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define TREK_TRANSFORM_KERNEL_X86 1
+#endif
+
+// Shared by the SSE2 and AVX2 translation units of TrekTransformKernel, each instantiating it with
+// its own Ops: a float vector F and an int vector I of WIDTH lanes and the operations below, kept
+// in an unnamed namespace. Only intrinsics and raw floats: nothing here may be an inline function
+// the AVX2 unit could share with the rest of the program, which runs on CPUs without AVX2.
+namespace Trek
+{
+	namespace TransformKernelSimd
+	{
+		// TrekTransformComponent as 9 floats: translation, scale, rotation. Matrices as 16 floats,
+		// column major. trek_transform_kernel.cpp checks both layouts.
+		constexpr uint32_t FLOATS = 9;
+		constexpr uint32_t TRANSLATION = 0;
+		constexpr uint32_t SCALE = 3;
+		constexpr uint32_t ROTATION = 6;
+		constexpr uint32_t MATRIX_FLOATS = 16;
+		// TrekTransformKernel::MAX_VECTOR_ANGLE.
+		constexpr float MAX_ANGLE = 8192.f;
+
+		// One transform the vector code can't handle, done by TrekTransformComponent.
+		using ScalarFunction = void (*)(const float* transform, float* modelMatrix, float* normalMatrix);
+
+#ifdef TREK_TRANSFORM_KERNEL_X86
+		// In trek_transform_kernel_avx2.cpp.
+		void computeAvx2(const float* transforms, uint32_t count, float* modelMatrices, float* normalMatrices, ScalarFunction scalar);
+#endif
+
+		// Cephes' sinf/cosf: reduced to [-pi/4, pi/4] around the nearest multiple of pi/4 in three
+		// steps, then a minimax polynomial each. Accurate to a few ulp up to MAX_VECTOR_ANGLE.
+		template <typename Ops>
+		void sincos(typename Ops::F x, typename Ops::F& sin, typename Ops::F& cos)
+		{
+			using F = typename Ops::F;
+			using I = typename Ops::I;
+			const F signMask = Ops::set1(-0.f);
+			F sinSign = Ops::andps(x, signMask);
+			x = Ops::andnot(signMask, x);
+
+			// Octant, rounded up to even.
+			I octant = Ops::cvtt(Ops::mul(x, Ops::set1(1.27323954473516f)));
+			octant = Ops::andi(Ops::addi(octant, Ops::set1i(1)), Ops::set1i(~1));
+			const F y = Ops::cvt(octant);
+			sinSign = Ops::xorps(sinSign, Ops::castf(Ops::slli29(Ops::andi(octant, Ops::set1i(4)))));
+			const F cosSign = Ops::castf(Ops::slli29(Ops::andnoti(Ops::subi(octant, Ops::set1i(2)), Ops::set1i(4))));
+			// Whether sin comes from the sine polynomial or the cosine one.
+			const F sinPoly = Ops::castf(Ops::cmpeqi(Ops::andi(octant, Ops::set1i(2)), Ops::set1i(0)));
+
+			x = Ops::madd(y, Ops::set1(-0.78515625f), x);
+			x = Ops::madd(y, Ops::set1(-2.4187564849853515625e-4f), x);
+			x = Ops::madd(y, Ops::set1(-3.77489497744594108e-8f), x);
+			const F z = Ops::mul(x, x);
+
+			F cosPoly = Ops::madd(Ops::set1(2.443315711809948e-5f), z, Ops::set1(-1.388731625493765e-3f));
+			cosPoly = Ops::madd(cosPoly, z, Ops::set1(4.166664568298827e-2f));
+			cosPoly = Ops::mul(Ops::mul(cosPoly, z), z);
+			cosPoly = Ops::madd(z, Ops::set1(-0.5f), cosPoly);
+			cosPoly = Ops::add(cosPoly, Ops::set1(1.f));
+
+			F sinPolyValue = Ops::madd(Ops::set1(-1.9515295891e-4f), z, Ops::set1(8.3321608736e-3f));
+			sinPolyValue = Ops::madd(sinPolyValue, z, Ops::set1(-1.6666654611e-1f));
+			sinPolyValue = Ops::madd(Ops::mul(sinPolyValue, z), x, x);
+
+			sin = Ops::xorps(Ops::orps(Ops::andps(sinPoly, sinPolyValue), Ops::andnot(sinPoly, cosPoly)), sinSign);
+			cos = Ops::xorps(Ops::orps(Ops::andps(sinPoly, cosPoly), Ops::andnot(sinPoly, sinPolyValue)), cosSign);
+		}
+
+		// TrekTransformComponent::mat4() and normalMatrix() for WIDTH transforms per iteration, the
+		// tail and groups with a rotation out of range one at a time.
+		template <typename Ops>
+		void compute(const float* transforms, const uint32_t count, float* modelMatrices, float* normalMatrices, const ScalarFunction scalar)
+		{
+			using F = typename Ops::F;
+			const F signMask = Ops::set1(-0.f);
+			const F maxAngle = Ops::set1(MAX_ANGLE);
+			const F zero = Ops::set1(0.f);
+			const F one = Ops::set1(1.f);
+
+			uint32_t i = 0;
+			for (; i + Ops::WIDTH <= count; i += Ops::WIDTH)
+			{
+				const float* base = transforms + i * FLOATS;
+				const F rotationX = Ops::gather(base + ROTATION, FLOATS);
+				const F rotationY = Ops::gather(base + ROTATION + 1, FLOATS);
+				const F rotationZ = Ops::gather(base + ROTATION + 2, FLOATS);
+				const F outOfRange = Ops::orps(
+					Ops::cmpgt(Ops::andnot(signMask, rotationX), maxAngle),
+					Ops::orps(Ops::cmpgt(Ops::andnot(signMask, rotationY), maxAngle), Ops::cmpgt(Ops::andnot(signMask, rotationZ), maxAngle)));
+				if (Ops::movemask(outOfRange) != 0)
+				{
+					for (uint32_t lane = i; lane < i + Ops::WIDTH; lane++)
+					{
+						scalar(transforms + lane * FLOATS, modelMatrices + lane * MATRIX_FLOATS, normalMatrices + lane * MATRIX_FLOATS);
+					}
+					continue;
+				}
+
+				// Same terms as TrekTransformComponent::mat4(), Ry * Rx * Rz.
+				F s1, c1, s2, c2, s3, c3;
+				sincos<Ops>(rotationY, s1, c1);
+				sincos<Ops>(rotationX, s2, c2);
+				sincos<Ops>(rotationZ, s3, c3);
+				const F s1s2 = Ops::mul(s1, s2);
+				const F c1s2 = Ops::mul(c1, s2);
+				const F r00 = Ops::madd(s1s2, s3, Ops::mul(c1, c3));
+				const F r01 = Ops::mul(c2, s3);
+				const F r02 = Ops::sub(Ops::mul(c1s2, s3), Ops::mul(c3, s1));
+				const F r10 = Ops::sub(Ops::mul(s1s2, c3), Ops::mul(c1, s3));
+				const F r11 = Ops::mul(c2, c3);
+				const F r12 = Ops::madd(c1s2, c3, Ops::mul(s1, s3));
+				const F r20 = Ops::mul(c2, s1);
+				const F r21 = Ops::xorps(s2, signMask);
+				const F r22 = Ops::mul(c1, c2);
+
+				const F scaleX = Ops::gather(base + SCALE, FLOATS);
+				const F scaleY = Ops::gather(base + SCALE + 1, FLOATS);
+				const F scaleZ = Ops::gather(base + SCALE + 2, FLOATS);
+				float* model = modelMatrices + i * MATRIX_FLOATS;
+				Ops::storeColumn(Ops::mul(scaleX, r00), Ops::mul(scaleX, r01), Ops::mul(scaleX, r02), zero, model, 0);
+				Ops::storeColumn(Ops::mul(scaleY, r10), Ops::mul(scaleY, r11), Ops::mul(scaleY, r12), zero, model, 1);
+				Ops::storeColumn(Ops::mul(scaleZ, r20), Ops::mul(scaleZ, r21), Ops::mul(scaleZ, r22), zero, model, 2);
+				Ops::storeColumn(
+					Ops::gather(base + TRANSLATION, FLOATS),
+					Ops::gather(base + TRANSLATION + 1, FLOATS),
+					Ops::gather(base + TRANSLATION + 2, FLOATS),
+					one, model, 3);
+
+				const F inverseX = Ops::div(one, scaleX);
+				const F inverseY = Ops::div(one, scaleY);
+				const F inverseZ = Ops::div(one, scaleZ);
+				float* normal = normalMatrices + i * MATRIX_FLOATS;
+				Ops::storeColumn(Ops::mul(inverseX, r00), Ops::mul(inverseX, r01), Ops::mul(inverseX, r02), zero, normal, 0);
+				Ops::storeColumn(Ops::mul(inverseY, r10), Ops::mul(inverseY, r11), Ops::mul(inverseY, r12), zero, normal, 1);
+				Ops::storeColumn(Ops::mul(inverseZ, r20), Ops::mul(inverseZ, r21), Ops::mul(inverseZ, r22), zero, normal, 2);
+				Ops::storeColumn(zero, zero, zero, one, normal, 3);
+			}
+
+			for (; i < count; i++)
+			{
+				scalar(transforms + i * FLOATS, modelMatrices + i * MATRIX_FLOATS, normalMatrices + i * MATRIX_FLOATS);
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef TREK_UPLOAD_QUEUE_H
+#define TREK_UPLOAD_QUEUE_H
+#include "trek_core.h"
+#include "trek_buffer.h"
+
+// std
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Trek
+{
+	// Batches host to device copies. Data is written into a persistently mapped staging ring and the
+	// copies are recorded into one command buffer, which flush() submits with a fence instead of
+	// waiting for the queue to go idle. Every enqueue returns the ticket of the batch it landed in;
+	// once isComplete(ticket) is true the destination can be used by any later submission.
+	//
+	// Copies run on TrekCore's transfer queue. When that is a queue of its own the batch signals a
+	// semaphore that a small graphics queue submit waits on; if it also belongs to another queue
+	// family, that submit acquires the written buffer ranges released by the transfer queue. On
+	// devices with a single queue the copies go straight to the graphics queue.
+	//
+	// When the transfer queue family has timestamps, each batch's copies are timed on the GPU.
+	class TrekUploadQueue
+	{
+	public:
+		using Ticket = uint64_t;
+		// Fills size bytes of staging memory with the bytes at offset of the upload.
+		using Writer = std::function<void(void* staging, VkDeviceSize offset, VkDeviceSize size)>;
+		// Ticket of work that never needs waiting on.
+		static constexpr Ticket COMPLETED_TICKET = 0;
+
+		TrekUploadQueue(TrekCore& device, VkDeviceSize stagingBytes);
+		~TrekUploadQueue();
+
+		TrekUploadQueue(const TrekUploadQueue&) = delete;
+		TrekUploadQueue& operator=(const TrekUploadQueue&) = delete;
+
+		// Copies size bytes into dstBuffer at dstOffset. Uploads larger than the staging ring are split.
+		// dstBuffer must be owned by the graphics queue family (VK_SHARING_MODE_EXCLUSIVE is fine).
+		Ticket enqueueBufferCopy(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+		// Like enqueueBufferCopy, but write produces the data straight into the mapped staging ring,
+		// so it can be converted on the way without a source array. Pieces start and end on
+		// multiples of granularity. write runs under the queue's lock and must not enqueue.
+		Ticket enqueueBufferWrite(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size, VkDeviceSize granularity, const Writer& write);
+		// Submits everything enqueued so far and returns its ticket. Cheap when nothing is pending.
+		// Submits to the graphics queue, so call it from the thread that submits frames.
+		Ticket flush();
+
+		bool isComplete(Ticket ticket);
+		// Flushes first if the ticket belongs to the batch still being recorded.
+		void wait(Ticket ticket);
+		void waitIdle();
+
+		VkDeviceSize getStagingCapacity() const { return stagingCapacity; }
+		uint64_t getSubmitCount() const { return submitCount; }
+		bool isTimed() const { return queryPool != VK_NULL_HANDLE; }
+		// GPU time of the copies of the batches retired since the last call, in milliseconds.
+		double takeGpuMilliseconds();
+		bool usesSeparateQueue() const { return separateQueue; }
+		bool transfersOwnership() const { return ownershipTransfer; }
+
+	private:
+		struct Batch {
+			Ticket ticket = COMPLETED_TICKET;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			// Graphics queue side of a separate transfer queue: semaphore wait and ownership acquire.
+			VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+			VkSemaphore semaphore = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			// Staging bytes consumed, including padding and the tail skipped when wrapping.
+			VkDeviceSize stagingBytes = 0;
+			// Timestamp pair around the copies, NO_QUERY when the batch isn't timed.
+			uint32_t queryPair = NO_QUERY;
+			// Pairs the acquire command buffer resets, ready for reuse once the batch retires.
+			std::vector<uint32_t> resetQueryPairs;
+		};
+
+		static constexpr uint32_t NO_QUERY = ~0u;
+		// Batches in flight beyond this many go untimed.
+		static constexpr uint32_t TIMED_BATCHES = 16;
+
+		void beginBatch();
+		Ticket submitBatch();
+		void submitShared();
+		void submitSeparate();
+		VkDeviceSize reserveStaging(VkDeviceSize size);
+		// Retires finished batches in submission order. With wait set the oldest one is waited on.
+		void retire(bool wait);
+		bool isCompleteLocked(Ticket ticket);
+		void createQueryPool();
+		// Begin timestamp of the recording batch, after resetting the pairs the transfer queue can reset.
+		void beginTimestamps();
+		void readTimestamps(uint32_t queryPair);
+
+		VkCommandBuffer beginCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList) const;
+		VkFence takeFence();
+		VkSemaphore takeSemaphore();
+
+		TrekCore& trekDevice;
+		uint32_t graphicsFamily;
+		uint32_t transferFamily;
+		bool separateQueue;
+		bool ownershipTransfer;
+
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		VkCommandPool acquirePool = VK_NULL_HANDLE;
+		std::unique_ptr<TrekBuffer> stagingBuffer;
+		VkDeviceSize stagingCapacity;
+		VkDeviceSize stagingHead = 0;
+		VkDeviceSize stagingUsed = 0;
+
+		std::mutex mutex;
+		Batch recording{};
+		bool hasCommands = false;
+		// Buffer ranges written by the recording batch, released to the graphics family on submit.
+		std::vector<VkBufferMemoryBarrier> ownershipBarriers;
+		std::deque<Batch> inFlight;
+		std::vector<VkCommandBuffer> freeCommandBuffers;
+		std::vector<VkCommandBuffer> freeAcquireCommandBuffers;
+		std::vector<VkFence> freeFences;
+		std::vector<VkSemaphore> freeSemaphores;
+
+		Ticket nextTicket = 1;
+		// Read without the lock by isComplete's fast path.
+		std::atomic<Ticket> completedTicket{ COMPLETED_TICKET };
+		uint64_t submitCount = 0;
+
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		double nanosecondsPerTick = 1.0;
+		uint64_t timestampMask = ~0ull;
+		// Transfer only families can't reset queries, the acquire on the graphics queue does it then.
+		bool resetOnTransferQueue = false;
+		// Query pairs ready for a batch, and those read back and waiting for a reset.
+		std::vector<uint32_t> freeQueryPairs;
+		std::vector<uint32_t> staleQueryPairs;
+		double gpuMilliseconds = 0.0;
+	};
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef TREK_UTILS_H
 #define TREK_UTILS_H
 
+#include <chrono>
 #include <functional>
 
 namespace Trek
@@ -11,6 +12,11 @@ namespace Trek
 		seed ^= std::hash<T>{}(v)+0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(hashCombine(seed, rest), ...);
 	};
+
+	inline double millisecondsSince(const std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
 }
 
 #endif
@@ -0,0 +1,101 @@
+#ifndef TREK_VERTEX_FORMAT_H
+#define TREK_VERTEX_FORMAT_H
+
+#include "trek_vertex_input.h"
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORECE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <vulkan/vulkan_core.h>
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace Trek
+{
+	// Layout of the vertices in a TrekGeometryArena. The shader bound with it must match:
+	//   Float       pointlight_diffuse_lighting_ubo_vertex
+	//   Packed      pointlight_diffuse_lighting_ubo_packed_vertex
+	//   PackedColor pointlight_diffuse_lighting_ubo_packed_color_vertex
+	enum class TrekVertexFormat
+	{
+		// TrekModel::Vertex as is, 44 bytes.
+		Float,
+		// TrekPackedVertex, 16 bytes. Drops the vertex color, the shader uses white.
+		Packed,
+		// TrekPackedColorVertex, 20 bytes.
+		PackedColor,
+	};
+
+	// Position as 16 bit unorm inside the mesh bounds, the model matrix carries the dequantization
+	// (see TrekVertexLayout::dequantizeMatrix). w is padding, three component 16 bit formats are
+	// rarely supported for vertex fetch. Normal is octahedral encoded snorm, uv half float.
+	struct TrekPackedVertex {
+		uint16_t position[4];
+		int16_t normal[2];
+		uint16_t uv[2];
+	};
+
+	// TrekPackedVertex plus an RGBA8 unorm color.
+	struct TrekPackedColorVertex {
+		uint16_t position[4];
+		int16_t normal[2];
+		uint16_t uv[2];
+		uint8_t color[4];
+	};
+
+	// Same locations as TrekModelVertexLayout so the shaders only differ in how they decode.
+	struct TrekPackedVertexLayout
+	{
+		using Vertex = TrekPackedVertex;
+		static constexpr TrekVertexField fields[] = {
+			{ 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(Vertex, position), sizeof(Vertex::position) },
+			{ 2, VK_FORMAT_R16G16_SNORM, offsetof(Vertex, normal), sizeof(Vertex::normal) },
+			{ 3, VK_FORMAT_R16G16_SFLOAT, offsetof(Vertex, uv), sizeof(Vertex::uv) },
+		};
+	};
+
+	struct TrekPackedColorVertexLayout
+	{
+		using Vertex = TrekPackedColorVertex;
+		static constexpr TrekVertexField fields[] = {
+			{ 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(Vertex, position), sizeof(Vertex::position) },
+			{ 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(Vertex, color), sizeof(Vertex::color) },
+			{ 2, VK_FORMAT_R16G16_SNORM, offsetof(Vertex, normal), sizeof(Vertex::normal) },
+			{ 3, VK_FORMAT_R16G16_SFLOAT, offsetof(Vertex, uv), sizeof(Vertex::uv) },
+		};
+	};
+
+	// Quantized positions only, for depth-only passes over a packed arena.
+	struct TrekPackedPositionLayout
+	{
+		using Vertex = TrekPackedVertex;
+		static constexpr TrekVertexField fields[] = {
+			{ 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(Vertex, position), sizeof(Vertex::position) },
+		};
+	};
+
+	class TrekVertexLayout
+	{
+	public:
+		// Command line names: float, packed and packed-color.
+		static bool parse(const std::string& name, TrekVertexFormat& format);
+		static uint32_t stride(TrekVertexFormat format);
+		// Description tables of the format's layout, for formats picked at runtime.
+		static TrekVertexInputState vertexInput(TrekVertexFormat format);
+
+		// Maps unorm positions quantized against [boundsMin, boundsMax] back to object space.
+		// Identity for Float.
+		static glm::mat4 dequantizeMatrix(TrekVertexFormat format, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+		static void quantizePosition(const glm::vec3& position, const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint16_t out[4]);
+		static void encodeOctahedral(const glm::vec3& normal, int16_t out[2]);
+		static glm::vec3 decodeOctahedral(const int16_t encoded[2]);
+		static void encodeHalf(const glm::vec2& uv, uint16_t out[2]);
+		static void encodeColor(const glm::vec3& color, uint8_t out[4]);
+	};
+}
+
+#endif
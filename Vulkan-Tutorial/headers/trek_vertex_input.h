@@ -0,0 +1,175 @@
+#ifndef TREK_VERTEX_INPUT_H
+#define TREK_VERTEX_INPUT_H
+
+//libs
+#include <vulkan/vulkan_core.h>
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace Trek
+{
+	// One attribute of a vertex layout. size is sizeof the member and has to match the format.
+	struct TrekVertexField {
+		uint32_t location;
+		VkFormat format;
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	// Non owning view of a layout's description tables, what pipeline creation consumes. The
+	// tables are static, so the view never dangles.
+	struct TrekVertexInputState {
+		const VkVertexInputBindingDescription* bindings = nullptr;
+		uint32_t bindingCount = 0;
+		const VkVertexInputAttributeDescription* attributes = nullptr;
+		uint32_t attributeCount = 0;
+	};
+
+	namespace VertexInputDetail
+	{
+		// Bytes per attribute, 0 for formats no layout uses yet.
+		constexpr uint32_t formatSize(const VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_R32_SFLOAT: return 4;
+			case VK_FORMAT_R32G32_SFLOAT: return 8;
+			case VK_FORMAT_R32G32B32_SFLOAT: return 12;
+			case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+			case VK_FORMAT_R32_UINT: return 4;
+			case VK_FORMAT_R16G16_SFLOAT: return 4;
+			case VK_FORMAT_R16G16_SNORM: return 4;
+			case VK_FORMAT_R16G16_UNORM: return 4;
+			case VK_FORMAT_R16G16B16A16_SFLOAT: return 8;
+			case VK_FORMAT_R16G16B16A16_SNORM: return 8;
+			case VK_FORMAT_R16G16B16A16_UNORM: return 8;
+			case VK_FORMAT_R16G16B16A16_UINT: return 8;
+			case VK_FORMAT_R8G8B8A8_UNORM: return 4;
+			case VK_FORMAT_R8G8B8A8_SNORM: return 4;
+			case VK_FORMAT_R8G8B8A8_UINT: return 4;
+			case VK_FORMAT_A2B10G10R10_UNORM_PACK32: return 4;
+			default: return 0;
+			}
+		}
+
+		// Size of one component, which the attribute offset has to be aligned to.
+		constexpr uint32_t componentSize(const VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_R16G16_SFLOAT:
+			case VK_FORMAT_R16G16_SNORM:
+			case VK_FORMAT_R16G16_UNORM:
+			case VK_FORMAT_R16G16B16A16_SFLOAT:
+			case VK_FORMAT_R16G16B16A16_SNORM:
+			case VK_FORMAT_R16G16B16A16_UNORM:
+			case VK_FORMAT_R16G16B16A16_UINT:
+				return 2;
+			case VK_FORMAT_R8G8B8A8_UNORM:
+			case VK_FORMAT_R8G8B8A8_SNORM:
+			case VK_FORMAT_R8G8B8A8_UINT:
+				return 1;
+			default:
+				return 4;
+			}
+		}
+
+		template <typename Layout>
+		constexpr bool formatsMatchFields()
+		{
+			for (const TrekVertexField& field : Layout::fields)
+			{
+				if (formatSize(field.format) == 0 || formatSize(field.format) != field.size)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		template <typename Layout>
+		constexpr bool fieldsFitStride()
+		{
+			for (const TrekVertexField& field : Layout::fields)
+			{
+				if (field.offset + field.size > sizeof(typename Layout::Vertex) || field.offset % componentSize(field.format) != 0)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		template <typename Layout>
+		constexpr bool locationsUnique()
+		{
+			const size_t count = std::size(Layout::fields);
+			for (size_t i = 0; i < count; i++)
+			{
+				for (size_t j = i + 1; j < count; j++)
+				{
+					if (Layout::fields[i].location == Layout::fields[j].location)
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		template <typename Layout, size_t Count>
+		constexpr std::array<VkVertexInputAttributeDescription, Count> makeAttributes()
+		{
+			std::array<VkVertexInputAttributeDescription, Count> attributes{};
+			for (size_t i = 0; i < Count; i++)
+			{
+				attributes[i] = { Layout::fields[i].location, 0, Layout::fields[i].format, Layout::fields[i].offset };
+			}
+			return attributes;
+		}
+	}
+
+	// Binding and attribute descriptions of a vertex layout, built at compile time. A layout names
+	// the vertex type and lists its fields once:
+	//
+	//   struct MyLayout {
+	//       using Vertex = MyVertex;
+	//       static constexpr TrekVertexField fields[] = {
+	//           { 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MyVertex, pos), sizeof(MyVertex::pos) },
+	//       };
+	//   };
+	//
+	// Several layouts may describe the same vertex type, e.g. a position only layout for depth
+	// passes reading the same buffer.
+	template <typename Layout>
+	class TrekVertexInput
+	{
+	public:
+		using Vertex = typename Layout::Vertex;
+		static constexpr uint32_t STRIDE = static_cast<uint32_t>(sizeof(Vertex));
+		static constexpr size_t ATTRIBUTE_COUNT = std::size(Layout::fields);
+
+		static_assert(VertexInputDetail::formatsMatchFields<Layout>(), "Vertex field size does not match its VkFormat");
+		static_assert(VertexInputDetail::fieldsFitStride<Layout>(), "Vertex field is misaligned or outside the vertex");
+		static_assert(VertexInputDetail::locationsUnique<Layout>(), "Vertex fields share a shader location");
+
+		static constexpr std::array<VkVertexInputBindingDescription, 1> bindings{ { { 0, STRIDE, VK_VERTEX_INPUT_RATE_VERTEX } } };
+		static constexpr std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT> attributes =
+			VertexInputDetail::makeAttributes<Layout, ATTRIBUTE_COUNT>();
+
+		static TrekVertexInputState state()
+		{
+			return {
+				bindings.data(),
+				static_cast<uint32_t>(bindings.size()),
+				attributes.data(),
+				static_cast<uint32_t>(attributes.size()) };
+		}
+	};
+}
+
+#endif
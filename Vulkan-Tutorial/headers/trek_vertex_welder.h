@@ -0,0 +1,89 @@
+#ifndef TREK_VERTEX_WELDER_H
+#define TREK_VERTEX_WELDER_H
+#include "trek_model.h"
+#include "trek_flat_index_map.h"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace Trek
+{
+	enum class TrekWeldMode
+	{
+		// Corners with equal attribute values share a vertex, even if the file repeats the values
+		// under different indices. Matches the original std::unordered_map<Vertex> welding.
+		Attributes,
+		// Corners share a vertex only when they use the same position/texcoord/normal indices. No
+		// vertex has to be built or hashed for repeated corners; files that store duplicate
+		// attribute values keep them as separate vertices.
+		IndexTriple,
+	};
+
+	// OBJ corner indices after resolving relative indices. Missing texcoord or normal is -1.
+	struct TrekIndexTriple {
+		int32_t position = -1;
+		int32_t texcoord = -1;
+		int32_t normal = -1;
+
+		bool operator==(const TrekIndexTriple& other) const
+		{
+			return position == other.position && texcoord == other.texcoord && normal == other.normal;
+		}
+	};
+
+	struct TrekIndexTripleHash {
+		size_t operator()(const TrekIndexTriple& triple) const;
+	};
+
+	// Hashes the float bits of every attribute, with -0 folded onto 0 so it agrees with Vertex::operator==.
+	struct TrekVertexBitsHash {
+		size_t operator()(const TrekModel::Vertex& vertex) const;
+	};
+
+	// Turns a stream of corners into deduplicated vertices plus one index per corner, keeping
+	// vertices in the order of their first use.
+	class TrekVertexWelder
+	{
+	public:
+		// Sized for expectedVertices unique vertices, the table grows past that.
+		TrekVertexWelder(TrekWeldMode mode, size_t expectedVertices);
+
+		// Unique vertices to expect from a stream of corners.
+		static size_t estimateVertices(size_t corners);
+
+		// makeVertex() is only called when the corner needs a vertex built, never for a repeated
+		// index triple.
+		template <typename MakeVertex>
+		uint32_t weld(const TrekIndexTriple& triple, MakeVertex makeVertex)
+		{
+			if (mode == TrekWeldMode::IndexTriple)
+			{
+				const auto [index, inserted] = triples.tryEmplace(triple, static_cast<uint32_t>(vertices.size()));
+				if (inserted)
+				{
+					vertices.push_back(makeVertex());
+					keys.push_back(triple);
+				}
+				return index;
+			}
+			return weld(makeVertex());
+		}
+		// Attribute welding of a ready made vertex.
+		uint32_t weld(const TrekModel::Vertex& vertex);
+
+		TrekWeldMode getMode() const { return mode; }
+		std::vector<TrekModel::Vertex>& getVertices() { return vertices; }
+		// Index triple of each vertex, only recorded in IndexTriple mode.
+		const std::vector<TrekIndexTriple>& getKeys() const { return keys; }
+
+	private:
+		TrekWeldMode mode;
+		TrekFlatIndexMap<TrekIndexTriple, TrekIndexTripleHash> triples;
+		TrekFlatIndexMap<TrekModel::Vertex, TrekVertexBitsHash> attributes;
+		std::vector<TrekModel::Vertex> vertices;
+		std::vector<TrekIndexTriple> keys;
+	};
+}
+
+#endif
@@ -2,4 +2,5 @@
 for %%f in (*.vert *.frag) do (
     C:\VulkanSDK\1.3.275.0\Bin\glslc.exe "%%f" -o "%%~nf.spv"
 )
+C:\VulkanSDK\1.3.275.0\Bin\glslc.exe -DVERTEX_COLOR pointlight_diffuse_lighting_ubo_packed_vertex.vert -o pointlight_diffuse_lighting_ubo_packed_color_vertex.spv
 pause
\ No newline at end of file
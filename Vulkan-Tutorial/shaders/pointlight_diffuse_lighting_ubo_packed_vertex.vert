@@ -0,0 +1,46 @@
+#version 450
+
+// Decodes TrekPackedVertex, or TrekPackedColorVertex when compiled with -DVERTEX_COLOR.
+// Positions arrive as unorm in the mesh bounds, push.modelMatrix includes the dequantization.
+layout(location = 0) in vec3 position;
+#ifdef VERTEX_COLOR
+layout(location = 1) in vec3 color;
+#endif
+layout(location = 2) in vec2 octNormal;
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projectionViewMatrix;
+    vec4 ambientLightColor; // w is intensity
+    vec3 lightPosition;
+    vec4 lightColor;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix; // model * dequantize
+    mat4 normalMatrix;
+} push;
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projectionViewMatrix * positionWorld;
+    fragNormalWorld = normalize(mat3(push.normalMatrix) * decodeOctahedral(octNormal));
+    fragPosWorld = positionWorld.xyz;
+#ifdef VERTEX_COLOR
+    fragColor = color;
+#else
+    fragColor = vec3(1.0);
+#endif
+}
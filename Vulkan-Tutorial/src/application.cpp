@@ -1,21 +1,59 @@
 #include "application.h"
+#include "trek_cpu_profiler.h"
 
 namespace Trek
 {
-	Application::Application()
+	Application::Application() : Application(Config{ false, 0 })
 	{
-		currentScene = std::make_unique<DiffuseLightingScene>(
-			trekWindow,
-			trekDevice,
-			"shaders/pointlight_diffuse_lighting_ubo_vertex.spv",
-			"shaders/pointlight_diffuse_lighting_ubo_fragment.spv");
+	}
+
+	Application::Application(const Config& config) : tracePath(config.tracePath)
+	{
+		TrekCpuProfiler::setThreadName("main");
+		if (config.hitchBudgetMs > 0.0)
+		{
+			TrekCpuProfiler::enableFlightRecorder(config.hitchBudgetMs, config.hitchFrames, ".");
+		}
 
+		const std::string vertexShaderPath = DiffuseLightingScene::vertexShaderFor(config.vertexFormat);
+		const std::string fragmentShaderPath = "shaders/pointlight_diffuse_lighting_ubo_fragment.spv";
+
+		if (config.headless)
+		{
+			trekDevice = std::make_unique<TrekCore>();
+			assets = std::make_unique<TrekAssetRegistry>(*trekDevice, config.vertexFormat);
+			currentScene = std::make_unique<DiffuseLightingScene>(
+				*trekDevice,
+				VkExtent2D{ WIDTH, HEIGHT },
+				vertexShaderPath,
+				fragmentShaderPath,
+				*assets,
+				config.cullBackFaces);
+		}
+		else
+		{
+			trekWindow = std::make_unique<TrekWindow>(WIDTH, HEIGHT, "Vulkan Tutorial!");
+			trekDevice = std::make_unique<TrekCore>(*trekWindow);
+			assets = std::make_unique<TrekAssetRegistry>(*trekDevice, config.vertexFormat);
+			currentScene = std::make_unique<DiffuseLightingScene>(
+				*trekWindow,
+				*trekDevice,
+				vertexShaderPath,
+				fragmentShaderPath,
+				*assets,
+				config.cullBackFaces);
+		}
+
+		currentScene->setFrameLimit(config.frameLimit);
 		currentScene->setup();
 	}
 
 	void Application::run()
 	{
 		currentScene->render();
+		if (!tracePath.empty())
+		{
+			TrekCpuProfiler::exportChromeTrace(tracePath);
+		}
 	}
 }
-
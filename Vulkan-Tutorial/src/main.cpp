@@ -1,13 +1,78 @@
 // ReSharper disable CppUseStructuredBinding
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
+#include <string>
 
 #include "application.h"
+#include "trek_mesh_cache.h"
+#include "trek_mesh_optimizer.h"
+#include "trek_vertex_format.h"
 
-int main() {
+int main(const int argc, char* argv[]) {
 	try
 	{
-		Trek::Application app{};
+		// --headless renders offscreen without a window, --frames N stops after N frames.
+		// --trace FILE writes a Chrome trace on exit, --hitch-budget MS [--hitch-frames N] dumps the
+		// last N frames of trace whenever a frame runs over budget.
+		// --vertex-format float|packed|packed-color selects the vertex layout of the scene's geometry.
+		// --cull-back-faces drops back faces and the meshlets facing away from the camera.
+		// --build-mesh-cache FILE... converts OBJ files to optimized .tmesh caches and exits without rendering.
+		Trek::Application::Config config{ false, 0 };
+		for (int i = 1; i < argc; i++)
+		{
+			if (std::strcmp(argv[i], "--headless") == 0)
+			{
+				config.headless = true;
+			}
+			else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			{
+				config.frameLimit = static_cast<uint32_t>(std::stoul(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+			{
+				config.tracePath = argv[++i];
+			}
+			else if (std::strcmp(argv[i], "--hitch-budget") == 0 && i + 1 < argc)
+			{
+				config.hitchBudgetMs = std::stod(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--hitch-frames") == 0 && i + 1 < argc)
+			{
+				config.hitchFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--cull-back-faces") == 0)
+			{
+				config.cullBackFaces = true;
+			}
+			else if (std::strcmp(argv[i], "--vertex-format") == 0 && i + 1 < argc)
+			{
+				if (!Trek::TrekVertexLayout::parse(argv[++i], config.vertexFormat))
+				{
+					throw std::runtime_error(std::string("unknown vertex format ") + argv[i]);
+				}
+			}
+			else if (std::strcmp(argv[i], "--build-mesh-cache") == 0)
+			{
+				for (i++; i < argc; i++)
+				{
+					Trek::TrekModel::Data data{};
+					data.loadModel(argv[i]);
+					const Trek::TrekMeshOptimizer::Report report = Trek::TrekMeshOptimizer::optimize(data);
+					const std::string cachePath = Trek::TrekMeshCache::cachePathFor(argv[i]);
+					if (!Trek::TrekMeshCache::write(cachePath, argv[i], data, Trek::TrekMeshOptimizer::ALL))
+					{
+						throw std::runtime_error("failed to write " + cachePath);
+					}
+					std::cout << argv[i] << " -> " << cachePath << " (" << data.vertices.size() << " vertices, "
+						<< data.indices.size() << " indices, " << report.lodCount << " LODs, ACMR " << report.before.acmr << " -> " << report.after.acmr
+						<< ", ATVR " << report.before.atvr << " -> " << report.after.atvr << ")\n";
+				}
+				return EXIT_SUCCESS;
+			}
+		}
+
+		Trek::Application app{ config };
         app.run();
     } catch(const std::exception& exception)
     {
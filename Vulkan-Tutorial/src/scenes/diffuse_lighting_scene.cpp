@@ -1,7 +1,10 @@
 #include "scene.h"
+#include "trek_utils.h"
+#include "trek_cpu_profiler.h"
 
 //std
 #include <chrono>
+#include <iostream>
 
 namespace Trek
 {
@@ -10,30 +13,38 @@ namespace Trek
 		cleanup();
 	}
 
-	void DiffuseLightingScene::setup()
+	std::string DiffuseLightingScene::vertexShaderFor(const TrekVertexFormat vertexFormat)
 	{
-		const std::shared_ptr<TrekModel> flatVaseModel = TrekModel::createModelFromFile(trekDevice, "models/flat_vase.obj");
-		const std::shared_ptr<TrekModel> smoothVaseModel = TrekModel::createModelFromFile(trekDevice, "models/smooth_vase.obj");
-		const std::shared_ptr<TrekModel> floorModel = TrekModel::createModelFromFile(trekDevice, "models/quad.obj");
-
-		auto flatVase = TrekGameObject::createGameObject();
-		flatVase.model = flatVaseModel;
-		flatVase.transform2d.translation = { -.5f, .5f, 0.f };
-		flatVase.transform2d.scale = glm::vec3{ 3.f };
-
-		auto smoothVase = TrekGameObject::createGameObject();
-		smoothVase.model = smoothVaseModel;
-		smoothVase.transform2d.translation = { .5f, .5f, 0.f };
-		smoothVase.transform2d.scale = glm::vec3{ 3.f };
-
-		auto floor = TrekGameObject::createGameObject();
-		floor.model = floorModel;
-		floor.transform2d.translation = { 0.f, .5f, 0.f };
-		floor.transform2d.scale = { 3.f, 1.f, 3.f };
+		switch (vertexFormat)
+		{
+		case TrekVertexFormat::Packed: return "shaders/pointlight_diffuse_lighting_ubo_packed_vertex.spv";
+		case TrekVertexFormat::PackedColor: return "shaders/pointlight_diffuse_lighting_ubo_packed_color_vertex.spv";
+		default: return "shaders/pointlight_diffuse_lighting_ubo_vertex.spv";
+		}
+	}
 
-		gameObjects.emplace(flatVase.getId(), std::move(flatVase));
-		gameObjects.emplace(smoothVase.getId(), std::move(smoothVase));
-		gameObjects.emplace(floor.getId(), std::move(floor));
+	void DiffuseLightingScene::setup()
+	{
+		// Imported on the loader's workers unless still resident from an earlier scene, objects show
+		// up once their model is resident.
+		const TrekModelHandle flatVaseModel = assets.loadModel("models/flat_vase.obj");
+		const TrekModelHandle smoothVaseModel = assets.loadModel("models/smooth_vase.obj");
+		const TrekModelHandle floorModel = assets.loadModel("models/quad.obj");
+
+		TrekTransformComponent flatVase{};
+		flatVase.translation = { -.5f, .5f, 0.f };
+		flatVase.scale = glm::vec3{ 3.f };
+		gameObjects.create(flatVase, flatVaseModel);
+
+		TrekTransformComponent smoothVase{};
+		smoothVase.translation = { .5f, .5f, 0.f };
+		smoothVase.scale = glm::vec3{ 3.f };
+		gameObjects.create(smoothVase, smoothVaseModel);
+
+		TrekTransformComponent floor{};
+		floor.translation = { 0.f, .5f, 0.f };
+		floor.scale = { 3.f, 1.f, 3.f };
+		gameObjects.create(floor, floorModel);
 
 		camera.setViewTarget(glm::vec3(2.f, -1.f, -1.f), glm::vec3(0.f, 0.f, 2.5f));
 		viewerObject.transform2d.translation.z = -2.5f;
@@ -42,46 +53,89 @@ namespace Trek
 	void DiffuseLightingScene::render()
 	{
 		// Render loop
-		auto currentTime = std::chrono::high_resolution_clock::now();
-		while (!trekWindow.shouldClose())
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		auto currentTime = startTime;
+		while (!shouldClose())
 		{
-			glfwPollEvents();
-
 			auto newTime = std::chrono::high_resolution_clock::now();
 			const float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
 			currentTime = newTime;
 
-			cameraController.moveInPlaneXZ(trekWindow.getGLFWwindow(), frameTime, viewerObject);
-			camera.setViewYXZ(viewerObject.transform2d.translation, viewerObject.transform2d.rotation);
-			const float aspect = trekRenderer.getAspectRatio();
-			camera.setPerspectiveProjection(glm::radians(50.0f), aspect, 0.1f, 10.f);
-			if (const auto commandBuffer = trekRenderer.beginFrame())
+			if (!isHeadless())
 			{
-				int frameIndex = trekRenderer.getFrameIndex();
-				FrameInfo frameInfo{
-					frameIndex,
-					frameTime,
-					commandBuffer,
-					camera,
-					globalDescriptorSets[frameIndex],
-					gameObjects
-				};
-
-				// update
-				GlobalUbo ubo{};
-				ubo.projectionView = camera.getProjection() * camera.getView();
-				uboBuffers[frameIndex]->writeToBuffer(&ubo);
-				uboBuffers[frameIndex]->flush();
-
-				// render
-				trekRenderer.beginSwapChainRenderPass(commandBuffer);
-				renderSystem->renderGameObjects(frameInfo);
-				trekRenderer.endSwapChainRenderPass(commandBuffer);
-				trekRenderer.endFrame();
+				glfwPollEvents();
 			}
+			renderFrame(frameTime);
 		}
 
 		vkDeviceWaitIdle(trekDevice.device());
+
+		if (isHeadless())
+		{
+			const float totalTime = std::chrono::duration<float, std::chrono::seconds::period>(
+				std::chrono::high_resolution_clock::now() - startTime).count();
+			std::cout << "Rendered " << framesRendered << " headless frames in " << totalTime << "s ("
+				<< static_cast<float>(framesRendered) / totalTime << " fps)" << std::endl;
+		}
+	}
+
+	bool DiffuseLightingScene::renderFrame(const float frameTime)
+	{
+		TrekCpuProfiler::Zone zone{ "DiffuseLightingScene::renderFrame" };
+		auto updateStart = std::chrono::steady_clock::now();
+		{
+			TrekCpuProfiler::Zone updateZone{ "update camera" };
+			updateCamera(frameTime);
+		}
+		assets.update();
+		gameObjects.updateWorldMatrices();
+		culler.cull(gameObjects, TrekFrustum::fromMatrix(camera.getProjection() * camera.getView()));
+		frameTimings.updateMs = millisecondsSince(updateStart);
+
+		const auto commandBuffer = trekRenderer.beginFrame();
+		if (!commandBuffer)
+		{
+			return false;
+		}
+
+		// update
+		updateStart = std::chrono::steady_clock::now();
+		GlobalUbo ubo{};
+		ubo.projectionView = camera.getProjection() * camera.getView();
+		TrekFrameAllocator& frameAllocator = trekRenderer.getFrameAllocator();
+		const uint32_t globalUboOffset = frameAllocator.push(ubo);
+		frameTimings.updateMs += millisecondsSince(updateStart);
+
+		int frameIndex = trekRenderer.getFrameIndex();
+		FrameInfo frameInfo{
+			frameIndex,
+			frameTime,
+			commandBuffer,
+			camera,
+			globalDescriptorSet,
+			globalUboOffset,
+			gameObjects,
+			trekRenderer.getGpuProfiler(),
+			&frameAllocator,
+			trekRenderer.getExtent(),
+			&culler.getVisible()
+		};
+
+		// render
+		const auto recordStart = std::chrono::steady_clock::now();
+		{
+			TrekCpuProfiler::Zone recordZone{ "record commands" };
+			trekRenderer.beginSwapChainRenderPass(commandBuffer);
+			renderSystem->renderGameObjects(frameInfo);
+			trekRenderer.endSwapChainRenderPass(commandBuffer);
+		}
+		frameTimings.recordMs = millisecondsSince(recordStart);
+
+		trekRenderer.endFrame();
+		frameTimings.submitMs = trekRenderer.getFrameTimings().submitMs;
+		frameTimings.presentMs = trekRenderer.getFrameTimings().presentMs;
+		framesRendered++;
+		return true;
 	}
 
 	void DiffuseLightingScene::cleanup()
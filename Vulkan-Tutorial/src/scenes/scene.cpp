@@ -6,49 +6,87 @@ namespace Trek
 		TrekWindow& trekWindow,
 		TrekCore& trekDevice,
 		std::string vertexShaderFilePath,
-		std::string fragmentShaderFilePath) :
-		trekWindow(trekWindow),
+		std::string fragmentShaderFilePath,
+		TrekAssetRegistry& assets,
+		const bool cullBackFaces) :
+		trekWindow(&trekWindow),
 		trekDevice(trekDevice),
+		trekRenderer(trekWindow, trekDevice),
+		assets(assets),
 		vertexShaderPath(vertexShaderFilePath),
-		fragmentShaderPath(fragmentShaderFilePath)
+		fragmentShaderPath(fragmentShaderFilePath),
+		vertexFormat(assets.getArena().getVertexFormat()),
+		cullBackFaces(cullBackFaces)
 	{
-		globalPool = TrekDescriptorPool::Builder(trekDevice)
-			.setMaxSets(TrekSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, TrekSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.build();
+		init();
+	}
+
+	Scene::Scene(
+		TrekCore& trekDevice,
+		const VkExtent2D extent,
+		std::string vertexShaderFilePath,
+		std::string fragmentShaderFilePath,
+		TrekAssetRegistry& assets,
+		const bool cullBackFaces) :
+		trekWindow(nullptr),
+		trekDevice(trekDevice),
+		trekRenderer(trekDevice, extent),
+		assets(assets),
+		vertexShaderPath(vertexShaderFilePath),
+		fragmentShaderPath(fragmentShaderFilePath),
+		vertexFormat(assets.getArena().getVertexFormat()),
+		cullBackFaces(cullBackFaces)
+	{
+		init();
+	}
+
+	bool Scene::shouldClose() const
+	{
+		if (frameLimit > 0 && framesRendered >= frameLimit)
+		{
+			return true;
+		}
+		return !isHeadless() && trekWindow->shouldClose();
+	}
 
-		// Setting up global uniform buffers.
-		for (int i = 0; i < uboBuffers.size(); i++)
+	void Scene::updateCamera(const float frameTime)
+	{
+		if (scriptedCamera)
 		{
-			uboBuffers[i] = std::make_unique<TrekBuffer>(
-				trekDevice,
-				sizeof(GlobalUbo),
-				1,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-			);
-
-			uboBuffers[i]->map();
+			scriptedCamera->advance(frameTime, viewerObject);
 		}
+		else if (!isHeadless())
+		{
+			cameraController.moveInPlaneXZ(trekWindow->getGLFWwindow(), frameTime, viewerObject);
+		}
+		camera.setViewYXZ(viewerObject.transform2d.translation, viewerObject.transform2d.rotation);
+		camera.setPerspectiveProjection(glm::radians(50.0f), trekRenderer.getAspectRatio(), 0.1f, 10.f);
+	}
 
-		// Setting up descriptor sets
+	void Scene::init()
+	{
+		globalPool = TrekDescriptorPool::Builder(trekDevice)
+			.setMaxSets(1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+			.build();
+
+		// Setting up descriptor sets. GlobalUbo lives in the renderer's frame allocator.
 		globalDescriptorSetLayout = TrekDescriptorSetLayout::Builder(trekDevice)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
 			.build();
 
-		for (int i = 0; i < globalDescriptorSets.size(); i++)
-		{
-			auto bufferInfo = uboBuffers[i]->descriptorInfo();
-			TrekDescriptorWriter(*globalDescriptorSetLayout, *globalPool)
-				.writeBuffer(0, &bufferInfo)
-				.build(globalDescriptorSets[i]);
-		}
+		auto bufferInfo = trekRenderer.getFrameAllocator().descriptorInfo(sizeof(GlobalUbo));
+		TrekDescriptorWriter(*globalDescriptorSetLayout, *globalPool)
+			.writeBuffer(0, &bufferInfo)
+			.build(globalDescriptorSet);
 
 		renderSystem = std::make_unique<SimpleRenderSystem>(
 			trekDevice,
 			trekRenderer.getSwapChainRenderPass(),
 			globalDescriptorSetLayout->GetDescriptorSetLayout(),
 			vertexShaderPath,
-			fragmentShaderPath );
+			fragmentShaderPath,
+			vertexFormat,
+			cullBackFaces);
 	}
 }
\ No newline at end of file
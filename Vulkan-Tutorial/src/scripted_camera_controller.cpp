@@ -0,0 +1,75 @@
+#include "scripted_camera_controller.h"
+
+//lib
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <cassert>
+#include <cmath>
+
+namespace Trek
+{
+	ScriptedCameraController::ScriptedCameraController(std::vector<Keyframe> keyframes) : keyframes(std::move(keyframes))
+	{
+		assert(!this->keyframes.empty() && "Scripted camera needs at least one keyframe.");
+	}
+
+	ScriptedCameraController ScriptedCameraController::orbit(
+		const glm::vec3 center,
+		const float radius,
+		const float height,
+		const float period,
+		const int segments)
+	{
+		assert(segments > 0 && period > 0.f && "Orbit needs a positive period and segment count.");
+
+		// +y points down, so a negative height puts the camera above the center and the pitch
+		// comes out negative, looking down on it.
+		const float pitch = std::atan2(height, radius);
+
+		std::vector<Keyframe> keyframes;
+		keyframes.reserve(segments + 1);
+		for (int i = 0; i <= segments; i++)
+		{
+			const float angle = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(segments);
+			Keyframe keyframe{};
+			keyframe.time = period * static_cast<float>(i) / static_cast<float>(segments);
+			keyframe.translation = center + glm::vec3{ radius * std::sin(angle), height, radius * std::cos(angle) };
+			// Yaw keeps increasing past 2pi instead of wrapping so interpolation never spins backwards.
+			keyframe.rotation = glm::vec3{ pitch, angle + glm::pi<float>(), 0.f };
+			keyframes.push_back(keyframe);
+		}
+
+		return ScriptedCameraController(std::move(keyframes));
+	}
+
+	void ScriptedCameraController::advance(const float dt, TrekGameObject& gameObject)
+	{
+		const float duration = keyframes.back().time;
+		elapsed += dt;
+		if (duration > 0.f)
+		{
+			elapsed = std::fmod(elapsed, duration);
+		}
+
+		size_t next = 1;
+		while (next < keyframes.size() && keyframes[next].time < elapsed)
+		{
+			next++;
+		}
+
+		if (next >= keyframes.size())
+		{
+			gameObject.transform2d.translation = keyframes.back().translation;
+			gameObject.transform2d.rotation = keyframes.back().rotation;
+			return;
+		}
+
+		const Keyframe& from = keyframes[next - 1];
+		const Keyframe& to = keyframes[next];
+		const float span = to.time - from.time;
+		const float t = span > 0.f ? (elapsed - from.time) / span : 0.f;
+		gameObject.transform2d.translation = glm::mix(from.translation, to.translation, t);
+		gameObject.transform2d.rotation = glm::mix(from.rotation, to.rotation, t);
+	}
+}
@@ -7,6 +7,7 @@
 
 // std
 #include <array>
+#include <cassert>
 #include <stdexcept>
 
 
@@ -23,10 +24,14 @@ namespace Trek
 		const VkRenderPass renderPass,
 		VkDescriptorSetLayout globalDescriptorSetLayout,
 		std::string vertexShader,
-		std::string fragmentShader) : 
+		std::string fragmentShader,
+		const TrekVertexFormat vertexFormat,
+		const bool cullBackFaces) : 
 		trekDevice{device},
 		vertexShaderPath(vertexShader),
-		fragmentShaderPath(fragmentShader)
+		fragmentShaderPath(fragmentShader),
+		vertexFormat(vertexFormat),
+		cullBackFaces(cullBackFaces)
 	{
 		createPipelineLayout(globalDescriptorSetLayout);
 		createPipeline(renderPass);
@@ -64,8 +69,15 @@ namespace Trek
 		PipelineConfigInfo pipelineConfigInfo{};
 		TrekPipeline::defaultPipelineConfigInfo(pipelineConfigInfo);
 
+		pipelineConfigInfo.vertexInput = TrekVertexLayout::vertexInput(vertexFormat);
 		pipelineConfigInfo.renderPass = renderPass;
 		pipelineConfigInfo.pipelineLayout = pipelineLayout;
+		if (cullBackFaces)
+		{
+			// Counter clockwise on screen is the winding of OBJ faces and of the meshlet cones.
+			pipelineConfigInfo.rasterizationInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+			pipelineConfigInfo.rasterizationInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		}
 		trekPipeline = std::make_unique<TrekPipeline>(
 			trekDevice,
 			vertexShaderPath,
@@ -76,6 +88,7 @@ namespace Trek
 	void SimpleRenderSystem::renderGameObjects(
 		FrameInfo& frameInfo) const
 	{
+		TrekGpuProfiler::Scope gpuScope{ frameInfo.gpuProfiler, frameInfo.commandBuffer, "SimpleRenderSystem" };
 		trekPipeline->bind(frameInfo.commandBuffer);
 
 		vkCmdBindDescriptorSets(
@@ -85,16 +98,39 @@ namespace Trek
 			0,
 			1,
 			&frameInfo.globalDescriptorSet,
-			0,
-			nullptr
+			1,
+			&frameInfo.globalUboOffset
 		);
 
-		for (auto& kv : frameInfo.gameObjects)
+		const TrekFrustum frustum = TrekFrustum::fromMatrix(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+		const glm::vec3 cameraPosition{ glm::inverse(frameInfo.camera.getView())[3] };
+
+		// Models normally share the scene's geometry arena, so geometry is only bound again when
+		// the arena or the index type changes.
+		const TrekGeometryArena* boundArena = nullptr;
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+		// World matrices are up to date, the scene updated them before recording.
+		const std::vector<uint32_t>* visibleObjects = frameInfo.visibleObjects;
+		const TrekEntityStore& objects = frameInfo.gameObjects;
+		const uint32_t count = visibleObjects ? static_cast<uint32_t>(visibleObjects->size()) : objects.size();
+		const glm::mat4* modelMatrices = objects.getWorldMatrices();
+		const glm::mat4* normalMatrices = objects.getNormalMatrices();
+		const TrekModelHandle* models = objects.getModels();
+		uint32_t* lods = frameInfo.gameObjects.getLods();
+		for (uint32_t drawn = 0; drawn < count; drawn++)
 		{
-			auto& obj = kv.second;
+			const uint32_t i = visibleObjects ? (*visibleObjects)[drawn] : drawn;
+			const TrekModelHandle& model = models[i];
+			if (!model.isResident())
+			{
+				continue;
+			}
+			const glm::mat4& modelMatrix = modelMatrices[i];
+			lods[i] = model->selectLod(modelMatrix, frameInfo.camera, static_cast<float>(frameInfo.extent.height), lods[i]);
+
 			SimplePushConstantData push{};
-			push.modelMatrix = obj.transform2d.mat4();
-			push.normalMatrix = obj.transform2d.normalMatrix();
+			push.modelMatrix = modelMatrix * model->getDequantizeMatrix();
+			push.normalMatrix = normalMatrices[i];
 			vkCmdPushConstants(
 				frameInfo.commandBuffer,
 				pipelineLayout,
@@ -103,8 +139,14 @@ namespace Trek
 				sizeof(SimplePushConstantData),
 				&push);
 
-			obj.model->bind(frameInfo.commandBuffer);
-			obj.model->draw(frameInfo.commandBuffer);
+			if (&model->getArena() != boundArena || model->getIndexType() != boundIndexType)
+			{
+				assert(model->getArena().getVertexFormat() == vertexFormat && "Model vertex format must match the pipeline");
+				model->bind(frameInfo.commandBuffer);
+				boundArena = &model->getArena();
+				boundIndexType = model->getIndexType();
+			}
+			model->drawVisibleMeshlets(frameInfo.commandBuffer, lods[i], modelMatrix, frustum, cameraPosition, cullBackFaces);
 		}
 	}
 
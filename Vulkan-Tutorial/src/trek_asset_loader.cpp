@@ -0,0 +1,225 @@
+#include "trek_asset_loader.h"
+#include "trek_cpu_profiler.h"
+#include "trek_vertex_format.h"
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+namespace Trek
+{
+	namespace
+	{
+		bool isGlb(const std::string& filePath)
+		{
+			std::string extension = std::filesystem::path{ filePath }.extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			return extension == ".glb";
+		}
+	}
+
+	TrekAssetLoader::TrekAssetLoader(TrekGeometryArena& arena, TrekUploadQueue& uploadQueue, unsigned threadCount)
+		: arena{ arena }, uploadQueue{ uploadQueue }
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+		}
+		for (unsigned i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back([this, i]()
+			{
+				TrekCpuProfiler::setThreadName("asset loader " + std::to_string(i));
+				workerLoop();
+			});
+		}
+	}
+
+	TrekAssetLoader::~TrekAssetLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+			tasks.clear();
+		}
+		wake.notify_all();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+		// Handles may outlive the loader, they must not report loading forever.
+		for (Job& job : jobs)
+		{
+			job.handle.state->failed = true;
+		}
+	}
+
+	TrekModelHandle TrekAssetLoader::loadModel(const std::string& filePath, const bool optimize, const uint32_t mesh)
+	{
+		// Two imports of one file would also race on writing its cache.
+		for (const Job& job : jobs)
+		{
+			if (job.filePath == filePath && job.optimize == optimize && job.mesh == mesh)
+			{
+				return job.handle;
+			}
+		}
+
+		std::packaged_task<Import()> task{ [filePath, optimize, mesh]()
+		{
+			Import import{};
+			// Content hashes are taken on the worker, so requesting a file costs the main thread no
+			// more than a stat.
+			if (isGlb(filePath))
+			{
+				import.glb = TrekGlbFile::open(filePath);
+				if (mesh >= import.glb->getMeshCount() || import.glb->getIndexCount(mesh) == 0)
+				{
+					throw std::runtime_error(filePath + ": mesh " + std::to_string(mesh) + " does not exist or has no triangles");
+				}
+				import.contentHash = import.glb->computeContentHash();
+				return import;
+			}
+			if (mesh != 0)
+			{
+				throw std::runtime_error(filePath + ": OBJ files only have mesh 0");
+			}
+			// The pool already runs an import per hardware thread, more threads per file would
+			// only oversubscribe it.
+			import.cache = TrekModel::importFile(filePath, import.data, optimize, 1, &import.contentHash);
+			return import;
+		} };
+
+		Job job{ filePath, optimize, mesh, TrekModelHandle{}, task.get_future(), nullptr };
+		job.handle.state = std::make_shared<TrekModelHandle::State>();
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			tasks.push_back(std::move(task));
+		}
+		wake.notify_one();
+		jobs.push_back(std::move(job));
+		return jobs.back().handle;
+	}
+
+	void TrekAssetLoader::update(const VkDeviceSize uploadBudget)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekAssetLoader::update" };
+		VkDeviceSize uploaded = 0;
+		bool created = false;
+		// In request order, but a small file doesn't wait for a big one requested before it.
+		for (auto job = jobs.begin(); job != jobs.end() && uploaded < uploadBudget;)
+		{
+			if (!job->import)
+			{
+				if (job->result.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready)
+				{
+					++job;
+					continue;
+				}
+				try
+				{
+					job->import = std::make_unique<Import>(job->result.get());
+					job->handle.state->contentHash = job->import->contentHash;
+				}
+				catch (...)
+				{
+					job->handle.state->failed = true;
+					jobs.erase(job);
+					if (created)
+					{
+						uploadQueue.flush();
+					}
+					throw;
+				}
+			}
+
+			// Over budget, the import waits for the next update.
+			const VkDeviceSize bytes = geometryBytes(*job->import, job->mesh);
+			if (created && uploaded + bytes > uploadBudget)
+			{
+				break;
+			}
+			try
+			{
+				if (job->import->glb)
+				{
+					job->handle.state->model = job->import->glb->createModel(arena, job->mesh);
+				}
+				else
+				{
+					job->handle.state->model = TrekModel::createFromImport(arena, job->import->cache.get(), job->import->data);
+				}
+			}
+			catch (...)
+			{
+				// E.g. the arena is full. Like a failed import, the models created before it are
+				// still submitted.
+				job->handle.state->failed = true;
+				jobs.erase(job);
+				if (created)
+				{
+					uploadQueue.flush();
+				}
+				throw;
+			}
+			uploaded += bytes;
+			created = true;
+			job = jobs.erase(job);
+		}
+
+		if (created)
+		{
+			uploadQueue.flush();
+		}
+	}
+
+	void TrekAssetLoader::waitAll()
+	{
+		while (!jobs.empty())
+		{
+			if (!jobs.front().import)
+			{
+				jobs.front().result.wait();
+			}
+			update(std::numeric_limits<VkDeviceSize>::max());
+		}
+		uploadQueue.wait(uploadQueue.flush());
+	}
+
+	void TrekAssetLoader::workerLoop()
+	{
+		for (;;)
+		{
+			std::packaged_task<Import()> task;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+				if (stopping)
+				{
+					return;
+				}
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			// Exceptions end up in the future and are rethrown by update().
+			task();
+		}
+	}
+
+	VkDeviceSize TrekAssetLoader::geometryBytes(const Import& import, const uint32_t mesh) const
+	{
+		if (import.glb)
+		{
+			const VkDeviceSize indexSize = import.glb->getIndexType(mesh) == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+			return import.glb->getVertexCount(mesh) * static_cast<VkDeviceSize>(TrekVertexLayout::stride(arena.getVertexFormat())) +
+				import.glb->getIndexCount(mesh) * indexSize;
+		}
+		const VkDeviceSize vertexCount = import.cache ? import.cache->vertexCount() : import.data.vertices.size();
+		const VkDeviceSize indexCount = import.cache ? import.cache->indexCount() : import.data.indices.size();
+		return vertexCount * TrekVertexLayout::stride(arena.getVertexFormat()) + indexCount * sizeof(uint32_t);
+	}
+}
@@ -0,0 +1,182 @@
+#include "trek_asset_registry.h"
+#include "trek_cpu_profiler.h"
+#include "trek_render_target.h"
+
+// std
+#include <filesystem>
+
+namespace Trek
+{
+	TrekAssetRegistry::TrekAssetRegistry(TrekCore& device, const TrekVertexFormat vertexFormat, const VkDeviceSize budget)
+		: arena{ device, vertexFormat, GEOMETRY_ARENA_VERTICES, GEOMETRY_ARENA_INDICES },
+		loader{ arena, device.getUploadQueue() },
+		budget{ budget }
+	{
+	}
+
+	TrekModelHandle TrekAssetRegistry::loadModel(const std::string& filePath, const bool optimize, const uint32_t mesh)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekAssetRegistry::loadModel" };
+		std::error_code error;
+		std::string canonicalPath = std::filesystem::weakly_canonical(filePath, error).string();
+		if (error)
+		{
+			canonicalPath = filePath;
+		}
+
+		// Missing files get a stamp of zeros, the loader reports the error.
+		const uint64_t size = std::filesystem::file_size(canonicalPath, error);
+		const auto mtime = error ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(canonicalPath, error);
+		Key key{ canonicalPath, error ? 0 : size, error ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count()), optimize, mesh };
+		const auto alias = aliases.find(key);
+		if (alias != aliases.end())
+		{
+			if (entries.count(alias->second) > 0)
+			{
+				key = alias->second;
+			}
+			else
+			{
+				aliases.erase(alias);
+			}
+		}
+
+		auto found = entries.find(key);
+		if (found != entries.end() && found->second.handle.isFailed())
+		{
+			// Retried, e.g. after the file was fixed.
+			entries.erase(found);
+			found = entries.end();
+		}
+		if (found != entries.end())
+		{
+			stats.hits++;
+			found->second.lastUsedFrame = frame;
+			return found->second.handle;
+		}
+
+		stats.misses++;
+		Entry entry{};
+		entry.path = canonicalPath;
+		entry.handle = loader.loadModel(canonicalPath, optimize, mesh);
+		entry.lastUsedFrame = frame;
+		return entries.emplace(key, std::move(entry)).first->second.handle;
+	}
+
+	void TrekAssetRegistry::update(const VkDeviceSize uploadBudget)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekAssetRegistry::update" };
+		frame++;
+		while (!retired.empty() && retired.front().first + TrekRenderTarget::MAX_FRAMES_IN_FLIGHT <= frame)
+		{
+			retired.pop_front();
+		}
+
+		loader.update(uploadBudget);
+		refresh();
+	}
+
+	void TrekAssetRegistry::waitAll()
+	{
+		loader.waitAll();
+		refresh();
+	}
+
+	void TrekAssetRegistry::refresh()
+	{
+		for (auto it = entries.begin(); it != entries.end();)
+		{
+			Entry& entry = it->second;
+			if (entry.contentHash == 0 && entry.handle.getContentHash() != 0)
+			{
+				entry.contentHash = entry.handle.getContentHash();
+				const ContentKey content{ entry.contentHash, std::get<3>(it->first), std::get<4>(it->first) };
+				const auto existing = contents.find(content);
+				const auto original = existing != contents.end() ? entries.find(existing->second) : entries.end();
+				if (original != entries.end() && original != it && original->second.contentHash == entry.contentHash)
+				{
+					// Handles already given out keep this copy alive, later requests get the original.
+					aliases[it->first] = original->first;
+					retired.emplace_back(frame, std::move(entry.handle));
+					it = entries.erase(it);
+					stats.merges++;
+					continue;
+				}
+				contents[content] = it->first;
+			}
+			if (entry.gpuBytes == 0 && entry.handle)
+			{
+				const TrekGeometryRange& range = entry.handle->getRange();
+				const VkDeviceSize indexSize = range.indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+				entry.gpuBytes = static_cast<VkDeviceSize>(range.vertexCount) * arena.getVertexStride() + range.indexCount * indexSize;
+			}
+			if (referencesOf(entry) > 0)
+			{
+				entry.lastUsedFrame = frame;
+			}
+			++it;
+		}
+		evictOverBudget();
+	}
+
+	TrekAssetRegistry::Stats TrekAssetRegistry::getStats() const
+	{
+		Stats result = stats;
+		result.assets = entries.size();
+		for (const auto& [key, entry] : entries)
+		{
+			result.loading += entry.handle.isLoading() ? 1 : 0;
+			result.gpuBytes += entry.gpuBytes;
+		}
+		return result;
+	}
+
+	std::vector<TrekAssetRegistry::AssetInfo> TrekAssetRegistry::getAssets() const
+	{
+		std::vector<AssetInfo> assets;
+		assets.reserve(entries.size());
+		for (const auto& [key, entry] : entries)
+		{
+			assets.push_back({ entry.path, entry.contentHash, referencesOf(entry), entry.gpuBytes, entry.lastUsedFrame });
+		}
+		return assets;
+	}
+
+	long TrekAssetRegistry::referencesOf(const Entry& entry) const
+	{
+		// Minus the registry's own handle, and the loader's while the import is queued.
+		return entry.handle.useCount() - 1 - (entry.handle.isLoading() ? 1 : 0);
+	}
+
+	void TrekAssetRegistry::evictOverBudget()
+	{
+		VkDeviceSize total = 0;
+		for (const auto& [key, entry] : entries)
+		{
+			total += entry.gpuBytes;
+		}
+
+		while (total > budget)
+		{
+			auto victim = entries.end();
+			for (auto it = entries.begin(); it != entries.end(); ++it)
+			{
+				if (it->second.gpuBytes > 0 && referencesOf(it->second) == 0 &&
+					(victim == entries.end() || it->second.lastUsedFrame < victim->second.lastUsedFrame))
+				{
+					victim = it;
+				}
+			}
+			if (victim == entries.end())
+			{
+				// Everything left is in use, the budget is exceeded until references drop.
+				return;
+			}
+
+			total -= victim->second.gpuBytes;
+			retired.emplace_back(frame, std::move(victim->second.handle));
+			entries.erase(victim);
+			stats.evictions++;
+		}
+	}
+}
@@ -51,33 +51,37 @@ namespace Trek {
     TrekBuffer::~TrekBuffer() {
         unmap();
         vkDestroyBuffer(trekDevice.device(), buffer, nullptr);
-        vkFreeMemory(trekDevice.device(), memory, nullptr);
+        trekDevice.getAllocator().free(memory);
     }
 
     /**
-     * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
+     * Points mapped at the buffer from offset on. If successful, everything past offset stays
+     * accessible until unmap().
+     *
+     * @note Host visible memory blocks are persistently mapped by TrekMemoryAllocator, so this only
+     * hands out a pointer into that mapping and never calls vkMapMemory
      *
-     * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
-     * buffer range.
      * @param offset (Optional) Byte offset from beginning
      *
-     * @return VkResult of the buffer mapping call
+     * @return VK_ERROR_MEMORY_MAP_FAILED if the buffer's memory is not host visible, VK_SUCCESS otherwise
      */
-    VkResult TrekBuffer::map(const VkDeviceSize size, const VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(trekDevice.device(), memory, offset, size, 0, &mapped);
+    VkResult TrekBuffer::map(const VkDeviceSize offset) {
+        assert(buffer && memory.memory && "Called map on buffer before create");
+        if (memory.mapped == nullptr) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped = static_cast<char*>(memory.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     /**
-     * Unmap a mapped memory range
+     * Forgets the pointer handed out by map()
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The memory itself stays mapped until TrekMemoryAllocator frees its block, so this never
+     * calls vkUnmapMemory and can't fail
      */
     void TrekBuffer::unmap() {
-        if (mapped) {
-            vkUnmapMemory(trekDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
     /**
@@ -116,11 +120,7 @@ namespace Trek {
      */
     VkResult TrekBuffer::flush(const VkDeviceSize size, const VkDeviceSize offset) const
     {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        const VkMappedMemoryRange mappedRange = trekDevice.getAllocator().mappedRange(memory, offset, size);
         return vkFlushMappedMemoryRanges(trekDevice.device(), 1, &mappedRange);
     }
 
@@ -137,11 +137,7 @@ namespace Trek {
      */
     VkResult TrekBuffer::invalidate(const VkDeviceSize size, const VkDeviceSize offset) const
     {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        const VkMappedMemoryRange mappedRange = trekDevice.getAllocator().mappedRange(memory, offset, size);
         return vkInvalidateMappedMemoryRanges(trekDevice.device(), 1, &mappedRange);
     }
 
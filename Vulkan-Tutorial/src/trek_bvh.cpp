@@ -0,0 +1,741 @@
+#include "trek_bvh.h"
+#include "trek_cpu_profiler.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace Trek
+{
+	namespace
+	{
+		using Aabb = TrekBvh::Aabb;
+
+		void grow(Aabb& box, const Aabb& other)
+		{
+			box.min = glm::min(box.min, other.min);
+			box.max = glm::max(box.max, other.max);
+		}
+
+		void grow(Aabb& box, const glm::vec3& point)
+		{
+			box.min = glm::min(box.min, point);
+			box.max = glm::max(box.max, point);
+		}
+
+		glm::vec3 centroid(const Aabb& box)
+		{
+			return box.isEmpty() ? glm::vec3{ 0.f } : (box.min + box.max) * 0.5f;
+		}
+
+		// Half the surface area, all the heuristic needs.
+		float area(const Aabb& box)
+		{
+			if (box.isEmpty())
+			{
+				return 0.f;
+			}
+			const glm::vec3 size = box.max - box.min;
+			return size.x * size.y + size.y * size.z + size.z * size.x;
+		}
+
+		// Distance to the plane of the box corner furthest along its normal and of the one furthest
+		// against it. The first sums like TrekFrustum::intersectsBox, so queries agree with it exactly.
+		float furthestDistance(const glm::vec4& plane, const Aabb& box)
+		{
+			const glm::vec3 corner{ plane.x >= 0.f ? box.max.x : box.min.x, plane.y >= 0.f ? box.max.y : box.min.y, plane.z >= 0.f ? box.max.z : box.min.z };
+			return glm::dot(glm::vec3{ plane }, corner) + plane.w;
+		}
+
+		float nearestDistance(const glm::vec4& plane, const Aabb& box)
+		{
+			const glm::vec3 corner{ plane.x >= 0.f ? box.min.x : box.max.x, plane.y >= 0.f ? box.min.y : box.max.y, plane.z >= 0.f ? box.min.z : box.max.z };
+			return glm::dot(glm::vec3{ plane }, corner) + plane.w;
+		}
+
+		constexpr uint32_t ALL_PLANES = (1u << TrekFrustum::PLANE_COUNT) - 1;
+	}
+
+	void TrekBvh::build(const std::vector<Aabb>& bounds)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekBvh::build" };
+		const uint32_t count = static_cast<uint32_t>(bounds.size());
+		buildItems.clear();
+		buildBounds.clear();
+		buildItems.reserve(count);
+		buildBounds.reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (!bounds[i].isEmpty())
+			{
+				buildItems.push_back(i);
+				buildBounds.push_back(bounds[i]);
+			}
+		}
+		positions.assign(count, INVALID_INDEX);
+		itemLeaves.assign(count, INVALID_INDEX);
+		buildTree();
+	}
+
+	void TrekBvh::buildAll()
+	{
+		buildItems.clear();
+		buildBounds.clear();
+		for (uint32_t item = 0; item < positions.size(); item++)
+		{
+			if (positions[item] != INVALID_INDEX)
+			{
+				buildItems.push_back(item);
+				buildBounds.push_back(itemBounds[positions[item]]);
+			}
+		}
+		buildTree();
+	}
+
+	void TrekBvh::buildTree()
+	{
+		const uint32_t count = static_cast<uint32_t>(buildItems.size());
+		nodes.clear();
+		items.clear();
+		itemBounds.clear();
+		nodes.reserve(count / MAX_LEAF_ITEMS * 2 + 1);
+		items.reserve(count + count / 2 + MAX_LEAF_ITEMS);
+		itemBounds.reserve(items.capacity());
+		nodes.emplace_back();
+		nodes[0].count = count;
+		buildSubtree(0, 0);
+
+		// Whatever changed is in the new boxes already.
+		changedNodes.clear();
+		marked.assign(nodes.size(), 0);
+		stats.items = count;
+		stats.nodes = static_cast<uint32_t>(nodes.size());
+		stats.garbageNodes = 0;
+		stats.garbageSlots = 0;
+		stats.fullBuilds++;
+	}
+
+	void TrekBvh::buildSubtree(const uint32_t node, const uint32_t depth)
+	{
+		Aabb bounds{};
+		Aabb centroids{};
+		centers.resize(buildItems.size());
+		for (uint32_t i = nodes[node].first; i < nodes[node].first + nodes[node].count; i++)
+		{
+			centers[i] = centroid(buildBounds[i]);
+			grow(bounds, buildBounds[i]);
+			grow(centroids, centers[i]);
+		}
+		nodes[node].bounds = bounds;
+		buildNode(node, depth, centroids);
+	}
+
+	void TrekBvh::buildNode(const uint32_t node, const uint32_t depth, const Aabb& centroids)
+	{
+		const uint32_t first = nodes[node].first;
+		const uint32_t count = nodes[node].count;
+		nodes[node].buildArea = area(nodes[node].bounds);
+		nodes[node].left = INVALID_INDEX;
+		if (count <= MAX_LEAF_ITEMS)
+		{
+			makeLeaf(node);
+			return;
+		}
+
+		Aabb childBounds[2]{};
+		Aabb childCentroids[2]{};
+		const uint32_t split = partition(first, count, centroids, depth, childBounds, childCentroids);
+		// Children are appended as a pair, so a rebuilt subtree never has to fit the old one's slots.
+		const uint32_t left = static_cast<uint32_t>(nodes.size());
+		nodes.resize(nodes.size() + 2);
+		nodes[left].first = first;
+		nodes[left].count = split - first;
+		nodes[left + 1].first = split;
+		nodes[left + 1].count = first + count - split;
+		for (uint32_t child = 0; child < 2; child++)
+		{
+			nodes[left + child].bounds = childBounds[child];
+			nodes[left + child].parent = node;
+		}
+		nodes[node].left = left;
+		buildNode(left, depth + 1, childCentroids[0]);
+		buildNode(left + 1, depth + 1, childCentroids[1]);
+	}
+
+	uint32_t TrekBvh::partition(
+		const uint32_t first,
+		const uint32_t count,
+		const Aabb& centroids,
+		const uint32_t depth,
+		Aabb childBounds[2],
+		Aabb childCentroids[2])
+	{
+		const uint32_t end = first + count;
+		const glm::vec3 extent = centroids.max - centroids.min;
+
+		// Binned along the axis the centroids spread furthest on only, a third of the work of trying
+		// all three for a slightly worse tree.
+		const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+		if (depth < MAX_SAH_DEPTH && extent[axis] > 0.f)
+		{
+			const float scale = SAH_BINS / extent[axis];
+			const auto binOf = [&](const uint32_t i)
+			{
+				return std::min(static_cast<uint32_t>((centers[i][axis] - centroids.min[axis]) * scale), SAH_BINS - 1);
+			};
+			uint32_t binCounts[SAH_BINS]{};
+			Aabb binBounds[SAH_BINS]{};
+			for (uint32_t i = first; i < end; i++)
+			{
+				const uint32_t bin = binOf(i);
+				binCounts[bin]++;
+				grow(binBounds[bin], buildBounds[i]);
+			}
+
+			// Cost of each split between bins, as items times area on either side.
+			float rightCosts[SAH_BINS]{};
+			Aabb rightBounds[SAH_BINS]{};
+			uint32_t rightCount = 0;
+			for (uint32_t bin = SAH_BINS - 1; bin > 0; bin--)
+			{
+				rightBounds[bin - 1] = bin + 1 < SAH_BINS ? rightBounds[bin] : Aabb{};
+				grow(rightBounds[bin - 1], binBounds[bin]);
+				rightCount += binCounts[bin];
+				rightCosts[bin] = rightCount * area(rightBounds[bin - 1]);
+			}
+			float bestCost = std::numeric_limits<float>::max();
+			uint32_t bestBin = 0;
+			Aabb left{};
+			uint32_t leftCount = 0;
+			for (uint32_t bin = 1; bin < SAH_BINS; bin++)
+			{
+				grow(left, binBounds[bin - 1]);
+				leftCount += binCounts[bin - 1];
+				const float cost = leftCount * area(left) + rightCosts[bin];
+				if (leftCount > 0 && leftCount < count && cost < bestCost)
+				{
+					bestCost = cost;
+					bestBin = bin;
+					childBounds[0] = left;
+					childBounds[1] = rightBounds[bin - 1];
+				}
+			}
+
+			if (bestBin > 0)
+			{
+				uint32_t split = first;
+				for (uint32_t i = first; i < end; i++)
+				{
+					if (binOf(i) < bestBin)
+					{
+						grow(childCentroids[0], centers[i]);
+						swapBuildItems(i, split++);
+					}
+					else
+					{
+						grow(childCentroids[1], centers[i]);
+					}
+				}
+				return split;
+			}
+		}
+
+		// Too deep or all centroids in one spot: halve by count.
+		std::vector<uint32_t> order(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			order[i] = first + i;
+		}
+		const uint32_t split = first + count / 2;
+		std::nth_element(order.begin(), order.begin() + count / 2, order.end(), [&](const uint32_t a, const uint32_t b)
+		{
+			return centers[a][axis] < centers[b][axis];
+		});
+
+		std::vector<uint32_t> sortedItems(count);
+		std::vector<Aabb> sortedBounds(count);
+		std::vector<glm::vec3> sortedCenters(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			sortedItems[i] = buildItems[order[i]];
+			sortedBounds[i] = buildBounds[order[i]];
+			sortedCenters[i] = centers[order[i]];
+		}
+		for (uint32_t i = 0; i < count; i++)
+		{
+			buildItems[first + i] = sortedItems[i];
+			buildBounds[first + i] = sortedBounds[i];
+			centers[first + i] = sortedCenters[i];
+			const uint32_t child = first + i < split ? 0 : 1;
+			grow(childBounds[child], sortedBounds[i]);
+			grow(childCentroids[child], sortedCenters[i]);
+		}
+		return split;
+	}
+
+	void TrekBvh::swapBuildItems(const uint32_t a, const uint32_t b)
+	{
+		std::swap(buildItems[a], buildItems[b]);
+		std::swap(buildBounds[a], buildBounds[b]);
+		std::swap(centers[a], centers[b]);
+	}
+
+	void TrekBvh::makeLeaf(const uint32_t node)
+	{
+		const uint32_t block = static_cast<uint32_t>(items.size());
+		items.resize(block + MAX_LEAF_ITEMS, INVALID_INDEX);
+		itemBounds.resize(block + MAX_LEAF_ITEMS);
+		const uint32_t first = nodes[node].first;
+		for (uint32_t i = 0; i < nodes[node].count; i++)
+		{
+			const uint32_t item = buildItems[first + i];
+			items[block + i] = item;
+			itemBounds[block + i] = buildBounds[first + i];
+			positions[item] = block + i;
+			itemLeaves[item] = node;
+		}
+		nodes[node].first = block;
+	}
+
+	void TrekBvh::insert(const uint32_t item, const Aabb& bounds)
+	{
+		assert(!contains(item) && "Item already in the BVH");
+		if (item >= positions.size())
+		{
+			positions.resize(item + 1, INVALID_INDEX);
+			itemLeaves.resize(item + 1, INVALID_INDEX);
+		}
+		if (nodes.empty())
+		{
+			buildItems.clear();
+			buildBounds.clear();
+			buildTree();
+		}
+		stats.items++;
+
+		// Down to the child whose box grows least, counting the item in every node on the way.
+		uint32_t node = 0;
+		uint32_t depth = 0;
+		while (nodes[node].left != INVALID_INDEX)
+		{
+			nodes[node].count++;
+			const auto growth = [&](const uint32_t child)
+			{
+				Aabb grown = nodes[child].bounds;
+				grow(grown, bounds);
+				return area(grown) - area(nodes[child].bounds);
+			};
+			const uint32_t left = nodes[node].left;
+			node = growth(left + 1) < growth(left) ? left + 1 : left;
+			depth++;
+		}
+
+		Node& leaf = nodes[node];
+		if (leaf.count < MAX_LEAF_ITEMS)
+		{
+			const uint32_t slot = leaf.first + leaf.count++;
+			items[slot] = item;
+			itemBounds[slot] = bounds;
+			positions[item] = slot;
+			itemLeaves[item] = node;
+			markChanged(node);
+			return;
+		}
+		// A full leaf is split. Past the depth where splits stop using the heuristic, a subtree
+		// further up is rebuilt instead, which keeps the tree within MAX_DEPTH.
+		while (depth >= MAX_SAH_DEPTH)
+		{
+			node = nodes[node].parent;
+			depth--;
+		}
+		rebuildSubtree(node, item, bounds);
+	}
+
+	void TrekBvh::remove(const uint32_t item)
+	{
+		assert(contains(item) && "Item not in the BVH");
+		const uint32_t leaf = itemLeaves[item];
+		// The leaf's last item fills the hole.
+		const uint32_t slot = positions[item];
+		const uint32_t last = nodes[leaf].first + --nodes[leaf].count;
+		items[slot] = items[last];
+		itemBounds[slot] = itemBounds[last];
+		positions[items[slot]] = slot;
+		items[last] = INVALID_INDEX;
+		itemBounds[last] = Aabb{};
+		positions[item] = INVALID_INDEX;
+		itemLeaves[item] = INVALID_INDEX;
+		for (uint32_t node = nodes[leaf].parent; node != INVALID_INDEX; node = nodes[node].parent)
+		{
+			nodes[node].count--;
+		}
+		stats.items--;
+		markChanged(leaf);
+	}
+
+	void TrekBvh::setBounds(const uint32_t item, const Aabb& bounds)
+	{
+		assert(contains(item) && "Item not in the BVH");
+		itemBounds[positions[item]] = bounds;
+		markChanged(itemLeaves[item]);
+	}
+
+	void TrekBvh::markChanged(const uint32_t node)
+	{
+		if (!marked[node])
+		{
+			marked[node] = 1;
+			changedNodes.push_back(node);
+		}
+	}
+
+	TrekBvh::Aabb TrekBvh::computeBounds(const Node& node) const
+	{
+		Aabb bounds{};
+		if (node.left != INVALID_INDEX)
+		{
+			bounds = nodes[node.left].bounds;
+			grow(bounds, nodes[node.left + 1].bounds);
+			return bounds;
+		}
+		for (uint32_t i = node.first; i < node.first + node.count; i++)
+		{
+			grow(bounds, itemBounds[i]);
+		}
+		return bounds;
+	}
+
+	void TrekBvh::refit(const float rebuildRatio, const uint32_t maxRebuildItems)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekBvh::refit" };
+		// Up each changed node's path until a box stops changing, remembering the topmost interior
+		// node that outgrew its build. Nodes cleared by a rebuild since have no parent and no items,
+		// so they stop right away.
+		degradedNodes.clear();
+		for (const uint32_t changed : changedNodes)
+		{
+			marked[changed] = 0;
+			uint32_t degraded = INVALID_INDEX;
+			for (uint32_t node = changed; node != INVALID_INDEX; node = nodes[node].parent)
+			{
+				const Aabb bounds = computeBounds(nodes[node]);
+				if (bounds.min == nodes[node].bounds.min && bounds.max == nodes[node].bounds.max)
+				{
+					break;
+				}
+				nodes[node].bounds = bounds;
+				if (nodes[node].left != INVALID_INDEX && area(bounds) > rebuildRatio * nodes[node].buildArea)
+				{
+					degraded = node;
+				}
+			}
+			if (degraded != INVALID_INDEX && !marked[degraded])
+			{
+				marked[degraded] = 1;
+				degradedNodes.push_back(degraded);
+			}
+		}
+		changedNodes.clear();
+
+		// Subtrees inside another degraded one go with it. Unmarking a nested one early is safe, the
+		// ancestor that made it nested is above anything below it too.
+		uint32_t kept = 0;
+		for (const uint32_t node : degradedNodes)
+		{
+			bool nested = false;
+			for (uint32_t ancestor = nodes[node].parent; ancestor != INVALID_INDEX && !nested; ancestor = nodes[ancestor].parent)
+			{
+				nested = marked[ancestor] != 0;
+			}
+			if (nested)
+			{
+				marked[node] = 0;
+			}
+			else
+			{
+				degradedNodes[kept++] = node;
+			}
+		}
+		degradedNodes.resize(kept);
+		for (const uint32_t node : degradedNodes)
+		{
+			marked[node] = 0;
+		}
+
+		if (std::find(degradedNodes.begin(), degradedNodes.end(), 0u) != degradedNodes.end())
+		{
+			buildAll();
+			return;
+		}
+		// Over budget subtrees wait until their items move again.
+		uint32_t budget = maxRebuildItems;
+		for (const uint32_t node : degradedNodes)
+		{
+			if (nodes[node].count > budget)
+			{
+				continue;
+			}
+			budget -= nodes[node].count;
+			rebuildSubtree(node, INVALID_INDEX, Aabb{});
+		}
+		if (stats.garbageNodes * 2 > stats.nodes || stats.garbageSlots * 2 > items.size())
+		{
+			buildAll();
+		}
+	}
+
+	void TrekBvh::collectItems(const uint32_t node)
+	{
+		const Node& current = nodes[node];
+		if (current.left == INVALID_INDEX)
+		{
+			for (uint32_t i = current.first; i < current.first + current.count; i++)
+			{
+				buildItems.push_back(items[i]);
+				buildBounds.push_back(itemBounds[i]);
+				items[i] = INVALID_INDEX;
+			}
+			stats.garbageSlots += MAX_LEAF_ITEMS;
+			return;
+		}
+		const uint32_t left = current.left;
+		for (uint32_t child = left; child < left + 2; child++)
+		{
+			collectItems(child);
+			nodes[child] = Node{};
+		}
+		stats.garbageNodes += 2;
+	}
+
+	uint32_t TrekBvh::depthOf(const uint32_t node) const
+	{
+		uint32_t depth = 0;
+		for (uint32_t ancestor = nodes[node].parent; ancestor != INVALID_INDEX; ancestor = nodes[ancestor].parent)
+		{
+			depth++;
+		}
+		return depth;
+	}
+
+	void TrekBvh::rebuildSubtree(const uint32_t node, const uint32_t extraItem, const Aabb& extraBounds)
+	{
+		buildItems.clear();
+		buildBounds.clear();
+		collectItems(node);
+		if (extraItem != INVALID_INDEX)
+		{
+			buildItems.push_back(extraItem);
+			buildBounds.push_back(extraBounds);
+		}
+		nodes[node].first = 0;
+		nodes[node].count = static_cast<uint32_t>(buildItems.size());
+		buildSubtree(node, depthOf(node));
+		marked.resize(nodes.size(), 0);
+		stats.nodes = static_cast<uint32_t>(nodes.size());
+		stats.partialRebuilds++;
+		// Without a new item it holds the same boxes, so the ones above it are still right.
+		if (extraItem != INVALID_INDEX && nodes[node].parent != INVALID_INDEX)
+		{
+			markChanged(nodes[node].parent);
+		}
+	}
+
+	void TrekBvh::queryFrustum(const TrekFrustum& frustum, std::vector<uint32_t>& result) const
+	{
+		TrekCpuProfiler::Zone zone{ "TrekBvh::queryFrustum" };
+		if (nodes.empty() || nodes[0].count == 0)
+		{
+			return;
+		}
+
+		// Planes a node is entirely inside of are dropped for everything below it.
+		struct Entry {
+			uint32_t node;
+			uint32_t planes;
+		};
+		Entry stack[MAX_DEPTH + 1];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = { 0, ALL_PLANES };
+		while (stackSize > 0)
+		{
+			const Entry entry = stack[--stackSize];
+			const Node& node = nodes[entry.node];
+			if (node.count == 0)
+			{
+				continue;
+			}
+			uint32_t planes = entry.planes;
+			bool outside = false;
+			for (int plane = 0; plane < TrekFrustum::PLANE_COUNT && !outside; plane++)
+			{
+				if (planes & (1u << plane))
+				{
+					outside = furthestDistance(frustum.planes[plane], node.bounds) < 0.f;
+					if (nearestDistance(frustum.planes[plane], node.bounds) >= 0.f)
+					{
+						planes &= ~(1u << plane);
+					}
+				}
+			}
+			if (outside)
+			{
+				continue;
+			}
+
+			// Below a node inside every plane the tests are skipped, but the items are still only
+			// in the leaves.
+			if (node.left != INVALID_INDEX)
+			{
+				assert(stackSize + 2 <= MAX_DEPTH + 1 && "BVH deeper than MAX_DEPTH");
+				stack[stackSize++] = { node.left + 1, planes };
+				stack[stackSize++] = { node.left, planes };
+				continue;
+			}
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				const Aabb& box = itemBounds[i];
+				if (box.isEmpty())
+				{
+					continue;
+				}
+				bool inside = true;
+				for (int plane = 0; plane < TrekFrustum::PLANE_COUNT && inside; plane++)
+				{
+					inside = !(planes & (1u << plane)) || furthestDistance(frustum.planes[plane], box) >= 0.f;
+				}
+				if (inside)
+				{
+					result.push_back(items[i]);
+				}
+			}
+		}
+	}
+
+	void TrekBvh::queryRadius(const glm::vec3& center, const float radius, std::vector<uint32_t>& result) const
+	{
+		if (nodes.empty() || nodes[0].count == 0)
+		{
+			return;
+		}
+
+		uint32_t stack[MAX_DEPTH + 1];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const Node& node = nodes[stack[--stackSize]];
+			if (!overlapsSphere(node.bounds, center, radius))
+			{
+				continue;
+			}
+			if (node.left != INVALID_INDEX)
+			{
+				assert(stackSize + 2 <= MAX_DEPTH + 1 && "BVH deeper than MAX_DEPTH");
+				stack[stackSize++] = node.left + 1;
+				stack[stackSize++] = node.left;
+				continue;
+			}
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				if (overlapsSphere(itemBounds[i], center, radius))
+				{
+					result.push_back(items[i]);
+				}
+			}
+		}
+	}
+
+	uint32_t TrekBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, float* hitDistance) const
+	{
+		if (nodes.empty() || nodes[0].count == 0)
+		{
+			return INVALID_INDEX;
+		}
+
+		const glm::vec3 inverseDirection = 1.f / direction;
+		uint32_t hit = INVALID_INDEX;
+		float best = maxDistance;
+		// Nearer child on top, and nodes that start beyond the best hit so far are skipped.
+		struct Entry {
+			uint32_t node;
+			float distance;
+		};
+		Entry stack[MAX_DEPTH + 1];
+		uint32_t stackSize = 0;
+		const float rootDistance = intersectRay(nodes[0].bounds, origin, inverseDirection, best);
+		if (rootDistance >= 0.f)
+		{
+			stack[stackSize++] = { 0, rootDistance };
+		}
+		while (stackSize > 0)
+		{
+			const Entry entry = stack[--stackSize];
+			if (entry.distance > best)
+			{
+				continue;
+			}
+			const Node& node = nodes[entry.node];
+			if (node.left == INVALID_INDEX)
+			{
+				for (uint32_t i = node.first; i < node.first + node.count; i++)
+				{
+					const float distance = intersectRay(itemBounds[i], origin, inverseDirection, best);
+					if (distance >= 0.f && (distance < best || hit == INVALID_INDEX))
+					{
+						best = distance;
+						hit = items[i];
+					}
+				}
+				continue;
+			}
+
+			Entry nearer{ node.left, intersectRay(nodes[node.left].bounds, origin, inverseDirection, best) };
+			Entry farther{ node.left + 1, intersectRay(nodes[node.left + 1].bounds, origin, inverseDirection, best) };
+			if (farther.distance >= 0.f && (nearer.distance < 0.f || farther.distance < nearer.distance))
+			{
+				std::swap(nearer, farther);
+			}
+			assert(stackSize + 2 <= MAX_DEPTH + 1 && "BVH deeper than MAX_DEPTH");
+			if (farther.distance >= 0.f)
+			{
+				stack[stackSize++] = farther;
+			}
+			if (nearer.distance >= 0.f)
+			{
+				stack[stackSize++] = nearer;
+			}
+		}
+
+		if (hitDistance != nullptr && hit != INVALID_INDEX)
+		{
+			*hitDistance = best;
+		}
+		return hit;
+	}
+
+	bool TrekBvh::overlapsSphere(const Aabb& box, const glm::vec3& center, const float radius)
+	{
+		if (box.isEmpty())
+		{
+			return false;
+		}
+		const glm::vec3 offset = glm::clamp(center, box.min, box.max) - center;
+		return glm::dot(offset, offset) <= radius * radius;
+	}
+
+	float TrekBvh::intersectRay(const Aabb& box, const glm::vec3& origin, const glm::vec3& inverseDirection, const float maxDistance)
+	{
+		if (box.isEmpty())
+		{
+			return -1.f;
+		}
+		// Slabs: where the ray is between each pair of faces.
+		const glm::vec3 toMin = (box.min - origin) * inverseDirection;
+		const glm::vec3 toMax = (box.max - origin) * inverseDirection;
+		const glm::vec3 entry = glm::min(toMin, toMax);
+		const glm::vec3 exit = glm::max(toMin, toMax);
+		const float enter = std::max({ entry.x, entry.y, entry.z, 0.f });
+		const float leave = std::min({ exit.x, exit.y, exit.z });
+		return enter <= leave && enter <= maxDistance ? enter : -1.f;
+	}
+}
@@ -1,9 +1,12 @@
 #include "trek_core.h"
+#include "trek_upload_queue.h"
 #include <vulkan/vulkan_core.h>
 
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <map>
 #include <set>
 #include <unordered_set>
 
@@ -48,26 +51,42 @@ namespace Trek {
         }
     }
 
-    TrekCore::TrekCore(TrekWindow& window) : window{window} 
+    TrekCore::TrekCore(TrekWindow& window) : window{&window}
+    {
+        init();
+    }
+
+    TrekCore::TrekCore() : window{nullptr}
+    {
+        init();
+    }
+
+    void TrekCore::init()
     {
         createInstance();
         setupDebugMessenger();
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
+        allocator = std::make_unique<TrekMemoryAllocator>(device_, physicalDevice);
         createCommandPool();
+        uploadQueue = std::make_unique<TrekUploadQueue>(*this, UPLOAD_STAGING_BYTES);
     }
 
     TrekCore::~TrekCore()
     {
+        uploadQueue.reset();
         vkDestroyCommandPool(device_, commandPool, nullptr);
+        allocator.reset();
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers) {
             DestroyDebugUtilsMessengerExt(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (!isHeadless()) {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -82,7 +101,8 @@ namespace Trek {
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        // 1.1 for vkGet*MemoryRequirements2 and dedicated allocations.
+        appInfo.apiVersion = VK_API_VERSION_1_1;
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -141,15 +161,18 @@ namespace Trek {
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+        // Queues needed per family, the transfer queue may be a second queue of the graphics family.
+        std::map<uint32_t, uint32_t> queueCounts = { { indices.graphicsFamily, 1 }, { indices.presentFamily, 1 } };
+        queueCounts[indices.transferFamily] = std::max(queueCounts[indices.transferFamily], indices.transferQueueIndex + 1);
+        const auto requiredDeviceExtensions = getRequiredDeviceExtensions();
 
-        float queuePriority = 1.0f;
-        for (uint32_t queueFamily : uniqueQueueFamilies) {
+        const float queuePriorities[] = { 1.0f, 1.0f };
+        for (const auto& [queueFamily, queueCount] : queueCounts) {
             VkDeviceQueueCreateInfo queueCreateInfo = {};
             queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
             queueCreateInfo.queueFamilyIndex = queueFamily;
-            queueCreateInfo.queueCount = 1;
-            queueCreateInfo.pQueuePriorities = &queuePriority;
+            queueCreateInfo.queueCount = queueCount;
+            queueCreateInfo.pQueuePriorities = queuePriorities;
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
@@ -163,8 +186,8 @@ namespace Trek {
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(requiredDeviceExtensions.size());
+        createInfo.ppEnabledExtensionNames = requiredDeviceExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -182,6 +205,7 @@ namespace Trek {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, indices.transferFamily, indices.transferQueueIndex, &transferQueue_);
     }
 
     void TrekCore::createCommandPool() {
@@ -198,7 +222,11 @@ namespace Trek {
         }
     }
 
-    void TrekCore::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void TrekCore::createSurface()
+    {
+        if (isHeadless()) return;
+        window->createWindowSurface(instance, &surface_);
+    }
 
     bool TrekCore::isDeviceSuitable(VkPhysicalDevice device) const
     {
@@ -206,17 +234,20 @@ namespace Trek {
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        // Headless devices never present, so any device with a graphics queue will do.
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless()) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
 
         VkPhysicalDeviceFeatures supportedFeatures;
         vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(device, &deviceProperties);
 
         return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-            supportedFeatures.samplerAnisotropy;
+            supportedFeatures.samplerAnisotropy && deviceProperties.apiVersion >= VK_API_VERSION_1_1;
     }
 
     void TrekCore::populateDebugMessengerCreateInfo(
@@ -269,10 +300,12 @@ namespace Trek {
 
     std::vector<const char*> TrekCore::getRequiredExtensions() const
     {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char*> extensions{};
+        if (!isHeadless()) {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -281,6 +314,14 @@ namespace Trek {
         return extensions;
     }
 
+    std::vector<const char*> TrekCore::getRequiredDeviceExtensions() const
+    {
+        if (isHeadless()) {
+            return {};
+        }
+        return deviceExtensions;
+    }
+
     void TrekCore::hasGflwRequiredInstanceExtensions() const
     {
         uint32_t extensionCount = 0;
@@ -317,7 +358,8 @@ namespace Trek {
             &extensionCount,
             availableExtensions.data());
 
-        std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+        const auto deviceExtensionNames = getRequiredDeviceExtensions();
+        std::set<std::string> requiredExtensions(deviceExtensionNames.begin(), deviceExtensionNames.end());
 
         for (const auto& extension : availableExtensions) {
             requiredExtensions.erase(extension.extensionName);
@@ -342,8 +384,14 @@ namespace Trek {
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
+            // Without a surface there is nothing to present to, so the graphics queue stands in.
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (isHeadless()) {
+                presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+            }
+            else {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            }
             if (queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
@@ -355,6 +403,31 @@ namespace Trek {
             i++;
         }
 
+        if (!indices.graphicsFamilyHasValue) {
+            return indices;
+        }
+
+        // Uploads prefer a transfer-only family, then any other non-graphics family (compute queues
+        // can always transfer), then a second graphics queue and finally share the graphics queue.
+        int transferScore = 0;
+        for (uint32_t family = 0; family < queueFamilyCount; family++) {
+            const VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if (queueFamilies[family].queueCount == 0 || (flags & VK_QUEUE_GRAPHICS_BIT) ||
+                !(flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT))) {
+                continue;
+            }
+            const int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+            if (score > transferScore) {
+                transferScore = score;
+                indices.transferFamily = family;
+                indices.transferQueueIndex = 0;
+            }
+        }
+        if (transferScore == 0) {
+            indices.transferFamily = indices.graphicsFamily;
+            indices.transferQueueIndex = queueFamilies[indices.graphicsFamily].queueCount > 1 ? 1 : 0;
+        }
+
         return indices;
     }
 
@@ -405,16 +478,7 @@ namespace Trek {
 
     uint32_t TrekCore::findMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags properties) const
     {
-        VkPhysicalDeviceMemoryProperties memProperties;
-        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-            if ((typeFilter & (1 << i)) &&
-                (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-                return i;
-            }
-        }
-
-        throw std::runtime_error("failed to find suitable memory type!");
+        return allocator->findMemoryType(typeFilter, properties);
     }
 
     void TrekCore::createBuffer(
@@ -422,7 +486,7 @@ namespace Trek {
 	    const VkBufferUsageFlags usage,
 	    const VkMemoryPropertyFlags memoryProperties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory) const
+        TrekAllocation& bufferMemory) const
     {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -434,19 +498,8 @@ namespace Trek {
             throw std::runtime_error("failed to create vertex buffer!");
         }
 
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, memoryProperties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
-
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+        bufferMemory = allocator->allocateBuffer(buffer, memoryProperties);
+        vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset);
     }
 
     VkCommandBuffer TrekCore::beginSingleTimeCommands() const
@@ -528,25 +581,18 @@ namespace Trek {
         const VkImageCreateInfo& imageInfo,
         const VkMemoryPropertyFlags memoryProperties,
         VkImage& image,
-        VkDeviceMemory& imageMemory) const
+        TrekAllocation& imageMemory) const
     {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
 
-        VkMemoryRequirements memRequirements;
-        vkGetImageMemoryRequirements(device_, image, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, memoryProperties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
+        const auto kind = imageInfo.tiling == VK_IMAGE_TILING_LINEAR
+            ? TrekMemoryAllocator::ResourceKind::Linear
+            : TrekMemoryAllocator::ResourceKind::Optimal;
+        imageMemory = allocator->allocateImage(image, memoryProperties, kind);
 
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
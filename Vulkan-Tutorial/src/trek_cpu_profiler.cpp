@@ -0,0 +1,249 @@
+#include "trek_cpu_profiler.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace Trek
+{
+	std::atomic<bool> TrekCpuProfiler::enabled{ true };
+	std::mutex TrekCpuProfiler::registryMutex;
+	std::vector<std::unique_ptr<TrekCpuProfiler::ThreadBuffer>> TrekCpuProfiler::threadBuffers;
+
+	double TrekCpuProfiler::frameBudgetMs = 0.0;
+	std::vector<uint64_t> TrekCpuProfiler::frameStarts;
+	uint64_t TrekCpuProfiler::frameCount = 0;
+	uint64_t TrekCpuProfiler::lastDumpFrame = 0;
+	std::string TrekCpuProfiler::flightRecorderDirectory;
+
+	void TrekCpuProfiler::ThreadBuffer::push(const char* name, const uint64_t timestamp, const EventType type)
+	{
+		const uint64_t index = head.load(std::memory_order_relaxed);
+		Event& event = events[index & (EVENTS_PER_THREAD - 1)];
+		event.name.store(name, std::memory_order_relaxed);
+		event.timestamp.store(timestamp, std::memory_order_relaxed);
+		event.type.store(type, std::memory_order_relaxed);
+		head.store(index + 1, std::memory_order_release);
+	}
+
+	std::vector<TrekCpuProfiler::EventCopy> TrekCpuProfiler::ThreadBuffer::snapshot(const uint64_t since) const
+	{
+		const uint64_t end = head.load(std::memory_order_acquire);
+		const uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+
+		std::vector<EventCopy> copies;
+		copies.reserve(static_cast<size_t>(end - begin));
+		for (uint64_t i = begin; i < end; i++)
+		{
+			const Event& event = events[i & (EVENTS_PER_THREAD - 1)];
+			copies.push_back({
+				event.name.load(std::memory_order_relaxed),
+				event.timestamp.load(std::memory_order_relaxed),
+				event.type.load(std::memory_order_relaxed) });
+		}
+
+		// Anything the producer lapped while we were copying may be torn, drop it. That includes the
+		// slot of event `after`, which the producer may be writing right now.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t after = head.load(std::memory_order_relaxed);
+		const uint64_t firstValid = after >= EVENTS_PER_THREAD ? after - EVENTS_PER_THREAD + 1 : 0;
+		if (firstValid > begin)
+		{
+			copies.erase(copies.begin(), copies.begin() + static_cast<std::ptrdiff_t>(std::min(firstValid - begin, end - begin)));
+		}
+
+		copies.erase(
+			std::remove_if(copies.begin(), copies.end(), [since](const EventCopy& event) { return event.timestamp < since; }),
+			copies.end());
+		return copies;
+	}
+
+	TrekCpuProfiler::ThreadBuffer& TrekCpuProfiler::threadBuffer()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (buffer == nullptr)
+		{
+			std::lock_guard<std::mutex> lock{ registryMutex };
+			threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+			buffer = threadBuffers.back().get();
+			buffer->threadId = static_cast<uint32_t>(threadBuffers.size());
+			buffer->threadName = "thread " + std::to_string(buffer->threadId);
+		}
+		return *buffer;
+	}
+
+	uint64_t TrekCpuProfiler::now()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	void TrekCpuProfiler::beginZone(const char* name)
+	{
+		if (enabled.load(std::memory_order_relaxed))
+		{
+			threadBuffer().push(name, now(), EventType::Begin);
+		}
+	}
+
+	void TrekCpuProfiler::endZone(const char* name)
+	{
+		// Ends are recorded even when disabled so zones that straddle setEnabled(false) still close.
+		threadBuffer().push(name, now(), EventType::End);
+	}
+
+	void TrekCpuProfiler::setThreadName(const std::string& name)
+	{
+		ThreadBuffer& buffer = threadBuffer();
+		std::lock_guard<std::mutex> lock{ registryMutex };
+		buffer.threadName = name;
+	}
+
+	void TrekCpuProfiler::setEnabled(const bool enable)
+	{
+		enabled.store(enable, std::memory_order_relaxed);
+	}
+
+	void TrekCpuProfiler::enableFlightRecorder(const double budgetMs, const uint32_t frames, const std::string& directory)
+	{
+		frameBudgetMs = budgetMs;
+		frameStarts.assign(std::max<uint32_t>(frames, 1) + 1, 0);
+		flightRecorderDirectory = directory;
+	}
+
+	void TrekCpuProfiler::markFrame()
+	{
+		const uint64_t timestamp = now();
+		threadBuffer().push("frame", timestamp, EventType::Frame);
+
+		if (frameBudgetMs <= 0.0 || frameStarts.empty())
+		{
+			return;
+		}
+
+		// frameStarts[frameCount % size] is the start of the frame that ends now, the slot after it
+		// is the start of the oldest frame still covered by the recorder.
+		const size_t slots = frameStarts.size();
+		const uint64_t frameStart = frameStarts[frameCount % slots];
+		const uint64_t windowStart = frameStarts[(frameCount + 1) % slots];
+		frameCount++;
+		frameStarts[frameCount % slots] = timestamp;
+
+		const uint32_t frames = static_cast<uint32_t>(slots - 1);
+		const double frameMs = static_cast<double>(timestamp - frameStart) / 1e6;
+		if (frameCount > slots && frameMs > frameBudgetMs && frameCount - lastDumpFrame >= frames)
+		{
+			lastDumpFrame = frameCount;
+			dumpFlightRecorder(windowStart, frameCount);
+			std::cerr << "frame " << frameCount << " took " << frameMs << "ms (budget " << frameBudgetMs
+				<< "ms), dumped last " << frames << " frames" << std::endl;
+		}
+	}
+
+	void TrekCpuProfiler::dumpFlightRecorder(const uint64_t since, const uint64_t frame)
+	{
+		const std::string path = flightRecorderDirectory + "/flight_" + std::to_string(frame) + ".json";
+		std::ofstream out{ path };
+		if (!out.is_open())
+		{
+			std::cerr << "failed to write flight recorder dump " << path << std::endl;
+			return;
+		}
+		writeTrace(out, since);
+	}
+
+	void TrekCpuProfiler::exportChromeTrace(std::ostream& out)
+	{
+		writeTrace(out, 0);
+	}
+
+	void TrekCpuProfiler::exportChromeTrace(const std::string& path)
+	{
+		std::ofstream out{ path };
+		if (!out.is_open())
+		{
+			throw std::runtime_error("failed to open trace file " + path);
+		}
+		writeTrace(out, 0);
+	}
+
+	void TrekCpuProfiler::writeTrace(std::ostream& out, const uint64_t since)
+	{
+		struct ThreadEvents {
+			uint32_t threadId;
+			std::string threadName;
+			std::vector<EventCopy> events;
+		};
+
+		std::vector<ThreadEvents> threads;
+		{
+			std::lock_guard<std::mutex> lock{ registryMutex };
+			for (const auto& buffer : threadBuffers)
+			{
+				threads.push_back({ buffer->threadId, buffer->threadName, buffer->snapshot(since) });
+			}
+		}
+
+		out << std::fixed << std::setprecision(3);
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		const auto separator = [&out, &first]()
+		{
+			out << (first ? "" : ",\n");
+			first = false;
+		};
+
+		for (const auto& thread : threads)
+		{
+			separator();
+			out << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << thread.threadId
+				<< R"(,"args":{"name":")" << thread.threadName << "\"}}";
+
+			// The window can start in the middle of a zone: drop ends without a begin and close
+			// whatever is still open at the last timestamp so viewers don't mis-nest the rest.
+			std::vector<const char*> open;
+			uint64_t last = 0;
+			for (const auto& event : thread.events)
+			{
+				last = event.timestamp;
+				const double microseconds = static_cast<double>(event.timestamp) / 1000.0;
+				if (event.type == EventType::End && open.empty())
+				{
+					continue;
+				}
+
+				separator();
+				if (event.type == EventType::Frame)
+				{
+					out << R"({"name":"frame","ph":"i","s":"g","pid":1,"tid":)" << thread.threadId
+						<< ",\"ts\":" << microseconds << "}";
+					continue;
+				}
+
+				if (event.type == EventType::Begin)
+				{
+					open.push_back(event.name);
+				}
+				else
+				{
+					open.pop_back();
+				}
+				out << "{\"name\":\"" << event.name << "\",\"ph\":\"" << (event.type == EventType::Begin ? "B" : "E")
+					<< "\",\"pid\":1,\"tid\":" << thread.threadId << ",\"ts\":" << microseconds << "}";
+			}
+
+			while (!open.empty())
+			{
+				separator();
+				out << "{\"name\":\"" << open.back() << "\",\"ph\":\"E\",\"pid\":1,\"tid\":" << thread.threadId
+					<< ",\"ts\":" << static_cast<double>(last) / 1000.0 << "}";
+				open.pop_back();
+			}
+		}
+		out << "\n]}\n";
+	}
+}
@@ -0,0 +1,309 @@
+#include "trek_entity_store.h"
+#include "trek_cpu_profiler.h"
+#include "trek_transform_kernel.h"
+
+// std
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace Trek
+{
+	namespace
+	{
+		template <typename T>
+		void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+		{
+			std::vector<T> permuted;
+			permuted.reserve(values.size());
+			for (const uint32_t index : order)
+			{
+				permuted.push_back(std::move(values[index]));
+			}
+			values = std::move(permuted);
+		}
+	}
+
+	TrekEntityStore::id_t TrekEntityStore::create(const TrekTransformComponent& transform, TrekModelHandle model, const glm::vec3& color)
+	{
+		id_t id;
+		if (!freeIds.empty())
+		{
+			id = freeIds.back();
+			freeIds.pop_back();
+		}
+		else
+		{
+			id = static_cast<id_t>(sparse.size());
+			sparse.push_back(INVALID_INDEX);
+		}
+
+		sparse[id] = size();
+		ids.push_back(id);
+		transforms.push_back(transform);
+		colors.push_back(color);
+		models.push_back(std::move(model));
+		lods.push_back(0);
+		parents.push_back(INVALID_ID);
+		parentIndices.push_back(INVALID_INDEX);
+		childCounts.push_back(0);
+		worldMatrices.emplace_back(1.f);
+		normalMatrices.emplace_back(1.f);
+		dirty.push_back(0);
+		markDirty(size() - 1);
+		pendingChangedIds.push_back(id);
+		return id;
+	}
+
+	void TrekEntityStore::destroy(const id_t id)
+	{
+		uint32_t index = indexOf(id);
+		if (childCounts[index] > 0)
+		{
+			const id_t parent = parents[index];
+			for (uint32_t i = 0; i < size() && childCounts[index] > 0; i++)
+			{
+				if (parents[i] == id)
+				{
+					setParent(ids[i], parent);
+				}
+			}
+		}
+		setParent(id, INVALID_ID);
+
+		const uint32_t last = size() - 1;
+		if (index != last)
+		{
+			ids[index] = ids[last];
+			transforms[index] = transforms[last];
+			colors[index] = colors[last];
+			models[index] = std::move(models[last]);
+			lods[index] = lods[last];
+			parents[index] = parents[last];
+			parentIndices[index] = parentIndices[last];
+			childCounts[index] = childCounts[last];
+			worldMatrices[index] = worldMatrices[last];
+			normalMatrices[index] = normalMatrices[last];
+			dirty[index] = dirty[last];
+			sparse[ids[index]] = index;
+			if (dirty[index])
+			{
+				firstDirty = std::min(firstDirty, index);
+			}
+			// The last entity has no children after it, but its parent may now come after it.
+			if (parents[index] != INVALID_ID && sparse[parents[index]] > index)
+			{
+				unsorted = true;
+			}
+			parentIndicesStale = parentIndicesStale || childCounts[index] > 0;
+		}
+
+		ids.pop_back();
+		transforms.pop_back();
+		colors.pop_back();
+		models.pop_back();
+		lods.pop_back();
+		parents.pop_back();
+		parentIndices.pop_back();
+		childCounts.pop_back();
+		worldMatrices.pop_back();
+		normalMatrices.pop_back();
+		dirty.pop_back();
+		sparse[id] = INVALID_INDEX;
+		freeIds.push_back(id);
+		pendingChangedIds.push_back(id);
+	}
+
+	void TrekEntityStore::clear()
+	{
+		pendingChangedIds.insert(pendingChangedIds.end(), ids.begin(), ids.end());
+		ids.clear();
+		sparse.clear();
+		freeIds.clear();
+		transforms.clear();
+		colors.clear();
+		models.clear();
+		lods.clear();
+		parents.clear();
+		parentIndices.clear();
+		childCounts.clear();
+		worldMatrices.clear();
+		normalMatrices.clear();
+		dirty.clear();
+		firstDirty = INVALID_INDEX;
+		unsorted = false;
+		parentIndicesStale = false;
+		updateIndices.clear();
+	}
+
+	void TrekEntityStore::reserve(const size_t count)
+	{
+		ids.reserve(count);
+		sparse.reserve(count);
+		transforms.reserve(count);
+		colors.reserve(count);
+		models.reserve(count);
+		lods.reserve(count);
+		parents.reserve(count);
+		parentIndices.reserve(count);
+		childCounts.reserve(count);
+		worldMatrices.reserve(count);
+		normalMatrices.reserve(count);
+		dirty.reserve(count);
+	}
+
+	void TrekEntityStore::setParent(const id_t id, const id_t parent)
+	{
+		const uint32_t index = indexOf(id);
+		if (parents[index] == parent)
+		{
+			return;
+		}
+		for (id_t ancestor = parent; ancestor != INVALID_ID; ancestor = parents[indexOf(ancestor)])
+		{
+			assert(ancestor != id && "Parenting would create a cycle");
+		}
+
+		if (parents[index] != INVALID_ID)
+		{
+			childCounts[indexOf(parents[index])]--;
+		}
+		parents[index] = parent;
+		parentIndices[index] = parent == INVALID_ID ? INVALID_INDEX : indexOf(parent);
+		if (parent != INVALID_ID)
+		{
+			childCounts[parentIndices[index]]++;
+			unsorted = unsorted || parentIndices[index] > index;
+		}
+		markDirty(index);
+	}
+
+	void TrekEntityStore::setModel(const id_t id, TrekModelHandle model)
+	{
+		models[indexOf(id)] = std::move(model);
+		pendingChangedIds.push_back(id);
+	}
+
+	TrekTransformComponent* TrekEntityStore::getTransforms()
+	{
+		if (!dirty.empty())
+		{
+			std::fill(dirty.begin(), dirty.end(), uint8_t{ 1 });
+			firstDirty = 0;
+		}
+		return transforms.data();
+	}
+
+	uint32_t TrekEntityStore::markDirty(const uint32_t index)
+	{
+		dirty[index] = 1;
+		firstDirty = std::min(firstDirty, index);
+		return index;
+	}
+
+	void TrekEntityStore::updateWorldMatrices()
+	{
+		TrekCpuProfiler::Zone zone{ "TrekEntityStore::updateWorldMatrices" };
+		updateIndices.clear();
+		changedIds.swap(pendingChangedIds);
+		pendingChangedIds.clear();
+		if (unsorted)
+		{
+			sortByDepth();
+		}
+		else if (parentIndicesStale)
+		{
+			refreshParentIndices();
+		}
+		if (firstDirty >= size())
+		{
+			firstDirty = INVALID_INDEX;
+			return;
+		}
+
+		// Parents come first, so a dirty parent has flagged its children by the time they are reached.
+		updateTransforms.clear();
+		for (uint32_t i = firstDirty; i < size(); i++)
+		{
+			if (!dirty[i])
+			{
+				if (parentIndices[i] == INVALID_INDEX || !dirty[parentIndices[i]])
+				{
+					continue;
+				}
+				dirty[i] = 1;
+			}
+			updateIndices.push_back(i);
+			updateTransforms.push_back(transforms[i]);
+		}
+
+		const uint32_t updatedCount = getUpdatedCount();
+		localMatrices.resize(updatedCount);
+		localNormalMatrices.resize(updatedCount);
+		TrekTransformKernel::compute(updateTransforms.data(), updatedCount, localMatrices.data(), localNormalMatrices.data());
+
+		// The inverse transpose of a product is the product of the inverse transposes.
+		for (uint32_t j = 0; j < updatedCount; j++)
+		{
+			const uint32_t i = updateIndices[j];
+			if (parentIndices[i] == INVALID_INDEX)
+			{
+				worldMatrices[i] = localMatrices[j];
+				normalMatrices[i] = localNormalMatrices[j];
+			}
+			else
+			{
+				worldMatrices[i] = worldMatrices[parentIndices[i]] * localMatrices[j];
+				normalMatrices[i] = normalMatrices[parentIndices[i]] * localNormalMatrices[j];
+			}
+			dirty[i] = 0;
+		}
+		firstDirty = INVALID_INDEX;
+	}
+
+	void TrekEntityStore::sortByDepth()
+	{
+		std::vector<uint32_t> depths(size());
+		for (uint32_t i = 0; i < size(); i++)
+		{
+			for (id_t ancestor = parents[i]; ancestor != INVALID_ID; ancestor = parents[sparse[ancestor]])
+			{
+				depths[i]++;
+			}
+		}
+
+		std::vector<uint32_t> order(size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) { return depths[a] < depths[b]; });
+
+		permute(ids, order);
+		permute(transforms, order);
+		permute(colors, order);
+		permute(models, order);
+		permute(lods, order);
+		permute(parents, order);
+		permute(childCounts, order);
+		permute(worldMatrices, order);
+		permute(normalMatrices, order);
+		permute(dirty, order);
+		for (uint32_t i = 0; i < size(); i++)
+		{
+			sparse[ids[i]] = i;
+		}
+		refreshParentIndices();
+		if (firstDirty != INVALID_INDEX)
+		{
+			firstDirty = 0;
+		}
+		unsorted = false;
+	}
+
+	void TrekEntityStore::refreshParentIndices()
+	{
+		for (uint32_t i = 0; i < size(); i++)
+		{
+			parentIndices[i] = parents[i] == INVALID_ID ? INVALID_INDEX : sparse[parents[i]];
+		}
+		parentIndicesStale = false;
+	}
+}
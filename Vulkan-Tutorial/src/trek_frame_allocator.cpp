@@ -0,0 +1,80 @@
+#include "trek_frame_allocator.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Trek
+{
+	namespace
+	{
+		VkDeviceSize alignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+	}
+
+	TrekFrameAllocator::TrekFrameAllocator(TrekCore& device, const uint32_t framesInFlight, const VkDeviceSize bytesPerFrame) :
+		trekDevice{ device }
+	{
+		const VkPhysicalDeviceLimits& limits = trekDevice.properties.limits;
+		alignment = std::max<VkDeviceSize>({
+			limits.minUniformBufferOffsetAlignment,
+			limits.minStorageBufferOffsetAlignment,
+			limits.nonCoherentAtomSize,
+			16 });
+		this->bytesPerFrame = alignUp(bytesPerFrame, alignment);
+
+		buffer = std::make_unique<TrekBuffer>(
+			trekDevice,
+			this->bytesPerFrame,
+			framesInFlight,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		buffer->map();
+
+		const uint32_t memoryType = buffer->getAllocation().memoryType;
+		coherent = (trekDevice.getAllocator().getMemoryTypeFlags(memoryType) & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	}
+
+	void TrekFrameAllocator::beginFrame(const int frameIndex)
+	{
+		assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < buffer->getInstanceCount() && "Frame index out of range");
+		frameStart = bytesPerFrame * static_cast<VkDeviceSize>(frameIndex);
+		head = frameStart;
+	}
+
+	void TrekFrameAllocator::flush()
+	{
+		if (coherent || head == frameStart)
+		{
+			return;
+		}
+		if (buffer->flush(head - frameStart, frameStart) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to flush frame allocator!");
+		}
+	}
+
+	TrekFrameAllocator::Slice TrekFrameAllocator::allocate(const VkDeviceSize size)
+	{
+		const VkDeviceSize offset = alignUp(head, alignment);
+		if (offset + size > frameStart + bytesPerFrame)
+		{
+			throw std::runtime_error("frame allocator is out of space for this frame!");
+		}
+		head = offset + size;
+
+		Slice slice{};
+		slice.data = static_cast<char*>(buffer->getMappedMemory()) + offset;
+		slice.offset = static_cast<uint32_t>(offset);
+		slice.size = size;
+		return slice;
+	}
+
+	VkDescriptorBufferInfo TrekFrameAllocator::descriptorInfo(const VkDeviceSize range) const
+	{
+		return VkDescriptorBufferInfo{ buffer->getBuffer(), 0, range };
+	}
+}
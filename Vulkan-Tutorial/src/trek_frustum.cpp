@@ -0,0 +1,51 @@
+#include "trek_frustum.h"
+
+namespace Trek
+{
+	TrekFrustum TrekFrustum::fromMatrix(const glm::mat4& projectionView)
+	{
+		const auto row = [&projectionView](const int i)
+		{
+			return glm::vec4{ projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i] };
+		};
+
+		TrekFrustum frustum{};
+		frustum.planes[LEFT] = row(3) + row(0);
+		frustum.planes[RIGHT] = row(3) - row(0);
+		frustum.planes[BOTTOM] = row(3) + row(1);
+		frustum.planes[TOP] = row(3) - row(1);
+		// Clip space z runs from 0 to w rather than -w to w.
+		frustum.planes[NEAR_PLANE] = row(2);
+		frustum.planes[FAR_PLANE] = row(3) - row(2);
+		for (glm::vec4& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3{ plane });
+		}
+		return frustum;
+	}
+
+	bool TrekFrustum::intersectsSphere(const glm::vec3& center, const float radius) const
+	{
+		for (const glm::vec4& plane : planes)
+		{
+			if (glm::dot(glm::vec3{ plane }, center) + plane.w < -radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool TrekFrustum::intersectsBox(const glm::vec3& min, const glm::vec3& max) const
+	{
+		for (const glm::vec4& plane : planes)
+		{
+			const glm::vec3 corner{ plane.x >= 0.f ? max.x : min.x, plane.y >= 0.f ? max.y : min.y, plane.z >= 0.f ? max.z : min.z };
+			if (glm::dot(glm::vec3{ plane }, corner) + plane.w < 0.f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
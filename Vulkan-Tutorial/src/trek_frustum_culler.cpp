@@ -0,0 +1,251 @@
+#include "trek_frustum_culler.h"
+#include "trek_cpu_profiler.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+// SSE2 is part of x64 and of MSVC's default Win32 target.
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define TREK_FRUSTUM_CULLER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Trek
+{
+	namespace
+	{
+		// Arvo: the model's box moved to world space and boxed again.
+		TrekBvh::Aabb worldBox(const TrekModel::Bounds& bounds, const glm::mat4& world)
+		{
+			const glm::vec3 center{ world * glm::vec4{ (bounds.min + bounds.max) * .5f, 1.f } };
+			const glm::vec3 halfSize = (bounds.max - bounds.min) * .5f;
+			const glm::vec3 extent =
+				glm::abs(glm::vec3{ world[0] }) * halfSize.x +
+				glm::abs(glm::vec3{ world[1] }) * halfSize.y +
+				glm::abs(glm::vec3{ world[2] }) * halfSize.z;
+			return { center - extent, center + extent };
+		}
+	}
+
+	void TrekFrustumCuller::cull(const TrekEntityStore& objects, const TrekFrustum& frustum)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekFrustumCuller::cull" };
+		visible.clear();
+		if (objects.size() >= BVH_MIN_OBJECTS)
+		{
+			cullBvh(objects, frustum);
+			return;
+		}
+		bvhReady = false;
+		cullSpheres(objects, frustum);
+	}
+
+	void TrekFrustumCuller::cullSpheres(const TrekEntityStore& objects, const TrekFrustum& frustum)
+	{
+		centerX.clear();
+		centerY.clear();
+		centerZ.clear();
+		radius.clear();
+		candidates.clear();
+
+		const glm::mat4* worldMatrices = objects.getWorldMatrices();
+		const TrekModelHandle* models = objects.getModels();
+		for (uint32_t i = 0; i < objects.size(); i++)
+		{
+			if (!models[i].isResident())
+			{
+				continue;
+			}
+			const TrekModel::Sphere& sphere = models[i]->getBoundingSphere();
+			const glm::mat4& world = worldMatrices[i];
+			const glm::vec3 center{ world * glm::vec4{ sphere.center, 1.f } };
+			// The longest axis bounds any non uniform scale.
+			const float scale = std::sqrt(std::max({
+				glm::dot(glm::vec3{ world[0] }, glm::vec3{ world[0] }),
+				glm::dot(glm::vec3{ world[1] }, glm::vec3{ world[1] }),
+				glm::dot(glm::vec3{ world[2] }, glm::vec3{ world[2] }) }));
+			centerX.push_back(center.x);
+			centerY.push_back(center.y);
+			centerZ.push_back(center.z);
+			radius.push_back(sphere.radius * scale);
+			candidates.push_back(i);
+		}
+
+		const uint32_t count = static_cast<uint32_t>(candidates.size());
+		cullSpheres(frustum, centerX.data(), centerY.data(), centerZ.data(), radius.data(), count, visible);
+		for (uint32_t& index : visible)
+		{
+			index = candidates[index];
+		}
+		stats.visible = static_cast<uint32_t>(visible.size());
+		stats.culled = count - stats.visible;
+	}
+
+	void TrekFrustumCuller::cullBvh(const TrekEntityStore& objects, const TrekFrustum& frustum)
+	{
+		const TrekEntityStore::id_t* ids = objects.getIds();
+		const glm::mat4* worldMatrices = objects.getWorldMatrices();
+		const TrekModelHandle* models = objects.getModels();
+		loading.resize(objects.getIdCapacity(), 0);
+		if (!bvhReady)
+		{
+			bvhBounds.assign(objects.getIdCapacity(), TrekBvh::Aabb{});
+			std::fill(loading.begin(), loading.end(), uint8_t{ 0 });
+			loadingIds.clear();
+			for (uint32_t i = 0; i < objects.size(); i++)
+			{
+				if (models[i].isResident())
+				{
+					bvhBounds[ids[i]] = worldBox(models[i]->getBounds(), worldMatrices[i]);
+				}
+				else
+				{
+					loading[ids[i]] = 1;
+					loadingIds.push_back(ids[i]);
+				}
+			}
+			bvh.build(bvhBounds);
+			bvhReady = true;
+		}
+		else
+		{
+			for (const TrekEntityStore::id_t id : objects.getChangedIds())
+			{
+				if (objects.contains(id))
+				{
+					trackObject(objects, id, objects.indexOf(id));
+				}
+				else if (bvh.contains(id))
+				{
+					bvh.remove(id);
+				}
+			}
+			for (const uint32_t i : objects.getUpdatedIndices())
+			{
+				trackObject(objects, ids[i], i);
+			}
+			// Destroyed ones just leave the list.
+			for (size_t j = 0; j < loadingIds.size();)
+			{
+				const TrekEntityStore::id_t id = loadingIds[j];
+				const bool exists = objects.contains(id);
+				if (exists && !models[objects.indexOf(id)].isResident())
+				{
+					j++;
+					continue;
+				}
+				loading[id] = 0;
+				loadingIds[j] = loadingIds.back();
+				loadingIds.pop_back();
+				if (exists)
+				{
+					trackObject(objects, id, objects.indexOf(id));
+				}
+			}
+			bvh.refit();
+		}
+
+		bvhHits.clear();
+		bvh.queryFrustum(frustum, bvhHits);
+		for (const uint32_t id : bvhHits)
+		{
+			visible.push_back(objects.indexOf(id));
+		}
+		// Dense order keeps the draws walking the component arrays forwards.
+		std::sort(visible.begin(), visible.end());
+		stats.visible = static_cast<uint32_t>(visible.size());
+		stats.culled = bvh.getStats().items - stats.visible;
+	}
+
+	void TrekFrustumCuller::trackObject(const TrekEntityStore& objects, const TrekEntityStore::id_t id, const uint32_t index)
+	{
+		const TrekModelHandle& model = objects.getModels()[index];
+		if (model.isResident())
+		{
+			const TrekBvh::Aabb bounds = worldBox(model->getBounds(), objects.getWorldMatrices()[index]);
+			if (bvh.contains(id))
+			{
+				bvh.setBounds(id, bounds);
+			}
+			else
+			{
+				bvh.insert(id, bounds);
+			}
+			return;
+		}
+		if (bvh.contains(id))
+		{
+			bvh.remove(id);
+		}
+		if (!loading[id])
+		{
+			loading[id] = 1;
+			loadingIds.push_back(id);
+		}
+	}
+
+	void TrekFrustumCuller::cullSpheres(
+		const TrekFrustum& frustum,
+		const float* centerX,
+		const float* centerY,
+		const float* centerZ,
+		const float* radius,
+		const uint32_t count,
+		std::vector<uint32_t>& visible,
+		const bool vectorized)
+	{
+		uint32_t i = 0;
+#ifdef TREK_FRUSTUM_CULLER_SSE2
+		if (vectorized)
+		{
+			__m128 planeX[TrekFrustum::PLANE_COUNT];
+			__m128 planeY[TrekFrustum::PLANE_COUNT];
+			__m128 planeZ[TrekFrustum::PLANE_COUNT];
+			__m128 planeW[TrekFrustum::PLANE_COUNT];
+			for (int plane = 0; plane < TrekFrustum::PLANE_COUNT; plane++)
+			{
+				planeX[plane] = _mm_set1_ps(frustum.planes[plane].x);
+				planeY[plane] = _mm_set1_ps(frustum.planes[plane].y);
+				planeZ[plane] = _mm_set1_ps(frustum.planes[plane].z);
+				planeW[plane] = _mm_set1_ps(frustum.planes[plane].w);
+			}
+			const __m128 signMask = _mm_set1_ps(-0.f);
+
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128 x = _mm_loadu_ps(centerX + i);
+				const __m128 y = _mm_loadu_ps(centerY + i);
+				const __m128 z = _mm_loadu_ps(centerZ + i);
+				const __m128 negativeRadius = _mm_xor_ps(_mm_loadu_ps(radius + i), signMask);
+				// Summed in intersectsSphere's order, so both agree on spheres touching a plane.
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (int plane = 0; plane < TrekFrustum::PLANE_COUNT; plane++)
+				{
+					__m128 distance = _mm_mul_ps(planeX[plane], x);
+					distance = _mm_add_ps(distance, _mm_mul_ps(planeY[plane], y));
+					distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[plane], z));
+					distance = _mm_add_ps(distance, planeW[plane]);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+				}
+
+				const int mask = _mm_movemask_ps(inside);
+				for (uint32_t lane = 0; lane < 4; lane++)
+				{
+					if (mask & (1 << lane))
+					{
+						visible.push_back(i + lane);
+					}
+				}
+			}
+		}
+#endif
+		for (; i < count; i++)
+		{
+			if (frustum.intersectsSphere({ centerX[i], centerY[i], centerZ[i] }, radius[i]))
+			{
+				visible.push_back(i);
+			}
+		}
+	}
+}
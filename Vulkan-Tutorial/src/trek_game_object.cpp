@@ -5,7 +5,7 @@ namespace Trek
 	// Matrix corresponds to Translate * Ry * Rx * Rz * Scale
 	// Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
 	// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
-	glm::mat4 TrekGameObject::TransformComponent::mat4() {
+	glm::mat4 TrekTransformComponent::mat4() const {
 		const float c3 = glm::cos(rotation.z);
 		const float s3 = glm::sin(rotation.z);
 		const float c2 = glm::cos(rotation.x);
@@ -33,7 +33,7 @@ namespace Trek
 					},
 			{ translation.x, translation.y, translation.z, 1.0f } };
 	}
-	glm::mat3 TrekGameObject::TransformComponent::normalMatrix()
+	glm::mat3 TrekTransformComponent::normalMatrix() const
 	{
 		const float c3 = glm::cos(rotation.z);
 		const float s3 = glm::sin(rotation.z);
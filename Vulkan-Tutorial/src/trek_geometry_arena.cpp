@@ -0,0 +1,168 @@
+#include "trek_geometry_arena.h"
+
+// std
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace Trek
+{
+	TrekGeometryArena::TrekGeometryArena(
+		TrekCore& device,
+		const TrekVertexFormat vertexFormat,
+		const uint32_t vertexCapacity,
+		const uint32_t indexCapacity) :
+		trekDevice{ device },
+		vertexFormat{ vertexFormat },
+		vertexStride{ TrekVertexLayout::stride(vertexFormat) },
+		vertexRanges{ vertexCapacity },
+		indexRanges{ 2ull * indexCapacity }
+	{
+		assert(vertexCapacity > 0 && indexCapacity > 0 && "Geometry arena capacities must be non zero");
+
+		vertexBuffer = std::make_unique<TrekBuffer>(
+			trekDevice,
+			vertexStride,
+			vertexCapacity,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		indexBuffer = std::make_unique<TrekBuffer>(
+			trekDevice,
+			sizeof(uint32_t),
+			indexCapacity,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+
+	TrekGeometryRange TrekGeometryArena::allocate(
+		const void* vertices,
+		const uint32_t vertexCount,
+		const void* indices,
+		const uint32_t indexCount,
+		const VkIndexType indexType)
+	{
+		const uint32_t stride = vertexStride;
+		const uint32_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+		const auto* vertexBytes = static_cast<const char*>(vertices);
+		const auto* indexBytes = static_cast<const char*>(indices);
+		return allocate(
+			vertexCount,
+			[=](void* destination, const uint32_t first, const uint32_t count)
+			{
+				memcpy(destination, vertexBytes + static_cast<size_t>(first) * stride, static_cast<size_t>(count) * stride);
+			},
+			indexCount,
+			[=](void* destination, const uint32_t first, const uint32_t count)
+			{
+				memcpy(destination, indexBytes + static_cast<size_t>(first) * indexSize, static_cast<size_t>(count) * indexSize);
+			},
+			indexType);
+	}
+
+	TrekGeometryRange TrekGeometryArena::allocate(
+		const uint32_t vertexCount,
+		const Writer& writeVertices,
+		const uint32_t indexCount,
+		const Writer& writeIndices,
+		const VkIndexType indexType)
+	{
+		TrekGeometryRange range = reserve(vertexCount, indexCount, indexType);
+		range.uploadTicket = upload(range, writeVertices, writeIndices);
+		return range;
+	}
+
+	TrekGeometryRange TrekGeometryArena::reserve(const uint32_t vertexCount, const uint32_t indexCount, const VkIndexType indexType)
+	{
+		assert((indexType == VK_INDEX_TYPE_UINT16 || indexType == VK_INDEX_TYPE_UINT32) && "Unsupported index type");
+		assert(vertexCount > 0 && "Geometry range needs at least one vertex");
+
+		TrekGeometryRange range{};
+		const TrekTlsfAllocator::Allocation vertexRange = vertexRanges.allocate(vertexCount);
+		if (!vertexRange.valid())
+		{
+			throw std::runtime_error("geometry arena is out of vertex space!");
+		}
+		range.firstVertex = static_cast<uint32_t>(vertexRange.offset);
+		range.vertexCount = vertexCount;
+		range.vertexNode = vertexRange.node;
+
+		if (indexCount > 0)
+		{
+			// 32 bit indices take two aligned slots, so firstIndex stays exact in either index type.
+			const uint32_t slots = indexType == VK_INDEX_TYPE_UINT16 ? 1 : 2;
+			const TrekTlsfAllocator::Allocation indexRange = indexRanges.allocate(static_cast<uint64_t>(indexCount) * slots, slots);
+			if (!indexRange.valid())
+			{
+				vertexRanges.free(range.vertexNode);
+				throw std::runtime_error("geometry arena is out of index space!");
+			}
+			range.firstIndex = static_cast<uint32_t>(indexRange.offset / slots);
+			range.indexType = indexType;
+			range.indexCount = indexCount;
+			range.indexNode = indexRange.node;
+		}
+
+		return range;
+	}
+
+	void TrekGeometryArena::free(TrekGeometryRange& range)
+	{
+		if (range.vertexNode != TrekTlsfAllocator::INVALID_NODE)
+		{
+			vertexRanges.free(range.vertexNode);
+		}
+		if (range.indexNode != TrekTlsfAllocator::INVALID_NODE)
+		{
+			indexRanges.free(range.indexNode);
+		}
+		range = {};
+	}
+
+	void TrekGeometryArena::bind(const VkCommandBuffer commandBuffer, const VkIndexType indexType) const
+	{
+		const VkBuffer buffers[] = { vertexBuffer->getBuffer() };
+		const VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType);
+	}
+
+	bool TrekGeometryArena::isUploaded(const TrekGeometryRange& range) const
+	{
+		return trekDevice.getUploadQueue().isComplete(range.uploadTicket);
+	}
+
+	TrekUploadQueue::Ticket TrekGeometryArena::upload(
+		const TrekGeometryRange& range,
+		const Writer& writeVertices,
+		const Writer& writeIndices) const
+	{
+		// Byte pieces of the upload map back to whole elements through the granularity.
+		const auto elementWriter = [](const Writer& write, const VkDeviceSize elementSize)
+		{
+			return [&write, elementSize](void* staging, const VkDeviceSize offset, const VkDeviceSize size)
+			{
+				write(staging, static_cast<uint32_t>(offset / elementSize), static_cast<uint32_t>(size / elementSize));
+			};
+		};
+
+		TrekUploadQueue& uploadQueue = trekDevice.getUploadQueue();
+		TrekUploadQueue::Ticket ticket = uploadQueue.enqueueBufferWrite(
+			vertexBuffer->getBuffer(),
+			static_cast<VkDeviceSize>(vertexStride) * range.firstVertex,
+			static_cast<VkDeviceSize>(vertexStride) * range.vertexCount,
+			vertexStride,
+			elementWriter(writeVertices, vertexStride));
+		if (range.indexCount > 0)
+		{
+			const VkDeviceSize indexSize = range.indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+			ticket = uploadQueue.enqueueBufferWrite(
+				indexBuffer->getBuffer(),
+				indexSize * range.firstIndex,
+				indexSize * range.indexCount,
+				indexSize,
+				elementWriter(writeIndices, indexSize));
+		}
+		return ticket;
+	}
+}
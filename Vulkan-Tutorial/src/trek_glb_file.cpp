@@ -0,0 +1,961 @@
+#include "trek_glb_file.h"
+#include "trek_cpu_profiler.h"
+#include "trek_mesh_cache.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace Trek
+{
+	namespace
+	{
+		constexpr uint32_t GLB_MAGIC = 0x46546C67;
+		constexpr uint32_t GLB_VERSION = 2;
+		constexpr uint32_t CHUNK_JSON = 0x4E4F534A;
+		constexpr uint32_t CHUNK_BIN = 0x004E4942;
+
+		constexpr uint32_t COMPONENT_BYTE = 5120;
+		constexpr uint32_t COMPONENT_UNSIGNED_BYTE = 5121;
+		constexpr uint32_t COMPONENT_SHORT = 5122;
+		constexpr uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+		constexpr uint32_t COMPONENT_UNSIGNED_INT = 5125;
+		constexpr uint32_t COMPONENT_FLOAT = 5126;
+		constexpr uint32_t MODE_TRIANGLES = 4;
+
+		// Deeper JSON is rejected instead of recursed into.
+		constexpr uint32_t MAX_JSON_DEPTH = 64;
+
+		struct JsonValue {
+			enum class Type { Null, Bool, Number, String, Array, Object };
+
+			Type type = Type::Null;
+			bool boolean = false;
+			double number = 0.0;
+			std::string string{};
+			// Array elements, or object member values named by keys.
+			std::vector<JsonValue> items{};
+			std::vector<std::string> keys{};
+
+			const JsonValue* find(const char* key) const
+			{
+				for (size_t i = 0; i < keys.size(); i++)
+				{
+					if (keys[i] == key)
+					{
+						return &items[i];
+					}
+				}
+				return nullptr;
+			}
+		};
+
+		// Just enough JSON for the glTF chunk, which is small next to the binary chunk.
+		class JsonParser
+		{
+		public:
+			JsonParser(const char* begin, const char* end) : cursor{ begin }, end{ end } {}
+
+			JsonValue parse()
+			{
+				JsonValue value = parseValue(0);
+				skipWhitespace();
+				if (cursor != end)
+				{
+					fail("trailing characters");
+				}
+				return value;
+			}
+
+		private:
+			[[noreturn]] static void fail(const char* what)
+			{
+				throw std::runtime_error(std::string("invalid JSON chunk, ") + what);
+			}
+
+			void skipWhitespace()
+			{
+				while (cursor != end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+				{
+					cursor++;
+				}
+			}
+
+			bool consume(const char* literal)
+			{
+				const size_t length = strlen(literal);
+				if (static_cast<size_t>(end - cursor) < length || memcmp(cursor, literal, length) != 0)
+				{
+					return false;
+				}
+				cursor += length;
+				return true;
+			}
+
+			JsonValue parseValue(const uint32_t depth)
+			{
+				if (depth > MAX_JSON_DEPTH)
+				{
+					fail("nested too deeply");
+				}
+				skipWhitespace();
+				if (cursor == end)
+				{
+					fail("unexpected end");
+				}
+
+				JsonValue value{};
+				if (*cursor == '{' || *cursor == '[')
+				{
+					const char close = *cursor == '{' ? '}' : ']';
+					value.type = close == '}' ? JsonValue::Type::Object : JsonValue::Type::Array;
+					cursor++;
+					skipWhitespace();
+					if (cursor != end && *cursor == close)
+					{
+						cursor++;
+						return value;
+					}
+					do
+					{
+						if (value.type == JsonValue::Type::Object)
+						{
+							skipWhitespace();
+							if (cursor == end || *cursor != '"')
+							{
+								fail("expected a member name");
+							}
+							value.keys.push_back(parseString());
+							skipWhitespace();
+							if (cursor == end || *cursor++ != ':')
+							{
+								fail("expected ':'");
+							}
+						}
+						value.items.push_back(parseValue(depth + 1));
+					} while (!endOfList(close));
+				}
+				else if (*cursor == '"')
+				{
+					value.type = JsonValue::Type::String;
+					value.string = parseString();
+				}
+				else if (consume("true"))
+				{
+					value.type = JsonValue::Type::Bool;
+					value.boolean = true;
+				}
+				else if (consume("false"))
+				{
+					value.type = JsonValue::Type::Bool;
+				}
+				else if (consume("null"))
+				{
+					value.type = JsonValue::Type::Null;
+				}
+				else
+				{
+					value.type = JsonValue::Type::Number;
+					value.number = parseNumber();
+				}
+				return value;
+			}
+
+			// After an element: true past the closing bracket, false past a comma.
+			bool endOfList(const char close)
+			{
+				skipWhitespace();
+				if (cursor == end)
+				{
+					fail("unexpected end");
+				}
+				const char next = *cursor++;
+				if (next != close && next != ',')
+				{
+					fail("expected ',' or a closing bracket");
+				}
+				return next == close;
+			}
+
+			std::string parseString()
+			{
+				cursor++;
+				std::string result;
+				while (true)
+				{
+					if (cursor == end)
+					{
+						fail("unterminated string");
+					}
+					const char next = *cursor++;
+					if (next == '"')
+					{
+						return result;
+					}
+					if (next != '\\')
+					{
+						result.push_back(next);
+						continue;
+					}
+					if (cursor == end)
+					{
+						fail("unterminated string");
+					}
+					switch (*cursor++)
+					{
+					case '"': result.push_back('"'); break;
+					case '\\': result.push_back('\\'); break;
+					case '/': result.push_back('/'); break;
+					case 'b': result.push_back('\b'); break;
+					case 'f': result.push_back('\f'); break;
+					case 'n': result.push_back('\n'); break;
+					case 'r': result.push_back('\r'); break;
+					case 't': result.push_back('\t'); break;
+					case 'u': appendCodePoint(result); break;
+					default: fail("invalid escape");
+					}
+				}
+			}
+
+			void appendCodePoint(std::string& out)
+			{
+				uint32_t code = parseHex4();
+				if (code >= 0xD800 && code < 0xDC00)
+				{
+					const uint32_t low = consume("\\u") ? parseHex4() : 0;
+					if (low < 0xDC00 || low >= 0xE000)
+					{
+						fail("unpaired surrogate");
+					}
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				}
+
+				if (code < 0x80)
+				{
+					out.push_back(static_cast<char>(code));
+				}
+				else if (code < 0x800)
+				{
+					out.push_back(static_cast<char>(0xC0 | code >> 6));
+					out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+				}
+				else if (code < 0x10000)
+				{
+					out.push_back(static_cast<char>(0xE0 | code >> 12));
+					out.push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+					out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+				}
+				else
+				{
+					out.push_back(static_cast<char>(0xF0 | code >> 18));
+					out.push_back(static_cast<char>(0x80 | (code >> 12 & 0x3F)));
+					out.push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+					out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+				}
+			}
+
+			uint32_t parseHex4()
+			{
+				if (end - cursor < 4)
+				{
+					fail("truncated escape");
+				}
+				uint32_t code = 0;
+				for (int i = 0; i < 4; i++)
+				{
+					const char digit = *cursor++;
+					code <<= 4;
+					if (digit >= '0' && digit <= '9') code |= digit - '0';
+					else if (digit >= 'a' && digit <= 'f') code |= digit - 'a' + 10;
+					else if (digit >= 'A' && digit <= 'F') code |= digit - 'A' + 10;
+					else fail("invalid escape");
+				}
+				return code;
+			}
+
+			double parseNumber()
+			{
+				// strtod needs a terminated string, so the token is copied out first.
+				const char* start = cursor;
+				while (cursor != end && ((*cursor >= '0' && *cursor <= '9') || *cursor == '-' || *cursor == '+' || *cursor == '.' || *cursor == 'e' || *cursor == 'E'))
+				{
+					cursor++;
+				}
+				const std::string token(start, cursor);
+				char* parsedEnd = nullptr;
+				const double number = std::strtod(token.c_str(), &parsedEnd);
+				if (token.empty() || parsedEnd != token.c_str() + token.size())
+				{
+					fail("unexpected character");
+				}
+				return number;
+			}
+
+			const char* cursor;
+			const char* end;
+		};
+
+		uint32_t readU32(const unsigned char* bytes)
+		{
+			uint32_t value;
+			memcpy(&value, bytes, sizeof(value));
+			return value;
+		}
+
+		uint32_t componentSize(const uint32_t componentType)
+		{
+			switch (componentType)
+			{
+			case COMPONENT_BYTE:
+			case COMPONENT_UNSIGNED_BYTE: return 1;
+			case COMPONENT_SHORT:
+			case COMPONENT_UNSIGNED_SHORT: return 2;
+			case COMPONENT_UNSIGNED_INT:
+			case COMPONENT_FLOAT: return 4;
+			default: return 0;
+			}
+		}
+
+		uint32_t componentCount(const std::string& type)
+		{
+			if (type == "SCALAR") return 1;
+			if (type == "VEC2") return 2;
+			if (type == "VEC3") return 3;
+			if (type == "VEC4") return 4;
+			return 0;
+		}
+
+		// Normalized integers map to [0, 1] or [-1, 1] as the spec defines.
+		float readComponent(const unsigned char* bytes, const uint32_t componentType, const bool normalized)
+		{
+			switch (componentType)
+			{
+			case COMPONENT_FLOAT:
+			{
+				float value;
+				memcpy(&value, bytes, sizeof(value));
+				return value;
+			}
+			case COMPONENT_UNSIGNED_BYTE:
+				return normalized ? bytes[0] / 255.f : bytes[0];
+			case COMPONENT_BYTE:
+			{
+				const auto value = static_cast<int8_t>(bytes[0]);
+				return normalized ? std::max(value / 127.f, -1.f) : value;
+			}
+			case COMPONENT_UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				memcpy(&value, bytes, sizeof(value));
+				return normalized ? value / 65535.f : value;
+			}
+			case COMPONENT_SHORT:
+			{
+				int16_t value;
+				memcpy(&value, bytes, sizeof(value));
+				return normalized ? std::max(value / 32767.f, -1.f) : value;
+			}
+			default:
+				return static_cast<float>(readU32(bytes));
+			}
+		}
+
+		uint32_t readIndex(const unsigned char* bytes, const uint32_t componentType)
+		{
+			switch (componentType)
+			{
+			case COMPONENT_UNSIGNED_BYTE:
+				return bytes[0];
+			case COMPONENT_UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				memcpy(&value, bytes, sizeof(value));
+				return value;
+			}
+			default:
+				return readU32(bytes);
+			}
+		}
+
+		// Rotation part of TrekTransformComponent::mat4 (Ry * Rx * Rz) back to its angles.
+		glm::vec3 eulerYXZ(const glm::mat3& rotation)
+		{
+			const float s2 = glm::clamp(-rotation[2][1], -1.f, 1.f);
+			const float x = std::asin(s2);
+			if (std::abs(s2) > .9999f)
+			{
+				// Gimbal lock, z folds into y.
+				return { x, std::atan2(-rotation[0][2], rotation[0][0]), 0.f };
+			}
+			return { x, std::atan2(rotation[2][0], rotation[2][2]), std::atan2(rotation[0][1], rotation[1][1]) };
+		}
+	}
+
+	std::unique_ptr<TrekGlbFile> TrekGlbFile::open(const std::string& filePath)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekGlbFile::open" };
+		const auto invalid = [&filePath](const std::string& what)
+		{
+			throw std::runtime_error(filePath + ": " + what);
+		};
+
+		std::unique_ptr<TrekGlbFile> glb{ new TrekGlbFile() };
+		if (!glb->file.open(filePath))
+		{
+			throw std::runtime_error("failed to open " + filePath);
+		}
+		const unsigned char* bytes = glb->file.data();
+		const size_t size = glb->file.size();
+
+		// 12 byte header, then chunks of length, type and data padded to 4 bytes: JSON first, BIN optionally second.
+		if (size < 20 || readU32(bytes) != GLB_MAGIC)
+		{
+			invalid("not a binary glTF file");
+		}
+		if (readU32(bytes + 4) != GLB_VERSION)
+		{
+			invalid("unsupported glTF version " + std::to_string(readU32(bytes + 4)));
+		}
+		const size_t totalLength = std::min<size_t>(readU32(bytes + 8), size);
+		const size_t jsonLength = readU32(bytes + 12);
+		if (readU32(bytes + 16) != CHUNK_JSON || 20 + jsonLength > totalLength)
+		{
+			invalid("missing or truncated JSON chunk");
+		}
+		const unsigned char* bin = nullptr;
+		size_t binLength = 0;
+		const size_t binHeader = 20 + ((jsonLength + 3) & ~size_t{ 3 });
+		if (binHeader + 8 <= totalLength && readU32(bytes + binHeader + 4) == CHUNK_BIN)
+		{
+			binLength = readU32(bytes + binHeader);
+			bin = bytes + binHeader + 8;
+			if (binHeader + 8 + binLength > totalLength)
+			{
+				invalid("truncated BIN chunk");
+			}
+		}
+
+		JsonValue json;
+		try
+		{
+			json = JsonParser{ reinterpret_cast<const char*>(bytes + 20), reinterpret_cast<const char*>(bytes + 20 + jsonLength) }.parse();
+		}
+		catch (const std::runtime_error& error)
+		{
+			invalid(error.what());
+		}
+		if (json.type != JsonValue::Type::Object)
+		{
+			invalid("JSON chunk is not an object");
+		}
+
+		const auto array = [&](const JsonValue& object, const char* key) -> const std::vector<JsonValue>&
+		{
+			static const std::vector<JsonValue> empty{};
+			const JsonValue* value = object.find(key);
+			if (!value)
+			{
+				return empty;
+			}
+			if (value->type != JsonValue::Type::Array)
+			{
+				invalid(std::string(key) + " must be an array");
+			}
+			return value->items;
+		};
+		const auto object = [&](const std::vector<JsonValue>& items, const uint32_t index, const char* what) -> const JsonValue&
+		{
+			if (index >= items.size() || items[index].type != JsonValue::Type::Object)
+			{
+				invalid(std::string(what) + " " + std::to_string(index) + " does not exist");
+			}
+			return items[index];
+		};
+		// Checked before the cast, which is undefined for values out of range.
+		const auto toInteger = [&](const JsonValue& value, const char* what)
+		{
+			if (value.type != JsonValue::Type::Number || value.number < 0.0 ||
+				value.number > std::numeric_limits<uint32_t>::max() || std::floor(value.number) != value.number)
+			{
+				invalid(std::string(what) + " must be a non-negative integer");
+			}
+			return static_cast<uint32_t>(value.number);
+		};
+		const auto integer = [&](const JsonValue& owner, const char* key, const uint32_t fallback)
+		{
+			const JsonValue* value = owner.find(key);
+			return value ? toInteger(*value, key) : fallback;
+		};
+		const auto floats = [&](const JsonValue& owner, const char* key, float* out, const size_t count)
+		{
+			const JsonValue* value = owner.find(key);
+			if (!value)
+			{
+				return false;
+			}
+			if (value->type != JsonValue::Type::Array || value->items.size() != count)
+			{
+				invalid(std::string(key) + " must be an array of " + std::to_string(count) + " numbers");
+			}
+			for (size_t i = 0; i < count; i++)
+			{
+				if (value->items[i].type != JsonValue::Type::Number)
+				{
+					invalid(std::string(key) + " must be an array of " + std::to_string(count) + " numbers");
+				}
+				out[i] = static_cast<float>(value->items[i].number);
+			}
+			return true;
+		};
+
+		if (const JsonValue* required = json.find("extensionsRequired"))
+		{
+			if (required->type == JsonValue::Type::Array && !required->items.empty())
+			{
+				invalid("requires extension " + required->items[0].string);
+			}
+		}
+
+		const std::vector<JsonValue>& buffers = array(json, "buffers");
+		const std::vector<JsonValue>& bufferViews = array(json, "bufferViews");
+		const std::vector<JsonValue>& accessors = array(json, "accessors");
+
+		// Every accessor is checked to lie within its buffer view, and the view within the BIN chunk.
+		const auto accessorAt = [&](const uint32_t index, const char* what)
+		{
+			const JsonValue& accessor = object(accessors, index, "accessor");
+			if (accessor.find("sparse"))
+			{
+				invalid(std::string(what) + " uses a sparse accessor");
+			}
+			if (!accessor.find("bufferView"))
+			{
+				invalid(std::string(what) + " accessor has no buffer view");
+			}
+			const JsonValue& view = object(bufferViews, integer(accessor, "bufferView", 0), "buffer view");
+			const uint32_t bufferIndex = integer(view, "buffer", 0);
+			if (object(buffers, bufferIndex, "buffer").find("uri") || bufferIndex != 0 || !bin)
+			{
+				invalid(std::string(what) + " refers to an external buffer");
+			}
+
+			Accessor result{};
+			result.componentType = integer(accessor, "componentType", 0);
+			const JsonValue* type = accessor.find("type");
+			result.components = type && type->type == JsonValue::Type::String ? componentCount(type->string) : 0;
+			const JsonValue* normalized = accessor.find("normalized");
+			result.normalized = normalized && normalized->type == JsonValue::Type::Bool && normalized->boolean;
+			result.count = integer(accessor, "count", 0);
+			const uint32_t elementSize = componentSize(result.componentType) * result.components;
+			if (elementSize == 0 || result.count == 0)
+			{
+				invalid(std::string(what) + " accessor has an invalid type, component type or count");
+			}
+
+			const uint64_t viewOffset = integer(view, "byteOffset", 0);
+			const uint64_t viewLength = integer(view, "byteLength", 0);
+			result.stride = integer(view, "byteStride", elementSize);
+			const uint64_t offset = integer(accessor, "byteOffset", 0);
+			if (viewOffset + viewLength > binLength ||
+				result.stride < elementSize ||
+				offset + static_cast<uint64_t>(result.stride) * (result.count - 1) + elementSize > viewLength)
+			{
+				invalid(std::string(what) + " accessor reaches past its buffer view");
+			}
+			result.data = bin + viewOffset + offset;
+			return result;
+		};
+
+		for (const JsonValue& meshJson : array(json, "meshes"))
+		{
+			if (meshJson.type != JsonValue::Type::Object)
+			{
+				invalid("mesh is not an object");
+			}
+			Mesh mesh{};
+			bool hasBounds = false;
+			for (const JsonValue& primitiveJson : array(meshJson, "primitives"))
+			{
+				if (primitiveJson.type != JsonValue::Type::Object)
+				{
+					invalid("primitive is not an object");
+				}
+				if (integer(primitiveJson, "mode", MODE_TRIANGLES) != MODE_TRIANGLES)
+				{
+					// Points and lines have nothing to shade, strips and fans are rare enough.
+					continue;
+				}
+				const JsonValue* attributes = primitiveJson.find("attributes");
+				if (!attributes || !attributes->find("POSITION"))
+				{
+					invalid("primitive has no POSITION");
+				}
+
+				Primitive primitive{};
+				primitive.position = accessorAt(integer(*attributes, "POSITION", 0), "POSITION");
+				if (primitive.position.componentType != COMPONENT_FLOAT || primitive.position.components != 3)
+				{
+					invalid("POSITION must be a float VEC3");
+				}
+				const auto matches = [&](const Accessor& accessor, const char* what)
+				{
+					if (accessor.count != primitive.position.count)
+					{
+						invalid(std::string(what) + " and POSITION differ in count");
+					}
+				};
+				if (attributes->find("NORMAL"))
+				{
+					primitive.normal = accessorAt(integer(*attributes, "NORMAL", 0), "NORMAL");
+					matches(primitive.normal, "NORMAL");
+					if (primitive.normal.componentType != COMPONENT_FLOAT || primitive.normal.components != 3)
+					{
+						invalid("NORMAL must be a float VEC3");
+					}
+				}
+				if (attributes->find("TEXCOORD_0"))
+				{
+					primitive.uv = accessorAt(integer(*attributes, "TEXCOORD_0", 0), "TEXCOORD_0");
+					matches(primitive.uv, "TEXCOORD_0");
+					const uint32_t type = primitive.uv.componentType;
+					if (primitive.uv.components != 2 || !(type == COMPONENT_FLOAT ||
+						((type == COMPONENT_UNSIGNED_BYTE || type == COMPONENT_UNSIGNED_SHORT) && primitive.uv.normalized)))
+					{
+						invalid("TEXCOORD_0 must be a float or normalized unsigned VEC2");
+					}
+				}
+				if (attributes->find("COLOR_0"))
+				{
+					primitive.color = accessorAt(integer(*attributes, "COLOR_0", 0), "COLOR_0");
+					matches(primitive.color, "COLOR_0");
+					const uint32_t type = primitive.color.componentType;
+					if ((primitive.color.components != 3 && primitive.color.components != 4) || !(type == COMPONENT_FLOAT ||
+						((type == COMPONENT_UNSIGNED_BYTE || type == COMPONENT_UNSIGNED_SHORT) && primitive.color.normalized)))
+					{
+						invalid("COLOR_0 must be a float or normalized unsigned VEC3 or VEC4");
+					}
+				}
+
+				primitive.indexCount = primitive.position.count;
+				if (primitiveJson.find("indices"))
+				{
+					primitive.indices = accessorAt(integer(primitiveJson, "indices", 0), "indices");
+					const uint32_t type = primitive.indices.componentType;
+					if (primitive.indices.components != 1 ||
+						(type != COMPONENT_UNSIGNED_BYTE && type != COMPONENT_UNSIGNED_SHORT && type != COMPONENT_UNSIGNED_INT))
+					{
+						invalid("indices must be unsigned SCALAR");
+					}
+					// Checked here so conversion can't fail halfway through an upload.
+					for (uint32_t i = 0; i < primitive.indices.count; i++)
+					{
+						if (readIndex(primitive.indices.data + static_cast<size_t>(i) * primitive.indices.stride, type) >= primitive.position.count)
+						{
+							invalid("index out of range of the primitive's vertices");
+						}
+					}
+					primitive.indexCount = primitive.indices.count;
+				}
+				if (primitive.indexCount % 3 != 0)
+				{
+					invalid("triangle list with a partial triangle");
+				}
+				if (static_cast<uint64_t>(mesh.vertexCount) + primitive.position.count > std::numeric_limits<uint32_t>::max() ||
+					static_cast<uint64_t>(mesh.indexCount) + primitive.indexCount > std::numeric_limits<uint32_t>::max())
+				{
+					invalid("mesh is too large");
+				}
+
+				// POSITION must carry min and max, files that leave them out get scanned.
+				const JsonValue& positionJson = accessors[integer(*attributes, "POSITION", 0)];
+				TrekModel::Bounds bounds{};
+				if (!floats(positionJson, "min", &bounds.min.x, 3) || !floats(positionJson, "max", &bounds.max.x, 3))
+				{
+					bounds.min = glm::vec3{ std::numeric_limits<float>::max() };
+					bounds.max = glm::vec3{ -std::numeric_limits<float>::max() };
+					for (uint32_t v = 0; v < primitive.position.count; v++)
+					{
+						float position[3];
+						memcpy(position, primitive.position.data + static_cast<size_t>(v) * primitive.position.stride, sizeof(position));
+						bounds.min = glm::min(bounds.min, glm::vec3{ position[0], position[1], position[2] });
+						bounds.max = glm::max(bounds.max, glm::vec3{ position[0], position[1], position[2] });
+					}
+				}
+				mesh.bounds.min = hasBounds ? glm::min(mesh.bounds.min, bounds.min) : bounds.min;
+				mesh.bounds.max = hasBounds ? glm::max(mesh.bounds.max, bounds.max) : bounds.max;
+				hasBounds = true;
+
+				primitive.firstVertex = mesh.vertexCount;
+				primitive.firstIndex = mesh.indexCount;
+				mesh.vertexCount += primitive.position.count;
+				mesh.indexCount += primitive.indexCount;
+				mesh.primitives.push_back(primitive);
+			}
+			glb->meshes.push_back(std::move(mesh));
+		}
+
+		// Instances of the default scene, or of every root node in files without scenes.
+		const std::vector<JsonValue>& nodes = array(json, "nodes");
+		std::vector<uint32_t> roots;
+		const std::vector<JsonValue>& scenes = array(json, "scenes");
+		if (!scenes.empty())
+		{
+			for (const JsonValue& root : array(object(scenes, integer(json, "scene", 0), "scene"), "nodes"))
+			{
+				roots.push_back(toInteger(root, "scene nodes"));
+			}
+		}
+		else
+		{
+			std::vector<bool> isChild(nodes.size(), false);
+			for (const JsonValue& node : nodes)
+			{
+				for (const JsonValue& child : array(node, "children"))
+				{
+					if (child.type == JsonValue::Type::Number && child.number >= 0.0 && child.number < static_cast<double>(nodes.size()))
+					{
+						isChild[static_cast<size_t>(child.number)] = true;
+					}
+				}
+			}
+			for (uint32_t node = 0; node < nodes.size(); node++)
+			{
+				if (!isChild[node])
+				{
+					roots.push_back(node);
+				}
+			}
+		}
+
+		std::vector<bool> visited(nodes.size(), false);
+		// Depth first in document order, so instances come out in a stable order.
+		std::vector<std::pair<uint32_t, glm::mat4>> stack;
+		for (auto root = roots.rbegin(); root != roots.rend(); ++root)
+		{
+			stack.emplace_back(*root, glm::mat4{ 1.f });
+		}
+		while (!stack.empty())
+		{
+			const auto [index, parent] = stack.back();
+			stack.pop_back();
+			const JsonValue& node = object(nodes, index, "node");
+			if (visited[index])
+			{
+				invalid("node " + std::to_string(index) + " has more than one parent");
+			}
+			visited[index] = true;
+
+			glm::mat4 local{ 1.f };
+			if (!floats(node, "matrix", &local[0][0], 16))
+			{
+				glm::vec3 translation{ 0.f };
+				float rotation[4] = { 0.f, 0.f, 0.f, 1.f };
+				glm::vec3 scale{ 1.f };
+				floats(node, "translation", &translation.x, 3);
+				floats(node, "rotation", rotation, 4);
+				floats(node, "scale", &scale.x, 3);
+				const float x = rotation[0], y = rotation[1], z = rotation[2], w = rotation[3];
+				local[0] = glm::vec4{ 1.f - 2.f * (y * y + z * z), 2.f * (x * y + w * z), 2.f * (x * z - w * y), 0.f } * scale.x;
+				local[1] = glm::vec4{ 2.f * (x * y - w * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z + w * x), 0.f } * scale.y;
+				local[2] = glm::vec4{ 2.f * (x * z + w * y), 2.f * (y * z - w * x), 1.f - 2.f * (x * x + y * y), 0.f } * scale.z;
+				local[3] = glm::vec4{ translation, 1.f };
+			}
+			const glm::mat4 world = parent * local;
+
+			if (node.find("mesh"))
+			{
+				const uint32_t mesh = integer(node, "mesh", 0);
+				if (mesh >= glb->meshes.size())
+				{
+					invalid("node refers to mesh " + std::to_string(mesh) + ", which does not exist");
+				}
+				Instance instance{};
+				instance.mesh = mesh;
+				instance.translation = glm::vec3{ world[3] };
+				instance.scale = { glm::length(glm::vec3{ world[0] }), glm::length(glm::vec3{ world[1] }), glm::length(glm::vec3{ world[2] }) };
+				glm::mat3 rotation{ 1.f };
+				for (int axis = 0; axis < 3; axis++)
+				{
+					if (instance.scale[axis] > 0.f)
+					{
+						rotation[axis] = glm::vec3{ world[axis] } / instance.scale[axis];
+					}
+				}
+				if (glm::determinant(rotation) < 0.f)
+				{
+					// Mirrored, carried by a negative x scale.
+					instance.scale.x = -instance.scale.x;
+					rotation[0] = -rotation[0];
+				}
+				instance.rotation = eulerYXZ(rotation);
+				glb->instances.push_back(instance);
+			}
+
+			const std::vector<JsonValue>& children = array(node, "children");
+			for (auto child = children.rbegin(); child != children.rend(); ++child)
+			{
+				stack.emplace_back(toInteger(*child, "children"), world);
+			}
+		}
+		return glb;
+	}
+
+	VkIndexType TrekGlbFile::getIndexType(const uint32_t mesh) const
+	{
+		return meshes[mesh].vertexCount <= std::numeric_limits<uint16_t>::max() + 1u ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	}
+
+	uint64_t TrekGlbFile::computeContentHash() const
+	{
+		TrekCpuProfiler::Zone zone{ "TrekGlbFile::computeContentHash" };
+		return TrekMeshCache::hashBytes(file.data(), file.size());
+	}
+
+	void TrekGlbFile::writeVertices(const uint32_t mesh, const TrekVertexFormat format, void* destination, const uint32_t first, const uint32_t count) const
+	{
+		const Mesh& source = meshes[mesh];
+		const uint32_t stride = TrekVertexLayout::stride(format);
+		auto* out = static_cast<unsigned char*>(destination);
+
+		// Primitives are sorted by firstVertex, find the one holding first.
+		auto primitive = std::upper_bound(source.primitives.begin(), source.primitives.end(), first,
+			[](const uint32_t vertex, const Primitive& p) { return vertex < p.firstVertex; }) - 1;
+		const uint32_t last = first + count;
+		for (uint32_t v = first; v < last; ++primitive)
+		{
+			const uint32_t end = std::min(last, primitive->firstVertex + primitive->position.count);
+			for (; v < end; v++, out += stride)
+			{
+				const uint32_t local = v - primitive->firstVertex;
+				TrekModel::Vertex vertex{};
+				vertex.color = { 1.f, 1.f, 1.f };
+				memcpy(&vertex.pos, primitive->position.data + static_cast<size_t>(local) * primitive->position.stride, sizeof(vertex.pos));
+				if (primitive->normal.data)
+				{
+					memcpy(&vertex.normal, primitive->normal.data + static_cast<size_t>(local) * primitive->normal.stride, sizeof(vertex.normal));
+				}
+				if (primitive->uv.data)
+				{
+					const unsigned char* uv = primitive->uv.data + static_cast<size_t>(local) * primitive->uv.stride;
+					const uint32_t size = componentSize(primitive->uv.componentType);
+					vertex.uv = { readComponent(uv, primitive->uv.componentType, true), readComponent(uv + size, primitive->uv.componentType, true) };
+				}
+				if (primitive->color.data)
+				{
+					const unsigned char* color = primitive->color.data + static_cast<size_t>(local) * primitive->color.stride;
+					const uint32_t size = componentSize(primitive->color.componentType);
+					for (int c = 0; c < 3; c++)
+					{
+						vertex.color[c] = readComponent(color + c * size, primitive->color.componentType, true);
+					}
+				}
+
+				switch (format)
+				{
+				case TrekVertexFormat::Float:
+					memcpy(out, &vertex, sizeof(vertex));
+					break;
+				case TrekVertexFormat::Packed:
+				{
+					TrekPackedVertex packed{};
+					TrekVertexLayout::quantizePosition(vertex.pos, source.bounds.min, source.bounds.max, packed.position);
+					TrekVertexLayout::encodeOctahedral(vertex.normal, packed.normal);
+					TrekVertexLayout::encodeHalf(vertex.uv, packed.uv);
+					memcpy(out, &packed, sizeof(packed));
+					break;
+				}
+				case TrekVertexFormat::PackedColor:
+				{
+					TrekPackedColorVertex packed{};
+					TrekVertexLayout::quantizePosition(vertex.pos, source.bounds.min, source.bounds.max, packed.position);
+					TrekVertexLayout::encodeOctahedral(vertex.normal, packed.normal);
+					TrekVertexLayout::encodeHalf(vertex.uv, packed.uv);
+					TrekVertexLayout::encodeColor(vertex.color, packed.color);
+					memcpy(out, &packed, sizeof(packed));
+					break;
+				}
+				}
+			}
+		}
+	}
+
+	void TrekGlbFile::writeIndices(const uint32_t mesh, const VkIndexType indexType, void* destination, const uint32_t first, const uint32_t count) const
+	{
+		const Mesh& source = meshes[mesh];
+		auto* out16 = static_cast<uint16_t*>(destination);
+		auto* out32 = static_cast<uint32_t*>(destination);
+
+		auto primitive = std::upper_bound(source.primitives.begin(), source.primitives.end(), first,
+			[](const uint32_t index, const Primitive& p) { return index < p.firstIndex; }) - 1;
+		const uint32_t last = first + count;
+		for (uint32_t i = first; i < last; ++primitive)
+		{
+			const uint32_t end = std::min(last, primitive->firstIndex + primitive->indexCount);
+			for (; i < end; i++)
+			{
+				const uint32_t local = i - primitive->firstIndex;
+				const uint32_t index = primitive->firstVertex + (primitive->indices.data
+					? readIndex(primitive->indices.data + static_cast<size_t>(local) * primitive->indices.stride, primitive->indices.componentType)
+					: local);
+				if (indexType == VK_INDEX_TYPE_UINT16)
+				{
+					*out16++ = static_cast<uint16_t>(index);
+				}
+				else
+				{
+					*out32++ = index;
+				}
+			}
+		}
+	}
+
+	std::shared_ptr<TrekModel> TrekGlbFile::createModel(TrekGeometryArena& arena, const uint32_t mesh) const
+	{
+		TrekCpuProfiler::Zone zone{ "TrekGlbFile::createModel" };
+		if (meshes[mesh].indexCount == 0)
+		{
+			return nullptr;
+		}
+		const TrekVertexFormat format = arena.getVertexFormat();
+		const VkIndexType indexType = getIndexType(mesh);
+		const TrekGeometryRange range = arena.allocate(
+			meshes[mesh].vertexCount,
+			[&](void* destination, const uint32_t first, const uint32_t count) { writeVertices(mesh, format, destination, first, count); },
+			meshes[mesh].indexCount,
+			[&](void* destination, const uint32_t first, const uint32_t count) { writeIndices(mesh, indexType, destination, first, count); },
+			indexType);
+		return std::make_shared<TrekModel>(arena, range, meshes[mesh].bounds);
+	}
+
+	std::vector<TrekModelHandle> TrekGlbFile::createModels(TrekGeometryArena& arena) const
+	{
+		std::vector<TrekModelHandle> models;
+		models.reserve(meshes.size());
+		for (uint32_t mesh = 0; mesh < meshes.size(); mesh++)
+		{
+			std::shared_ptr<TrekModel> model = createModel(arena, mesh);
+			models.push_back(model ? TrekModelHandle{ std::move(model) } : TrekModelHandle{});
+		}
+		return models;
+	}
+
+	void TrekGlbFile::createGameObjects(const std::vector<TrekModelHandle>& models, TrekEntityStore& gameObjects) const
+	{
+		for (const Instance& instance : instances)
+		{
+			if (instance.mesh >= models.size() || (!models[instance.mesh] && !models[instance.mesh].isLoading()))
+			{
+				continue;
+			}
+			TrekTransformComponent transform{};
+			transform.translation = instance.translation;
+			transform.rotation = instance.rotation;
+			transform.scale = instance.scale;
+			gameObjects.create(transform, models[instance.mesh]);
+		}
+	}
+}
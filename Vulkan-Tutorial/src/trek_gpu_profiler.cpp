@@ -0,0 +1,160 @@
+#include "trek_gpu_profiler.h"
+#include "trek_upload_queue.h"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace Trek
+{
+	TrekGpuProfiler::Scope::Scope(TrekGpuProfiler* profiler, const VkCommandBuffer commandBuffer, const char* name) :
+		profiler(profiler),
+		commandBuffer(commandBuffer),
+		index(profiler ? profiler->beginScope(commandBuffer, name) : INVALID_SCOPE)
+	{
+	}
+
+	TrekGpuProfiler::Scope::~Scope()
+	{
+		if (profiler)
+		{
+			profiler->endScope(commandBuffer, index);
+		}
+	}
+
+	TrekGpuProfiler::TrekGpuProfiler(TrekCore& device, const uint32_t maxScopesPerFrame) :
+		trekDevice(device),
+		maxScopes(maxScopesPerFrame)
+	{
+		const QueueFamilyIndices indices = trekDevice.findPhysicalQueueFamilies();
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(trekDevice.getPhysicalDevice(), &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(trekDevice.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+		const uint32_t validBits = queueFamilies[indices.graphicsFamily].timestampValidBits;
+		supported = validBits > 0 && trekDevice.properties.limits.timestampPeriod > 0.f;
+		if (!supported)
+		{
+			return;
+		}
+
+		nanosecondsPerTick = static_cast<double>(trekDevice.properties.limits.timestampPeriod);
+		timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+		queryData.resize(static_cast<size_t>(maxScopes) * 2 * 2);
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = maxScopes * 2;
+
+		for (auto& pool : queryPools)
+		{
+			if (vkCreateQueryPool(trekDevice.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create timestamp query pool!");
+			}
+		}
+	}
+
+	TrekGpuProfiler::~TrekGpuProfiler()
+	{
+		for (const auto pool : queryPools)
+		{
+			if (pool != VK_NULL_HANDLE)
+			{
+				vkDestroyQueryPool(trekDevice.device(), pool, nullptr);
+			}
+		}
+	}
+
+	void TrekGpuProfiler::beginFrame(const VkCommandBuffer commandBuffer, const int frameIndex)
+	{
+		assert(openDepth == 0 && "Every GPU profiler scope must be closed before the next frame.");
+		currentFrame = frameIndex;
+		if (!supported)
+		{
+			return;
+		}
+
+		results.clear();
+		resolve(frameIndex);
+		frameScopes[frameIndex].clear();
+
+		TrekUploadQueue& uploadQueue = trekDevice.getUploadQueue();
+		if (uploadQueue.isTimed())
+		{
+			results.push_back({ "uploads", 0, uploadQueue.takeGpuMilliseconds() });
+		}
+		vkCmdResetQueryPool(commandBuffer, queryPools[frameIndex], 0, maxScopes * 2);
+	}
+
+	uint32_t TrekGpuProfiler::beginScope(const VkCommandBuffer commandBuffer, const char* name)
+	{
+		assert(currentFrame >= 0 && "Cannot open a GPU profiler scope before beginFrame.");
+		if (!supported || frameScopes[currentFrame].size() >= maxScopes)
+		{
+			return INVALID_SCOPE;
+		}
+
+		std::vector<ScopeRecord>& scopes = frameScopes[currentFrame];
+
+		const auto index = static_cast<uint32_t>(scopes.size());
+		scopes.push_back({ name, openDepth++, false });
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPools[currentFrame], index * 2);
+		return index;
+	}
+
+	void TrekGpuProfiler::endScope(const VkCommandBuffer commandBuffer, const uint32_t scopeIndex)
+	{
+		if (scopeIndex == INVALID_SCOPE)
+		{
+			return;
+		}
+
+		ScopeRecord& scope = frameScopes[currentFrame][scopeIndex];
+		assert(!scope.closed && "GPU profiler scope closed twice.");
+		scope.closed = true;
+		openDepth--;
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPools[currentFrame], scopeIndex * 2 + 1);
+	}
+
+	void TrekGpuProfiler::resolve(const int frameIndex)
+	{
+		const std::vector<ScopeRecord>& scopes = frameScopes[frameIndex];
+		if (scopes.empty())
+		{
+			return;
+		}
+
+		// Each query yields a value/availability pair. No WAIT_BIT: the frame's fence has been
+		// waited on already, and if a driver still reports a query as unavailable we skip it.
+		const auto queryCount = static_cast<uint32_t>(scopes.size() * 2);
+		const VkResult result = vkGetQueryPoolResults(
+			trekDevice.device(),
+			queryPools[frameIndex],
+			0,
+			queryCount,
+			queryCount * 2 * sizeof(uint64_t),
+			queryData.data(),
+			2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (result != VK_SUCCESS && result != VK_NOT_READY)
+		{
+			throw std::runtime_error("failed to read timestamp queries!");
+		}
+
+		for (size_t i = 0; i < scopes.size(); i++)
+		{
+			const uint64_t* begin = &queryData[i * 4];
+			const uint64_t* end = &queryData[i * 4 + 2];
+			if (!scopes[i].closed || begin[1] == 0 || end[1] == 0)
+			{
+				continue;
+			}
+
+			const uint64_t ticks = ((end[0] & timestampMask) - (begin[0] & timestampMask)) & timestampMask;
+			results.push_back({ scopes[i].name, scopes[i].depth, static_cast<double>(ticks) * nanosecondsPerTick / 1e6 });
+		}
+	}
+}
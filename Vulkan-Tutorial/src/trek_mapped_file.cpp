@@ -0,0 +1,126 @@
+#include "trek_mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Trek
+{
+	TrekMappedFile::~TrekMappedFile()
+	{
+		close();
+	}
+
+#ifdef _WIN32
+	bool TrekMappedFile::open(const std::string& path)
+	{
+		close();
+		const HANDLE file = CreateFileA(
+			path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize))
+		{
+			CloseHandle(file);
+			return false;
+		}
+		fileHandle = file;
+		opened = true;
+		byteSize = static_cast<size_t>(fileSize.QuadPart);
+		if (byteSize == 0)
+		{
+			return true;
+		}
+
+		mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle == nullptr)
+		{
+			close();
+			return false;
+		}
+		view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void TrekMappedFile::close()
+	{
+		if (view != nullptr)
+		{
+			UnmapViewOfFile(view);
+		}
+		if (mappingHandle != nullptr)
+		{
+			CloseHandle(mappingHandle);
+		}
+		if (fileHandle != nullptr)
+		{
+			CloseHandle(fileHandle);
+		}
+		view = nullptr;
+		mappingHandle = nullptr;
+		fileHandle = nullptr;
+		byteSize = 0;
+		opened = false;
+	}
+#else
+	bool TrekMappedFile::open(const std::string& path)
+	{
+		close();
+		const int file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+
+		struct stat fileStat {};
+		if (fstat(file, &fileStat) != 0)
+		{
+			::close(file);
+			return false;
+		}
+		byteSize = static_cast<size_t>(fileStat.st_size);
+		if (byteSize > 0)
+		{
+			void* mapping = mmap(nullptr, byteSize, PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapping == MAP_FAILED)
+			{
+				::close(file);
+				byteSize = 0;
+				return false;
+			}
+			view = mapping;
+		}
+		// The mapping keeps the file referenced, the descriptor isn't needed anymore.
+		::close(file);
+		opened = true;
+		return true;
+	}
+
+	void TrekMappedFile::close()
+	{
+		if (view != nullptr)
+		{
+			munmap(const_cast<void*>(view), byteSize);
+		}
+		view = nullptr;
+		byteSize = 0;
+		opened = false;
+	}
+#endif
+}
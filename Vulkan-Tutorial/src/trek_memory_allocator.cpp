@@ -0,0 +1,350 @@
+#include "trek_memory_allocator.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Trek
+{
+	class TrekMemoryBlock
+	{
+	public:
+		TrekMemoryBlock(const VkDeviceMemory memory, void* mapped, const VkDeviceSize size, const uint32_t poolIndex) :
+			memory(memory), mapped(mapped), poolIndex(poolIndex), allocator(size)
+		{
+		}
+
+		VkDeviceMemory memory;
+		void* mapped;
+		uint32_t poolIndex;
+		TrekTlsfAllocator allocator;
+	};
+
+	TrekMemoryAllocator::TrekMemoryAllocator(
+		const VkDevice device,
+		const VkPhysicalDevice physicalDevice,
+		const VkDeviceSize preferredBlockSize) :
+		device(device)
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		limits = properties.limits;
+
+		pools.resize(memoryProperties.memoryTypeCount * 2);
+		typeStats.resize(memoryProperties.memoryTypeCount);
+		for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++)
+		{
+			// Small heaps (e.g. the 256MB host visible device local window) get proportionally
+			// smaller blocks so a couple of pools can't exhaust them.
+			const VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[type].heapIndex].size;
+			const VkDeviceSize blockSize = std::min(preferredBlockSize, std::max<VkDeviceSize>(heapSize / 8, 1));
+			pools[type * 2].blockSize = blockSize;
+			pools[type * 2 + 1].blockSize = blockSize;
+		}
+	}
+
+	TrekMemoryAllocator::~TrekMemoryAllocator()
+	{
+		for (auto& pool : pools)
+		{
+			for (auto& block : pool.blocks)
+			{
+				assert(block->allocator.isEmpty() && "Device memory leaked: allocations outlived the allocator.");
+				freeDeviceMemory(block->memory, block->mapped != nullptr);
+			}
+		}
+	}
+
+	uint32_t TrekMemoryAllocator::findMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			if ((typeFilter & (1 << i)) &&
+				(memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return i;
+			}
+		}
+
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	bool TrekMemoryAllocator::isHostVisible(const uint32_t memoryType) const
+	{
+		return (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+	}
+
+	VkDeviceMemory TrekMemoryAllocator::allocateDeviceMemory(
+		const VkDeviceSize size,
+		const uint32_t memoryType,
+		void** mapped,
+		const VkMemoryDedicatedAllocateInfo* dedicatedInfo)
+	{
+		Stats& stats = typeStats[memoryType];
+		uint32_t liveAllocations = 0;
+		for (const auto& type : typeStats)
+		{
+			liveAllocations += type.blockCount + type.dedicatedCount;
+		}
+		if (liveAllocations >= limits.maxMemoryAllocationCount)
+		{
+			throw std::runtime_error("maxMemoryAllocationCount reached!");
+		}
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.pNext = dedicatedInfo;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate device memory!");
+		}
+		stats.deviceAllocations++;
+
+		*mapped = nullptr;
+		if (isHostVisible(memoryType) && vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+			vkFreeMemory(device, memory, nullptr);
+			throw std::runtime_error("failed to map device memory!");
+		}
+		return memory;
+	}
+
+	void TrekMemoryAllocator::freeDeviceMemory(const VkDeviceMemory memory, const bool mapped)
+	{
+		if (mapped)
+		{
+			vkUnmapMemory(device, memory);
+		}
+		vkFreeMemory(device, memory, nullptr);
+	}
+
+	TrekAllocation TrekMemoryAllocator::allocateBuffer(const VkBuffer buffer, const VkMemoryPropertyFlags properties)
+	{
+		VkBufferMemoryRequirementsInfo2 info{};
+		info.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+		info.buffer = buffer;
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+		vkGetBufferMemoryRequirements2(device, &info, &requirements);
+
+		VkMemoryDedicatedAllocateInfo resource{};
+		resource.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		resource.buffer = buffer;
+		return allocate(requirements.memoryRequirements, properties, ResourceKind::Linear,
+			dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation, &resource);
+	}
+
+	TrekAllocation TrekMemoryAllocator::allocateImage(const VkImage image, const VkMemoryPropertyFlags properties, const ResourceKind kind)
+	{
+		VkImageMemoryRequirementsInfo2 info{};
+		info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+		info.image = image;
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+		vkGetImageMemoryRequirements2(device, &info, &requirements);
+
+		VkMemoryDedicatedAllocateInfo resource{};
+		resource.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		resource.image = image;
+		return allocate(requirements.memoryRequirements, properties, kind,
+			dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation, &resource);
+	}
+
+	TrekAllocation TrekMemoryAllocator::allocate(
+		const VkMemoryRequirements& requirements,
+		const VkMemoryPropertyFlags properties,
+		const ResourceKind kind)
+	{
+		return allocate(requirements, properties, kind, false, nullptr);
+	}
+
+	TrekAllocation TrekMemoryAllocator::allocate(
+		const VkMemoryRequirements& requirements,
+		const VkMemoryPropertyFlags properties,
+		const ResourceKind kind,
+		const bool dedicated,
+		const VkMemoryDedicatedAllocateInfo* resource)
+	{
+		const uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+		const uint32_t poolIndex = memoryType * 2 + (kind == ResourceKind::Linear ? 0 : 1);
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		Pool& pool = pools[poolIndex];
+		if (dedicated || requirements.size > pool.blockSize / 2)
+		{
+			return allocateDedicated(requirements.size, memoryType, resource);
+		}
+
+		VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+		const bool coherent = (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+		if (isHostVisible(memoryType) && !coherent)
+		{
+			// Keeps flush/invalidate ranges of one allocation from needing its neighbours' atoms.
+			alignment = std::max(alignment, limits.nonCoherentAtomSize);
+		}
+
+		TrekMemoryBlock* block = nullptr;
+		TrekTlsfAllocator::Allocation range{};
+		for (auto& candidate : pool.blocks)
+		{
+			range = candidate->allocator.allocate(requirements.size, alignment);
+			if (range.valid())
+			{
+				block = candidate.get();
+				break;
+			}
+		}
+
+		Stats& stats = typeStats[memoryType];
+		if (block == nullptr)
+		{
+			void* mapped = nullptr;
+			const VkDeviceMemory memory = allocateDeviceMemory(pool.blockSize, memoryType, &mapped, nullptr);
+			pool.blocks.push_back(std::make_unique<TrekMemoryBlock>(memory, mapped, pool.blockSize, poolIndex));
+			stats.blockCount++;
+			stats.blockBytes += pool.blockSize;
+
+			block = pool.blocks.back().get();
+			range = block->allocator.allocate(requirements.size, alignment);
+			assert(range.valid() && "Fresh memory block could not fit an allocation under half its size.");
+		}
+
+		stats.allocationCount++;
+		stats.usedBytes += requirements.size;
+
+		TrekAllocation allocation{};
+		allocation.memory = block->memory;
+		allocation.offset = range.offset;
+		allocation.size = requirements.size;
+		allocation.mapped = block->mapped ? static_cast<char*>(block->mapped) + range.offset : nullptr;
+		allocation.memoryType = memoryType;
+		allocation.block = block;
+		allocation.node = range.node;
+		return allocation;
+	}
+
+	TrekAllocation TrekMemoryAllocator::allocateDedicated(
+		const VkDeviceSize size,
+		const uint32_t memoryType,
+		const VkMemoryDedicatedAllocateInfo* resource)
+	{
+		TrekAllocation allocation{};
+		allocation.memory = allocateDeviceMemory(size, memoryType, &allocation.mapped, resource);
+		allocation.size = size;
+		allocation.memoryType = memoryType;
+
+		Stats& stats = typeStats[memoryType];
+		stats.dedicatedCount++;
+		stats.dedicatedBytes += size;
+		stats.allocationCount++;
+		stats.usedBytes += size;
+		return allocation;
+	}
+
+	void TrekMemoryAllocator::free(TrekAllocation& allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		Stats& stats = typeStats[allocation.memoryType];
+		stats.allocationCount--;
+		stats.usedBytes -= allocation.size;
+
+		if (allocation.block == nullptr)
+		{
+			freeDeviceMemory(allocation.memory, allocation.mapped != nullptr);
+			stats.dedicatedCount--;
+			stats.dedicatedBytes -= allocation.size;
+		}
+		else
+		{
+			TrekMemoryBlock* block = allocation.block;
+			block->allocator.free(allocation.node);
+
+			// Keep one empty block per pool around so a free/allocate pair doesn't hit the driver.
+			Pool& pool = pools[block->poolIndex];
+			if (block->allocator.isEmpty() && pool.blocks.size() > 1)
+			{
+				const auto found = std::find_if(pool.blocks.begin(), pool.blocks.end(),
+					[block](const std::unique_ptr<TrekMemoryBlock>& candidate) { return candidate.get() == block; });
+				freeDeviceMemory(block->memory, block->mapped != nullptr);
+				stats.blockCount--;
+				stats.blockBytes -= block->allocator.getCapacity();
+				pool.blocks.erase(found);
+			}
+		}
+
+		allocation = TrekAllocation{};
+	}
+
+	VkMappedMemoryRange TrekMemoryAllocator::mappedRange(
+		const TrekAllocation& allocation,
+		const VkDeviceSize offset,
+		const VkDeviceSize size) const
+	{
+		const VkDeviceSize atom = std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1);
+		const VkDeviceSize memorySize = allocation.block ? allocation.block->allocator.getCapacity() : allocation.size;
+		const VkDeviceSize begin = allocation.offset + offset;
+		VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+		VkMappedMemoryRange range{};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = allocation.memory;
+		range.offset = begin / atom * atom;
+		end = (end + atom - 1) / atom * atom;
+		range.size = end >= memorySize ? VK_WHOLE_SIZE : end - range.offset;
+		return range;
+	}
+
+	TrekMemoryAllocator::Stats TrekMemoryAllocator::getStats(const uint32_t memoryType) const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return typeStats[memoryType];
+	}
+
+	TrekMemoryAllocator::Stats TrekMemoryAllocator::getStats() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		Stats total{};
+		for (const auto& stats : typeStats)
+		{
+			total.blockCount += stats.blockCount;
+			total.dedicatedCount += stats.dedicatedCount;
+			total.allocationCount += stats.allocationCount;
+			total.blockBytes += stats.blockBytes;
+			total.usedBytes += stats.usedBytes;
+			total.dedicatedBytes += stats.dedicatedBytes;
+			total.deviceAllocations += stats.deviceAllocations;
+		}
+		return total;
+	}
+
+	void TrekMemoryAllocator::printStats(std::ostream& out) const
+	{
+		for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++)
+		{
+			const Stats stats = getStats(type);
+			if (stats.deviceAllocations == 0)
+			{
+				continue;
+			}
+			out << "memory type " << type << ": "
+				<< stats.allocationCount << " allocations, "
+				<< stats.usedBytes / 1024 << " KiB used of "
+				<< (stats.blockBytes + stats.dedicatedBytes) / 1024 << " KiB in "
+				<< stats.blockCount << " blocks + " << stats.dedicatedCount << " dedicated, "
+				<< stats.deviceAllocations << " vkAllocateMemory calls\n";
+		}
+	}
+}
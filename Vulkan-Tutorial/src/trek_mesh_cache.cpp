@@ -0,0 +1,273 @@
+#include "trek_mesh_cache.h"
+#include "trek_cpu_profiler.h"
+
+// std
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+namespace Trek
+{
+	namespace
+	{
+		constexpr char MAGIC[4] = { 'T', 'M', 'S', 'H' };
+		constexpr uint64_t DATA_ALIGNMENT = 16;
+
+		struct Header {
+			char magic[4];
+			uint32_t version;
+			uint32_t vertexStride;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			// TrekMeshOptimizer steps applied before writing. Older caches have 0 here.
+			uint32_t processing;
+			uint64_t sourceSize;
+			int64_t sourceMtime;
+			uint64_t sourceHash;
+			float boundsMin[3];
+			float boundsMax[3];
+			uint64_t vertexOffset;
+			uint64_t indexOffset;
+			uint64_t lodOffset;
+			uint32_t lodCount;
+			uint32_t meshletCount;
+			uint64_t meshletOffset;
+		};
+		static_assert(std::is_trivially_copyable_v<TrekModel::Vertex>, "TrekModel::Vertex is written to disk as raw bytes");
+		static_assert(std::is_trivially_copyable_v<TrekModel::Lod>, "TrekModel::Lod is written to disk as raw bytes");
+		static_assert(std::is_trivially_copyable_v<TrekModel::Meshlet>, "TrekModel::Meshlet is written to disk as raw bytes");
+
+		struct SourceStamp {
+			bool exists = false;
+			uint64_t size = 0;
+			int64_t mtime = 0;
+		};
+
+		SourceStamp stampOf(const std::string& path)
+		{
+			SourceStamp stamp{};
+			std::error_code error;
+			const auto size = std::filesystem::file_size(path, error);
+			if (error)
+			{
+				return stamp;
+			}
+			const auto mtime = std::filesystem::last_write_time(path, error);
+			if (error)
+			{
+				return stamp;
+			}
+			stamp.exists = true;
+			stamp.size = size;
+			stamp.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+			return stamp;
+		}
+
+		uint64_t alignUp(const uint64_t value)
+		{
+			return (value + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+		}
+
+		// Moves a fully written temporary file over path, so readers never see a partial one.
+		bool replaceWith(const std::string& tempPath, const std::string& path)
+		{
+			std::error_code error;
+			std::filesystem::rename(tempPath, path, error);
+			if (error)
+			{
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+			return true;
+		}
+
+		// A copy of the mapped cache under a new header.
+		bool writeWithHeader(const std::string& tempPath, const TrekMappedFile& cache, const Header& header)
+		{
+			std::ofstream out{ tempPath, std::ios::binary | std::ios::trunc };
+			if (!out.is_open())
+			{
+				return false;
+			}
+			out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			out.write(reinterpret_cast<const char*>(cache.data() + sizeof(Header)), static_cast<std::streamsize>(cache.size() - sizeof(Header)));
+			return out.good();
+		}
+	}
+
+	uint64_t TrekMeshCache::hashFile(const std::string& path)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekMeshCache::hashFile" };
+		TrekMappedFile source;
+		if (!source.open(path))
+		{
+			return 0;
+		}
+		return hashBytes(source.data(), source.size());
+	}
+
+	uint64_t TrekMeshCache::hashBytes(const unsigned char* data, const size_t size)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	std::unique_ptr<TrekMeshCache> TrekMeshCache::open(const std::string& cachePath, const std::string& sourcePath, const uint32_t processing)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekMeshCache::open" };
+		std::unique_ptr<TrekMeshCache> cache{ new TrekMeshCache() };
+		if (!cache->file.open(cachePath) || cache->file.size() < sizeof(Header))
+		{
+			return nullptr;
+		}
+
+		Header header;
+		memcpy(&header, cache->file.data(), sizeof(Header));
+		if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+			header.version != VERSION ||
+			header.processing != processing ||
+			header.vertexStride != sizeof(TrekModel::Vertex) ||
+			header.vertexOffset % DATA_ALIGNMENT != 0 ||
+			header.indexOffset % DATA_ALIGNMENT != 0 ||
+			header.vertexOffset + static_cast<uint64_t>(header.vertexCount) * sizeof(TrekModel::Vertex) > cache->file.size() ||
+			header.indexOffset + static_cast<uint64_t>(header.indexCount) * sizeof(uint32_t) > cache->file.size() ||
+			header.lodOffset % DATA_ALIGNMENT != 0 ||
+			header.lodOffset + static_cast<uint64_t>(header.lodCount) * sizeof(TrekModel::Lod) > cache->file.size() ||
+			header.meshletOffset % DATA_ALIGNMENT != 0 ||
+			header.meshletOffset + static_cast<uint64_t>(header.meshletCount) * sizeof(TrekModel::Meshlet) > cache->file.size())
+		{
+			return nullptr;
+		}
+
+		const SourceStamp source = stampOf(sourcePath);
+		if (source.exists && (source.size != header.sourceSize || source.mtime != header.sourceMtime))
+		{
+			// Touched or replaced. Only worth hashing when the size still matches.
+			if (source.size != header.sourceSize || hashFile(sourcePath) != header.sourceHash)
+			{
+				return nullptr;
+			}
+			// Only touched: record the new mtime so the next open doesn't hash the source again.
+			// A read-only asset directory just means hashing again next time.
+			header.sourceMtime = source.mtime;
+			const std::string tempPath = cachePath + ".tmp";
+			if (writeWithHeader(tempPath, cache->file, header))
+			{
+				// Windows can't replace a mapped file. Either version has the same layout.
+				const size_t size = cache->file.size();
+				cache->file.close();
+				replaceWith(tempPath, cachePath);
+				if (!cache->file.open(cachePath) || cache->file.size() != size)
+				{
+					return nullptr;
+				}
+			}
+			else
+			{
+				std::error_code error;
+				std::filesystem::remove(tempPath, error);
+			}
+		}
+
+		const auto* lods = reinterpret_cast<const TrekModel::Lod*>(cache->file.data() + header.lodOffset);
+		for (uint32_t lod = 0; lod < header.lodCount; lod++)
+		{
+			if (static_cast<uint64_t>(lods[lod].firstIndex) + lods[lod].indexCount > header.indexCount ||
+				static_cast<uint64_t>(lods[lod].firstMeshlet) + lods[lod].meshletCount > header.meshletCount)
+			{
+				return nullptr;
+			}
+		}
+		const auto* meshlets = reinterpret_cast<const TrekModel::Meshlet*>(cache->file.data() + header.meshletOffset);
+		for (uint32_t meshlet = 0; meshlet < header.meshletCount; meshlet++)
+		{
+			if (static_cast<uint64_t>(meshlets[meshlet].firstIndex) + meshlets[meshlet].indexCount > header.indexCount)
+			{
+				return nullptr;
+			}
+		}
+
+		cache->vertexData = reinterpret_cast<const TrekModel::Vertex*>(cache->file.data() + header.vertexOffset);
+		cache->indexData = reinterpret_cast<const uint32_t*>(cache->file.data() + header.indexOffset);
+		cache->vertexTotal = header.vertexCount;
+		cache->indexTotal = header.indexCount;
+		cache->lodData = lods;
+		cache->lodTotal = header.lodCount;
+		cache->meshletData = meshlets;
+		cache->meshletTotal = header.meshletCount;
+		cache->meshBounds.min = { header.boundsMin[0], header.boundsMin[1], header.boundsMin[2] };
+		cache->meshBounds.max = { header.boundsMax[0], header.boundsMax[1], header.boundsMax[2] };
+		cache->sourceContentHash = header.sourceHash;
+		return cache;
+	}
+
+	bool TrekMeshCache::write(
+		const std::string& cachePath,
+		const std::string& sourcePath,
+		const TrekModel::Data& data,
+		const uint32_t processing,
+		const uint64_t sourceHash)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekMeshCache::write" };
+		const SourceStamp source = stampOf(sourcePath);
+		const TrekModel::Bounds bounds = data.computeBounds();
+
+		Header header{};
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.vertexStride = sizeof(TrekModel::Vertex);
+		header.processing = processing;
+		header.vertexCount = static_cast<uint32_t>(data.vertices.size());
+		header.indexCount = static_cast<uint32_t>(data.indices.size());
+		header.sourceSize = source.size;
+		header.sourceMtime = source.mtime;
+		header.sourceHash = !source.exists ? 0 : sourceHash != 0 ? sourceHash : hashFile(sourcePath);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			header.boundsMin[axis] = bounds.min[axis];
+			header.boundsMax[axis] = bounds.max[axis];
+		}
+		const uint64_t vertexBytes = data.vertices.size() * sizeof(TrekModel::Vertex);
+		header.vertexOffset = alignUp(sizeof(Header));
+		header.indexOffset = alignUp(header.vertexOffset + vertexBytes);
+		const uint64_t indexBytes = data.indices.size() * sizeof(uint32_t);
+		header.lodOffset = alignUp(header.indexOffset + indexBytes);
+		header.lodCount = static_cast<uint32_t>(data.lods.size());
+		const uint64_t lodBytes = data.lods.size() * sizeof(TrekModel::Lod);
+		header.meshletOffset = alignUp(header.lodOffset + lodBytes);
+		header.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+
+		const std::string tempPath = cachePath + ".tmp";
+		{
+			std::ofstream out{ tempPath, std::ios::binary | std::ios::trunc };
+			if (!out.is_open())
+			{
+				return false;
+			}
+			const char padding[DATA_ALIGNMENT] = {};
+			out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			out.write(padding, static_cast<std::streamsize>(header.vertexOffset - sizeof(Header)));
+			out.write(reinterpret_cast<const char*>(data.vertices.data()), static_cast<std::streamsize>(vertexBytes));
+			out.write(padding, static_cast<std::streamsize>(header.indexOffset - header.vertexOffset - vertexBytes));
+			out.write(reinterpret_cast<const char*>(data.indices.data()), static_cast<std::streamsize>(indexBytes));
+			out.write(padding, static_cast<std::streamsize>(header.lodOffset - header.indexOffset - indexBytes));
+			out.write(reinterpret_cast<const char*>(data.lods.data()), static_cast<std::streamsize>(lodBytes));
+			out.write(padding, static_cast<std::streamsize>(header.meshletOffset - header.lodOffset - lodBytes));
+			out.write(
+				reinterpret_cast<const char*>(data.meshlets.data()),
+				static_cast<std::streamsize>(data.meshlets.size() * sizeof(TrekModel::Meshlet)));
+			if (!out.good())
+			{
+				return false;
+			}
+		}
+
+		return replaceWith(tempPath, cachePath);
+	}
+}
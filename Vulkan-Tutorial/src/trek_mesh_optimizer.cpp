@@ -0,0 +1,345 @@
+#include "trek_mesh_optimizer.h"
+#include "trek_cpu_profiler.h"
+#include "trek_mesh_simplifier.h"
+#include "trek_meshlet_builder.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace Trek
+{
+	namespace
+	{
+		constexpr uint32_t NO_VERTEX = ~0u;
+
+		// Triangles using each vertex, as offsets into one flat array.
+		struct Adjacency {
+			std::vector<uint32_t> offsets;
+			std::vector<uint32_t> triangles;
+
+			Adjacency(const std::vector<uint32_t>& indices, const size_t vertexCount) : offsets(vertexCount + 1, 0), triangles(indices.size())
+			{
+				for (const uint32_t index : indices)
+				{
+					offsets[index + 1]++;
+				}
+				std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+				std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+				for (size_t corner = 0; corner < indices.size(); corner++)
+				{
+					triangles[fill[indices[corner]]++] = static_cast<uint32_t>(corner / 3);
+				}
+			}
+		};
+
+		// Simulates a FIFO cache through timestamps: a vertex is cached while fewer than cacheSize
+		// misses happened since it was loaded.
+		class FifoCache
+		{
+		public:
+			FifoCache(const size_t vertexCount, const uint32_t cacheSize) : loadedAt(vertexCount, 0), cacheSize{ cacheSize } {}
+
+			// Returns true on a miss.
+			bool access(const uint32_t vertex)
+			{
+				if (loadedAt[vertex] != 0 && time - loadedAt[vertex] < cacheSize)
+				{
+					return false;
+				}
+				loadedAt[vertex] = time++;
+				return true;
+			}
+
+		private:
+			std::vector<uint32_t> loadedAt;
+			uint32_t cacheSize;
+			// Starts at 1 so 0 means never loaded.
+			uint32_t time = 1;
+		};
+
+		glm::vec3 triangleNormal(const std::vector<TrekModel::Vertex>& vertices, const uint32_t* triangle)
+		{
+			// Unnormalized, so larger triangles weigh more in a cluster's normal.
+			return glm::cross(vertices[triangle[1]].pos - vertices[triangle[0]].pos, vertices[triangle[2]].pos - vertices[triangle[0]].pos);
+		}
+	}
+
+	TrekMeshOptimizer::Report TrekMeshOptimizer::optimize(TrekModel::Data& data, const uint32_t steps)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekMeshOptimizer::optimize" };
+		const auto analyzeLod0 = [&data]()
+		{
+			const uint32_t indexCount = data.lods.empty() ? static_cast<uint32_t>(data.indices.size()) : data.lods[0].indexCount;
+			return analyzeVertexCache(data.indices.data(), indexCount, data.vertices.size());
+		};
+
+		Report report{};
+		report.before = analyzeLod0();
+		if (data.indices.size() % 3 == 0)
+		{
+			if (steps & LODS)
+			{
+				TrekMeshSimplifier::buildLods(data);
+			}
+
+			if (steps & (VERTEX_CACHE | OVERDRAW))
+			{
+				const std::vector<TrekModel::Lod> lods = data.lods.empty()
+					? std::vector<TrekModel::Lod>{ { 0, static_cast<uint32_t>(data.indices.size()), 0.f } }
+					: data.lods;
+				std::vector<uint32_t> lodIndices;
+				for (const TrekModel::Lod& lod : lods)
+				{
+					const auto first = data.indices.begin() + lod.firstIndex;
+					lodIndices.assign(first, first + lod.indexCount);
+					optimizeVertexCache(lodIndices, data.vertices.size());
+					if (steps & OVERDRAW)
+					{
+						optimizeOverdraw(lodIndices, data.vertices);
+					}
+					std::copy(lodIndices.begin(), lodIndices.end(), first);
+				}
+			}
+			// Over all LODs at once, LOD 0 first, since they share the vertices.
+			if (steps & VERTEX_FETCH)
+			{
+				optimizeVertexFetch(data.indices, data.vertices);
+			}
+			// Last, so the clusters follow the final triangle order.
+			if (steps & MESHLETS)
+			{
+				TrekMeshletBuilder::build(data);
+			}
+		}
+		report.after = analyzeLod0();
+		report.lodCount = data.lods.empty() ? 1 : static_cast<uint32_t>(data.lods.size());
+		report.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+		return report;
+	}
+
+	TrekMeshOptimizer::CacheStats TrekMeshOptimizer::analyzeVertexCache(
+		const uint32_t* indices,
+		const size_t indexCount,
+		const size_t vertexCount,
+		const uint32_t cacheSize)
+	{
+		CacheStats stats{};
+		if (indexCount < 3 || vertexCount == 0)
+		{
+			return stats;
+		}
+
+		FifoCache cache{ vertexCount, cacheSize };
+		size_t misses = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			misses += cache.access(indices[i]) ? 1 : 0;
+		}
+		stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+		stats.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount);
+		return stats;
+	}
+
+	void TrekMeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, const size_t vertexCount, const uint32_t cacheSize)
+	{
+		// Tipsify, Sander et al. 2007: fan around a vertex, emitting all of its remaining
+		// triangles, then continue with the vertex among the just emitted ones that will still be
+		// in the cache after its own triangles are emitted. Dead ends fall back to recently used
+		// vertices, then to input order.
+		TrekCpuProfiler::Zone zone{ "TrekMeshOptimizer::optimizeVertexCache" };
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		const Adjacency adjacency{ indices, vertexCount };
+		std::vector<uint32_t> liveTriangles(vertexCount);
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			liveTriangles[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+		}
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		uint32_t time = cacheSize + 1;
+		size_t inputCursor = 0;
+		uint32_t fan = indices[0];
+		while (fan != NO_VERTEX)
+		{
+			candidates.clear();
+			for (uint32_t a = adjacency.offsets[fan]; a < adjacency.offsets[fan + 1]; a++)
+			{
+				const uint32_t triangle = adjacency.triangles[a];
+				if (emitted[triangle])
+				{
+					continue;
+				}
+				emitted[triangle] = true;
+				for (int corner = 0; corner < 3; corner++)
+				{
+					const uint32_t vertex = indices[3 * triangle + corner];
+					output.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					liveTriangles[vertex]--;
+					if (time - cacheTime[vertex] > cacheSize)
+					{
+						cacheTime[vertex] = time++;
+					}
+				}
+			}
+
+			// Prefer the candidate that entered the cache earliest but stays cached through its fan.
+			fan = NO_VERTEX;
+			int64_t bestPriority = -1;
+			for (const uint32_t vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0)
+				{
+					continue;
+				}
+				int64_t priority = 0;
+				if (static_cast<int64_t>(time) - cacheTime[vertex] + 2 * static_cast<int64_t>(liveTriangles[vertex]) <= cacheSize)
+				{
+					priority = static_cast<int64_t>(time) - cacheTime[vertex];
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fan = vertex;
+				}
+			}
+
+			while (fan == NO_VERTEX && !deadEnds.empty())
+			{
+				const uint32_t vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[vertex] > 0)
+				{
+					fan = vertex;
+				}
+			}
+			while (fan == NO_VERTEX && inputCursor < indices.size())
+			{
+				const uint32_t vertex = indices[inputCursor++];
+				if (liveTriangles[vertex] > 0)
+				{
+					fan = vertex;
+				}
+			}
+		}
+
+		assert(output.size() == indices.size() && "Tipsify must emit every triangle once");
+		indices = std::move(output);
+	}
+
+	void TrekMeshOptimizer::optimizeOverdraw(
+		std::vector<uint32_t>& indices,
+		const std::vector<TrekModel::Vertex>& vertices,
+		const uint32_t cacheSize)
+	{
+		// Sander et al. 2007: cut the cache optimized order into clusters wherever the cache starts
+		// over (all three vertices of a triangle miss), then draw clusters facing away from the
+		// mesh center first, as those are the likeliest occluders from any view. Reordering whole
+		// clusters keeps most of the cache locality.
+		TrekCpuProfiler::Zone zone{ "TrekMeshOptimizer::optimizeOverdraw" };
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		std::vector<size_t> clusterStarts;
+		FifoCache cache{ vertices.size(), cacheSize };
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			int misses = 0;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				misses += cache.access(indices[3 * triangle + corner]) ? 1 : 0;
+			}
+			if (triangle == 0 || misses == 3)
+			{
+				clusterStarts.push_back(triangle);
+			}
+		}
+		clusterStarts.push_back(triangleCount);
+		const size_t clusterCount = clusterStarts.size() - 1;
+
+		glm::vec3 meshCenter{ 0.f };
+		float meshArea = 0.f;
+		std::vector<glm::vec3> clusterCenters(clusterCount, glm::vec3{ 0.f });
+		std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3{ 0.f });
+		for (size_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			float clusterArea = 0.f;
+			for (size_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; triangle++)
+			{
+				const uint32_t* corners = &indices[3 * triangle];
+				const glm::vec3 normal = triangleNormal(vertices, corners);
+				const float area = glm::length(normal);
+				const glm::vec3 centroid = (vertices[corners[0]].pos + vertices[corners[1]].pos + vertices[corners[2]].pos) / 3.f;
+				clusterCenters[cluster] += centroid * area;
+				clusterNormals[cluster] += normal;
+				clusterArea += area;
+			}
+			meshCenter += clusterCenters[cluster];
+			meshArea += clusterArea;
+			clusterCenters[cluster] = clusterArea > 0.f ? clusterCenters[cluster] / clusterArea : vertices[indices[3 * clusterStarts[cluster]]].pos;
+		}
+		meshCenter = meshArea > 0.f ? meshCenter / meshArea : glm::vec3{ 0.f };
+
+		std::vector<float> sortKeys(clusterCount);
+		for (size_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			const float length = glm::length(clusterNormals[cluster]);
+			const glm::vec3 normal = length > 0.f ? clusterNormals[cluster] / length : glm::vec3{ 0.f };
+			sortKeys[cluster] = glm::dot(clusterCenters[cluster] - meshCenter, normal);
+		}
+
+		std::vector<uint32_t> order(clusterCount);
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](const uint32_t a, const uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+		for (const uint32_t cluster : order)
+		{
+			output.insert(output.end(), indices.begin() + 3 * clusterStarts[cluster], indices.begin() + 3 * clusterStarts[cluster + 1]);
+		}
+		indices = std::move(output);
+	}
+
+	void TrekMeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<TrekModel::Vertex>& vertices)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekMeshOptimizer::optimizeVertexFetch" };
+		std::vector<uint32_t> remap(vertices.size(), NO_VERTEX);
+		std::vector<TrekModel::Vertex> reordered;
+		reordered.reserve(vertices.size());
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == NO_VERTEX)
+			{
+				remap[index] = static_cast<uint32_t>(reordered.size());
+				reordered.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+		// Unreferenced vertices keep their relative order at the end.
+		for (size_t vertex = 0; vertex < vertices.size(); vertex++)
+		{
+			if (remap[vertex] == NO_VERTEX)
+			{
+				reordered.push_back(vertices[vertex]);
+			}
+		}
+		vertices = std::move(reordered);
+	}
+}
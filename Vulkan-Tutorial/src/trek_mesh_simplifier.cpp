@@ -0,0 +1,403 @@
+#include "trek_mesh_simplifier.h"
+#include "trek_cpu_profiler.h"
+#include "trek_flat_index_map.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace Trek
+{
+	namespace
+	{
+		constexpr uint32_t NO_VERTEX = ~0u;
+		// Cosine of the largest normal change a collapse may cause, about 75 degrees.
+		constexpr float MAX_NORMAL_TURN = .25f;
+
+		struct PositionHash {
+			size_t operator()(const glm::vec3& position) const
+			{
+				uint32_t bits[3];
+				// + 0.f turns -0 into 0, which compares equal anyway.
+				const glm::vec3 folded = position + glm::vec3{ 0.f };
+				memcpy(bits, &folded, sizeof(bits));
+				uint64_t hash = (bits[0] * 0x9e3779b97f4a7c15ull) ^ (bits[1] * 0xc2b2ae3d27d4eb4full) ^ (bits[2] * 0x165667b19e3779f9ull);
+				return static_cast<size_t>(hash ^ (hash >> 32));
+			}
+		};
+
+		struct EdgeHash {
+			size_t operator()(const uint64_t edge) const
+			{
+				const uint64_t hash = edge * 0x9e3779b97f4a7c15ull;
+				return static_cast<size_t>(hash ^ (hash >> 32));
+			}
+		};
+
+		uint64_t edgeKey(const uint32_t from, const uint32_t to)
+		{
+			return (static_cast<uint64_t>(from) << 32) | to;
+		}
+
+		// Sum of squared distances to a set of area weighted planes, as the symmetric matrix A, the
+		// vector b and the constant c of p^T A p + 2 b^T p + c.
+		struct Quadric {
+			double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+			double b0 = 0, b1 = 0, b2 = 0;
+			double c = 0;
+			double weight = 0;
+
+			void addPlane(const glm::vec3& normal, const float distance, const float area)
+			{
+				const double x = normal.x, y = normal.y, z = normal.z, d = distance;
+				a00 += area * x * x; a01 += area * x * y; a02 += area * x * z;
+				a11 += area * y * y; a12 += area * y * z; a22 += area * z * z;
+				b0 += area * x * d; b1 += area * y * d; b2 += area * z * d;
+				c += area * d * d;
+				weight += area;
+			}
+
+			Quadric& operator+=(const Quadric& other)
+			{
+				a00 += other.a00; a01 += other.a01; a02 += other.a02;
+				a11 += other.a11; a12 += other.a12; a22 += other.a22;
+				b0 += other.b0; b1 += other.b1; b2 += other.b2;
+				c += other.c;
+				weight += other.weight;
+				return *this;
+			}
+
+			// Mean squared distance of p to the planes.
+			double error(const glm::vec3& p) const
+			{
+				const double x = p.x, y = p.y, z = p.z;
+				const double sum =
+					a00 * x * x + a11 * y * y + a22 * z * z +
+					2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+					2.0 * (b0 * x + b1 * y + b2 * z) + c;
+				return weight > 0.0 ? std::abs(sum) / weight : 0.0;
+			}
+		};
+
+		struct Collapse {
+			double cost;
+			uint32_t from;
+			uint32_t to;
+
+			bool operator<(const Collapse& other) const
+			{
+				if (cost != other.cost) return cost < other.cost;
+				if (from != other.from) return from < other.from;
+				return to < other.to;
+			}
+		};
+
+		glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+		{
+			return glm::cross(b - a, c - a);
+		}
+	}
+
+	std::vector<uint32_t> TrekMeshSimplifier::simplify(
+		const std::vector<TrekModel::Vertex>& vertices,
+		const std::vector<uint32_t>& indices,
+		const size_t targetIndexCount,
+		const float targetError,
+		float* resultError)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekMeshSimplifier::simplify" };
+		assert(indices.size() % 3 == 0 && "Simplification needs a triangle list");
+		const size_t vertexCount = vertices.size();
+
+		// Vertices at the same position form one group, named after its first vertex, and the
+		// vertices of a group (its wedges) are linked in a ring. Topology is decided on groups.
+		std::vector<uint32_t> group(vertexCount);
+		std::vector<uint32_t> nextWedge(vertexCount);
+		{
+			TrekFlatIndexMap<glm::vec3, PositionHash> positions{ vertexCount };
+			for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			{
+				const auto [first, inserted] = positions.tryEmplace(vertices[vertex].pos, vertex);
+				group[vertex] = first;
+				nextWedge[vertex] = inserted ? vertex : nextWedge[first];
+				if (!inserted)
+				{
+					nextWedge[first] = vertex;
+				}
+			}
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (size_t corner = 0; corner < indices.size(); corner += 3)
+		{
+			const uint32_t a = group[indices[corner]], b = group[indices[corner + 1]], c = group[indices[corner + 2]];
+			if (a != b && b != c && a != c)
+			{
+				result.insert(result.end(), indices.begin() + corner, indices.begin() + corner + 3);
+			}
+		}
+
+		// An edge used once in each direction is interior and manifold. Anything else, open
+		// borders included, locks both its ends.
+		std::vector<bool> locked(vertexCount, false);
+		{
+			TrekFlatIndexMap<uint64_t, EdgeHash> edges{ result.size() };
+			std::vector<uint32_t> edgeUses;
+			edgeUses.reserve(result.size());
+			const auto edgeId = [&](const uint32_t from, const uint32_t to)
+			{
+				const auto [id, inserted] = edges.tryEmplace(edgeKey(from, to), static_cast<uint32_t>(edgeUses.size()));
+				if (inserted)
+				{
+					edgeUses.push_back(0);
+				}
+				return id;
+			};
+			for (size_t corner = 0; corner < result.size(); corner++)
+			{
+				const size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+				edgeUses[edgeId(group[result[corner]], group[result[next]])]++;
+			}
+			for (size_t corner = 0; corner < result.size(); corner++)
+			{
+				const size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+				const uint32_t from = group[result[corner]], to = group[result[next]];
+				const uint32_t forward = edgeId(from, to);
+				const uint32_t backward = edgeId(to, from);
+				if (edgeUses[forward] != 1 || edgeUses[backward] != 1)
+				{
+					locked[from] = true;
+					locked[to] = true;
+				}
+			}
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t corner = 0; corner < result.size(); corner += 3)
+		{
+			const glm::vec3& p0 = vertices[result[corner]].pos;
+			const glm::vec3 normal = triangleNormal(p0, vertices[result[corner + 1]].pos, vertices[result[corner + 2]].pos);
+			const float length = glm::length(normal);
+			if (length == 0.f)
+			{
+				continue;
+			}
+			const glm::vec3 unit = normal / length;
+			for (int i = 0; i < 3; i++)
+			{
+				quadrics[group[result[corner + i]]].addPlane(unit, -glm::dot(unit, p0), length * .5f);
+			}
+		}
+
+		const double errorLimit = static_cast<double>(targetError) * targetError;
+		double maxError = 0.0;
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<Collapse> candidates;
+		std::vector<bool> touched(vertexCount);
+		std::vector<uint32_t> collapseTo(vertexCount);
+		std::vector<std::pair<uint32_t, uint32_t>> wedgeTargets;
+
+		// Each pass collapses a set of edges whose one-rings don't overlap, so every check in the
+		// pass sees up to date geometry, then rebuilds the triangle list.
+		while (result.size() > targetIndexCount)
+		{
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (const uint32_t index : result)
+			{
+				adjacencyOffsets[group[index] + 1]++;
+			}
+			for (size_t i = 1; i <= vertexCount; i++)
+			{
+				adjacencyOffsets[i] += adjacencyOffsets[i - 1];
+			}
+			adjacency.resize(result.size());
+			{
+				std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t corner = 0; corner < result.size(); corner++)
+				{
+					adjacency[fill[group[result[corner]]]++] = static_cast<uint32_t>(corner / 3);
+				}
+			}
+
+			candidates.clear();
+			for (size_t corner = 0; corner < result.size(); corner++)
+			{
+				const size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+				const uint32_t a = group[result[corner]], b = group[result[next]];
+				Quadric sum = quadrics[a];
+				sum += quadrics[b];
+				// Every interior edge shows up once per direction, so each direction is added once.
+				if (!locked[a])
+				{
+					candidates.push_back({ sum.error(vertices[b].pos), a, b });
+				}
+			}
+			std::sort(candidates.begin(), candidates.end());
+
+			std::fill(touched.begin(), touched.end(), false);
+			for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			{
+				collapseTo[vertex] = vertex;
+			}
+			const size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+			size_t trianglesRemoved = 0;
+			size_t collapses = 0;
+			for (const Collapse& collapse : candidates)
+			{
+				if (collapse.cost > errorLimit || trianglesRemoved >= trianglesToRemove)
+				{
+					break;
+				}
+				if (touched[collapse.from] || touched[collapse.to])
+				{
+					continue;
+				}
+
+				// Every wedge of `from` still in use must move to a single wedge of `to` it shares a
+				// triangle with, and wedges on different sides of a seam to different ones.
+				bool valid = true;
+				wedgeTargets.clear();
+				uint32_t wedge = collapse.from;
+				do
+				{
+					uint32_t target = NO_VERTEX;
+					bool used = false;
+					for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && valid; a++)
+					{
+						const uint32_t* triangle = &result[3 * adjacency[a]];
+						if (triangle[0] != wedge && triangle[1] != wedge && triangle[2] != wedge)
+						{
+							continue;
+						}
+						used = true;
+						for (int i = 0; i < 3; i++)
+						{
+							if (group[triangle[i]] == collapse.to)
+							{
+								valid = target == NO_VERTEX || target == triangle[i];
+								target = triangle[i];
+							}
+						}
+					}
+					if (used)
+					{
+						valid = valid && target != NO_VERTEX;
+						for (const auto& other : wedgeTargets)
+						{
+							valid = valid && other.second != target;
+						}
+						wedgeTargets.emplace_back(wedge, target);
+					}
+					wedge = nextWedge[wedge];
+				} while (valid && wedge != collapse.from);
+				if (!valid)
+				{
+					continue;
+				}
+
+				// Reject collapses that flip a remaining triangle or turn it close to edge on, where the
+				// next pass couldn't tell which way it faces any more.
+				size_t removed = 0;
+				const glm::vec3& to = vertices[collapse.to].pos;
+				for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && valid; a++)
+				{
+					const uint32_t* triangle = &result[3 * adjacency[a]];
+					if (group[triangle[0]] == collapse.to || group[triangle[1]] == collapse.to || group[triangle[2]] == collapse.to)
+					{
+						removed++;
+						continue;
+					}
+					glm::vec3 corners[3];
+					for (int i = 0; i < 3; i++)
+					{
+						corners[i] = group[triangle[i]] == collapse.from ? to : vertices[triangle[i]].pos;
+					}
+					const glm::vec3 before = triangleNormal(vertices[triangle[0]].pos, vertices[triangle[1]].pos, vertices[triangle[2]].pos);
+					const glm::vec3 after = triangleNormal(corners[0], corners[1], corners[2]);
+					valid = glm::dot(before, after) > MAX_NORMAL_TURN * glm::length(before) * glm::length(after);
+				}
+				if (!valid)
+				{
+					continue;
+				}
+
+				for (const auto& [from, target] : wedgeTargets)
+				{
+					collapseTo[from] = target;
+				}
+				quadrics[collapse.to] += quadrics[collapse.from];
+				maxError = std::max(maxError, collapse.cost);
+				for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++)
+				{
+					const uint32_t* triangle = &result[3 * adjacency[a]];
+					for (int i = 0; i < 3; i++)
+					{
+						touched[group[triangle[i]]] = true;
+					}
+				}
+				trianglesRemoved += removed;
+				collapses++;
+			}
+
+			if (collapses == 0)
+			{
+				break;
+			}
+
+			size_t written = 0;
+			for (size_t corner = 0; corner < result.size(); corner += 3)
+			{
+				const uint32_t a = collapseTo[result[corner]], b = collapseTo[result[corner + 1]], c = collapseTo[result[corner + 2]];
+				if (group[a] != group[b] && group[b] != group[c] && group[a] != group[c])
+				{
+					result[written++] = a;
+					result[written++] = b;
+					result[written++] = c;
+				}
+			}
+			result.resize(written);
+		}
+
+		if (resultError)
+		{
+			*resultError = static_cast<float>(std::sqrt(maxError));
+		}
+		return result;
+	}
+
+	void TrekMeshSimplifier::buildLods(TrekModel::Data& data, const uint32_t maxLods)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekMeshSimplifier::buildLods" };
+		if (data.lods.empty())
+		{
+			data.lods.push_back({ 0, static_cast<uint32_t>(data.indices.size()), 0.f });
+		}
+		// Rebuilding drops any previous chain.
+		data.indices.resize(data.lods[0].indexCount);
+		data.lods.resize(1);
+
+		const TrekModel::Bounds bounds = data.computeBounds();
+		const float maxError = glm::length(bounds.max - bounds.min) * LOD_MAX_ERROR;
+		std::vector<uint32_t> previous = data.indices;
+		float error = 0.f;
+		while (data.lods.size() < maxLods)
+		{
+			const size_t target = static_cast<size_t>(static_cast<float>(previous.size() / 3) * LOD_REDUCTION) * 3;
+			float passError = 0.f;
+			std::vector<uint32_t> next = simplify(data.vertices, previous, target, maxError, &passError);
+			if (next.empty() || static_cast<float>(next.size()) > static_cast<float>(previous.size()) * (1.f - LOD_MIN_GAIN))
+			{
+				break;
+			}
+
+			error += passError;
+			data.lods.push_back({ static_cast<uint32_t>(data.indices.size()), static_cast<uint32_t>(next.size()), error });
+			data.indices.insert(data.indices.end(), next.begin(), next.end());
+			previous = std::move(next);
+		}
+	}
+}
@@ -0,0 +1,132 @@
+#include "trek_meshlet_builder.h"
+#include "trek_cpu_profiler.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace Trek
+{
+	namespace
+	{
+		void computeBounds(const std::vector<TrekModel::Vertex>& vertices, const std::vector<uint32_t>& indices, TrekModel::Meshlet& meshlet)
+		{
+			const uint32_t end = meshlet.firstIndex + meshlet.indexCount;
+			glm::vec3 min{ vertices[indices[meshlet.firstIndex]].pos };
+			glm::vec3 max{ min };
+			for (uint32_t i = meshlet.firstIndex; i < end; i++)
+			{
+				min = glm::min(min, vertices[indices[i]].pos);
+				max = glm::max(max, vertices[indices[i]].pos);
+			}
+			meshlet.center = (min + max) * .5f;
+			meshlet.radius = 0.f;
+			for (uint32_t i = meshlet.firstIndex; i < end; i++)
+			{
+				meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].pos - meshlet.center));
+			}
+
+			// The cone axis is the average of the unit face normals, its half angle the widest angle
+			// between the axis and any of them.
+			glm::vec3 axis{ 0.f };
+			for (uint32_t i = meshlet.firstIndex; i < end; i += 3)
+			{
+				const glm::vec3& a = vertices[indices[i]].pos;
+				const glm::vec3 normal = glm::cross(vertices[indices[i + 1]].pos - a, vertices[indices[i + 2]].pos - a);
+				const float length = glm::length(normal);
+				if (length > 0.f)
+				{
+					axis += normal / length;
+				}
+			}
+			const float axisLength = glm::length(axis);
+			meshlet.coneAxis = glm::vec3{ 0.f };
+			meshlet.coneCutoff = 1.f;
+			if (axisLength == 0.f)
+			{
+				return;
+			}
+			axis /= axisLength;
+
+			float minDot = 1.f;
+			for (uint32_t i = meshlet.firstIndex; i < end; i += 3)
+			{
+				const glm::vec3& a = vertices[indices[i]].pos;
+				const glm::vec3 normal = glm::cross(vertices[indices[i + 1]].pos - a, vertices[indices[i + 2]].pos - a);
+				const float length = glm::length(normal);
+				if (length > 0.f)
+				{
+					minDot = std::min(minDot, glm::dot(normal / length, axis));
+				}
+			}
+			if (minDot > TrekMeshletBuilder::MIN_CONE_SPREAD)
+			{
+				meshlet.coneAxis = axis;
+				meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+			}
+		}
+	}
+
+	void TrekMeshletBuilder::buildRange(
+		const std::vector<TrekModel::Vertex>& vertices,
+		const std::vector<uint32_t>& indices,
+		const uint32_t firstIndex,
+		const uint32_t indexCount,
+		std::vector<TrekModel::Meshlet>& meshlets)
+	{
+		// The meshlet each vertex was last added to, so membership is a single compare.
+		std::vector<uint32_t> lastMeshlet(vertices.size(), ~0u);
+		TrekModel::Meshlet meshlet{ firstIndex, 0 };
+		uint32_t meshletId = static_cast<uint32_t>(meshlets.size());
+		uint32_t vertexCount = 0;
+		const uint32_t end = firstIndex + indexCount;
+		for (uint32_t triangle = firstIndex; triangle + 2 < end; triangle += 3)
+		{
+			uint32_t newVertices = 0;
+			for (uint32_t i = triangle; i < triangle + 3; i++)
+			{
+				// A triangle repeating a vertex counts it once.
+				const bool repeated = (i > triangle && indices[i] == indices[triangle]) || (i == triangle + 2 && indices[i] == indices[triangle + 1]);
+				newVertices += lastMeshlet[indices[i]] != meshletId && !repeated ? 1 : 0;
+			}
+			if (meshlet.indexCount > 0 && (vertexCount + newVertices > MAX_VERTICES || meshlet.indexCount / 3 == MAX_TRIANGLES))
+			{
+				computeBounds(vertices, indices, meshlet);
+				meshlets.push_back(meshlet);
+				meshlet = TrekModel::Meshlet{ triangle, 0 };
+				meshletId++;
+				vertexCount = 0;
+			}
+			for (uint32_t i = triangle; i < triangle + 3; i++)
+			{
+				if (lastMeshlet[indices[i]] != meshletId)
+				{
+					lastMeshlet[indices[i]] = meshletId;
+					vertexCount++;
+				}
+			}
+			meshlet.indexCount += 3;
+		}
+		if (meshlet.indexCount > 0)
+		{
+			computeBounds(vertices, indices, meshlet);
+			meshlets.push_back(meshlet);
+		}
+	}
+
+	void TrekMeshletBuilder::build(TrekModel::Data& data)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekMeshletBuilder::build" };
+		if (data.lods.empty())
+		{
+			data.lods.push_back({ 0, static_cast<uint32_t>(data.indices.size()), 0.f });
+		}
+		data.meshlets.clear();
+		for (TrekModel::Lod& lod : data.lods)
+		{
+			lod.firstMeshlet = static_cast<uint32_t>(data.meshlets.size());
+			buildRange(data.vertices, data.indices, lod.firstIndex, lod.indexCount, data.meshlets);
+			lod.meshletCount = static_cast<uint32_t>(data.meshlets.size()) - lod.firstMeshlet;
+		}
+	}
+}
@@ -1,209 +1,336 @@
 #include "trek_model.h"
 #include "trek_utils.h"
-
-//libs
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
-#define GLM_ENABLE_EXPERIMENTAL
-#include "glm/gtx/hash.hpp"
+#include "trek_cpu_profiler.h"
+#include "trek_mesh_cache.h"
+#include "trek_mesh_optimizer.h"
+#include "trek_obj_loader.h"
+#include "trek_vertex_format.h"
 
 //std
-#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 
-namespace std
+namespace Trek
 {
-	template<>
-	struct hash<Trek::TrekModel::Vertex>
+	namespace
 	{
-		size_t operator()(Trek::TrekModel::Vertex const& vertex) const
+		template <typename PackedVertex>
+		std::vector<PackedVertex> packVertices(const TrekModel::Vertex* vertices, const uint32_t vertexCount, const TrekModel::Bounds& bounds)
 		{
-			size_t seed = 0;
-			Trek::hashCombine(seed, vertex.pos, vertex.color, vertex.normal, vertex.uv);
-			return seed;
+			std::vector<PackedVertex> packed(vertexCount);
+			for (uint32_t i = 0; i < vertexCount; i++)
+			{
+				TrekVertexLayout::quantizePosition(vertices[i].pos, bounds.min, bounds.max, packed[i].position);
+				TrekVertexLayout::encodeOctahedral(vertices[i].normal, packed[i].normal);
+				TrekVertexLayout::encodeHalf(vertices[i].uv, packed[i].uv);
+				if constexpr (std::is_same_v<PackedVertex, TrekPackedColorVertex>)
+				{
+					TrekVertexLayout::encodeColor(vertices[i].color, packed[i].color);
+				}
+			}
+			return packed;
 		}
-	};
-}
+	}
 
-namespace Trek
-{
-	std::vector<VkVertexInputBindingDescription> TrekModel::Vertex::getBindingDescriptions()
+	TrekModel::TrekModel(TrekGeometryArena& arena, const TrekModel::Data& data)
+		: TrekModel{
+			arena,
+			data.vertices.data(),
+			static_cast<uint32_t>(data.vertices.size()),
+			data.indices.data(),
+			static_cast<uint32_t>(data.indices.size()),
+			data.computeBounds(),
+			data.lods.data(),
+			static_cast<uint32_t>(data.lods.size()),
+			data.meshlets.data(),
+			static_cast<uint32_t>(data.meshlets.size()) }
 	{
-		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
-		bindingDescriptions[0].binding = 0;
-		bindingDescriptions[0].stride = sizeof(Vertex);
-		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-		return bindingDescriptions;
 	}
 
-	std::vector<VkVertexInputAttributeDescription> TrekModel::Vertex::getAttributeDescriptions()
+	TrekModel::TrekModel(
+		TrekGeometryArena& arena,
+		const Vertex* vertices,
+		const uint32_t vertexCount,
+		const uint32_t* indices,
+		const uint32_t indexCount,
+		const Bounds& bounds,
+		const Lod* lods,
+		const uint32_t lodCount,
+		const Meshlet* meshlets,
+		const uint32_t meshletCount)
+		: arena{arena}, bounds{bounds}, meshlets(meshlets, meshlets + meshletCount)
 	{
-		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
-		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos) });
-		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) });
-		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) });
-		attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv) });
-		return attributeDescriptions;
+		assert(vertexCount >= 3 && "Vertex count must be atleast 3");
+		if (lodCount > 0)
+		{
+			this->lods.assign(lods, lods + lodCount);
+		}
+		else
+		{
+			this->lods.push_back({ 0, indexCount, 0.f });
+		}
+
+		// The upload queue copies into staging right away, so the converted arrays can be temporaries.
+		const void* vertexData = vertices;
+		std::vector<TrekPackedVertex> packed;
+		std::vector<TrekPackedColorVertex> packedColor;
+		switch (arena.getVertexFormat())
+		{
+		case TrekVertexFormat::Float:
+			break;
+		case TrekVertexFormat::Packed:
+			packed = packVertices<TrekPackedVertex>(vertices, vertexCount, bounds);
+			vertexData = packed.data();
+			break;
+		case TrekVertexFormat::PackedColor:
+			packedColor = packVertices<TrekPackedColorVertex>(vertices, vertexCount, bounds);
+			vertexData = packedColor.data();
+			break;
+		}
+		dequantize = TrekVertexLayout::dequantizeMatrix(arena.getVertexFormat(), bounds.min, bounds.max);
+
+		sphere.center = (bounds.min + bounds.max) * .5f;
+		float radiusSquared = 0.f;
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			const glm::vec3 offset = vertices[i].pos - sphere.center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		sphere.radius = std::sqrt(radiusSquared);
+
+		if (vertexCount < std::numeric_limits<uint16_t>::max() + 1u)
+		{
+			const std::vector<uint16_t> shortIndices(indices, indices + indexCount);
+			range = arena.allocate(vertexData, vertexCount, shortIndices.data(), indexCount, VK_INDEX_TYPE_UINT16);
+		}
+		else
+		{
+			range = arena.allocate(vertexData, vertexCount, indices, indexCount, VK_INDEX_TYPE_UINT32);
+		}
 	}
 
-	TrekModel::TrekModel(TrekCore& trekDevice, const TrekModel::Data& data)
-		: trekDevice{trekDevice}
+	TrekModel::TrekModel(TrekGeometryArena& arena, const TrekGeometryRange& range, const Bounds& bounds)
+		: arena{arena}, range{range}, bounds{bounds}
 	{
-		createVertexBuffers(data.vertices);
-		createIndexBuffer(data.indices);
+		lods.push_back({ 0, range.indexCount, 0.f });
+		dequantize = TrekVertexLayout::dequantizeMatrix(arena.getVertexFormat(), bounds.min, bounds.max);
+		sphere.center = (bounds.min + bounds.max) * .5f;
+		sphere.radius = glm::length(bounds.max - bounds.min) * .5f;
 	}
 
-	TrekModel::~TrekModel(){}
+	TrekModel::~TrekModel()
+	{
+		arena.free(range);
+	}
 
-	std::unique_ptr<TrekModel> TrekModel::createModelFromFile(TrekCore& device, const std::string& filePath)
+	std::unique_ptr<TrekModel> TrekModel::createModelFromFile(TrekGeometryArena& arena, const std::string& filePath, const bool optimize)
 	{
 		Data data{};
-		data.loadModel(filePath);
-		return std::make_unique<TrekModel>(device, data);
+		const std::unique_ptr<TrekMeshCache> cache = importFile(filePath, data, optimize);
+		return createFromImport(arena, cache.get(), data);
 	}
 
-	void TrekModel::bind(const VkCommandBuffer commandBuffer) const
+	std::unique_ptr<TrekMeshCache> TrekModel::importFile(
+		const std::string& filePath,
+		Data& data,
+		const bool optimize,
+		const unsigned threadCount,
+		uint64_t* sourceHash)
 	{
-		const VkBuffer buffers[] = { vertexBuffer->getBuffer()};
-		const VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		TrekCpuProfiler::Zone zone{ "TrekModel::importFile" };
+		const std::string cachePath = TrekMeshCache::cachePathFor(filePath);
+		const uint32_t steps = optimize ? TrekMeshOptimizer::ALL : TrekMeshOptimizer::NONE;
+		if (auto cache = TrekMeshCache::open(cachePath, filePath, steps))
+		{
+			if (sourceHash)
+			{
+				*sourceHash = cache->sourceHash();
+			}
+			return cache;
+		}
 
-		if(hasIndexBuffer)
+		data.loadModel(filePath, threadCount);
+		if (steps != TrekMeshOptimizer::NONE)
+		{
+			TrekMeshOptimizer::optimize(data, steps);
+		}
+		const uint64_t hash = TrekMeshCache::hashFile(filePath);
+		if (sourceHash)
 		{
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			*sourceHash = hash;
 		}
+		// A read-only asset directory just means parsing again next time.
+		TrekMeshCache::write(cachePath, filePath, data, steps, hash);
+		return nullptr;
 	}
 
-	void TrekModel::draw(const VkCommandBuffer commandBuffer) const
+	std::unique_ptr<TrekModel> TrekModel::createFromImport(TrekGeometryArena& arena, const TrekMeshCache* cache, const Data& data)
 	{
-		if(hasIndexBuffer)
-		{
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
-		}
-		else
+		if (!cache)
 		{
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+			return std::make_unique<TrekModel>(arena, data);
 		}
+		return std::make_unique<TrekModel>(
+			arena,
+			cache->vertices(),
+			cache->vertexCount(),
+			cache->indices(),
+			cache->indexCount(),
+			cache->bounds(),
+			cache->lods(),
+			cache->lodCount(),
+			cache->meshlets(),
+			cache->meshletCount());
 	}
 
-	void TrekModel::createVertexBuffers(const std::vector<Vertex>& vertices)
+	uint32_t TrekModel::selectLod(
+		const glm::mat4& modelMatrix,
+		const TrekCamera& camera,
+		const float viewportHeight,
+		const uint32_t currentLod,
+		const float pixelError,
+		const float hysteresis) const
 	{
-		vertexCount = static_cast<uint32_t>(vertices.size());
-		assert(vertexCount >= 3 && "Vertex count must be atleast 3");
-		const VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
-
-		TrekBuffer stagingBuffer{
-			trekDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
+		const glm::vec3 center = glm::vec3{ modelMatrix * glm::vec4{ (bounds.min + bounds.max) * .5f, 1.f } };
+		const float scale = std::max({ glm::length(glm::vec3{ modelMatrix[0] }), glm::length(glm::vec3{ modelMatrix[1] }), glm::length(glm::vec3{ modelMatrix[2] }) });
+		const float radius = glm::length(bounds.max - bounds.min) * .5f * scale;
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data());
+		// Pixels per world unit at the point of the bounding sphere closest to the camera.
+		const glm::mat4& projection = camera.getProjection();
+		float pixelsPerUnit = projection[1][1] * viewportHeight * .5f;
+		if (projection[3][3] == 0.f)
+		{
+			const float distance = (camera.getView() * glm::vec4{ center, 1.f }).z - radius;
+			if (distance <= 0.f)
+			{
+				return 0;
+			}
+			pixelsPerUnit /= distance;
+		}
+		pixelsPerUnit = std::abs(pixelsPerUnit);
 
-		vertexBuffer = std::make_unique<TrekBuffer>(
-			trekDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-			);
+		// Errors grow with the LOD index, so the coarsest LOD within a budget is a linear scan.
+		const auto coarsestWithin = [&](const float budget)
+		{
+			uint32_t lod = 0;
+			while (lod + 1 < lods.size() && lods[lod + 1].error * scale * pixelsPerUnit <= budget)
+			{
+				lod++;
+			}
+			return lod;
+		};
 
-		trekDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+		const uint32_t acceptable = coarsestWithin(pixelError);
+		if (currentLod > acceptable)
+		{
+			return acceptable;
+		}
+		return std::max(currentLod, coarsestWithin(pixelError * (1.f - hysteresis)));
 	}
 
-	void TrekModel::createIndexBuffer(const std::vector<uint32_t>& indices)
+	void TrekModel::drawVisibleMeshlets(
+		const VkCommandBuffer commandBuffer,
+		const uint32_t lod,
+		const glm::mat4& modelMatrix,
+		const TrekFrustum& frustum,
+		const glm::vec3& cameraPosition,
+		const bool coneCulling) const
 	{
-		indexCount = static_cast<uint32_t>(indices.size());
-		hasIndexBuffer = indexCount > 0;
-		if (!hasIndexBuffer) return;
-
-		const VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
-
-		TrekBuffer stagingBuffer{
-			trekDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		assert(lod < lods.size() && "LOD out of range");
+		if (range.indexCount == 0 || lods[lod].meshletCount == 0)
+		{
+			draw(commandBuffer, lod);
+			return;
+		}
+
+		const float scale = std::max({ glm::length(glm::vec3{ modelMatrix[0] }), glm::length(glm::vec3{ modelMatrix[1] }), glm::length(glm::vec3{ modelMatrix[2] }) });
+		const glm::mat3 axisMatrix{ modelMatrix };
+		uint32_t runStart = 0;
+		uint32_t runCount = 0;
+		const auto flush = [&]()
+		{
+			if (runCount > 0)
+			{
+				vkCmdDrawIndexed(commandBuffer, runCount, 1, range.firstIndex + runStart, static_cast<int32_t>(range.firstVertex), 0);
+				runCount = 0;
+			}
 		};
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)indices.data());
-		
-		indexBuffer = std::make_unique<TrekBuffer>(
-			trekDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
-
-		trekDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+		const Meshlet* first = meshlets.data() + lods[lod].firstMeshlet;
+		for (const Meshlet* meshlet = first; meshlet != first + lods[lod].meshletCount; meshlet++)
+		{
+			const glm::vec3 center = glm::vec3{ modelMatrix * glm::vec4{ meshlet->center, 1.f } };
+			const float radius = meshlet->radius * scale;
+			bool visible = frustum.intersectsSphere(center, radius);
+			if (visible && coneCulling && meshlet->coneCutoff < 1.f)
+			{
+				// Back facing when every point of the bounding sphere sees only the back of the cone.
+				const glm::vec3 toCenter = center - cameraPosition;
+				const glm::vec3 axis = glm::normalize(axisMatrix * meshlet->coneAxis);
+				visible = glm::dot(toCenter, axis) < meshlet->coneCutoff * glm::length(toCenter) + radius;
+			}
+
+			if (!visible)
+			{
+				flush();
+			}
+			else if (runCount == 0)
+			{
+				runStart = meshlet->firstIndex;
+				runCount = meshlet->indexCount;
+			}
+			else
+			{
+				// Meshlets tile the LOD's range, so a visible neighbour just extends the run.
+				runCount += meshlet->indexCount;
+			}
+		}
+		flush();
 	}
 
-	void TrekModel::Data::loadModel(const std::string& filePath)
+	void TrekModel::bind(const VkCommandBuffer commandBuffer) const
 	{
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
+		arena.bind(commandBuffer, range.indexType);
+	}
 
-		if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filePath.c_str()))
+	void TrekModel::draw(const VkCommandBuffer commandBuffer, const uint32_t lod) const
+	{
+		if(range.indexCount > 0)
 		{
-			throw std::runtime_error(err);
+			assert(lod < lods.size() && "LOD out of range");
+			vkCmdDrawIndexed(commandBuffer, lods[lod].indexCount, 1, range.firstIndex + lods[lod].firstIndex, static_cast<int32_t>(range.firstVertex), 0);
 		}
-
-		vertices.clear();
-		indices.clear();
-
-		std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-
-		for(const auto& shape : shapes)
+		else
 		{
-			for(const auto& index : shape.mesh.indices)
-			{
-				Vertex vertex{};
-				if(index.vertex_index >= 0)
-				{
-					vertex.pos = 
-					{
-						attrib.vertices[3 * index.vertex_index + 0],
-						attrib.vertices[3 * index.vertex_index + 1],
-						attrib.vertices[3 * index.vertex_index + 2],
-					};
-					vertex.color = { 1.f, 1.f, 1.f };
-				}
+			vkCmdDraw(commandBuffer, range.vertexCount, 1, range.firstVertex, 0);
+		}
+	}
 
-				if (index.normal_index >= 0)
-				{
-					vertex.normal =
-					{
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2],
-					};
-				}
+	TrekModel::Bounds TrekModel::Data::computeBounds() const
+	{
+		if (vertices.empty())
+		{
+			return {};
+		}
 
-				if (index.texcoord_index >= 0)
-				{
-					vertex.uv =
-					{
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						attrib.texcoords[2 * index.texcoord_index + 1],
-					};
-				}
+		Bounds bounds{ vertices[0].pos, vertices[0].pos };
+		for (const auto& vertex : vertices)
+		{
+			bounds.min = glm::min(bounds.min, vertex.pos);
+			bounds.max = glm::max(bounds.max, vertex.pos);
+		}
+		return bounds;
+	}
 
-				if(uniqueVertices.count(vertex) == 0)
-				{
-					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertex);
-				}
-				indices.push_back(uniqueVertices[vertex]);
-			}
+	void TrekModel::Data::loadModel(const std::string& filePath, const unsigned threadCount)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekModel::Data::loadModel" };
+		if (!TrekObjLoader::loadParallel(filePath, *this, threadCount))
+		{
+			TrekObjLoader::loadSerial(filePath, *this);
 		}
 	}
 
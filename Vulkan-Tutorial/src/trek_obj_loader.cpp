@@ -0,0 +1,443 @@
+#include "trek_obj_loader.h"
+#include "trek_cpu_profiler.h"
+#include "trek_mapped_file.h"
+#include "trek_vertex_welder.h"
+
+//libs
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+//std
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace Trek
+{
+	namespace
+	{
+		constexpr int32_t MISSING_INDEX = std::numeric_limits<int32_t>::min();
+		constexpr uint8_t RELATIVE_POSITION = 1;
+		constexpr uint8_t RELATIVE_TEXCOORD = 2;
+		constexpr uint8_t RELATIVE_NORMAL = 4;
+		// Chunks per thread, so threads that finish early pick up more work.
+		constexpr size_t CHUNKS_PER_THREAD = 4;
+
+		// Indices as written in the file. Negative ones are still relative to the chunk start here.
+		struct Corner {
+			int32_t position;
+			int32_t texcoord;
+			int32_t normal;
+			uint8_t relative;
+		};
+
+		struct Chunk {
+			const char* begin;
+			const char* end;
+			bool supported = true;
+
+			std::vector<float> positions;
+			std::vector<float> texcoords;
+			std::vector<float> normals;
+			std::vector<Corner> corners;
+
+			size_t positionBase = 0;
+			size_t texcoordBase = 0;
+			size_t normalBase = 0;
+			size_t cornerBase = 0;
+
+			std::vector<TrekModel::Vertex> uniqueVertices;
+			// Index triple of each unique vertex, only filled in TrekWeldMode::IndexTriple.
+			std::vector<TrekIndexTriple> uniqueKeys;
+			std::vector<uint32_t> localIndices;
+			// Chunk-local unique vertex to its index in the merged vertex array.
+			std::vector<uint32_t> remap;
+		};
+
+		template <typename Function>
+		void parallelFor(const size_t count, const unsigned threadCount, Function function)
+		{
+			std::atomic<size_t> next{ 0 };
+			auto worker = [&]()
+			{
+				for (size_t i = next++; i < count; i = next++)
+				{
+					function(i);
+				}
+			};
+
+			std::vector<std::thread> threads;
+			for (unsigned t = 1; t < threadCount; t++)
+			{
+				threads.emplace_back(worker);
+			}
+			worker();
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+		bool isSpace(const char c)
+		{
+			return c == ' ' || c == '\t';
+		}
+
+		// Same grammar as tinyobj's parseTriple: v, v/vt, v//vn or v/vt/vn.
+		bool parseIndex(const char** token, int32_t& index, uint8_t& relative, const uint8_t relativeBit)
+		{
+			const int value = atoi(*token);
+			(*token) += strcspn(*token, "/ \t\r");
+			if (value == 0)
+			{
+				return false;
+			}
+			if (value < 0)
+			{
+				relative |= relativeBit;
+			}
+			index = value > 0 ? value - 1 : value;
+			return true;
+		}
+
+		bool parseCorner(const char** token, Corner& corner)
+		{
+			corner = { MISSING_INDEX, MISSING_INDEX, MISSING_INDEX, 0 };
+			if (!parseIndex(token, corner.position, corner.relative, RELATIVE_POSITION))
+			{
+				return false;
+			}
+			if ((*token)[0] != '/')
+			{
+				return true;
+			}
+			(*token)++;
+			if ((*token)[0] == '/')
+			{
+				(*token)++;
+				return parseIndex(token, corner.normal, corner.relative, RELATIVE_NORMAL);
+			}
+			if (!parseIndex(token, corner.texcoord, corner.relative, RELATIVE_TEXCOORD))
+			{
+				return false;
+			}
+			if ((*token)[0] != '/')
+			{
+				return true;
+			}
+			(*token)++;
+			return parseIndex(token, corner.normal, corner.relative, RELATIVE_NORMAL);
+		}
+
+		void parseChunk(Chunk& chunk)
+		{
+			std::string line;
+			const char* cursor = chunk.begin;
+			while (cursor < chunk.end && chunk.supported)
+			{
+				const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', chunk.end - cursor));
+				if (lineEnd == nullptr)
+				{
+					lineEnd = chunk.end;
+				}
+				// tinyobj's float parser reads up to a terminator, so hand it a terminated copy.
+				line.assign(cursor, lineEnd);
+				cursor = lineEnd + 1;
+				if (!line.empty() && line.back() == '\r')
+				{
+					line.pop_back();
+				}
+
+				const char* token = line.c_str();
+				token += strspn(token, " \t");
+				if (token[0] == 'v' && isSpace(token[1]))
+				{
+					token += 2;
+					chunk.positions.push_back(tinyobj::parseReal(&token));
+					chunk.positions.push_back(tinyobj::parseReal(&token));
+					chunk.positions.push_back(tinyobj::parseReal(&token));
+				}
+				else if (token[0] == 'v' && token[1] == 'n' && isSpace(token[2]))
+				{
+					token += 3;
+					chunk.normals.push_back(tinyobj::parseReal(&token));
+					chunk.normals.push_back(tinyobj::parseReal(&token));
+					chunk.normals.push_back(tinyobj::parseReal(&token));
+				}
+				else if (token[0] == 'v' && token[1] == 't' && isSpace(token[2]))
+				{
+					token += 3;
+					chunk.texcoords.push_back(tinyobj::parseReal(&token));
+					chunk.texcoords.push_back(tinyobj::parseReal(&token));
+				}
+				else if (token[0] == 'f' && isSpace(token[1]))
+				{
+					token += 2;
+					token += strspn(token, " \t");
+					size_t cornerCount = 0;
+					while (token[0] != '\0')
+					{
+						Corner corner;
+						if (!parseCorner(&token, corner))
+						{
+							chunk.supported = false;
+							break;
+						}
+						// Relative indices count back from the data parsed so far in this chunk.
+						if (corner.relative & RELATIVE_POSITION) corner.position += static_cast<int32_t>(chunk.positions.size() / 3);
+						if (corner.relative & RELATIVE_TEXCOORD) corner.texcoord += static_cast<int32_t>(chunk.texcoords.size() / 2);
+						if (corner.relative & RELATIVE_NORMAL) corner.normal += static_cast<int32_t>(chunk.normals.size() / 3);
+						chunk.corners.push_back(corner);
+						cornerCount++;
+						token += strspn(token, " \t\r");
+					}
+					if (cornerCount != 3)
+					{
+						chunk.supported = false;
+					}
+				}
+			}
+		}
+
+		bool resolveIndex(int32_t& index, const bool relative, const size_t base, const size_t count)
+		{
+			if (index == MISSING_INDEX)
+			{
+				return true;
+			}
+			const int64_t resolved = relative ? static_cast<int64_t>(base) + index : index;
+			if (resolved < 0 || resolved >= static_cast<int64_t>(count))
+			{
+				return false;
+			}
+			index = static_cast<int32_t>(resolved);
+			return true;
+		}
+	}
+
+	void TrekObjLoader::loadSerial(const std::string& filePath, TrekModel::Data& data, const TrekWeldMode weldMode)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekObjLoader::loadSerial" };
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+
+		if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filePath.c_str()))
+		{
+			throw std::runtime_error(err);
+		}
+
+		data.indices.clear();
+
+		size_t cornerCount = 0;
+		for (const auto& shape : shapes)
+		{
+			cornerCount += shape.mesh.indices.size();
+		}
+		TrekVertexWelder welder{ weldMode, TrekVertexWelder::estimateVertices(cornerCount) };
+		data.indices.reserve(cornerCount);
+
+		for(const auto& shape : shapes)
+		{
+			for(const auto& index : shape.mesh.indices)
+			{
+				const auto makeVertex = [&]()
+				{
+					TrekModel::Vertex vertex{};
+					if(index.vertex_index >= 0)
+					{
+						vertex.pos = 
+						{
+							attrib.vertices[3 * index.vertex_index + 0],
+							attrib.vertices[3 * index.vertex_index + 1],
+							attrib.vertices[3 * index.vertex_index + 2],
+						};
+						vertex.color = { 1.f, 1.f, 1.f };
+					}
+
+					if (index.normal_index >= 0)
+					{
+						vertex.normal =
+						{
+							attrib.normals[3 * index.normal_index + 0],
+							attrib.normals[3 * index.normal_index + 1],
+							attrib.normals[3 * index.normal_index + 2],
+						};
+					}
+
+					if (index.texcoord_index >= 0)
+					{
+						vertex.uv =
+						{
+							attrib.texcoords[2 * index.texcoord_index + 0],
+							attrib.texcoords[2 * index.texcoord_index + 1],
+						};
+					}
+					return vertex;
+				};
+				data.indices.push_back(welder.weld({ index.vertex_index, index.texcoord_index, index.normal_index }, makeVertex));
+			}
+		}
+		data.vertices = std::move(welder.getVertices());
+	}
+
+	bool TrekObjLoader::loadParallel(const std::string& filePath, TrekModel::Data& data, unsigned threadCount, const TrekWeldMode weldMode)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekObjLoader::loadParallel" };
+		TrekMappedFile file;
+		if (!file.open(filePath))
+		{
+			throw std::runtime_error("failed to open " + filePath);
+		}
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		// Line aligned chunks of roughly equal size.
+		const char* const fileBegin = reinterpret_cast<const char*>(file.data());
+		const char* const fileEnd = fileBegin + file.size();
+		const size_t chunkTarget = std::max<size_t>(file.size() / (threadCount * CHUNKS_PER_THREAD), 64 * 1024);
+		std::vector<Chunk> chunks;
+		for (const char* begin = fileBegin; begin < fileEnd;)
+		{
+			const char* end = begin + std::min<size_t>(chunkTarget, fileEnd - begin);
+			const char* newline = static_cast<const char*>(memchr(end - 1, '\n', fileEnd - (end - 1)));
+			end = newline != nullptr ? newline + 1 : fileEnd;
+			Chunk chunk{};
+			chunk.begin = begin;
+			chunk.end = end;
+			chunks.push_back(std::move(chunk));
+			begin = end;
+		}
+
+		{
+			TrekCpuProfiler::Zone parseZone{ "parse chunks" };
+			parallelFor(chunks.size(), threadCount, [&chunks](const size_t i) { parseChunk(chunks[i]); });
+		}
+
+		size_t positionCount = 0;
+		size_t texcoordCount = 0;
+		size_t normalCount = 0;
+		size_t cornerCount = 0;
+		for (auto& chunk : chunks)
+		{
+			if (!chunk.supported)
+			{
+				return false;
+			}
+			chunk.positionBase = positionCount;
+			chunk.texcoordBase = texcoordCount;
+			chunk.normalBase = normalCount;
+			chunk.cornerBase = cornerCount;
+			positionCount += chunk.positions.size() / 3;
+			texcoordCount += chunk.texcoords.size() / 2;
+			normalCount += chunk.normals.size() / 3;
+			cornerCount += chunk.corners.size();
+		}
+
+		std::vector<float> positions(positionCount * 3);
+		std::vector<float> texcoords(texcoordCount * 2);
+		std::vector<float> normals(normalCount * 3);
+		for (const auto& chunk : chunks)
+		{
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase * 3);
+			std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + chunk.texcoordBase * 2);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase * 3);
+		}
+
+		// Build each corner's vertex exactly like the serial loop and weld within the chunk.
+		std::atomic<bool> indicesValid{ true };
+		{
+			TrekCpuProfiler::Zone weldZone{ "weld chunks" };
+			parallelFor(chunks.size(), threadCount, [&](const size_t i)
+			{
+				Chunk& chunk = chunks[i];
+				TrekVertexWelder welder{ weldMode, TrekVertexWelder::estimateVertices(chunk.corners.size()) };
+				chunk.localIndices.reserve(chunk.corners.size());
+				for (Corner corner : chunk.corners)
+				{
+					if (!resolveIndex(corner.position, corner.relative & RELATIVE_POSITION, chunk.positionBase, positionCount) ||
+						!resolveIndex(corner.texcoord, corner.relative & RELATIVE_TEXCOORD, chunk.texcoordBase, texcoordCount) ||
+						!resolveIndex(corner.normal, corner.relative & RELATIVE_NORMAL, chunk.normalBase, normalCount))
+					{
+						indicesValid = false;
+						return;
+					}
+
+					// The serial path sees tinyobj's -1 for missing texcoords and normals.
+					const TrekIndexTriple triple{
+						corner.position,
+						corner.texcoord != MISSING_INDEX ? corner.texcoord : -1,
+						corner.normal != MISSING_INDEX ? corner.normal : -1 };
+					const auto makeVertex = [&]()
+					{
+						TrekModel::Vertex vertex{};
+						vertex.pos = { positions[3 * corner.position + 0], positions[3 * corner.position + 1], positions[3 * corner.position + 2] };
+						vertex.color = { 1.f, 1.f, 1.f };
+						if (corner.normal != MISSING_INDEX)
+						{
+							vertex.normal = { normals[3 * corner.normal + 0], normals[3 * corner.normal + 1], normals[3 * corner.normal + 2] };
+						}
+						if (corner.texcoord != MISSING_INDEX)
+						{
+							vertex.uv = { texcoords[2 * corner.texcoord + 0], texcoords[2 * corner.texcoord + 1] };
+						}
+						return vertex;
+					};
+					chunk.localIndices.push_back(welder.weld(triple, makeVertex));
+				}
+				chunk.uniqueVertices = std::move(welder.getVertices());
+				chunk.uniqueKeys = welder.getKeys();
+				std::vector<Corner>().swap(chunk.corners);
+			});
+		}
+		if (!indicesValid)
+		{
+			return false;
+		}
+
+		// Chunks hold their vertices in first-use order, so merging them in file order reproduces
+		// the serial path's global first-use order.
+		std::vector<TrekModel::Vertex> vertices;
+		{
+			TrekCpuProfiler::Zone mergeZone{ "merge chunks" };
+			size_t uniqueCount = 0;
+			for (const auto& chunk : chunks)
+			{
+				uniqueCount += chunk.uniqueVertices.size();
+			}
+			TrekVertexWelder welder{ weldMode, uniqueCount };
+			for (auto& chunk : chunks)
+			{
+				chunk.remap.resize(chunk.uniqueVertices.size());
+				for (size_t i = 0; i < chunk.uniqueVertices.size(); i++)
+				{
+					chunk.remap[i] = weldMode == TrekWeldMode::IndexTriple
+						? welder.weld(chunk.uniqueKeys[i], [&]() { return chunk.uniqueVertices[i]; })
+						: welder.weld(chunk.uniqueVertices[i]);
+				}
+			}
+			vertices = std::move(welder.getVertices());
+		}
+
+		std::vector<uint32_t> indices(cornerCount);
+		parallelFor(chunks.size(), threadCount, [&](const size_t i)
+		{
+			const Chunk& chunk = chunks[i];
+			for (size_t corner = 0; corner < chunk.localIndices.size(); corner++)
+			{
+				indices[chunk.cornerBase + corner] = chunk.remap[chunk.localIndices[corner]];
+			}
+		});
+
+		data.vertices = std::move(vertices);
+		data.indices = std::move(indices);
+		return true;
+	}
+}
@@ -1,4 +1,5 @@
 #include "trek_pipeline.h"
+#include "trek_cpu_profiler.h"
 
 #include <cassert>
 #include <stdexcept>
@@ -56,6 +57,7 @@ namespace Trek
 	void TrekPipeline::createGraphicsPipeline(const TrekCore& device, const std::string& vertexFilePath,
 		const std::string& fragFilePath, const PipelineConfigInfo& configInfo)
 	{
+		TrekCpuProfiler::Zone zone{ "TrekPipeline::createGraphicsPipeline" };
 		assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline:: "
 			"no pipelineLayout in configInfo.");
 		assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: "
@@ -83,14 +85,12 @@ namespace Trek
 		shaderStages[0] = vertShaderStageInfo;
 		shaderStages[1] = fragShaderStageInfo;
 
-		const auto bindingDescriptions = TrekModel::Vertex::getBindingDescriptions();
-		const auto attributeDescriptions = TrekModel::Vertex::getAttributeDescriptions();
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());;
-		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+		vertexInputInfo.vertexBindingDescriptionCount = configInfo.vertexInput.bindingCount;
+		vertexInputInfo.vertexAttributeDescriptionCount = configInfo.vertexInput.attributeCount;
+		vertexInputInfo.pVertexBindingDescriptions = configInfo.vertexInput.bindings;
+		vertexInputInfo.pVertexAttributeDescriptions = configInfo.vertexInput.attributes;
 
 		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -190,6 +190,8 @@ namespace Trek
 		configInfo.dynamicStateInfo.dynamicStateCount = 
 			static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 		configInfo.dynamicStateInfo.flags = 0;
+
+		configInfo.vertexInput = TrekVertexInput<TrekModelVertexLayout>::state();
 	}
 
 
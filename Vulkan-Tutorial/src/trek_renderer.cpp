@@ -1,17 +1,33 @@
 #include "trek_renderer.h"
+#include "trek_utils.h"
+#include "trek_cpu_profiler.h"
 
 // std
 #include <array>
+#include <chrono>
 #include <stdexcept>
 
 
 namespace Trek
 {
 	TrekRenderer::TrekRenderer(TrekWindow& window, TrekCore& device)
-		: trekWindow(window), trekDevice(device)
+		: trekWindow(&window), trekDevice(device)
 	{
 		recreateSwapChain();
 		createCommandBuffers();
+		gpuProfiler = std::make_unique<TrekGpuProfiler>(trekDevice);
+		frameAllocator = std::make_unique<TrekFrameAllocator>(
+			trekDevice, TrekSwapChain::MAX_FRAMES_IN_FLIGHT, FRAME_ALLOCATOR_BYTES);
+	}
+
+	TrekRenderer::TrekRenderer(TrekCore& device, const VkExtent2D extent)
+		: trekWindow(nullptr), trekDevice(device)
+	{
+		offscreenTarget = std::make_unique<TrekOffscreenTarget>(trekDevice, extent);
+		createCommandBuffers();
+		gpuProfiler = std::make_unique<TrekGpuProfiler>(trekDevice);
+		frameAllocator = std::make_unique<TrekFrameAllocator>(
+			trekDevice, TrekSwapChain::MAX_FRAMES_IN_FLIGHT, FRAME_ALLOCATOR_BYTES);
 	}
 
 	TrekRenderer::~TrekRenderer()
@@ -21,10 +37,11 @@ namespace Trek
 
 	void TrekRenderer::recreateSwapChain()
 	{
-		auto extent = trekWindow.getExtent();
+		assert(!isHeadless() && "Headless renderer has no swap chain to recreate.");
+		auto extent = trekWindow->getExtent();
 		while (extent.width == 0 || extent.height == 0)
 		{
-			extent = trekWindow.getExtent();
+			extent = trekWindow->getExtent();
 			glfwWaitEvents();
 		}
 
@@ -47,10 +64,19 @@ namespace Trek
 		// TODO: come back to this.
 	}
 
+	TrekRenderTarget& TrekRenderer::renderTarget() const
+	{
+		if (isHeadless())
+		{
+			return *offscreenTarget;
+		}
+		return *trekSwapChain;
+	}
+
 
 	void TrekRenderer::createCommandBuffers()
 	{
-		assert(trekSwapChain != nullptr && "Cannot create pipeline before swap chain.");
+		assert((trekSwapChain != nullptr || offscreenTarget != nullptr) && "Cannot create pipeline before swap chain.");
 		commandBuffers.resize(TrekSwapChain::MAX_FRAMES_IN_FLIGHT);
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -76,8 +102,11 @@ namespace Trek
 
 	VkCommandBuffer TrekRenderer::beginFrame()
 	{
+		TrekCpuProfiler::Zone zone{ "TrekRenderer::beginFrame" };
 		assert(!isFrameStarted && "Cannot call begin frame while frame is in progress.");
-		const auto result = trekSwapChain->acquireNextImage(&currentImageIndex);
+		const auto acquireStart = std::chrono::steady_clock::now();
+		const auto result = renderTarget().acquireNextImage(&currentImageIndex);
+		acquireMs = millisecondsSince(acquireStart);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 			recreateSwapChain();
@@ -88,6 +117,8 @@ namespace Trek
 		}
 
 		isFrameStarted = true;
+		// The target has waited for this frame's fence, so its old transient data is no longer in use.
+		frameAllocator->beginFrame(currentFrameIndex);
 
 		const auto commandBuffer = getCurrentCommandBuffer();
 		VkCommandBufferBeginInfo beginInfo{};
@@ -99,23 +130,38 @@ namespace Trek
 			throw std::runtime_error("failed to begin recording command buffer!");
 		}
 
+		gpuProfiler->beginFrame(commandBuffer, currentFrameIndex);
+		frameScope = gpuProfiler->beginScope(commandBuffer, "frame");
 		return commandBuffer;
 	}
 
 	void TrekRenderer::endFrame()
 	{
+		TrekCpuProfiler::Zone zone{ "TrekRenderer::endFrame" };
 		assert(isFrameStarted && "Cannot call end frame while frame is not in progress.");
 		const auto commandBuffer = getCurrentCommandBuffer();
+		gpuProfiler->endScope(commandBuffer, frameScope);
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to record command buffer!");
 		}
 
-		const auto result = trekSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
-			trekWindow.wasWindowResized())
+		const auto submitStart = std::chrono::steady_clock::now();
+		frameAllocator->flush();
+		auto result = renderTarget().submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		frameTimings.submitMs = millisecondsSince(submitStart);
+
+		const auto presentStart = std::chrono::steady_clock::now();
+		if (result == VK_SUCCESS)
+		{
+			result = renderTarget().presentImage(&currentImageIndex);
+		}
+		frameTimings.presentMs = acquireMs + millisecondsSince(presentStart);
+
+		if (!isHeadless() && (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
+			trekWindow->wasWindowResized()))
 		{
-			trekWindow.resetWindowResizedFlag();
+			trekWindow->resetWindowResizedFlag();
 			recreateSwapChain();
 		}
 		else if (result != VK_SUCCESS) {
@@ -124,9 +170,10 @@ namespace Trek
 
 		isFrameStarted = false;
 		currentFrameIndex = (currentFrameIndex + 1) % TrekSwapChain::MAX_FRAMES_IN_FLIGHT;
+		TrekCpuProfiler::markFrame();
 	}
 
-	void TrekRenderer::beginSwapChainRenderPass(const VkCommandBuffer commandBuffer) const
+	void TrekRenderer::beginSwapChainRenderPass(const VkCommandBuffer commandBuffer)
 	{
 		assert(isFrameStarted && "Cannot call beginSwapChainRenderPass while frame is in progress.");
 		assert(commandBuffer == getCurrentCommandBuffer() 
@@ -134,10 +181,11 @@ namespace Trek
 
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = trekSwapChain->getRenderPass();
-		renderPassInfo.framebuffer = trekSwapChain->getFrameBuffer(currentImageIndex);
+		const TrekRenderTarget& target = renderTarget();
+		renderPassInfo.renderPass = target.getRenderPass();
+		renderPassInfo.framebuffer = target.getFrameBuffer(currentImageIndex);
 		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = trekSwapChain->getSwapChainExtent();
+		renderPassInfo.renderArea.extent = target.getExtent();
 
 		std::array<VkClearValue, 2> clearValues{};
 		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
@@ -145,30 +193,32 @@ namespace Trek
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
+		renderPassScope = gpuProfiler->beginScope(commandBuffer, "main pass");
 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(trekSwapChain->getSwapChainExtent().width);
-		viewport.height = static_cast<float>(trekSwapChain->getSwapChainExtent().height);
+		viewport.width = static_cast<float>(target.getExtent().width);
+		viewport.height = static_cast<float>(target.getExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
 		VkRect2D scissor{};
 		scissor.offset = { 0, 0 };
-		scissor.extent = trekSwapChain->getSwapChainExtent();
+		scissor.extent = target.getExtent();
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 	}
 
-	void TrekRenderer::endSwapChainRenderPass(const VkCommandBuffer commandBuffer) const
+	void TrekRenderer::endSwapChainRenderPass(const VkCommandBuffer commandBuffer)
 	{
 		assert(isFrameStarted && "Cannot call endSwapChainRenderPass while frame is in progress.");
 		assert(commandBuffer == getCurrentCommandBuffer()
 			&& "Cannot end render pass on command buffer from a different frame.");
 
 		vkCmdEndRenderPass(commandBuffer);
+		gpuProfiler->endScope(commandBuffer, renderPassScope);
 	}
 
 
@@ -1,4 +1,5 @@
 #include "trek_swapchain.h"
+#include "trek_cpu_profiler.h"
 
 // std
 #include <array>
@@ -52,7 +53,7 @@ namespace Trek {
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
             vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            device.getAllocator().free(depthImageMemorys[i]);
         }
 
         for (const auto framebuffer : swapChainFramebuffers) {
@@ -71,12 +72,16 @@ namespace Trek {
 
     VkResult TrekSwapChain::acquireNextImage(uint32_t* imageIndex) const
     {
-        vkWaitForFences(
-            device.device(),
-            1,
-            &inFlightFences[currentFrame],
-            VK_TRUE,
-            std::numeric_limits<uint64_t>::max());
+        TrekCpuProfiler::Zone zone{ "TrekSwapChain::acquireNextImage" };
+        {
+            TrekCpuProfiler::Zone fenceZone{ "wait for frame fence" };
+            vkWaitForFences(
+                device.device(),
+                1,
+                &inFlightFences[currentFrame],
+                VK_TRUE,
+                std::numeric_limits<uint64_t>::max());
+        }
 
         const VkResult result = vkAcquireNextImageKHR(
             device.device(),
@@ -118,11 +123,17 @@ namespace Trek {
             throw std::runtime_error("failed to submit draw command buffer!");
         }
 
+        return VK_SUCCESS;
+    }
+
+    VkResult TrekSwapChain::presentImage(const uint32_t* imageIndex) {
+        const VkSemaphore waitSemaphores[] = { renderFinishedSemaphores[currentFrame] };
+
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
         presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores = signalSemaphores;
+        presentInfo.pWaitSemaphores = waitSemaphores;
 
         const VkSwapchainKHR swapChains[] = { swapChain };
         presentInfo.swapchainCount = 1;
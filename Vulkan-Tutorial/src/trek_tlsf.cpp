@@ -0,0 +1,264 @@
+#include "trek_tlsf.h"
+
+// std
+#include <cassert>
+
+namespace Trek
+{
+	namespace
+	{
+		uint32_t floorLog2(uint64_t value)
+		{
+			uint32_t result = 0;
+			while (value >>= 1)
+			{
+				result++;
+			}
+			return result;
+		}
+
+		uint32_t lowestBit(const uint64_t value)
+		{
+			uint32_t result = 0;
+			while (((value >> result) & 1) == 0)
+			{
+				result++;
+			}
+			return result;
+		}
+	}
+
+	TrekTlsfAllocator::TrekTlsfAllocator(const uint64_t capacity) : capacity(capacity)
+	{
+		assert(capacity > 0 && "TLSF allocator needs a non-empty range.");
+		for (auto& lists : freeLists)
+		{
+			lists.fill(INVALID_NODE);
+		}
+		insertFree(createNode(0, capacity));
+	}
+
+	void TrekTlsfAllocator::mapping(const uint64_t size, uint32_t& fl, uint32_t& sl)
+	{
+		// Sizes below SL_COUNT all live in first level 0, one second level bucket per byte.
+		if (size < SL_COUNT)
+		{
+			fl = 0;
+			sl = static_cast<uint32_t>(size);
+			return;
+		}
+		const uint32_t log2 = floorLog2(size);
+		fl = log2 - SL_BITS + 1;
+		sl = static_cast<uint32_t>(size >> (log2 - SL_BITS)) ^ SL_COUNT;
+	}
+
+	bool TrekTlsfAllocator::findFreeBlock(uint64_t size, uint32_t& fl, uint32_t& sl) const
+	{
+		// Round up to the next bucket boundary so any block in the found bucket is big enough.
+		if (size >= SL_COUNT)
+		{
+			const uint64_t round = (uint64_t{ 1 } << (floorLog2(size) - SL_BITS)) - 1;
+			if (size > UINT64_MAX - round)
+			{
+				return false;
+			}
+			size += round;
+		}
+		mapping(size, fl, sl);
+		if (fl >= FL_COUNT)
+		{
+			return false;
+		}
+
+		uint32_t slMap = slBitmaps[fl] & (~0u << sl);
+		if (slMap == 0)
+		{
+			const uint64_t flMap = fl + 1 < 64 ? flBitmap & (~uint64_t{ 0 } << (fl + 1)) : 0;
+			if (flMap == 0)
+			{
+				return false;
+			}
+			fl = lowestBit(flMap);
+			slMap = slBitmaps[fl];
+		}
+		sl = lowestBit(slMap);
+		return true;
+	}
+
+	TrekTlsfAllocator::Allocation TrekTlsfAllocator::allocate(const uint64_t size, const uint64_t alignment)
+	{
+		assert(size > 0 && "Cannot allocate zero bytes.");
+		assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+		// Searching for size + alignment - 1 guarantees the aligned range fits whatever the block offset.
+		const uint64_t searchSize = size + alignment - 1;
+		uint32_t fl = 0;
+		uint32_t sl = 0;
+		if (searchSize < size || !findFreeBlock(searchSize, fl, sl))
+		{
+			return {};
+		}
+
+		const uint32_t node = freeLists[fl][sl];
+		removeFree(node);
+
+		// Free blocks never touch another free block, so the padding in front and the tail
+		// split off below can go straight back into the free lists without merging.
+		const uint64_t alignedOffset = (nodes[node].offset + alignment - 1) & ~(alignment - 1);
+		const uint64_t padding = alignedOffset - nodes[node].offset;
+		if (padding > 0)
+		{
+			const uint32_t front = createNode(nodes[node].offset, padding);
+			nodes[front].prevPhysical = nodes[node].prevPhysical;
+			nodes[front].nextPhysical = node;
+			if (nodes[front].prevPhysical != INVALID_NODE)
+			{
+				nodes[nodes[front].prevPhysical].nextPhysical = front;
+			}
+			nodes[node].prevPhysical = front;
+			nodes[node].offset = alignedOffset;
+			nodes[node].size -= padding;
+			insertFree(front);
+		}
+
+		if (nodes[node].size > size)
+		{
+			const uint32_t tail = createNode(nodes[node].offset + size, nodes[node].size - size);
+			nodes[tail].prevPhysical = node;
+			nodes[tail].nextPhysical = nodes[node].nextPhysical;
+			if (nodes[tail].nextPhysical != INVALID_NODE)
+			{
+				nodes[nodes[tail].nextPhysical].prevPhysical = tail;
+			}
+			nodes[node].nextPhysical = tail;
+			nodes[node].size = size;
+			insertFree(tail);
+		}
+
+		nodes[node].free = false;
+		usedBytes += size;
+		allocationCount++;
+		return { alignedOffset, node };
+	}
+
+	void TrekTlsfAllocator::free(uint32_t node)
+	{
+		assert(node < nodes.size() && !nodes[node].free && "Freeing a block that is not allocated.");
+		usedBytes -= nodes[node].size;
+		allocationCount--;
+
+		const uint32_t prev = nodes[node].prevPhysical;
+		if (prev != INVALID_NODE && nodes[prev].free)
+		{
+			removeFree(prev);
+			nodes[prev].size += nodes[node].size;
+			nodes[prev].nextPhysical = nodes[node].nextPhysical;
+			if (nodes[prev].nextPhysical != INVALID_NODE)
+			{
+				nodes[nodes[prev].nextPhysical].prevPhysical = prev;
+			}
+			releaseNode(node);
+			node = prev;
+		}
+
+		const uint32_t next = nodes[node].nextPhysical;
+		if (next != INVALID_NODE && nodes[next].free)
+		{
+			removeFree(next);
+			nodes[node].size += nodes[next].size;
+			nodes[node].nextPhysical = nodes[next].nextPhysical;
+			if (nodes[node].nextPhysical != INVALID_NODE)
+			{
+				nodes[nodes[node].nextPhysical].prevPhysical = node;
+			}
+			releaseNode(next);
+		}
+
+		insertFree(node);
+	}
+
+	uint64_t TrekTlsfAllocator::largestFreeBlock() const
+	{
+		if (flBitmap == 0)
+		{
+			return 0;
+		}
+		const uint32_t fl = floorLog2(flBitmap);
+		uint64_t largest = 0;
+		for (uint32_t node = freeLists[fl][floorLog2(slBitmaps[fl])]; node != INVALID_NODE; node = nodes[node].nextFree)
+		{
+			largest = nodes[node].size > largest ? nodes[node].size : largest;
+		}
+		return largest;
+	}
+
+	uint32_t TrekTlsfAllocator::createNode(const uint64_t offset, const uint64_t size)
+	{
+		const Node node{ offset, size, INVALID_NODE, INVALID_NODE, INVALID_NODE, INVALID_NODE, false };
+		if (!unusedNodes.empty())
+		{
+			const uint32_t index = unusedNodes.back();
+			unusedNodes.pop_back();
+			nodes[index] = node;
+			return index;
+		}
+		nodes.push_back(node);
+		return static_cast<uint32_t>(nodes.size() - 1);
+	}
+
+	void TrekTlsfAllocator::releaseNode(const uint32_t node)
+	{
+		unusedNodes.push_back(node);
+	}
+
+	void TrekTlsfAllocator::insertFree(const uint32_t node)
+	{
+		uint32_t fl = 0;
+		uint32_t sl = 0;
+		mapping(nodes[node].size, fl, sl);
+
+		const uint32_t head = freeLists[fl][sl];
+		nodes[node].free = true;
+		nodes[node].prevFree = INVALID_NODE;
+		nodes[node].nextFree = head;
+		if (head != INVALID_NODE)
+		{
+			nodes[head].prevFree = node;
+		}
+		freeLists[fl][sl] = node;
+		flBitmap |= uint64_t{ 1 } << fl;
+		slBitmaps[fl] |= 1u << sl;
+	}
+
+	void TrekTlsfAllocator::removeFree(const uint32_t node)
+	{
+		uint32_t fl = 0;
+		uint32_t sl = 0;
+		mapping(nodes[node].size, fl, sl);
+
+		const uint32_t prev = nodes[node].prevFree;
+		const uint32_t next = nodes[node].nextFree;
+		if (prev != INVALID_NODE)
+		{
+			nodes[prev].nextFree = next;
+		}
+		else
+		{
+			freeLists[fl][sl] = next;
+		}
+		if (next != INVALID_NODE)
+		{
+			nodes[next].prevFree = prev;
+		}
+
+		if (freeLists[fl][sl] == INVALID_NODE)
+		{
+			slBitmaps[fl] &= ~(1u << sl);
+			if (slBitmaps[fl] == 0)
+			{
+				flBitmap &= ~(uint64_t{ 1 } << fl);
+			}
+		}
+		nodes[node].free = false;
+	}
+}
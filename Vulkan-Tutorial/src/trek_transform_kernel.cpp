@@ -0,0 +1,167 @@
+#include "trek_transform_kernel.h"
+#include "trek_transform_kernel_simd.h"
+
+// std
+#include <cassert>
+#include <cstddef>
+
+#ifdef TREK_TRANSFORM_KERNEL_X86
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace Trek
+{
+	namespace
+	{
+		static_assert(sizeof(TrekTransformComponent) == TransformKernelSimd::FLOATS * sizeof(float), "TrekTransformComponent must be 9 packed floats");
+		static_assert(offsetof(TrekTransformComponent, scale) == TransformKernelSimd::SCALE * sizeof(float), "Unexpected TrekTransformComponent layout");
+		static_assert(offsetof(TrekTransformComponent, rotation) == TransformKernelSimd::ROTATION * sizeof(float), "Unexpected TrekTransformComponent layout");
+		static_assert(sizeof(glm::mat4) == TransformKernelSimd::MATRIX_FLOATS * sizeof(float), "glm::mat4 must be 16 packed floats");
+		static_assert(TransformKernelSimd::MAX_ANGLE == TrekTransformKernel::MAX_VECTOR_ANGLE, "Vector angle limits differ");
+
+		void computeScalar(const float* transform, float* modelMatrix, float* normalMatrix)
+		{
+			const TrekTransformComponent& component = *reinterpret_cast<const TrekTransformComponent*>(transform);
+			*reinterpret_cast<glm::mat4*>(modelMatrix) = component.mat4();
+			*reinterpret_cast<glm::mat4*>(normalMatrix) = glm::mat4{ component.normalMatrix() };
+		}
+
+#ifdef TREK_TRANSFORM_KERNEL_X86
+		struct Sse2Ops
+		{
+			using F = __m128;
+			using I = __m128i;
+			static constexpr uint32_t WIDTH = 4;
+
+			static F set1(const float value) { return _mm_set1_ps(value); }
+			static I set1i(const int value) { return _mm_set1_epi32(value); }
+			static F add(const F& a, const F& b) { return _mm_add_ps(a, b); }
+			static F sub(const F& a, const F& b) { return _mm_sub_ps(a, b); }
+			static F mul(const F& a, const F& b) { return _mm_mul_ps(a, b); }
+			static F div(const F& a, const F& b) { return _mm_div_ps(a, b); }
+			static F madd(const F& a, const F& b, const F& c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+			static F andps(const F& a, const F& b) { return _mm_and_ps(a, b); }
+			static F andnot(const F& a, const F& b) { return _mm_andnot_ps(a, b); }
+			static F orps(const F& a, const F& b) { return _mm_or_ps(a, b); }
+			static F xorps(const F& a, const F& b) { return _mm_xor_ps(a, b); }
+			static F cmpgt(const F& a, const F& b) { return _mm_cmpgt_ps(a, b); }
+			static int movemask(const F& a) { return _mm_movemask_ps(a); }
+			static I cvtt(const F& a) { return _mm_cvttps_epi32(a); }
+			static F cvt(const I& a) { return _mm_cvtepi32_ps(a); }
+			static F castf(const I& a) { return _mm_castsi128_ps(a); }
+			static I addi(const I& a, const I& b) { return _mm_add_epi32(a, b); }
+			static I subi(const I& a, const I& b) { return _mm_sub_epi32(a, b); }
+			static I andi(const I& a, const I& b) { return _mm_and_si128(a, b); }
+			static I andnoti(const I& a, const I& b) { return _mm_andnot_si128(a, b); }
+			static I cmpeqi(const I& a, const I& b) { return _mm_cmpeq_epi32(a, b); }
+			static I slli29(const I& a) { return _mm_slli_epi32(a, 29); }
+
+			static F gather(const float* base, const uint32_t stride)
+			{
+				return _mm_set_ps(base[3 * stride], base[2 * stride], base[stride], base[0]);
+			}
+
+			// Lane k of x, y, z and w becomes column `column` of matrix k.
+			static void storeColumn(const F& x, const F& y, const F& z, const F& w, float* matrices, const uint32_t column)
+			{
+				__m128 lane0 = x, lane1 = y, lane2 = z, lane3 = w;
+				_MM_TRANSPOSE4_PS(lane0, lane1, lane2, lane3);
+				_mm_storeu_ps(matrices + 0 * TransformKernelSimd::MATRIX_FLOATS + column * 4, lane0);
+				_mm_storeu_ps(matrices + 1 * TransformKernelSimd::MATRIX_FLOATS + column * 4, lane1);
+				_mm_storeu_ps(matrices + 2 * TransformKernelSimd::MATRIX_FLOATS + column * 4, lane2);
+				_mm_storeu_ps(matrices + 3 * TransformKernelSimd::MATRIX_FLOATS + column * 4, lane3);
+			}
+		};
+
+		bool cpuHasAvx2()
+		{
+#ifdef _MSC_VER
+			int info[4]{};
+			__cpuid(info, 0);
+			if (info[0] < 7)
+			{
+				return false;
+			}
+			__cpuid(info, 1);
+			const bool fma = (info[2] & (1 << 12)) != 0;
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			if (!fma || !osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+			{
+				return false;
+			}
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+		}
+#endif
+	}
+
+	TrekTransformKernel::Path TrekTransformKernel::detect()
+	{
+		static const Path path = isSupported(Path::Avx2) ? Path::Avx2 : isSupported(Path::Sse2) ? Path::Sse2 : Path::Scalar;
+		return path;
+	}
+
+	bool TrekTransformKernel::isSupported(const Path path)
+	{
+		switch (path)
+		{
+#ifdef TREK_TRANSFORM_KERNEL_X86
+		case Path::Sse2: return true;
+		case Path::Avx2:
+		{
+			static const bool avx2 = cpuHasAvx2();
+			return avx2;
+		}
+#endif
+		case Path::Scalar: return true;
+		default: return false;
+		}
+	}
+
+	const char* TrekTransformKernel::name(const Path path)
+	{
+		switch (path)
+		{
+		case Path::Sse2: return "sse2";
+		case Path::Avx2: return "avx2";
+		default: return "scalar";
+		}
+	}
+
+	void TrekTransformKernel::compute(const TrekTransformComponent* transforms, const uint32_t count, glm::mat4* modelMatrices, glm::mat4* normalMatrices)
+	{
+		compute(transforms, count, modelMatrices, normalMatrices, detect());
+	}
+
+	void TrekTransformKernel::compute(const TrekTransformComponent* transforms, const uint32_t count, glm::mat4* modelMatrices, glm::mat4* normalMatrices, const Path path)
+	{
+		assert(isSupported(path) && "Transform kernel path not supported by this CPU");
+		const float* transformFloats = reinterpret_cast<const float*>(transforms);
+		float* modelFloats = reinterpret_cast<float*>(modelMatrices);
+		float* normalFloats = reinterpret_cast<float*>(normalMatrices);
+		switch (path)
+		{
+#ifdef TREK_TRANSFORM_KERNEL_X86
+		case Path::Avx2:
+			TransformKernelSimd::computeAvx2(transformFloats, count, modelFloats, normalFloats, computeScalar);
+			return;
+		case Path::Sse2:
+			TransformKernelSimd::compute<Sse2Ops>(transformFloats, count, modelFloats, normalFloats, computeScalar);
+			return;
+#endif
+		default:
+			for (uint32_t i = 0; i < count; i++)
+			{
+				modelMatrices[i] = transforms[i].mat4();
+				normalMatrices[i] = glm::mat4{ transforms[i].normalMatrix() };
+			}
+		}
+	}
+}
@@ -0,0 +1,75 @@
+// Only called once TrekTransformKernel has detected AVX2 and FMA. Built without /arch:AVX2, MSVC
+// emits the intrinsics regardless, so no other code in the program can end up compiled for AVX2.
+#include "trek_transform_kernel_simd.h"
+
+#ifdef TREK_TRANSFORM_KERNEL_X86
+#include <immintrin.h>
+
+namespace Trek
+{
+	namespace
+	{
+		struct Avx2Ops
+		{
+			using F = __m256;
+			using I = __m256i;
+			static constexpr uint32_t WIDTH = 8;
+
+			static F set1(const float value) { return _mm256_set1_ps(value); }
+			static I set1i(const int value) { return _mm256_set1_epi32(value); }
+			static F add(const F& a, const F& b) { return _mm256_add_ps(a, b); }
+			static F sub(const F& a, const F& b) { return _mm256_sub_ps(a, b); }
+			static F mul(const F& a, const F& b) { return _mm256_mul_ps(a, b); }
+			static F div(const F& a, const F& b) { return _mm256_div_ps(a, b); }
+			static F madd(const F& a, const F& b, const F& c) { return _mm256_fmadd_ps(a, b, c); }
+			static F andps(const F& a, const F& b) { return _mm256_and_ps(a, b); }
+			static F andnot(const F& a, const F& b) { return _mm256_andnot_ps(a, b); }
+			static F orps(const F& a, const F& b) { return _mm256_or_ps(a, b); }
+			static F xorps(const F& a, const F& b) { return _mm256_xor_ps(a, b); }
+			static F cmpgt(const F& a, const F& b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+			static int movemask(const F& a) { return _mm256_movemask_ps(a); }
+			static I cvtt(const F& a) { return _mm256_cvttps_epi32(a); }
+			static F cvt(const I& a) { return _mm256_cvtepi32_ps(a); }
+			static F castf(const I& a) { return _mm256_castsi256_ps(a); }
+			static I addi(const I& a, const I& b) { return _mm256_add_epi32(a, b); }
+			static I subi(const I& a, const I& b) { return _mm256_sub_epi32(a, b); }
+			static I andi(const I& a, const I& b) { return _mm256_and_si256(a, b); }
+			static I andnoti(const I& a, const I& b) { return _mm256_andnot_si256(a, b); }
+			static I cmpeqi(const I& a, const I& b) { return _mm256_cmpeq_epi32(a, b); }
+			static I slli29(const I& a) { return _mm256_slli_epi32(a, 29); }
+
+			static F gather(const float* base, const uint32_t stride)
+			{
+				return _mm256_set_ps(
+					base[7 * stride], base[6 * stride], base[5 * stride], base[4 * stride],
+					base[3 * stride], base[2 * stride], base[stride], base[0]);
+			}
+
+			// Lane k of x, y, z and w becomes column `column` of matrix k, four lanes per half.
+			static void storeColumn(const F& x, const F& y, const F& z, const F& w, float* matrices, const uint32_t column)
+			{
+				storeHalf(_mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z), _mm256_castps256_ps128(w), matrices, column);
+				storeHalf(_mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1), matrices + 4 * TransformKernelSimd::MATRIX_FLOATS, column);
+			}
+
+			static void storeHalf(const __m128& x, const __m128& y, const __m128& z, const __m128& w, float* matrices, const uint32_t column)
+			{
+				__m128 lane0 = x, lane1 = y, lane2 = z, lane3 = w;
+				_MM_TRANSPOSE4_PS(lane0, lane1, lane2, lane3);
+				_mm_storeu_ps(matrices + 0 * TransformKernelSimd::MATRIX_FLOATS + column * 4, lane0);
+				_mm_storeu_ps(matrices + 1 * TransformKernelSimd::MATRIX_FLOATS + column * 4, lane1);
+				_mm_storeu_ps(matrices + 2 * TransformKernelSimd::MATRIX_FLOATS + column * 4, lane2);
+				_mm_storeu_ps(matrices + 3 * TransformKernelSimd::MATRIX_FLOATS + column * 4, lane3);
+			}
+		};
+	}
+
+	namespace TransformKernelSimd
+	{
+		void computeAvx2(const float* transforms, const uint32_t count, float* modelMatrices, float* normalMatrices, const ScalarFunction scalar)
+		{
+			compute<Avx2Ops>(transforms, count, modelMatrices, normalMatrices, scalar);
+		}
+	}
+}
+#endif
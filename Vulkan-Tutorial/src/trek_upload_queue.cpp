@@ -0,0 +1,601 @@
+#include "trek_upload_queue.h"
+#include "trek_cpu_profiler.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace Trek
+{
+	namespace
+	{
+		constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+		constexpr VkAccessFlags UPLOAD_READ_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+			VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+		constexpr VkPipelineStageFlags UPLOAD_READ_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		VkCommandPool createCommandPool(const VkDevice device, const uint32_t queueFamily)
+		{
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = queueFamily;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+			VkCommandPool pool;
+			if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create upload command pool!");
+			}
+			return pool;
+		}
+	}
+
+	TrekUploadQueue::TrekUploadQueue(TrekCore& device, const VkDeviceSize stagingBytes) :
+		trekDevice{ device },
+		stagingCapacity{ stagingBytes }
+	{
+		const QueueFamilyIndices indices = trekDevice.findPhysicalQueueFamilies();
+		graphicsFamily = indices.graphicsFamily;
+		transferFamily = indices.transferFamily;
+		separateQueue = trekDevice.transferQueue() != trekDevice.graphicsQueue();
+		ownershipTransfer = transferFamily != graphicsFamily;
+
+		commandPool = createCommandPool(trekDevice.device(), transferFamily);
+		if (separateQueue)
+		{
+			acquirePool = createCommandPool(trekDevice.device(), graphicsFamily);
+		}
+
+		stagingBuffer = std::make_unique<TrekBuffer>(
+			trekDevice,
+			stagingCapacity,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		stagingBuffer->map();
+		createQueryPool();
+
+		recording.ticket = nextTicket++;
+	}
+
+	TrekUploadQueue::~TrekUploadQueue()
+	{
+		waitIdle();
+		if (recording.commandBuffer != VK_NULL_HANDLE)
+		{
+			vkEndCommandBuffer(recording.commandBuffer);
+			freeCommandBuffers.push_back(recording.commandBuffer);
+		}
+		if (!freeCommandBuffers.empty())
+		{
+			vkFreeCommandBuffers(
+				trekDevice.device(),
+				commandPool,
+				static_cast<uint32_t>(freeCommandBuffers.size()),
+				freeCommandBuffers.data());
+		}
+		if (!freeAcquireCommandBuffers.empty())
+		{
+			vkFreeCommandBuffers(
+				trekDevice.device(),
+				acquirePool,
+				static_cast<uint32_t>(freeAcquireCommandBuffers.size()),
+				freeAcquireCommandBuffers.data());
+		}
+		for (const VkFence fence : freeFences)
+		{
+			vkDestroyFence(trekDevice.device(), fence, nullptr);
+		}
+		for (const VkSemaphore semaphore : freeSemaphores)
+		{
+			vkDestroySemaphore(trekDevice.device(), semaphore, nullptr);
+		}
+		vkDestroyCommandPool(trekDevice.device(), commandPool, nullptr);
+		if (acquirePool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(trekDevice.device(), acquirePool, nullptr);
+		}
+		if (queryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(trekDevice.device(), queryPool, nullptr);
+		}
+	}
+
+	void TrekUploadQueue::createQueryPool()
+	{
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(trekDevice.getPhysicalDevice(), &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(trekDevice.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+		const VkQueueFamilyProperties& family = queueFamilies[transferFamily];
+		if (family.timestampValidBits == 0 || trekDevice.properties.limits.timestampPeriod <= 0.f)
+		{
+			return;
+		}
+		nanosecondsPerTick = static_cast<double>(trekDevice.properties.limits.timestampPeriod);
+		timestampMask = family.timestampValidBits >= 64 ? ~0ull : (1ull << family.timestampValidBits) - 1;
+		resetOnTransferQueue = (family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) != 0;
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = TIMED_BATCHES * 2;
+		if (vkCreateQueryPool(trekDevice.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create upload timestamp query pool!");
+		}
+		// Fresh queries need a reset before their first use like any read back ones.
+		for (uint32_t pair = 0; pair < TIMED_BATCHES; pair++)
+		{
+			staleQueryPairs.push_back(pair);
+		}
+	}
+
+	TrekUploadQueue::Ticket TrekUploadQueue::enqueueBufferCopy(
+		const VkBuffer dstBuffer,
+		const VkDeviceSize dstOffset,
+		const void* data,
+		const VkDeviceSize size)
+	{
+		const auto* bytes = static_cast<const char*>(data);
+		return enqueueBufferWrite(dstBuffer, dstOffset, size, 1, [bytes](void* staging, const VkDeviceSize offset, const VkDeviceSize pieceSize)
+		{
+			memcpy(staging, bytes + offset, pieceSize);
+		});
+	}
+
+	TrekUploadQueue::Ticket TrekUploadQueue::enqueueBufferWrite(
+		const VkBuffer dstBuffer,
+		const VkDeviceSize dstOffset,
+		const VkDeviceSize size,
+		const VkDeviceSize granularity,
+		const Writer& write)
+	{
+		assert(granularity > 0 && granularity <= stagingCapacity / 2 && "Write granularity must fit half the staging ring");
+		std::lock_guard<std::mutex> lock{ mutex };
+		// Pieces of at most half the ring, so a piece never has to wait for the batch it is in.
+		const VkDeviceSize maxPieceSize = stagingCapacity / 2 / granularity * granularity;
+		VkDeviceSize copied = 0;
+		while (copied < size)
+		{
+			const VkDeviceSize pieceSize = std::min(size - copied, maxPieceSize);
+			const VkDeviceSize stagingOffset = reserveStaging(pieceSize);
+			beginBatch();
+			write(static_cast<char*>(stagingBuffer->getMappedMemory()) + stagingOffset, copied, pieceSize);
+
+			VkBufferCopy copyRegion{};
+			copyRegion.srcOffset = stagingOffset;
+			copyRegion.dstOffset = dstOffset + copied;
+			copyRegion.size = pieceSize;
+			vkCmdCopyBuffer(recording.commandBuffer, stagingBuffer->getBuffer(), dstBuffer, 1, &copyRegion);
+			hasCommands = true;
+			copied += pieceSize;
+		}
+
+		if (ownershipTransfer && size > 0)
+		{
+			VkBufferMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = transferFamily;
+			barrier.dstQueueFamilyIndex = graphicsFamily;
+			barrier.buffer = dstBuffer;
+			barrier.offset = dstOffset;
+			barrier.size = size;
+			ownershipBarriers.push_back(barrier);
+		}
+		return size > 0 ? recording.ticket : COMPLETED_TICKET;
+	}
+
+	TrekUploadQueue::Ticket TrekUploadQueue::flush()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return submitBatch();
+	}
+
+	bool TrekUploadQueue::isComplete(const Ticket ticket)
+	{
+		if (ticket <= completedTicket)
+		{
+			return true;
+		}
+		std::lock_guard<std::mutex> lock{ mutex };
+		return isCompleteLocked(ticket);
+	}
+
+	void TrekUploadQueue::wait(const Ticket ticket)
+	{
+		TrekCpuProfiler::Zone zone{ "TrekUploadQueue::wait" };
+		std::lock_guard<std::mutex> lock{ mutex };
+		assert(ticket <= recording.ticket && "Waiting on a ticket that was never handed out");
+		if (ticket == recording.ticket)
+		{
+			submitBatch();
+		}
+		while (!isCompleteLocked(ticket) && !inFlight.empty())
+		{
+			retire(true);
+		}
+	}
+
+	void TrekUploadQueue::waitIdle()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		submitBatch();
+		while (!inFlight.empty())
+		{
+			retire(true);
+		}
+	}
+
+	double TrekUploadQueue::takeGpuMilliseconds()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		retire(false);
+		const double milliseconds = gpuMilliseconds;
+		gpuMilliseconds = 0.0;
+		return milliseconds;
+	}
+
+	void TrekUploadQueue::beginBatch()
+	{
+		if (recording.commandBuffer == VK_NULL_HANDLE)
+		{
+			recording.commandBuffer = beginCommandBuffer(commandPool, freeCommandBuffers);
+			if (queryPool != VK_NULL_HANDLE)
+			{
+				beginTimestamps();
+			}
+		}
+	}
+
+	void TrekUploadQueue::beginTimestamps()
+	{
+		if (resetOnTransferQueue)
+		{
+			for (const uint32_t pair : staleQueryPairs)
+			{
+				vkCmdResetQueryPool(recording.commandBuffer, queryPool, pair * 2, 2);
+			}
+			freeQueryPairs.insert(freeQueryPairs.end(), staleQueryPairs.begin(), staleQueryPairs.end());
+			staleQueryPairs.clear();
+		}
+		if (!freeQueryPairs.empty())
+		{
+			recording.queryPair = freeQueryPairs.back();
+			freeQueryPairs.pop_back();
+			vkCmdWriteTimestamp(recording.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, recording.queryPair * 2);
+		}
+	}
+
+	void TrekUploadQueue::readTimestamps(const uint32_t queryPair)
+	{
+		// Value and availability of both queries. The batch's fence has signaled, so they are
+		// normally available; one that still isn't is skipped.
+		uint64_t data[4] = {};
+		const VkResult result = vkGetQueryPoolResults(
+			trekDevice.device(),
+			queryPool,
+			queryPair * 2,
+			2,
+			sizeof(data),
+			data,
+			2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if ((result != VK_SUCCESS && result != VK_NOT_READY) || data[1] == 0 || data[3] == 0)
+		{
+			return;
+		}
+		const uint64_t ticks = ((data[2] & timestampMask) - (data[0] & timestampMask)) & timestampMask;
+		gpuMilliseconds += static_cast<double>(ticks) * nanosecondsPerTick / 1e6;
+	}
+
+	TrekUploadQueue::Ticket TrekUploadQueue::submitBatch()
+	{
+		if (!hasCommands)
+		{
+			// Nothing recorded since the last submit, the previous ticket covers everything.
+			return recording.ticket - 1;
+		}
+		TrekCpuProfiler::Zone zone{ "TrekUploadQueue::submit" };
+
+		recording.fence = takeFence();
+		if (recording.queryPair != NO_QUERY)
+		{
+			vkCmdWriteTimestamp(recording.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, recording.queryPair * 2 + 1);
+		}
+		if (separateQueue)
+		{
+			submitSeparate();
+		}
+		else
+		{
+			submitShared();
+		}
+		submitCount++;
+
+		const Ticket ticket = recording.ticket;
+		inFlight.push_back(recording);
+		recording = Batch{};
+		recording.ticket = nextTicket++;
+		hasCommands = false;
+		ownershipBarriers.clear();
+		return ticket;
+	}
+
+	void TrekUploadQueue::submitShared()
+	{
+		// Make the copies visible to everything submitted after this batch on the graphics queue.
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = UPLOAD_READ_ACCESS;
+		vkCmdPipelineBarrier(
+			recording.commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			UPLOAD_READ_STAGES,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr);
+
+		if (vkEndCommandBuffer(recording.commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record upload command buffer!");
+		}
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &recording.commandBuffer;
+		if (vkQueueSubmit(trekDevice.graphicsQueue(), 1, &submitInfo, recording.fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to submit upload batch!");
+		}
+	}
+
+	void TrekUploadQueue::submitSeparate()
+	{
+		// Release half of the ownership transfer, the destination access is performed by the acquire.
+		for (auto& barrier : ownershipBarriers)
+		{
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = 0;
+		}
+		if (!ownershipBarriers.empty())
+		{
+			vkCmdPipelineBarrier(
+				recording.commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				0,
+				0, nullptr,
+				static_cast<uint32_t>(ownershipBarriers.size()), ownershipBarriers.data(),
+				0, nullptr);
+		}
+		if (vkEndCommandBuffer(recording.commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record upload command buffer!");
+		}
+
+		recording.semaphore = takeSemaphore();
+		VkSubmitInfo transferSubmit{};
+		transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmit.commandBufferCount = 1;
+		transferSubmit.pCommandBuffers = &recording.commandBuffer;
+		transferSubmit.signalSemaphoreCount = 1;
+		transferSubmit.pSignalSemaphores = &recording.semaphore;
+		if (vkQueueSubmit(trekDevice.transferQueue(), 1, &transferSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to submit upload batch!");
+		}
+
+		// The graphics queue waits for the copies before anything submitted after this point, and
+		// acquires the released ranges. A semaphore wait alone is enough within one queue family.
+		const VkPipelineStageFlags waitStage = ownershipTransfer ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TRANSFER_BIT) : UPLOAD_READ_STAGES;
+		VkSubmitInfo acquireSubmit{};
+		acquireSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		acquireSubmit.waitSemaphoreCount = 1;
+		acquireSubmit.pWaitSemaphores = &recording.semaphore;
+		acquireSubmit.pWaitDstStageMask = &waitStage;
+
+		if (ownershipTransfer)
+		{
+			recording.acquireCommandBuffer = beginCommandBuffer(acquirePool, freeAcquireCommandBuffers);
+			for (auto& barrier : ownershipBarriers)
+			{
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = UPLOAD_READ_ACCESS;
+			}
+			vkCmdPipelineBarrier(
+				recording.acquireCommandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				UPLOAD_READ_STAGES,
+				0,
+				0, nullptr,
+				static_cast<uint32_t>(ownershipBarriers.size()), ownershipBarriers.data(),
+				0, nullptr);
+			if (!resetOnTransferQueue)
+			{
+				for (const uint32_t pair : staleQueryPairs)
+				{
+					vkCmdResetQueryPool(recording.acquireCommandBuffer, queryPool, pair * 2, 2);
+				}
+				recording.resetQueryPairs = std::move(staleQueryPairs);
+				staleQueryPairs.clear();
+			}
+			if (vkEndCommandBuffer(recording.acquireCommandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to record upload acquire command buffer!");
+			}
+			acquireSubmit.commandBufferCount = 1;
+			acquireSubmit.pCommandBuffers = &recording.acquireCommandBuffer;
+		}
+
+		if (vkQueueSubmit(trekDevice.graphicsQueue(), 1, &acquireSubmit, recording.fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to submit upload acquire!");
+		}
+	}
+
+	VkDeviceSize TrekUploadQueue::reserveStaging(const VkDeviceSize size)
+	{
+		while (true)
+		{
+			if (stagingUsed == 0)
+			{
+				stagingHead = 0;
+			}
+
+			VkDeviceSize offset = (stagingHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+			VkDeviceSize padding = offset - stagingHead;
+			if (offset + size > stagingCapacity)
+			{
+				// Skip the tail of the ring and wrap around to the start.
+				padding = stagingCapacity - stagingHead;
+				offset = 0;
+			}
+
+			if (stagingUsed + padding + size <= stagingCapacity)
+			{
+				stagingHead = offset + size;
+				stagingUsed += padding + size;
+				recording.stagingBytes += padding + size;
+				return offset;
+			}
+
+			// Out of staging space: get the pending copies going and wait for the oldest batch.
+			if (hasCommands)
+			{
+				submitBatch();
+			}
+			if (inFlight.empty())
+			{
+				throw std::runtime_error("upload does not fit into the staging ring!");
+			}
+			retire(true);
+		}
+	}
+
+	void TrekUploadQueue::retire(bool wait)
+	{
+		while (!inFlight.empty())
+		{
+			Batch& batch = inFlight.front();
+			if (wait)
+			{
+				vkWaitForFences(trekDevice.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+				wait = false;
+			}
+			else if (vkGetFenceStatus(trekDevice.device(), batch.fence) != VK_SUCCESS)
+			{
+				return;
+			}
+
+			// The fence is on the last submit of the batch, so its semaphore has been waited on as well.
+			vkResetFences(trekDevice.device(), 1, &batch.fence);
+			freeFences.push_back(batch.fence);
+			freeCommandBuffers.push_back(batch.commandBuffer);
+			if (batch.acquireCommandBuffer != VK_NULL_HANDLE)
+			{
+				freeAcquireCommandBuffers.push_back(batch.acquireCommandBuffer);
+			}
+			if (batch.semaphore != VK_NULL_HANDLE)
+			{
+				freeSemaphores.push_back(batch.semaphore);
+			}
+			if (batch.queryPair != NO_QUERY)
+			{
+				readTimestamps(batch.queryPair);
+				staleQueryPairs.push_back(batch.queryPair);
+			}
+			freeQueryPairs.insert(freeQueryPairs.end(), batch.resetQueryPairs.begin(), batch.resetQueryPairs.end());
+			stagingUsed -= batch.stagingBytes;
+			completedTicket = batch.ticket;
+			inFlight.pop_front();
+		}
+	}
+
+	bool TrekUploadQueue::isCompleteLocked(const Ticket ticket)
+	{
+		if (ticket > completedTicket && ticket < recording.ticket)
+		{
+			retire(false);
+		}
+		return ticket <= completedTicket;
+	}
+
+	VkCommandBuffer TrekUploadQueue::beginCommandBuffer(const VkCommandPool pool, std::vector<VkCommandBuffer>& freeList) const
+	{
+		VkCommandBuffer commandBuffer;
+		if (freeList.empty())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = pool;
+			allocInfo.commandBufferCount = 1;
+			if (vkAllocateCommandBuffers(trekDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate upload command buffer!");
+			}
+		}
+		else
+		{
+			commandBuffer = freeList.back();
+			freeList.pop_back();
+			vkResetCommandBuffer(commandBuffer, 0);
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin upload command buffer!");
+		}
+		return commandBuffer;
+	}
+
+	VkFence TrekUploadQueue::takeFence()
+	{
+		if (!freeFences.empty())
+		{
+			const VkFence fence = freeFences.back();
+			freeFences.pop_back();
+			return fence;
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkFence fence;
+		if (vkCreateFence(trekDevice.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create upload fence!");
+		}
+		return fence;
+	}
+
+	VkSemaphore TrekUploadQueue::takeSemaphore()
+	{
+		if (!freeSemaphores.empty())
+		{
+			const VkSemaphore semaphore = freeSemaphores.back();
+			freeSemaphores.pop_back();
+			return semaphore;
+		}
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		VkSemaphore semaphore;
+		if (vkCreateSemaphore(trekDevice.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create upload semaphore!");
+		}
+		return semaphore;
+	}
+}
@@ -0,0 +1,120 @@
+#include "trek_vertex_format.h"
+#include "trek_model.h"
+
+//libs
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+// std
+#include <cmath>
+#include <stdexcept>
+
+namespace Trek
+{
+	namespace
+	{
+		float signNotZero(const float value)
+		{
+			return value >= 0.f ? 1.f : -1.f;
+		}
+	}
+
+	bool TrekVertexLayout::parse(const std::string& name, TrekVertexFormat& format)
+	{
+		if (name == "float") format = TrekVertexFormat::Float;
+		else if (name == "packed") format = TrekVertexFormat::Packed;
+		else if (name == "packed-color") format = TrekVertexFormat::PackedColor;
+		else return false;
+		return true;
+	}
+
+	uint32_t TrekVertexLayout::stride(const TrekVertexFormat format)
+	{
+		switch (format)
+		{
+		case TrekVertexFormat::Float: return TrekVertexInput<TrekModelVertexLayout>::STRIDE;
+		case TrekVertexFormat::Packed: return TrekVertexInput<TrekPackedVertexLayout>::STRIDE;
+		case TrekVertexFormat::PackedColor: return TrekVertexInput<TrekPackedColorVertexLayout>::STRIDE;
+		}
+		throw std::runtime_error("unknown vertex format!");
+	}
+
+	TrekVertexInputState TrekVertexLayout::vertexInput(const TrekVertexFormat format)
+	{
+		switch (format)
+		{
+		case TrekVertexFormat::Float: return TrekVertexInput<TrekModelVertexLayout>::state();
+		case TrekVertexFormat::Packed: return TrekVertexInput<TrekPackedVertexLayout>::state();
+		case TrekVertexFormat::PackedColor: return TrekVertexInput<TrekPackedColorVertexLayout>::state();
+		}
+		throw std::runtime_error("unknown vertex format!");
+	}
+
+	glm::mat4 TrekVertexLayout::dequantizeMatrix(const TrekVertexFormat format, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		if (format == TrekVertexFormat::Float)
+		{
+			return glm::mat4{ 1.f };
+		}
+		return glm::scale(glm::translate(glm::mat4{ 1.f }, boundsMin), boundsMax - boundsMin);
+	}
+
+	void TrekVertexLayout::quantizePosition(const glm::vec3& position, const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint16_t out[4])
+	{
+		const glm::vec3 extent = boundsMax - boundsMin;
+		for (int i = 0; i < 3; i++)
+		{
+			// Flat meshes have no extent along one axis, every vertex sits at the minimum there.
+			const float normalized = extent[i] > 0.f ? (position[i] - boundsMin[i]) / extent[i] : 0.f;
+			out[i] = static_cast<uint16_t>(std::lround(glm::clamp(normalized, 0.f, 1.f) * 65535.f));
+		}
+		out[3] = 0;
+	}
+
+	void TrekVertexLayout::encodeOctahedral(const glm::vec3& normal, int16_t out[2])
+	{
+		const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (length == 0.f)
+		{
+			out[0] = out[1] = 0;
+			return;
+		}
+
+		glm::vec2 encoded = glm::vec2{ normal.x, normal.y } / length;
+		if (normal.z < 0.f)
+		{
+			// Fold the lower hemisphere over the diagonals.
+			encoded = glm::vec2{
+				(1.f - std::abs(encoded.y)) * signNotZero(encoded.x),
+				(1.f - std::abs(encoded.x)) * signNotZero(encoded.y) };
+		}
+		out[0] = static_cast<int16_t>(std::lround(glm::clamp(encoded.x, -1.f, 1.f) * 32767.f));
+		out[1] = static_cast<int16_t>(std::lround(glm::clamp(encoded.y, -1.f, 1.f) * 32767.f));
+	}
+
+	glm::vec3 TrekVertexLayout::decodeOctahedral(const int16_t encoded[2])
+	{
+		// Mirrors decodeOctahedral() in the packed vertex shader.
+		const glm::vec2 e = glm::max(glm::vec2{ static_cast<float>(encoded[0]), static_cast<float>(encoded[1]) } / 32767.f, glm::vec2{ -1.f });
+		glm::vec3 normal{ e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y) };
+		const float t = glm::max(-normal.z, 0.f);
+		normal.x += normal.x >= 0.f ? -t : t;
+		normal.y += normal.y >= 0.f ? -t : t;
+		return glm::normalize(normal);
+	}
+
+	void TrekVertexLayout::encodeHalf(const glm::vec2& uv, uint16_t out[2])
+	{
+		out[0] = glm::packHalf1x16(uv.x);
+		out[1] = glm::packHalf1x16(uv.y);
+	}
+
+	void TrekVertexLayout::encodeColor(const glm::vec3& color, uint8_t out[4])
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			out[i] = static_cast<uint8_t>(std::lround(glm::clamp(color[i], 0.f, 1.f) * 255.f));
+		}
+		out[3] = 255;
+	}
+}
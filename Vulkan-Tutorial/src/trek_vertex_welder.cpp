@@ -0,0 +1,73 @@
+#include "trek_vertex_welder.h"
+
+// std
+#include <cstring>
+
+namespace Trek
+{
+	namespace
+	{
+		uint64_t mix(uint64_t value)
+		{
+			value ^= value >> 33;
+			value *= 0xff51afd7ed558ccdull;
+			value ^= value >> 33;
+			value *= 0xc4ceb9fe1a85ec53ull;
+			value ^= value >> 33;
+			return value;
+		}
+	}
+
+	size_t TrekIndexTripleHash::operator()(const TrekIndexTriple& triple) const
+	{
+		const uint64_t low = static_cast<uint32_t>(triple.position) | static_cast<uint64_t>(static_cast<uint32_t>(triple.texcoord)) << 32;
+		return static_cast<size_t>(mix(low ^ mix(static_cast<uint32_t>(triple.normal))));
+	}
+
+	size_t TrekVertexBitsHash::operator()(const TrekModel::Vertex& vertex) const
+	{
+		constexpr size_t FLOAT_COUNT = sizeof(TrekModel::Vertex) / sizeof(float);
+		static_assert(sizeof(TrekModel::Vertex) == FLOAT_COUNT * sizeof(float), "Vertex must be made of floats only");
+
+		uint32_t bits[FLOAT_COUNT];
+		memcpy(bits, &vertex, sizeof(bits));
+		uint64_t hash = 0;
+		for (size_t i = 0; i < FLOAT_COUNT; i++)
+		{
+			// -0.f == 0.f, so both have to land in the same bucket.
+			const uint32_t value = bits[i] == 0x80000000u ? 0u : bits[i];
+			hash = (hash ^ value) * 0x100000001b3ull + (hash >> 29);
+		}
+		return static_cast<size_t>(mix(hash));
+	}
+
+	TrekVertexWelder::TrekVertexWelder(const TrekWeldMode mode, const size_t expectedVertices) : mode{ mode }
+	{
+		if (mode == TrekWeldMode::IndexTriple)
+		{
+			triples.reserve(expectedVertices);
+		}
+		else
+		{
+			attributes.reserve(expectedVertices);
+		}
+	}
+
+	size_t TrekVertexWelder::estimateVertices(const size_t corners)
+	{
+		// Closed meshes use each vertex about six times, UV and normal seams bring that down.
+		// Reserving a slot per corner instead would cost a full vertex per corner in Attributes
+		// mode, half a gigabyte for ten million corners.
+		return corners / 4;
+	}
+
+	uint32_t TrekVertexWelder::weld(const TrekModel::Vertex& vertex)
+	{
+		const auto [index, inserted] = attributes.tryEmplace(vertex, static_cast<uint32_t>(vertices.size()));
+		if (inserted)
+		{
+			vertices.push_back(vertex);
+		}
+		return index;
+	}
+}